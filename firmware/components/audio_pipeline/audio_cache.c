@@ -0,0 +1,251 @@
+#include <stdlib.h>
+#include <string.h>
+#include "audio_cache.h"
+
+static const char *TAG = "AUDIO_CACHE";
+
+static void wr_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void wr_le32(uint8_t *p, uint32_t v) {
+    wr_le16(p, (uint16_t)v);
+    wr_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void write_wav_header(uint8_t *h, uint32_t sample_rate, uint16_t bits, uint32_t data_len) {
+    uint16_t block_align = bits / 8;
+    memcpy(h, "RIFF", 4);
+    wr_le32(h + 4, 36 + data_len);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    wr_le32(h + 16, 16);
+    wr_le16(h + 20, 1);
+    wr_le16(h + 22, 1);
+    wr_le32(h + 24, sample_rate);
+    wr_le32(h + 28, sample_rate * block_align);
+    wr_le16(h + 32, block_align);
+    wr_le16(h + 34, bits);
+    memcpy(h + 36, "data", 4);
+    wr_le32(h + 40, data_len);
+}
+
+void audio_cache_init(audio_cache_t *c, size_t budget, void *(*alloc)(size_t), const audio_cache_store_t *store) {
+    memset(c, 0, sizeof(*c));
+    c->budget = budget;
+    c->alloc = alloc ? alloc : malloc;
+    c->store = store;
+    audio_lock_init(&c->lock);
+}
+
+static void drop(audio_cache_t *c, audio_cache_entry_t *e) {
+    free(e->data);
+    c->used -= e->size;
+    memset(e, 0, sizeof(*e));
+}
+
+void audio_cache_deinit(audio_cache_t *c) {
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        if (c->entries[i].data) drop(c, &c->entries[i]);
+    }
+}
+
+static audio_cache_entry_t *lookup(audio_cache_t *c, const char *key) {
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        audio_cache_entry_t *e = &c->entries[i];
+        if (e->committed && strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+static bool evict_lru(audio_cache_t *c) {
+    audio_cache_entry_t *victim = NULL;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        audio_cache_entry_t *e = &c->entries[i];
+        if (e->committed && e->pins == 0 && (!victim || e->last_use < victim->last_use)) victim = e;
+    }
+    if (!victim) return false;
+    AUDIO_LOGI(TAG, "Evicting %s (%u bytes)", victim->key, (unsigned)victim->size);
+    drop(c, victim);
+    c->counters.evictions++;
+    return true;
+}
+
+// Free slot with `size` bytes of budget available, evicting as needed.
+static audio_cache_entry_t *reserve(audio_cache_t *c, size_t size) {
+    if (size > c->budget) return NULL;
+    while (c->used + size > c->budget) {
+        if (!evict_lru(c)) return NULL;
+    }
+    while (1) {
+        for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+            if (!c->entries[i].data) return &c->entries[i];
+        }
+        if (!evict_lru(c)) return NULL;
+    }
+}
+
+static audio_cache_entry_t *alloc_entry(audio_cache_t *c, const char *key, size_t size) {
+    audio_cache_entry_t *e = reserve(c, size);
+    if (!e) return NULL;
+    e->data = c->alloc(size);
+    if (!e->data) return NULL;
+    strncpy(e->key, key, sizeof(e->key) - 1);
+    e->size = size;
+    e->pins = 1;
+    e->last_use = ++c->clock;
+    c->used += size;
+    return e;
+}
+
+audio_cache_entry_t *audio_cache_acquire(audio_cache_t *c, const char *key) {
+    audio_lock(&c->lock);
+    audio_cache_entry_t *e = lookup(c, key);
+    if (e) {
+        e->pins++;
+        e->last_use = ++c->clock;
+        c->counters.hits++;
+        audio_unlock(&c->lock);
+        return e;
+    }
+
+    int stored = c->store ? c->store->find(c->store->ctx, key) : -1;
+    if (stored > AUDIO_CACHE_WAV_HEADER) {
+        e = alloc_entry(c, key, (size_t)stored);
+        if (e && c->store->read(c->store->ctx, key, e->data, (size_t)stored)) {
+            e->len = (size_t)stored;
+            e->committed = true;
+            e->stored = true;
+            c->counters.store_hits++;
+            audio_unlock(&c->lock);
+            return e;
+        }
+        if (e) drop(c, e);
+        AUDIO_LOGW(TAG, "Failed to load %s from the store", key);
+    }
+    c->counters.misses++;
+    audio_unlock(&c->lock);
+    return NULL;
+}
+
+bool audio_cache_contains(audio_cache_t *c, const char *key) {
+    audio_lock(&c->lock);
+    bool found = lookup(c, key) || (c->store && c->store->find(c->store->ctx, key) > AUDIO_CACHE_WAV_HEADER);
+    audio_unlock(&c->lock);
+    return found;
+}
+
+void audio_cache_release(audio_cache_t *c, audio_cache_entry_t *e) {
+    audio_lock(&c->lock);
+    if (e->pins > 0) e->pins--;
+    audio_unlock(&c->lock);
+}
+
+audio_cache_entry_t *audio_cache_begin(audio_cache_t *c, const char *key, uint32_t sample_rate,
+                                       uint16_t bits_per_sample, size_t max_pcm) {
+    if (!key || !key[0] || strlen(key) >= AUDIO_CACHE_KEY_MAX) return NULL;
+    audio_lock(&c->lock);
+    audio_cache_entry_t *e = NULL;
+    if (!lookup(c, key)) {
+        e = alloc_entry(c, key, AUDIO_CACHE_WAV_HEADER + max_pcm);
+        if (e) {
+            write_wav_header(e->data, sample_rate, bits_per_sample, 0);
+            e->len = AUDIO_CACHE_WAV_HEADER;
+        } else {
+            c->counters.rejects++;
+        }
+    }
+    audio_unlock(&c->lock);
+    return e;
+}
+
+bool audio_cache_append(audio_cache_entry_t *e, const void *pcm, size_t len) {
+    if (e->len + len > e->size) return false;
+    memcpy(e->data + e->len, pcm, len);
+    e->len += len;
+    return true;
+}
+
+void audio_cache_commit(audio_cache_t *c, audio_cache_entry_t *e) {
+    uint32_t data_len = (uint32_t)(e->len - AUDIO_CACHE_WAV_HEADER);
+    wr_le32(e->data + 4, 36 + data_len);
+    wr_le32(e->data + 40, data_len);
+
+    audio_lock(&c->lock);
+    if (lookup(c, e->key)) {
+        // Someone else cached the same clip meanwhile
+        drop(c, e);
+    } else {
+        e->committed = true;
+        e->pins--;
+        e->last_use = ++c->clock;
+    }
+    audio_unlock(&c->lock);
+}
+
+void audio_cache_abort(audio_cache_t *c, audio_cache_entry_t *e) {
+    audio_lock(&c->lock);
+    drop(c, e);
+    audio_unlock(&c->lock);
+}
+
+void audio_cache_flush(audio_cache_t *c) {
+    if (!c->store) return;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        audio_cache_entry_t *e = &c->entries[i];
+        audio_lock(&c->lock);
+        bool pending = e->committed && !e->stored;
+        if (pending) e->pins++;
+        audio_unlock(&c->lock);
+        if (!pending) continue;
+
+        // Pinned, so the write can run without holding the lock
+        bool ok = c->store->write(c->store->ctx, e->key, e->data, e->len);
+        audio_lock(&c->lock);
+        e->pins--;
+        if (ok) {
+            e->stored = true;
+            c->counters.stored++;
+        }
+        audio_unlock(&c->lock);
+        if (!ok) AUDIO_LOGW(TAG, "Failed to store %s", e->key);
+    }
+}
+
+audio_cache_counters_t audio_cache_counters(audio_cache_t *c) {
+    audio_lock(&c->lock);
+    audio_cache_counters_t out = c->counters;
+    audio_unlock(&c->lock);
+    return out;
+}
+
+// ---- in-memory source ----
+
+static int cache_source_open(void *ctx, const char *url) {
+    audio_cache_source_t *src = ctx;
+    src->pos = 0;
+    return (int)src->entry->len;
+}
+
+static int cache_source_read(void *ctx, uint8_t *buf, int len) {
+    audio_cache_source_t *src = ctx;
+    size_t left = src->entry->len - src->pos;
+    size_t n = (size_t)len < left ? (size_t)len : left;
+    memcpy(buf, src->entry->data + src->pos, n);
+    src->pos += n;
+    return (int)n;
+}
+
+static void cache_source_close(void *ctx) {
+}
+
+void audio_cache_source_bind(audio_cache_source_t *src, const audio_cache_entry_t *e, audio_source_t *out) {
+    src->entry = e;
+    src->pos = 0;
+    *out = (audio_source_t) {
+        .ctx = src,
+        .open = cache_source_open,
+        .read = cache_source_read,
+        .close = cache_source_close,
+    };
+}
@@ -0,0 +1,71 @@
+#include <string.h>
+#include "audio_chime.h"
+#include "audio_pipeline.h"
+
+static uint32_t rd_le32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int audio_chime_find(const void *image, size_t size, unsigned id, audio_chime_t *out) {
+    const uint8_t *img = image;
+    if (!img || size < AUDIO_CHIME_HEADER || memcmp(img, AUDIO_CHIME_MAGIC, 4) != 0) {
+        return AUDIO_ERR_FORMAT;
+    }
+    uint32_t count = rd_le32(img + 4);
+    if (count > AUDIO_CHIME_MAX || AUDIO_CHIME_HEADER + (size_t)count * AUDIO_CHIME_ENTRY > size) {
+        return AUDIO_ERR_FORMAT;
+    }
+    if (id == 0 || id > count) return AUDIO_ERR_FORMAT;
+
+    const uint8_t *e = img + AUDIO_CHIME_HEADER + (id - 1) * AUDIO_CHIME_ENTRY;
+    uint32_t offset = rd_le32(e);
+    uint32_t len = rd_le32(e + 4);
+    uint32_t sample_rate = rd_le32(e + 8);
+    uint16_t bits = (uint16_t)(e[12] | e[13] << 8);
+    if (offset > size || len > size - offset || sample_rate == 0 || (bits != 16 && bits != 32) ||
+        len % (bits / 8) != 0) {
+        return AUDIO_ERR_FORMAT;
+    }
+
+    *out = (audio_chime_t) {
+        .pcm = img + offset,
+        .len = len,
+        .sample_rate = sample_rate,
+        .bits_per_sample = bits,
+    };
+    return AUDIO_OK;
+}
+
+int64_t audio_chime_duration_us(const audio_chime_t *c) {
+    uint64_t frames = c->len / (c->bits_per_sample / 8);
+    return (int64_t)(frames * 1000000 / c->sample_rate);
+}
+
+int audio_chime_play(const audio_chime_t *c, const audio_sink_t *sink, audio_resampler_t *rs, uint32_t out_rate) {
+    size_t frame_bytes = c->bits_per_sample / 8;
+    if (rs && audio_resample_init(rs, c->sample_rate, c->bits_per_sample, out_rate) != AUDIO_OK) {
+        return AUDIO_ERR_FORMAT;
+    }
+    size_t pos = 0;
+    while (pos < c->len) {
+        size_t n = c->len - pos;
+        if (n > AUDIO_CHUNK_BUFFER_SIZE) n = AUDIO_CHUNK_BUFFER_SIZE;
+        size_t written = 0;
+        if (rs) {
+            uint32_t out = 0;
+            n -= n % frame_bytes;
+            if (n == 0 || audio_resample_write(rs, c->pcm + pos, n / frame_bytes, sink, &out) != AUDIO_OK) {
+                return AUDIO_ERR_IO;
+            }
+            written = n;
+        } else if (sink->write(sink->ctx, c->pcm + pos, n, &written) != 0 || written == 0) {
+            return AUDIO_ERR_IO;
+        }
+        pos += written;
+    }
+    if (rs) {
+        uint32_t out = 0;
+        return audio_resample_finish(rs, sink, &out);
+    }
+    return AUDIO_OK;
+}
@@ -0,0 +1,95 @@
+#include <string.h>
+#include "audio_conceal.h"
+#include "audio_pipeline.h"
+
+// Gain ramp over frames [from, from + n) of a `len`-frame fade, Q15.
+// Rising ends at unity, falling ends at zero.
+static void ramp(uint8_t *buf, uint16_t bps, size_t n, size_t from, size_t len, bool rising) {
+    for (size_t i = 0; i < n; i++) {
+        size_t k = from + i;
+        int32_t g = (int32_t)(((rising ? k + 1 : len - 1 - k) << 15) / len);
+        if (bps == sizeof(int16_t)) {
+            int16_t *s = (int16_t *)buf + i;
+            *s = (int16_t)((*s * g) >> 15);
+        } else {
+            int32_t *s = (int32_t *)buf + i;
+            *s = (int32_t)(((int64_t)*s * g) >> 15);
+        }
+    }
+}
+
+static int forward(audio_conceal_t *c, const void *buf, size_t len) {
+    size_t written = 0;
+    return len == 0 || c->next.write(c->next.ctx, buf, len, &written) == 0 ? 0 : -1;
+}
+
+// Passes everything but the newest fade_frames on, keeping those in tail
+static int hold(audio_conceal_t *c, const uint8_t *in, size_t len) {
+    size_t cap = c->fade_frames * c->bytes_per_sample;
+    if (len >= cap) {
+        if (forward(c, c->tail, c->held) != 0 || forward(c, in, len - cap) != 0) return -1;
+        memcpy(c->tail, in + len - cap, cap);
+        c->held = cap;
+        return 0;
+    }
+    if (c->held + len > cap) {
+        size_t out = c->held + len - cap;
+        if (forward(c, c->tail, out) != 0) return -1;
+        memmove(c->tail, c->tail + out, c->held - out);
+        c->held -= out;
+    }
+    memcpy(c->tail + c->held, in, len);
+    c->held += len;
+    return 0;
+}
+
+static int conceal_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    audio_conceal_t *c = ctx;
+    const uint8_t *in = buf;
+    *written = 0;
+    while (c->fade_in_pos < c->fade_frames && len >= c->bytes_per_sample) {
+        size_t frames = len / c->bytes_per_sample;
+        if (frames > c->fade_frames - c->fade_in_pos) frames = c->fade_frames - c->fade_in_pos;
+        size_t bytes = frames * c->bytes_per_sample;
+        memcpy(c->scratch, in, bytes);
+        ramp(c->scratch, c->bytes_per_sample, frames, c->fade_in_pos, c->fade_frames, true);
+        if (hold(c, c->scratch, bytes) != 0) return -1;
+        c->fade_in_pos += frames;
+        in += bytes;
+        len -= bytes;
+        *written += bytes;
+    }
+    if (len && hold(c, in, len) != 0) return -1;
+    *written += len;
+    return 0;
+}
+
+void audio_conceal_bind(audio_conceal_t *c, const audio_sink_t *next, uint32_t sample_rate,
+                        uint16_t bits_per_sample, audio_sink_t *out) {
+    c->next = *next;
+    c->bytes_per_sample = bits_per_sample / 8;
+    c->fade_frames = (size_t)sample_rate * AUDIO_CONCEAL_FADE_MS / 1000;
+    if (c->fade_frames > AUDIO_CONCEAL_MAX_FRAMES) c->fade_frames = AUDIO_CONCEAL_MAX_FRAMES;
+    if (c->fade_frames == 0) c->fade_frames = 1;
+    c->held = 0;
+    c->fade_in_pos = c->fade_frames;
+    out->ctx = c;
+    out->write = conceal_write;
+}
+
+int audio_conceal_fade_out(audio_conceal_t *c) {
+    size_t frames = c->held / c->bytes_per_sample;
+    if (frames) ramp(c->tail, c->bytes_per_sample, frames, 0, frames, false);
+    int rc = forward(c, c->tail, c->held);
+    c->held = 0;
+    memset(c->scratch, 0, AUDIO_CONCEAL_PAD_FRAMES * c->bytes_per_sample);
+    if (rc == 0) rc = forward(c, c->scratch, AUDIO_CONCEAL_PAD_FRAMES * c->bytes_per_sample);
+    c->fade_in_pos = 0;
+    return rc == 0 ? AUDIO_OK : AUDIO_ERR_IO;
+}
+
+int audio_conceal_finish(audio_conceal_t *c) {
+    int rc = forward(c, c->tail, c->held);
+    c->held = 0;
+    return rc == 0 ? AUDIO_OK : AUDIO_ERR_IO;
+}
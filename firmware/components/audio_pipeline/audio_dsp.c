@@ -0,0 +1,216 @@
+#include <math.h>
+#include <string.h>
+#include "audio_dsp.h"
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "pcm_convert.h"
+
+static const char *TAG = "AUDIO_DSP";
+
+static inline int16_t sat16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+// RBJ audio EQ cookbook, normalized by a0
+static int design(audio_biquad_t *f, const audio_eq_band_t *band, uint32_t sample_rate) {
+    if (band->freq_hz <= 0 || band->freq_hz >= sample_rate / 2.0f || band->q <= 0) return AUDIO_ERR_FORMAT;
+    double w = 2 * M_PI * band->freq_hz / sample_rate;
+    double cw = cos(w), alpha = sin(w) / (2 * band->q);
+    double A = pow(10, band->gain_db / 40), sa = 2 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+    switch (band->type) {
+        case AUDIO_EQ_HIGHPASS:
+            b0 = (1 + cw) / 2; b1 = -(1 + cw); b2 = b0;
+            a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+            break;
+        case AUDIO_EQ_LOWPASS:
+            b0 = (1 - cw) / 2; b1 = 1 - cw; b2 = b0;
+            a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+            break;
+        case AUDIO_EQ_PEAK:
+            b0 = 1 + alpha * A; b1 = -2 * cw; b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A; a1 = -2 * cw; a2 = 1 - alpha / A;
+            break;
+        case AUDIO_EQ_LOWSHELF:
+            b0 = A * ((A + 1) - (A - 1) * cw + sa); b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+            b2 = A * ((A + 1) - (A - 1) * cw - sa);
+            a0 = (A + 1) + (A - 1) * cw + sa; a1 = -2 * ((A - 1) + (A + 1) * cw);
+            a2 = (A + 1) + (A - 1) * cw - sa;
+            break;
+        case AUDIO_EQ_HIGHSHELF:
+            b0 = A * ((A + 1) + (A - 1) * cw + sa); b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+            b2 = A * ((A + 1) + (A - 1) * cw - sa);
+            a0 = (A + 1) - (A - 1) * cw + sa; a1 = 2 * ((A - 1) - (A + 1) * cw);
+            a2 = (A + 1) - (A - 1) * cw - sa;
+            break;
+        default:
+            return AUDIO_ERR_FORMAT;
+    }
+    const double c[5] = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+    int32_t *q[5] = { &f->b0, &f->b1, &f->b2, &f->a1, &f->a2 };
+    for (int i = 0; i < 5; i++) {
+        if (fabs(c[i]) >= (double)(INT32_MAX >> AUDIO_DSP_COEF_Q)) return AUDIO_ERR_FORMAT;
+        *q[i] = (int32_t)lrint(c[i] * (1 << AUDIO_DSP_COEF_Q));
+    }
+    return AUDIO_OK;
+}
+
+int audio_dsp_init(audio_dsp_t *d, const audio_dsp_config_t *cfg, uint32_t sample_rate) {
+    memset(d, 0, sizeof(*d));
+    if (cfg->num_bands > AUDIO_DSP_MAX_BANDS) return AUDIO_ERR_FORMAT;
+    for (size_t i = 0; i < cfg->num_bands; i++) {
+        if (design(&d->eq[i], &cfg->bands[i], sample_rate) != AUDIO_OK) {
+            AUDIO_LOGE(TAG, "EQ band %u (%.0f Hz) cannot be realized at %lu Hz", (unsigned)i,
+                       (double)cfg->bands[i].freq_hz, (unsigned long)sample_rate);
+            return AUDIO_ERR_FORMAT;
+        }
+    }
+    d->num_bands = cfg->num_bands;
+
+    // x2 undoes the EQ's half-scale headroom
+    float gain_db = cfg->gain_db < AUDIO_DSP_MAX_GAIN_DB ? cfg->gain_db : AUDIO_DSP_MAX_GAIN_DB;
+    long g = lrint(2 * pow(10, gain_db / 20) * PCM_GAIN_UNITY);
+    d->gain_max = g > PCM_GAIN_MAX ? PCM_GAIN_MAX : (int32_t)g;
+    float limit = cfg->limit_dbfs < 0 ? cfg->limit_dbfs : 0;
+    d->ceiling = (int32_t)lrint(INT16_MAX * pow(10, limit / 20));
+    double blocks = cfg->release_ms ? cfg->release_ms * 1e-3 * sample_rate / AUDIO_DSP_BLOCK : 1;
+    d->release_q15 = (int32_t)lrint((1 - exp(-1 / blocks)) * 32768);
+    if (d->release_q15 < 1) d->release_q15 = 1;
+    audio_dsp_reset(d);
+    return AUDIO_OK;
+}
+
+void audio_dsp_reset(audio_dsp_t *d) {
+    for (size_t i = 0; i < d->num_bands; i++) {
+        audio_biquad_t *f = &d->eq[i];
+        f->x1 = f->x2 = f->y1 = f->y2 = 0;
+    }
+    d->gain = d->gain_max;
+    d->has_pending = false;
+    d->fill = 0;
+    d->limited_blocks = 0;
+    d->cycles = 0;
+    d->samples = 0;
+}
+
+static inline int32_t biquad(audio_biquad_t *f, int32_t x) {
+    int64_t acc = (int64_t)f->b0 * x + (int64_t)f->b1 * f->x1 + (int64_t)f->b2 * f->x2 -
+                  (int64_t)f->a1 * f->y1 - (int64_t)f->a2 * f->y2;
+    int32_t y = (int32_t)((acc + (1 << (AUDIO_DSP_COEF_Q - 1))) >> AUDIO_DSP_COEF_Q);
+    f->x2 = f->x1;
+    f->x1 = x;
+    f->y2 = f->y1;
+    f->y1 = y;
+    return y;
+}
+
+// Highest gain that keeps every sample of a block under the ceiling
+static int32_t block_limit(const audio_dsp_t *d, const int16_t *block, size_t n) {
+    int32_t peak = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t a = block[i] < 0 ? -block[i] : block[i];
+        if (a > peak) peak = a;
+    }
+    if (peak == 0) return d->gain_max;
+    int32_t g = (int32_t)(((int64_t)d->ceiling << PCM_GAIN_Q) / peak);
+    return g < d->gain_max ? g : d->gain_max;
+}
+
+// Ramps the gain from where it stands to `target`, which never exceeds
+// what this block allows, and recovers towards the make-up gain only at
+// the release rate
+static void emit(audio_dsp_t *d, int16_t *block, size_t n, int32_t target, int16_t *out) {
+    if (target > d->gain) {
+        int32_t up = d->gain + (int32_t)(((int64_t)(d->gain_max - d->gain) * d->release_q15 + 32767) >> 15);
+        if (target > up) target = up;
+    }
+    pcm_gain_ramp_s16(block, n, d->gain, target);
+    if (target < d->gain_max) d->limited_blocks++;
+    d->gain = target;
+    memcpy(out, block, n * sizeof(int16_t));
+}
+
+size_t audio_dsp_process(audio_dsp_t *d, const int16_t *in, size_t frames, int16_t *out) {
+    uint32_t t0 = audio_cycles();
+    size_t produced = 0;
+    for (size_t i = 0; i < frames; i++) {
+        int32_t x = (int32_t)in[i] << AUDIO_DSP_STATE_Q;
+        for (size_t b = 0; b < d->num_bands; b++) x = biquad(&d->eq[b], x);
+        d->cur[d->fill++] = sat16((x + (1 << AUDIO_DSP_STATE_Q)) >> (AUDIO_DSP_STATE_Q + 1));
+        if (d->fill < AUDIO_DSP_BLOCK) continue;
+
+        // A block is out once its successor is known: look-ahead
+        int32_t req = block_limit(d, d->cur, AUDIO_DSP_BLOCK);
+        if (d->has_pending) {
+            emit(d, d->pending, AUDIO_DSP_BLOCK, req < d->req_pending ? req : d->req_pending, out + produced);
+            produced += AUDIO_DSP_BLOCK;
+        } else if (req < d->gain) {
+            d->gain = req;      // first block has no predecessor to ramp down in
+        }
+        memcpy(d->pending, d->cur, sizeof(d->cur));
+        d->req_pending = req;
+        d->has_pending = true;
+        d->fill = 0;
+    }
+    d->cycles += (uint32_t)(audio_cycles() - t0);
+    d->samples += frames;
+    return produced;
+}
+
+size_t audio_dsp_flush(audio_dsp_t *d, int16_t *out) {
+    size_t produced = 0;
+    int32_t req = block_limit(d, d->cur, d->fill);
+    if (d->has_pending) {
+        emit(d, d->pending, AUDIO_DSP_BLOCK, req < d->req_pending ? req : d->req_pending, out);
+        produced = AUDIO_DSP_BLOCK;
+    } else if (req < d->gain) {
+        d->gain = req;
+    }
+    if (d->fill) {
+        emit(d, d->cur, d->fill, req, out + produced);
+        produced += d->fill;
+    }
+    d->has_pending = false;
+    d->fill = 0;
+    return produced;
+}
+
+static int dsp_sink_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    audio_dsp_t *d = ctx;
+    const int16_t *in = buf;
+    size_t frames = len / sizeof(int16_t);
+    *written = 0;
+    while (frames > 0) {
+        size_t n = frames < AUDIO_DSP_CHUNK ? frames : AUDIO_DSP_CHUNK;
+        size_t produced = audio_dsp_process(d, in, n, d->out);
+        size_t out_written = 0;
+        if (produced && d->next.write(d->next.ctx, d->out, produced * sizeof(int16_t), &out_written) != 0) {
+            return -1;
+        }
+        in += n;
+        frames -= n;
+        *written += n * sizeof(int16_t);
+    }
+    return 0;
+}
+
+void audio_dsp_sink_bind(audio_dsp_t *d, const audio_sink_t *next, audio_sink_t *out) {
+    d->next = *next;
+    out->ctx = d;
+    out->write = dsp_sink_write;
+}
+
+int audio_dsp_sink_finish(audio_dsp_t *d) {
+    size_t produced = audio_dsp_flush(d, d->out);
+    size_t written = 0;
+    int rc = produced ? d->next.write(d->next.ctx, d->out, produced * sizeof(int16_t), &written) : 0;
+    AUDIO_LOGI(TAG, "%lu cycles/sample, limiter engaged on %lu of %lu blocks",
+               (unsigned long)audio_dsp_cycles_per_sample(d), (unsigned long)d->limited_blocks,
+               (unsigned long)(d->samples / AUDIO_DSP_BLOCK));
+    audio_dsp_reset(d);
+    return rc == 0 ? AUDIO_OK : AUDIO_ERR_IO;
+}
+
+uint32_t audio_dsp_cycles_per_sample(const audio_dsp_t *d) {
+    return d->samples ? (uint32_t)(d->cycles / d->samples) : 0;
+}
@@ -0,0 +1,224 @@
+#include <string.h>
+#include "audio_inline.h"
+
+static const char *TAG = "AUDIO_INLINE";
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void audio_inline_init(audio_inline_t *a, uint8_t *buf, size_t capacity, const audio_signal_t *signal) {
+    memset(a, 0, sizeof(*a));
+    a->buf = buf;
+    a->capacity = capacity;
+    a->signal = *signal;
+    audio_lock_init(&a->lock);
+}
+
+bool audio_inline_is_chunk(const uint8_t *data, size_t len) {
+    return len >= AUDIO_INLINE_HEADER_SIZE && data[0] == 'R' && data[1] == 'A' && data[2] == AUDIO_INLINE_VERSION;
+}
+
+bool audio_inline_parse_header(const uint8_t *data, size_t len, audio_inline_header_t *h) {
+    if (!audio_inline_is_chunk(data, len)) return false;
+    h->flags = data[3];
+    h->clip_id = get_le32(data + 4);
+    h->offset = get_le32(data + 8);
+    h->seq = (uint16_t)(data[12] | data[13] << 8);
+    return true;
+}
+
+void audio_inline_write_header(const audio_inline_header_t *h, uint8_t *out) {
+    out[0] = 'R';
+    out[1] = 'A';
+    out[2] = AUDIO_INLINE_VERSION;
+    out[3] = h->flags;
+    put_le32(out + 4, h->clip_id);
+    put_le32(out + 8, h->offset);
+    out[12] = (uint8_t)h->seq;
+    out[13] = (uint8_t)(h->seq >> 8);
+    out[14] = out[15] = 0;
+}
+
+bool audio_inline_begin(audio_inline_t *a, uint32_t id, uint32_t total, const uint8_t *sha256) {
+    if (total == 0 || total > a->capacity) return false;
+    audio_lock(&a->lock);
+    bool busy = a->claimed;
+    if (!busy) {
+        if (a->state == AUDIO_INLINE_RECEIVING || a->state == AUDIO_INLINE_COMPLETE) {
+            AUDIO_LOGW(TAG, "Clip %lu replaced before it played", (unsigned long)a->clip_id);
+        }
+        a->state = AUDIO_INLINE_RECEIVING;
+        a->clip_id = id;
+        a->total = total;
+        a->received = 0;
+        a->next_seq = 0;
+        a->in_chunk = false;
+        a->verify = sha256 != NULL;
+        if (a->verify) {
+            memcpy(a->digest, sha256, HMAC_SHA256_LEN);
+            sha256_start(&a->sha);
+        }
+        memset(&a->stats, 0, sizeof(a->stats));
+        a->stats.t_begin_us = audio_time_us();
+    }
+    audio_unlock(&a->lock);
+    return !busy;
+}
+
+// Called with the lock held
+static void fail(audio_inline_t *a, const char *why) {
+    AUDIO_LOGW(TAG, "Clip %lu failed at byte %lu of %lu: %s", (unsigned long)a->clip_id,
+               (unsigned long)a->received, (unsigned long)a->total, why);
+    a->state = AUDIO_INLINE_FAILED;
+    a->in_chunk = false;
+    a->stats.gaps++;
+}
+
+void audio_inline_feed(audio_inline_t *a, const uint8_t *data, size_t len, size_t offset, size_t msg_len) {
+    bool msg_done = offset + len >= msg_len;
+    audio_lock(&a->lock);
+    if (offset == 0) {
+        audio_inline_header_t h;
+        a->in_chunk = false;
+        if (!audio_inline_parse_header(data, len, &h)) {
+            audio_unlock(&a->lock);
+            return;
+        }
+        uint32_t payload = (uint32_t)(msg_len - AUDIO_INLINE_HEADER_SIZE);
+        if (a->state != AUDIO_INLINE_RECEIVING || h.clip_id != a->clip_id) {
+            a->stats.stale++;
+        } else if (h.seq < a->next_seq) {
+            a->stats.duplicates++;
+        } else if (h.seq != a->next_seq || h.offset != a->received || payload > a->total - a->received) {
+            fail(a, "chunk missing or out of order");
+        } else {
+            a->in_chunk = true;
+            a->in_last = h.flags & AUDIO_INLINE_FLAG_LAST;
+            if (!a->stats.t_first_chunk_us) a->stats.t_first_chunk_us = audio_time_us();
+        }
+        data += AUDIO_INLINE_HEADER_SIZE;
+        len -= AUDIO_INLINE_HEADER_SIZE;
+    }
+    if (!a->in_chunk || a->state != AUDIO_INLINE_RECEIVING) {
+        bool failed = a->state == AUDIO_INLINE_FAILED;
+        a->in_chunk = false;
+        audio_unlock(&a->lock);
+        if (failed) a->signal.signal(a->signal.ctx);
+        return;
+    }
+    // The reader never looks at or above `received`, so the copy needs no lock
+    uint32_t at = a->received;
+    audio_unlock(&a->lock);
+    memcpy(a->buf + at, data, len);
+    if (a->verify) sha256_update(&a->sha, data, len);
+
+    audio_lock(&a->lock);
+    if (a->in_chunk && a->state == AUDIO_INLINE_RECEIVING) {
+        a->received += (uint32_t)len;
+        if (msg_done) {
+            a->in_chunk = false;
+            a->next_seq++;
+            a->stats.chunks++;
+            if (a->received == a->total) {
+                uint8_t digest[HMAC_SHA256_LEN];
+                if (a->verify) sha256_finish(&a->sha, digest);
+                if (a->verify && memcmp(digest, a->digest, sizeof(digest)) != 0) {
+                    fail(a, "SHA-256 mismatch");
+                } else {
+                    a->state = AUDIO_INLINE_COMPLETE;
+                    a->stats.t_complete_us = audio_time_us();
+                }
+            } else if (a->in_last) {
+                fail(a, "last chunk before the end");
+            }
+        }
+    }
+    audio_unlock(&a->lock);
+    a->signal.signal(a->signal.ctx);
+}
+
+// ---- source over the buffer ----
+
+static int inline_open(void *ctx, const char *url) {
+    audio_inline_t *a = ctx;
+    return (int)a->total;
+}
+
+// Blocks until `len` bytes have arrived or the clip ends, like esp_http_client_read
+static int inline_read(void *ctx, uint8_t *buf, int len) {
+    audio_inline_t *a = ctx;
+    int total = 0;
+    while (total < len) {
+        audio_lock(&a->lock);
+        uint32_t avail = a->received - a->read_pos;
+        audio_inline_state_t state = a->state;
+        audio_unlock(&a->lock);
+        if (avail) {
+            uint32_t n = avail < (uint32_t)(len - total) ? avail : (uint32_t)(len - total);
+            memcpy(buf + total, a->buf + a->read_pos, n);
+            a->read_pos += n;
+            total += (int)n;
+            continue;
+        }
+        if (state == AUDIO_INLINE_COMPLETE) break;
+        if (state != AUDIO_INLINE_RECEIVING) return -1;
+        if (!a->signal.wait(a->signal.ctx, AUDIO_INLINE_STALL_MS)) {
+            audio_lock(&a->lock);
+            if (a->state == AUDIO_INLINE_RECEIVING && a->received == a->read_pos) fail(a, "no chunk in time");
+            audio_unlock(&a->lock);
+        }
+    }
+    return total;
+}
+
+static void inline_close(void *ctx) {
+    audio_inline_t *a = ctx;
+    audio_lock(&a->lock);
+    a->state = AUDIO_INLINE_IDLE;
+    a->claimed = false;
+    audio_unlock(&a->lock);
+}
+
+bool audio_inline_claim(audio_inline_t *a, uint32_t id, audio_source_t *out) {
+    audio_lock(&a->lock);
+    while (a->verify && !a->claimed && a->clip_id == id && a->state == AUDIO_INLINE_RECEIVING) {
+        uint32_t received = a->received;
+        audio_unlock(&a->lock);
+        bool woken = a->signal.wait(a->signal.ctx, AUDIO_INLINE_STALL_MS);
+        audio_lock(&a->lock);
+        if (!woken && a->clip_id == id && a->state == AUDIO_INLINE_RECEIVING && a->received == received) {
+            fail(a, "no chunk in time");
+        }
+    }
+    bool ok = !a->claimed && a->clip_id == id &&
+              (a->state == AUDIO_INLINE_RECEIVING || a->state == AUDIO_INLINE_COMPLETE);
+    if (ok) {
+        a->claimed = true;
+        a->read_pos = 0;
+    }
+    audio_unlock(&a->lock);
+    if (ok) {
+        *out = (audio_source_t) {
+            .ctx = a,
+            .open = inline_open,
+            .read = inline_read,
+            .close = inline_close,
+        };
+    }
+    return ok;
+}
+
+audio_inline_stats_t audio_inline_stats(audio_inline_t *a) {
+    audio_lock(&a->lock);
+    audio_inline_stats_t s = a->stats;
+    audio_unlock(&a->lock);
+    return s;
+}
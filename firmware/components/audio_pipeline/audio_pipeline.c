@@ -0,0 +1,546 @@
+#include <stdlib.h>
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "ima_adpcm.h"
+#include "pcm_convert.h"
+
+static const char *TAG = "AUDIO_PIPELINE";
+
+static uint32_t out_byte_rate(const audio_pipeline_t *p) {
+    return p->out_sample_rate * (p->out_bits_per_sample / 8);
+}
+
+// What the sink consumes per second, for the playback clock
+static uint32_t sink_byte_rate(const audio_pipeline_t *p) {
+    return p->sink_sample_rate ? p->sink_sample_rate * (uint32_t)sizeof(int16_t) : out_byte_rate(p);
+}
+
+static int64_t bytes_to_us(uint64_t bytes, uint32_t byte_rate) {
+    return byte_rate ? (int64_t)(bytes * 1000000 / byte_rate) : 0;
+}
+
+// Clip duration from the data chunk (or what is left of the body when the
+// chunk size is missing or a placeholder), and how much audio the ring can
+// take before the writer starts: a chunk of headroom for slot headers and
+// the wrap gap, plus the chunk in flight.
+static void setup_prefill(audio_pipeline_t *p) {
+    int body_left = p->stats.content_length - p->stats.bytes_processed;
+    if (p->prefill_min_ms == 0) p->prefill_min_ms = AUDIO_PREFILL_MIN_MS;
+    if (p->prefill_safety_pct == 0) p->prefill_safety_pct = AUDIO_PREFILL_SAFETY_PCT;
+    uint32_t data_bytes = p->wav.data_size;
+    if (body_left > 0 && (data_bytes == 0 || data_bytes > (uint32_t)body_left)) {
+        data_bytes = body_left;
+    }
+    uint32_t in_rate;
+    if (p->wav.format_tag == WAV_FORMAT_IMA_ADPCM) {
+        in_rate = (uint32_t)((uint64_t)p->wav.sample_rate * p->wav.block_align / p->wav.samples_per_block);
+    } else {
+        in_rate = p->wav.sample_rate * p->wav.num_channels * (p->wav.bits_per_sample / 8);
+    }
+
+    size_t cap = p->ring.capacity > 4 * AUDIO_CHUNK_BUFFER_SIZE
+        ? p->ring.capacity - 2 * AUDIO_CHUNK_BUFFER_SIZE : p->ring.capacity / 2;
+    p->prefill.total_us = bytes_to_us(data_bytes, in_rate);
+    p->prefill.min_us = (int64_t)p->prefill_min_ms * 1000;
+    p->prefill.max_us = bytes_to_us(cap, out_byte_rate(p));
+    p->prefill.rtt_us = p->stats.t_headers_us - p->stats.t_open_us;
+    p->prefill.safety_pct = (int)p->prefill_safety_pct;
+}
+
+int audio_pipeline_init(audio_pipeline_t *p) {
+    setup_prefill(p);
+    if (p->sink_sample_rate) {
+        if (!p->resampler || audio_resample_init(p->resampler, p->out_sample_rate, p->out_bits_per_sample,
+                                                 p->sink_sample_rate) != AUDIO_OK) {
+            AUDIO_LOGE(TAG, "Cannot convert %lu Hz to the %lu Hz output", (unsigned long)p->out_sample_rate,
+                       (unsigned long)p->sink_sample_rate);
+            return AUDIO_ERR_FORMAT;
+        }
+    }
+    if (p->zero_copy && (!p->ring.acquire || !p->ring.complete)) {
+        AUDIO_LOGW(TAG, "Ring has no acquire/complete, falling back to copying");
+        p->zero_copy = false;
+    }
+    bool compressed = p->wav.format_tag == WAV_FORMAT_IMA_ADPCM;
+    if (p->zero_copy && !compressed) {
+        // Reads land directly in ring slots; no staging buffers needed
+        return AUDIO_OK;
+    }
+
+    // 16-byte aligned so the SIMD conversion kernels take their fast path.
+    // The decoder always needs somewhere to put compressed blocks, but in
+    // zero-copy mode it decodes straight into ring slots.
+    if (!p->chunk_buffer) {
+        p->chunk_buffer = audio_alloc_aligned(AUDIO_CHUNK_BUFFER_SIZE);
+        p->owns_chunk_buffer = true;
+    }
+    if (!p->zero_copy && !p->mono_buffer) {
+        p->mono_buffer = audio_alloc_aligned(AUDIO_CHUNK_BUFFER_SIZE);
+        p->owns_mono_buffer = true;
+    }
+    if (!p->chunk_buffer || (!p->zero_copy && !p->mono_buffer)) {
+        AUDIO_LOGE(TAG, "Failed to allocate audio buffers!");
+        audio_pipeline_deinit(p);
+        return AUDIO_ERR_NO_MEM;
+    }
+    return AUDIO_OK;
+}
+
+void audio_pipeline_deinit(audio_pipeline_t *p) {
+    if (p->owns_chunk_buffer) {
+        free(p->chunk_buffer);
+        p->chunk_buffer = NULL;
+    }
+    if (p->owns_mono_buffer) {
+        free(p->mono_buffer);
+        p->mono_buffer = NULL;
+    }
+    p->owns_chunk_buffer = false;
+    p->owns_mono_buffer = false;
+}
+
+size_t audio_pipeline_output_bytes(const audio_pipeline_t *p) {
+    if (p->prefill.total_us <= 0) return 0;
+    // Round up to whole chunks: the last ADPCM block decodes to a full block
+    uint64_t bytes = (uint64_t)p->prefill.total_us * out_byte_rate(p) / 1000000;
+    return (size_t)(bytes + AUDIO_CHUNK_BUFFER_SIZE);
+}
+
+// Stamps the first body byte on its way to the header parser
+static int first_byte_read(void *ctx, uint8_t *buf, int len) {
+    audio_pipeline_t *p = ctx;
+    int n = p->source.read(p->source.ctx, buf, len);
+    if (n > 0 && p->stats.t_first_byte_us == 0) p->stats.t_first_byte_us = audio_time_us();
+    return n;
+}
+
+int audio_pipeline_open(audio_pipeline_t *p, const char *url) {
+    if (p->cancelled) return AUDIO_ERR_CANCELLED;
+    p->download_complete = false;
+    p->player_started = false;
+    memset(&p->stats, 0, sizeof(p->stats));
+    p->stats.t_open_us = audio_time_us();
+    int content_length = p->source.open(p->source.ctx, url);
+    if (content_length < 0) {
+        AUDIO_LOGE(TAG, "Failed to open audio source");
+        return AUDIO_ERR_IO;
+    }
+    p->stats.t_source_open_us = audio_time_us();
+    p->stats.content_length = content_length;
+    AUDIO_LOGI(TAG, "Streaming audio (%d bytes)...", content_length);
+
+    // Walk the RIFF header up to the start of the sample data
+    audio_source_t timed = { .ctx = p, .read = first_byte_read };
+    int header_len = wav_header_read(&timed, &p->wav);
+    if (header_len < 0) {
+        AUDIO_LOGE(TAG, "Failed to read WAV header");
+        return AUDIO_ERR_IO;
+    }
+    p->stats.bytes_processed = header_len;
+    p->stats.t_headers_us = audio_time_us();
+
+    AUDIO_LOGI(TAG, "WAV: %lu Hz, %u channels, %u bits, format 0x%04x", (unsigned long)p->wav.sample_rate,
+               (unsigned)p->wav.num_channels, (unsigned)p->wav.bits_per_sample, (unsigned)p->wav.format_tag);
+
+    if (!wav_format_supported(&p->wav)) {
+        AUDIO_LOGE(TAG, "Unsupported WAV format: %u-bit, %u channels (Only 16/32-bit PCM or IMA ADPCM, 1/2 channels supported)",
+                   (unsigned)p->wav.bits_per_sample, (unsigned)p->wav.num_channels);
+        return AUDIO_ERR_FORMAT;
+    }
+    p->out_sample_rate = p->wav.sample_rate;
+    p->out_bits_per_sample = wav_output_bits(&p->wav);
+    return AUDIO_OK;
+}
+
+static bool start_player(audio_pipeline_t *p) {
+    p->stats.t_prefill_us = audio_time_us();
+    if (!p->start_playback(p)) {
+        AUDIO_LOGE(TAG, "Failed to start playback!");
+        return false;
+    }
+    p->player_started = true;
+    return true;
+}
+
+// Start playback once enough audio is buffered. Nothing is consumed before
+// the writer starts, so the bytes pushed so far are the fill level (a
+// no-split ring's free size reports the largest item that fits, not the
+// free bytes).
+static bool check_prefill(audio_pipeline_t *p) {
+    if (p->player_started) return true;
+    uint32_t pushed = p->stats.bytes_pushed;
+    if (p->start_threshold) {
+        if (pushed < p->start_threshold) return true;
+        AUDIO_LOGI(TAG, "Buffer threshold reached, starting playback");
+    } else {
+        // Rate is measured from the request, not the header: the first body
+        // bytes usually arrive with the header segment and would make a slow
+        // link look instantaneous. A prefetched body counts the time it took.
+        int64_t buffered_us = bytes_to_us(pushed, out_byte_rate(p));
+        audio_prefill_estimate_t e = audio_prefill_estimate(&p->prefill, buffered_us,
+                                                            audio_time_us() - p->stats.t_open_us + p->prefetch_us);
+        if (buffered_us < e.required_us) return true;
+        p->stats.prefill_target_ms = (uint32_t)(e.required_us / 1000);
+        p->stats.rate_permille = e.rate_permille;
+        p->stats.predicted_underrun = e.predict_underrun;
+        AUDIO_LOGI(TAG, "Prefill %lu ms of %lu ms clip at %lu.%03lux real time, predicted underrun: %s",
+                   (unsigned long)(buffered_us / 1000), (unsigned long)(p->prefill.total_us / 1000),
+                   (unsigned long)(e.rate_permille / 1000), (unsigned long)(e.rate_permille % 1000),
+                   e.predict_underrun ? "yes" : "no");
+    }
+    p->stats.prefill_bytes = pushed;
+    return start_player(p);
+}
+
+// Account for a block about to be committed to the ring
+static void pushed(audio_pipeline_t *p, const void *pcm, size_t len) {
+    p->stats.bytes_pushed += len;
+    if (p->tap.write && len > 0) {
+        p->tap.write(p->tap.ctx, pcm, len);
+    }
+}
+
+// Copies a block into the ring; false once the ring refuses it
+static bool push_copy(audio_pipeline_t *p, const void *pcm, size_t len) {
+    pushed(p, pcm, len);
+    if (!p->ring.send(p->ring.ctx, pcm, len, AUDIO_WAIT_FOREVER)) {
+        AUDIO_LOGE(TAG, "Failed to send %u bytes to the ring", (unsigned)len);
+        return false;
+    }
+    p->stats.bytes_copied += len;
+    return true;
+}
+
+// Body bytes still in the data chunk: whatever follows it (LIST, id3) is
+// not audio. A missing or placeholder size reads to the end of the body.
+static uint32_t data_chunk_size(const audio_pipeline_t *p) {
+    return p->wav.data_size ? p->wav.data_size : UINT32_MAX;
+}
+
+static int read_limit(uint32_t remaining, int room) {
+    return remaining < (uint32_t)room ? (int)remaining : room;
+}
+
+// Interleaved stereo -> mono; dst may alias src.
+static void downmix(const wav_info_t *wav, void *dst, const void *src, int frames) {
+    if (wav->bits_per_sample == 16) {
+        pcm_downmix_s16(dst, src, frames);
+    } else if (wav->bits_per_sample == 32) {
+        pcm_downmix_s32(dst, src, frames);
+    }
+}
+
+static int download_copy(audio_pipeline_t *p) {
+    int sample_size = p->wav.bits_per_sample / 8;
+    int frame_size = sample_size * p->wav.num_channels;
+    int bytes_in_chunk = 0;
+    uint32_t remaining = data_chunk_size(p);
+
+    while (remaining > 0) {
+        if (p->cancelled) return AUDIO_ERR_CANCELLED;
+        int read_len = p->source.read(p->source.ctx, (uint8_t *)p->chunk_buffer + bytes_in_chunk,
+                                      read_limit(remaining, AUDIO_CHUNK_BUFFER_SIZE - bytes_in_chunk));
+        if (read_len < 0) return AUDIO_ERR_IO;
+        if (read_len == 0) break;
+        remaining -= read_len;
+
+        int total_len = read_len + bytes_in_chunk;
+        int frames = total_len / frame_size;
+        int bytes_to_process = frames * frame_size;
+
+        if (frames > 0) {
+            if (p->wav.num_channels == 2) {
+                downmix(&p->wav, p->mono_buffer, p->chunk_buffer, frames);
+                if (!push_copy(p, p->mono_buffer, frames * sample_size)) return AUDIO_ERR_IO;
+            } else {
+                if (!push_copy(p, p->chunk_buffer, bytes_to_process)) return AUDIO_ERR_IO;
+            }
+            p->stats.bytes_processed += bytes_to_process;
+
+            // Slide leftover bytes to the start of the buffer
+            bytes_in_chunk = total_len - bytes_to_process;
+            if (bytes_in_chunk > 0) {
+                memmove(p->chunk_buffer, p->chunk_buffer + bytes_to_process, bytes_in_chunk);
+                p->stats.bytes_copied += bytes_in_chunk;
+            }
+        } else {
+            bytes_in_chunk = total_len; // Just keep the partial frame for next read
+        }
+
+        if (!check_prefill(p)) return AUDIO_ERR_START;
+    }
+    return AUDIO_OK;
+}
+
+static int download_zero_copy(audio_pipeline_t *p) {
+    int sample_size = p->wav.bits_per_sample / 8;
+    int frame_size = sample_size * p->wav.num_channels;
+    uint8_t carry[8];   // partial frame left over from the previous read (< frame_size)
+    int carry_len = 0;
+    uint32_t remaining = data_chunk_size(p);
+
+    while (remaining > 0) {
+        if (p->cancelled) return AUDIO_ERR_CANCELLED;
+        void *slot;
+        if (!p->ring.acquire(p->ring.ctx, &slot, AUDIO_CHUNK_BUFFER_SIZE, AUDIO_WAIT_FOREVER)) {
+            AUDIO_LOGE(TAG, "Failed to acquire ring buffer slot");
+            return AUDIO_ERR_IO;
+        }
+        uint8_t *dst = slot;
+        if (carry_len > 0) {
+            memcpy(dst, carry, carry_len);
+            p->stats.bytes_copied += carry_len;
+        }
+
+        int read_len = p->source.read(p->source.ctx, dst + carry_len,
+                                      read_limit(remaining, AUDIO_CHUNK_BUFFER_SIZE - carry_len));
+        if (read_len <= 0) {
+            p->ring.complete(p->ring.ctx, slot, 0);
+            if (read_len < 0) return AUDIO_ERR_IO;
+            break;
+        }
+        remaining -= read_len;
+
+        int total_len = read_len + carry_len;
+        int frames = total_len / frame_size;
+        int bytes_to_process = frames * frame_size;
+
+        // Stash the trailing partial frame before the slot is committed
+        carry_len = total_len - bytes_to_process;
+        if (carry_len > 0) {
+            memcpy(carry, dst + bytes_to_process, carry_len);
+        }
+
+        size_t push_len = bytes_to_process;
+        if (p->wav.num_channels == 2) {
+            downmix(&p->wav, dst, dst, frames);
+            push_len = frames * sample_size;
+        }
+        pushed(p, dst, push_len);
+        p->ring.complete(p->ring.ctx, slot, push_len);
+        p->stats.bytes_processed += bytes_to_process;
+
+        if (!check_prefill(p)) return AUDIO_ERR_START;
+    }
+    return AUDIO_OK;
+}
+
+// IMA ADPCM: read one block at a time, decode (straight into a ring slot in
+// zero-copy mode), downmix and push 16-bit PCM.
+static int download_adpcm(audio_pipeline_t *p) {
+    uint16_t channels = p->wav.num_channels;
+    size_t block_align = p->wav.block_align;
+    size_t max_frames = ima_adpcm_block_samples(block_align, channels);
+    uint32_t remaining = data_chunk_size(p);
+
+    while (remaining > 0) {
+        if (p->cancelled) return AUDIO_ERR_CANCELLED;
+        int want = remaining < block_align ? (int)remaining : (int)block_align;
+        int read_len = p->source.read(p->source.ctx, (uint8_t *)p->chunk_buffer, want);
+        if (read_len < 0) return AUDIO_ERR_IO;
+        if (read_len == 0) break;
+        remaining -= read_len;
+
+        void *slot = NULL;
+        int16_t *pcm = (int16_t *)p->mono_buffer;
+        if (p->zero_copy) {
+            if (!p->ring.acquire(p->ring.ctx, &slot, max_frames * channels * sizeof(int16_t), AUDIO_WAIT_FOREVER)) {
+                AUDIO_LOGE(TAG, "Failed to acquire ring buffer slot");
+                return AUDIO_ERR_IO;
+            }
+            pcm = slot;
+        }
+
+        size_t frames = ima_adpcm_decode_block((const uint8_t *)p->chunk_buffer, read_len, channels, pcm);
+        if (channels == 2) {
+            pcm_downmix_s16(pcm, pcm, frames);
+        }
+        size_t push_len = frames * sizeof(int16_t);
+        if (p->zero_copy) {
+            pushed(p, pcm, push_len);
+            p->ring.complete(p->ring.ctx, slot, push_len);
+        } else if (push_len > 0 && !push_copy(p, pcm, push_len)) {
+            return AUDIO_ERR_IO;
+        }
+        p->stats.bytes_processed += read_len;
+
+        if (!check_prefill(p)) return AUDIO_ERR_START;
+    }
+    return AUDIO_OK;
+}
+
+int audio_pipeline_download(audio_pipeline_t *p) {
+    AUDIO_LOGI(TAG, "Buffering...");
+
+    int ret;
+    if (p->wav.format_tag == WAV_FORMAT_IMA_ADPCM) {
+        ret = download_adpcm(p);
+    } else {
+        ret = p->zero_copy ? download_zero_copy(p) : download_copy(p);
+    }
+
+    p->stats.t_complete_us = audio_time_us();
+    p->download_complete = true;
+
+    // If download finished but player never started (tiny file), start it now
+    if (!p->player_started && ret == AUDIO_OK) {
+        AUDIO_LOGI(TAG, "Tiny file, starting playback immediately");
+        p->stats.prefill_bytes = p->stats.bytes_pushed;
+        if (!start_player(p)) {
+            ret = AUDIO_ERR_START;
+        }
+    }
+
+    // Wake the writer once it has drained the ring. Without a writer nothing
+    // reads the ring, and the caller discards what is left in it.
+    if (p->player_started) {
+        p->ring.finish(p->ring.ctx);
+    }
+
+    if (ret == AUDIO_ERR_CANCELLED) {
+        AUDIO_LOGI(TAG, "Download cancelled after %d bytes", p->stats.bytes_processed);
+    } else {
+        AUDIO_LOGI(TAG, "Download complete (%d bytes)", p->stats.bytes_processed);
+    }
+    return ret;
+}
+
+void audio_pipeline_cancel(audio_pipeline_t *p) {
+    if (p->cancelled) return;
+    p->stats.t_cancel_us = audio_time_us();
+    p->cancelled = true;
+    if (p->sync) p->sync->cancelled = true;
+}
+
+// Hands `len` bytes of ring PCM to the sink, through the resampler when the
+// sink's format is fixed
+static void write_pcm(audio_pipeline_t *p, const audio_sink_t *sink, const void *pcm, size_t len) {
+    size_t bytes_written = 0;
+    if (p->sink_sample_rate) {
+        audio_resample_write(p->resampler, pcm, len / (p->out_bits_per_sample / 8), sink, &p->stats.bytes_written);
+    } else {
+        sink->write(sink->ctx, pcm, len, &bytes_written);
+        p->stats.bytes_written += bytes_written;
+    }
+}
+
+// Keeps the clip on the shared clock, block by block: frames off the start
+// to catch up, the last frame played twice or dropped for drift
+static void write_synced(audio_pipeline_t *p, const audio_sink_t *sink, const uint8_t *pcm, size_t len) {
+    size_t frame = p->out_bits_per_sample / 8;
+    while (len >= frame && !p->cancelled) {
+        size_t block = len < AUDIO_SYNC_BLOCK_FRAMES * frame ? len : AUDIO_SYNC_BLOCK_FRAMES * frame;
+        int32_t repeat;
+        size_t skip = audio_sync_block(p->sync, audio_time_us() - p->play_origin_us, (uint32_t)(block / frame),
+                                       &repeat) * frame;
+        size_t out = block - skip - (repeat < 0 ? frame : 0);
+        if (out) write_pcm(p, sink, pcm + skip, out);
+        if (repeat > 0) write_pcm(p, sink, pcm + block - frame, frame);
+        pcm += block;
+        len -= block;
+    }
+    p->stats.bytes_discarded += len;
+}
+
+// A ring item can hold seconds of audio: handed over in blocks, so a
+// cancel stops the writer within one
+static void write_blocks(audio_pipeline_t *p, const audio_sink_t *sink, const uint8_t *pcm, size_t len) {
+    size_t max = AUDIO_WRITE_BLOCK_FRAMES * (p->out_bits_per_sample / 8);
+    while (len > 0 && !p->cancelled) {
+        size_t block = len < max ? len : max;
+        write_pcm(p, sink, pcm, block);
+        pcm += block;
+        len -= block;
+    }
+    p->stats.bytes_discarded += len;
+}
+
+// Playback clock: audio handed to the sink runs out at now - play_origin.
+// A block arriving after that point means the sink starved; the clock is
+// then re-anchored so a single gap counts once.
+static void write_item(audio_pipeline_t *p, const audio_sink_t *sink, void *item, size_t item_size) {
+    if (item_size == 0 || p->cancelled) {
+        // Empty slot committed at end of stream, or a clip no longer wanted
+        p->stats.bytes_discarded += item_size;
+        p->ring.return_item(p->ring.ctx, item);
+        return;
+    }
+    // A scheduled start: wait for it before the first write, unsynchronized
+    // if the shared clock is not set
+    if (p->sync && p->stats.t_first_write_us == 0 && !audio_sync_start(p->sync, p->out_sample_rate)) {
+        p->sync = NULL;
+    }
+    int64_t now = audio_time_us();
+    int64_t written_us = bytes_to_us(p->stats.bytes_written, sink_byte_rate(p));
+    if (p->stats.t_first_write_us == 0) {
+        p->stats.t_first_write_us = now;
+        p->play_origin_us = now;
+    } else if (now - p->play_origin_us > written_us + AUDIO_UNDERRUN_SLACK_US) {
+        p->stats.underruns++;
+        p->stats.starved_ms += (uint32_t)((now - p->play_origin_us - written_us) / 1000);
+        p->play_origin_us = now - written_us;
+    }
+    if (p->sync) {
+        write_synced(p, sink, item, item_size);
+    } else {
+        write_blocks(p, sink, item, item_size);
+    }
+    p->stats.t_last_write_us = now;
+    p->ring.return_item(p->ring.ctx, item);
+}
+
+// How long the writer may wait for the ring before it has to fade out:
+// what the sink still has queued, less the guard
+static uint32_t conceal_wait_ms(const audio_pipeline_t *p) {
+    if (!p->conceal || p->stats.t_first_write_us == 0) return AUDIO_WAIT_FOREVER;
+    int64_t queued_us = bytes_to_us(p->stats.bytes_written, sink_byte_rate(p)) -
+                        (audio_time_us() - p->play_origin_us);
+    return queued_us > AUDIO_CONCEAL_GUARD_US ? (uint32_t)((queued_us - AUDIO_CONCEAL_GUARD_US) / 1000) : 0;
+}
+
+void audio_pipeline_write_loop(audio_pipeline_t *p, const audio_sink_t *sink) {
+    size_t item_size;
+    void *item;
+    audio_sink_t out = *sink;
+    if (p->conceal) {
+        uint16_t bits = p->sink_sample_rate ? 16 : p->out_bits_per_sample;
+        audio_conceal_bind(p->conceal, sink, p->sink_sample_rate ? p->sink_sample_rate : p->out_sample_rate, bits,
+                           &out);
+    }
+
+    // Blocks until data arrives, or with concealment until the sink is
+    // about to starve; NULL without a timeout once the download has
+    // finished the ring
+    bool faded = false;
+    for (;;) {
+        bool done = p->download_complete;
+        uint32_t wait = done || faded ? AUDIO_WAIT_FOREVER : conceal_wait_ms(p);
+        item = p->ring.receive(p->ring.ctx, &item_size, wait);
+        if (item) {
+            faded = false;
+            write_item(p, &out, item, item_size);
+            continue;
+        }
+        if (wait == AUDIO_WAIT_FOREVER) break;
+        // Empty ring: a stall unless the download just finished it
+        if (p->download_complete) continue;
+        audio_conceal_fade_out(p->conceal);
+        p->stats.concealed++;
+        faded = true;
+    }
+    if (p->cancelled) {
+        AUDIO_LOGI(TAG, "Cancelled, %lu bytes discarded", (unsigned long)p->stats.bytes_discarded);
+        return;
+    }
+    if (p->sink_sample_rate) {
+        audio_resample_finish(p->resampler, &out, &p->stats.bytes_written);
+    }
+    if (p->conceal) audio_conceal_finish(p->conceal);
+
+    if (p->stats.underruns || p->stats.predicted_underrun) {
+        AUDIO_LOGW(TAG, "Underruns: %lu, %lu ms starved, %lu concealed (predicted: %s)",
+                   (unsigned long)p->stats.underruns, (unsigned long)p->stats.starved_ms,
+                   (unsigned long)p->stats.concealed, p->stats.predicted_underrun ? "yes" : "no");
+    }
+}
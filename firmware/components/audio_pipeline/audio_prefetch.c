@@ -0,0 +1,85 @@
+#include <string.h>
+#include "audio_port.h"
+#include "audio_prefetch.h"
+
+static const char *TAG = "AUDIO_PREFETCH";
+
+void audio_prefetch_init(audio_prefetch_t *pf, uint8_t *buf, size_t capacity) {
+    memset(pf, 0, sizeof(*pf));
+    pf->buf = buf;
+    pf->capacity = capacity;
+    pf->length = -1;
+}
+
+int audio_prefetch_start(audio_prefetch_t *pf, const audio_source_t *inner, const char *url) {
+    audio_prefetch_init(pf, pf->buf, pf->capacity);
+    pf->inner = *inner;
+    int64_t t0 = audio_time_us();
+    pf->length = pf->inner.open(pf->inner.ctx, url);
+    pf->busy_us = audio_time_us() - t0;
+    if (pf->length < 0) {
+        pf->inner.close(pf->inner.ctx);
+        return pf->length;
+    }
+    pf->opened = true;
+    return pf->length;
+}
+
+int audio_prefetch_fill(audio_prefetch_t *pf) {
+    if (!pf->opened || pf->eof || pf->failed || pf->len == pf->capacity) return 0;
+    size_t want = pf->capacity - pf->len;
+    if (want > AUDIO_PREFETCH_READ_SIZE) want = AUDIO_PREFETCH_READ_SIZE;
+    int64_t t0 = audio_time_us();
+    int n = pf->inner.read(pf->inner.ctx, pf->buf + pf->len, (int)want);
+    pf->busy_us += audio_time_us() - t0;
+    if (n < 0) {
+        AUDIO_LOGW(TAG, "Read failed after %u bytes", (unsigned)pf->len);
+        pf->failed = true;
+        return n;
+    }
+    pf->len += n;
+    if (n == 0 || (pf->length > 0 && pf->len >= (size_t)pf->length)) pf->eof = true;
+    return n;
+}
+
+static int prefetch_open(void *ctx, const char *url) {
+    audio_prefetch_t *pf = ctx;
+    return pf->opened ? pf->length : -1;
+}
+
+// Buffer first, then the rest of the body, keeping read()'s block-until-len contract
+static int prefetch_read(void *ctx, uint8_t *buf, int len) {
+    audio_prefetch_t *pf = ctx;
+    int n = 0;
+    if (pf->off < pf->len) {
+        size_t avail = pf->len - pf->off;
+        n = (size_t)len < avail ? len : (int)avail;
+        memcpy(buf, pf->buf + pf->off, n);
+        pf->off += n;
+    }
+    if (n < len && !pf->eof) {
+        int m = pf->inner.read(pf->inner.ctx, buf + n, len - n);
+        if (m < 0) return n > 0 ? n : m;
+        n += m;
+    }
+    return n;
+}
+
+static void prefetch_close(void *ctx) {
+    audio_prefetch_abandon(ctx);
+}
+
+void audio_prefetch_bind(audio_prefetch_t *pf, audio_source_t *out) {
+    *out = (audio_source_t) {
+        .ctx = pf,
+        .open = prefetch_open,
+        .read = prefetch_read,
+        .close = prefetch_close,
+    };
+}
+
+void audio_prefetch_abandon(audio_prefetch_t *pf) {
+    if (!pf->opened) return;
+    pf->inner.close(pf->inner.ctx);
+    pf->opened = false;
+}
@@ -0,0 +1,28 @@
+#include "audio_prefill.h"
+
+audio_prefill_estimate_t audio_prefill_estimate(const audio_prefill_t *m, int64_t buffered_us, int64_t elapsed_us) {
+    audio_prefill_estimate_t e = { .required_us = m->min_us };
+    // Over less than a round trip the "rate" is just the size of the first
+    // TCP window, so pad the window by one RTT plus the jitter floor
+    elapsed_us = (elapsed_us > 0 ? elapsed_us : 0) + m->rtt_us + m->min_us + 1;
+    int64_t rate = buffered_us * 1000 / elapsed_us;   // permille of real time
+    e.rate_permille = rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+
+    if (m->total_us <= 0) {
+        // Unknown length: nothing to extrapolate from, fill half the ring
+        e.required_us = m->max_us / 2;
+    } else {
+        int64_t trusted = rate * m->safety_pct / 100;
+        if (trusted < 1000) {
+            e.required_us = m->total_us * (1000 - trusted) / 1000;
+        }
+    }
+
+    if (e.required_us < m->min_us) e.required_us = m->min_us;
+    if (m->total_us > 0 && e.required_us > m->total_us) e.required_us = m->total_us;
+    if (e.required_us > m->max_us) {
+        e.predict_underrun = true;
+        e.required_us = m->max_us;
+    }
+    return e;
+}
@@ -0,0 +1,124 @@
+#include <string.h>
+#include "audio_queue.h"
+
+static const char *TAG = "AUDIO_QUEUE";
+
+void audio_queue_init(audio_queue_t *q, audio_msg_t *slots, size_t capacity, audio_queue_policy_t policy) {
+    memset(q, 0, sizeof(*q));
+    q->slots = slots;
+    q->capacity = capacity;
+    q->policy = policy;
+    audio_lock_init(&q->lock);
+}
+
+static audio_msg_t *slot(audio_queue_t *q, size_t i) {
+    return &q->slots[(q->head + i) % q->capacity];
+}
+
+// Closes the gap left by slot i, keeping arrival order
+static void remove_at(audio_queue_t *q, size_t i) {
+    if (i == 0) {
+        q->head = (q->head + 1) % q->capacity;
+    } else {
+        for (; i + 1 < q->count; i++) memcpy(slot(q, i), slot(q, i + 1), sizeof(audio_msg_t));
+    }
+    q->count--;
+}
+
+// Oldest message of the highest priority
+static size_t highest(audio_queue_t *q) {
+    size_t best = 0;
+    for (size_t i = 1; i < q->count; i++) {
+        if (slot(q, i)->priority > slot(q, best)->priority) best = i;
+    }
+    return best;
+}
+
+// Oldest message of the lowest priority
+static size_t lowest(audio_queue_t *q) {
+    size_t worst = 0;
+    for (size_t i = 1; i < q->count; i++) {
+        if (slot(q, i)->priority < slot(q, worst)->priority) worst = i;
+    }
+    return worst;
+}
+
+static void copy_msg(audio_msg_t *dst, const audio_msg_t *src, int64_t now, uint32_t id) {
+    memcpy(dst, src, sizeof(*dst));
+    dst->url[AUDIO_MSG_URL_MAX - 1] = '\0';
+    dst->filename[AUDIO_CACHE_KEY_MAX - 1] = '\0';
+    dst->t_enqueued_us = now;
+    dst->id = id;
+}
+
+audio_queue_result_t audio_queue_push(audio_queue_t *q, const audio_msg_t *msg) {
+    if ((!msg->url[0] && !msg->inline_id) || q->capacity == 0) return AUDIO_QUEUE_REJECTED;
+    int64_t now = audio_time_us();
+    audio_queue_result_t result = AUDIO_QUEUE_QUEUED;
+
+    audio_lock(&q->lock);
+    if (q->policy == AUDIO_QUEUE_COALESCE && msg->filename[0]) {
+        for (size_t i = 0; i < q->count; i++) {
+            audio_msg_t *m = slot(q, i);
+            if (strcmp(m->filename, msg->filename) == 0) {
+                // Keep the original arrival time and id: the wait is the older message's
+                copy_msg(m, msg, m->t_enqueued_us, m->id);
+                q->stats.coalesced++;
+                audio_unlock(&q->lock);
+                return AUDIO_QUEUE_COALESCED;
+            }
+        }
+    }
+
+    if (q->count == q->capacity) {
+        q->stats.dropped++;
+        size_t victim = lowest(q);
+        if (msg->priority <= slot(q, victim)->priority &&
+            (q->policy == AUDIO_QUEUE_FIFO || msg->priority < slot(q, victim)->priority)) {
+            audio_unlock(&q->lock);
+            AUDIO_LOGW(TAG, "Queue full, dropping new message %s", msg->filename);
+            return AUDIO_QUEUE_REJECTED;
+        }
+        AUDIO_LOGW(TAG, "Queue full, dropping message %s", slot(q, victim)->filename);
+        remove_at(q, victim);
+        result = AUDIO_QUEUE_DISPLACED;
+    }
+
+    copy_msg(slot(q, q->count), msg, now, ++q->next_id);
+    q->count++;
+    q->stats.enqueued++;
+    q->stats.depth = (uint32_t)q->count;
+    if (q->stats.depth > q->stats.max_depth) q->stats.max_depth = q->stats.depth;
+    audio_unlock(&q->lock);
+    return result;
+}
+
+bool audio_queue_pop(audio_queue_t *q, audio_msg_t *out) {
+    audio_lock(&q->lock);
+    if (q->count == 0) {
+        audio_unlock(&q->lock);
+        return false;
+    }
+    size_t i = highest(q);
+    memcpy(out, slot(q, i), sizeof(*out));
+    remove_at(q, i);
+    q->stats.dequeued++;
+    q->stats.depth = (uint32_t)q->count;
+    audio_unlock(&q->lock);
+    return true;
+}
+
+bool audio_queue_peek(audio_queue_t *q, audio_msg_t *out) {
+    audio_lock(&q->lock);
+    bool got = q->count > 0;
+    if (got) memcpy(out, slot(q, highest(q)), sizeof(*out));
+    audio_unlock(&q->lock);
+    return got;
+}
+
+audio_queue_stats_t audio_queue_stats(audio_queue_t *q) {
+    audio_lock(&q->lock);
+    audio_queue_stats_t out = q->stats;
+    audio_unlock(&q->lock);
+    return out;
+}
@@ -0,0 +1,182 @@
+#include <math.h>
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_resample.h"
+#include "pcm_convert.h"
+
+#define HALF (AUDIO_RESAMPLE_TAPS / 2)
+#define PHASE_BITS 6    // log2(AUDIO_RESAMPLE_PHASES)
+#define KAISER_BETA 7.0 // ~70 dB stopband
+#define CUTOFF 0.90     // of the lower Nyquist frequency, leaving room for the transition band
+
+// Modified Bessel function of the first kind, order 0 (series)
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+// Sub-filter p of the table serves outputs p / PHASES of an input frame
+// past the frame at tap HALF - 1. Each is normalized to unity DC gain, so a
+// constant signal passes through exactly.
+static void build_coefs(audio_resampler_t *r, double cutoff) {
+    double norm = bessel_i0(KAISER_BETA);
+    for (int p = 0; p <= AUDIO_RESAMPLE_PHASES; p++) {
+        double phase = (double)p / AUDIO_RESAMPLE_PHASES;
+        double h[AUDIO_RESAMPLE_TAPS];
+        double sum = 0;
+        for (int k = 0; k < AUDIO_RESAMPLE_TAPS; k++) {
+            double x = k - (HALF - 1) - phase;
+            double t = x / HALF;
+            double w = t * t < 1.0 ? bessel_i0(KAISER_BETA * sqrt(1.0 - t * t)) / norm : 0.0;
+            double s = x == 0 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            h[k] = cutoff * s * w;
+            sum += h[k];
+        }
+        int total = 0;
+        for (int k = 0; k < AUDIO_RESAMPLE_TAPS; k++) {
+            r->coef[p][k] = (int16_t)lrint(h[k] / sum * (1 << AUDIO_RESAMPLE_COEF_Q));
+            total += r->coef[p][k];
+        }
+        // Rounding residue goes to the largest tap so the sum is exact
+        r->coef[p][phase < 0.5 ? HALF - 1 : HALF] += (int16_t)((1 << AUDIO_RESAMPLE_COEF_Q) - total);
+    }
+}
+
+int audio_resample_init(audio_resampler_t *r, uint32_t in_rate, uint16_t in_bits, uint32_t out_rate) {
+    if (in_rate == 0 || out_rate == 0 || in_rate > 8 * out_rate || out_rate > 8 * in_rate ||
+        (in_bits != 16 && in_bits != 32)) {
+        return AUDIO_ERR_FORMAT;
+    }
+    bool same_filter = r->in_rate == in_rate && r->out_rate == out_rate;
+    r->in_bits = in_bits;
+    r->passthrough = in_rate == out_rate;
+    // Rounded up: never an extra output at the end of a stream
+    r->step = (((uint64_t)in_rate << 32) + out_rate - 1) / out_rate;
+    // Half a window of silence ahead of the first frame puts it under the
+    // filter's centre for output 0
+    memset(r->hist, 0, sizeof(r->hist));
+    r->hist_len = HALF - 1;
+    r->pos = 0;
+    if (!same_filter && !r->passthrough) {
+        double ratio = (double)out_rate / in_rate;
+        build_coefs(r, CUTOFF * (ratio < 1.0 ? ratio : 1.0));
+    }
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    return AUDIO_OK;
+}
+
+size_t audio_resample_max_out(const audio_resampler_t *r, size_t in_frames) {
+    if (r->passthrough) return in_frames;
+    return (size_t)((uint64_t)in_frames * r->out_rate / r->in_rate) + 2;
+}
+
+static inline int16_t filter(const audio_resampler_t *r) {
+    const int16_t *x = &r->hist[r->pos >> 32];
+    uint32_t frac = (uint32_t)r->pos;
+    const int16_t *c0 = r->coef[frac >> (32 - PHASE_BITS)];
+    const int16_t *c1 = c0 + AUDIO_RESAMPLE_TAPS;
+    int32_t a0 = 0, a1 = 0;
+    for (int k = 0; k < AUDIO_RESAMPLE_TAPS; k++) {
+        a0 += x[k] * c0[k];
+        a1 += x[k] * c1[k];
+    }
+    // Blend the two phases by the remaining fraction, Q15
+    int32_t f = (int32_t)((frac >> (32 - PHASE_BITS - 15)) & 0x7FFF);
+    int64_t v = ((int64_t)a0 * (32768 - f) + (int64_t)a1 * f + (1 << (14 + AUDIO_RESAMPLE_COEF_Q))) >>
+                (15 + AUDIO_RESAMPLE_COEF_Q);
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+static void load(int16_t *dst, const void *in, size_t offset, size_t n, uint16_t bits) {
+    if (bits == 16) {
+        memcpy(dst, (const int16_t *)in + offset, n * sizeof(int16_t));
+    } else {
+        pcm_narrow_s32_to_s16(dst, (const int32_t *)in + offset, n);
+    }
+}
+
+size_t audio_resample_process(audio_resampler_t *r, const void *in, size_t frames, int16_t *out) {
+    if (r->passthrough) {
+        load(out, in, 0, frames, r->in_bits);
+        return frames;
+    }
+    size_t produced = 0, taken = 0;
+    while (taken < frames) {
+        size_t n = sizeof(r->hist) / sizeof(r->hist[0]) - r->hist_len;
+        if (n > frames - taken) n = frames - taken;
+        load(r->hist + r->hist_len, in, taken, n, r->in_bits);
+        r->hist_len += n;
+        taken += n;
+
+        while ((size_t)(r->pos >> 32) + AUDIO_RESAMPLE_TAPS <= r->hist_len) {
+            out[produced++] = filter(r);
+            r->pos += r->step;
+        }
+        // Slide the window: keep what the next output still needs
+        size_t drop = (size_t)(r->pos >> 32);
+        if (drop > r->hist_len) drop = r->hist_len;
+        memmove(r->hist, r->hist + drop, (r->hist_len - drop) * sizeof(r->hist[0]));
+        r->hist_len -= drop;
+        r->pos -= (uint64_t)drop << 32;
+    }
+    return produced;
+}
+
+size_t audio_resample_flush(audio_resampler_t *r, int16_t *out) {
+    if (r->passthrough) return 0;
+    static const int16_t silence[HALF + 1];
+    // Outputs centred before the end of the input are still owed; the pad
+    // of silence gives their windows something to cover
+    uint64_t end = (uint64_t)(r->hist_len - (HALF - 1)) << 32;
+    size_t owed = end > r->pos ? (size_t)((end - r->pos + r->step - 1) / r->step) : 0;
+    int16_t tail[AUDIO_RESAMPLE_FLUSH_MAX];
+    r->in_bits = 16;
+    size_t n = audio_resample_process(r, silence, HALF + 1, tail);
+    if (n > owed) n = owed;
+    memcpy(out, tail, n * sizeof(tail[0]));
+    return n;
+}
+
+int audio_resample_write(audio_resampler_t *r, const void *in, size_t frames, const audio_sink_t *sink,
+                         uint32_t *bytes_written) {
+    size_t frame_bytes = r->in_bits / 8;
+    if (r->passthrough && r->in_bits == 16) {
+        size_t written = 0;
+        int rc = sink->write(sink->ctx, in, frames * frame_bytes, &written);
+        *bytes_written += written;
+        return rc == 0 ? AUDIO_OK : AUDIO_ERR_IO;
+    }
+    // Pieces small enough that their output fits the staging buffer
+    size_t piece = (size_t)((uint64_t)(AUDIO_RESAMPLE_OUT - 2) * r->in_rate / r->out_rate);
+    if (piece > AUDIO_RESAMPLE_OUT) piece = AUDIO_RESAMPLE_OUT;
+    const uint8_t *src = in;
+    while (frames > 0) {
+        size_t n = frames < piece ? frames : piece;
+        size_t produced = audio_resample_process(r, src, n, r->out);
+        src += n * frame_bytes;
+        frames -= n;
+        if (produced == 0) continue;
+        size_t written = 0;
+        int rc = sink->write(sink->ctx, r->out, produced * sizeof(int16_t), &written);
+        *bytes_written += written;
+        if (rc != 0) return AUDIO_ERR_IO;
+    }
+    return AUDIO_OK;
+}
+
+int audio_resample_finish(audio_resampler_t *r, const audio_sink_t *sink, uint32_t *bytes_written) {
+    size_t produced = audio_resample_flush(r, r->out);
+    if (produced == 0) return AUDIO_OK;
+    size_t written = 0;
+    int rc = sink->write(sink->ctx, r->out, produced * sizeof(int16_t), &written);
+    *bytes_written += written;
+    return rc == 0 ? AUDIO_OK : AUDIO_ERR_IO;
+}
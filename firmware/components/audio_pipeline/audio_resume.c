@@ -0,0 +1,114 @@
+#include "audio_resume.h"
+#include "audio_port.h"
+
+static const char *TAG = "AUDIO_RESUME";
+
+static int resume_open(void *ctx, const char *url) {
+    audio_resume_t *r = ctx;
+    r->url = url;
+    r->offset = 0;
+    r->resumes = r->retries = r->skipped = r->stalled_ms = 0;
+    r->length = r->inner.open(r->inner.ctx, url);
+    return r->length;
+}
+
+// Reads and drops the bytes between where a reopened body starts and the offset
+static bool skip_to_offset(audio_resume_t *r, uint32_t start) {
+    uint8_t scratch[256];
+    while (start < r->offset) {
+        uint32_t want = r->offset - start;
+        int n = r->inner.read(r->inner.ctx, scratch, want < sizeof(scratch) ? (int)want : (int)sizeof(scratch));
+        if (n <= 0) return false;
+        start += n;
+        r->skipped += n;
+    }
+    return true;
+}
+
+// Sleeps in slices so a cancel is seen within a few ms; false once cancelled
+#define CANCEL_SLICE_MS 10
+
+static bool backoff_sleep(const audio_resume_t *r, uint32_t ms) {
+    if (!r->cfg.cancelled) {
+        audio_sleep_ms(ms);
+        return true;
+    }
+    while (!*r->cfg.cancelled && ms > 0) {
+        uint32_t slice = ms < CANCEL_SLICE_MS ? ms : CANCEL_SLICE_MS;
+        audio_sleep_ms(slice);
+        ms -= slice;
+    }
+    return !*r->cfg.cancelled;
+}
+
+static bool reconnect(audio_resume_t *r) {
+    if (!r->inner.open_range || r->cfg.max_retries == 0) return false;
+    int64_t t0 = audio_time_us();
+    uint32_t backoff = r->cfg.backoff_ms;
+    while (r->retries < r->cfg.max_retries) {
+        if (r->cfg.deadline_us && audio_time_us() + (int64_t)backoff * 1000 >= r->cfg.deadline_us) {
+            AUDIO_LOGW(TAG, "URL expires before the next attempt, giving up at byte %lu",
+                       (unsigned long)r->offset);
+            return false;
+        }
+        if (!backoff_sleep(r, backoff)) return false;
+        backoff = backoff * 2 > r->cfg.max_backoff_ms ? r->cfg.max_backoff_ms : backoff * 2;
+        r->retries++;
+
+        r->inner.close(r->inner.ctx);
+        uint32_t start = 0;
+        int len = r->inner.open_range(r->inner.ctx, r->url, r->offset, &start);
+        if (len < 0 || start > r->offset || (r->length > 0 && len != r->length - (int)start) ||
+            !skip_to_offset(r, start)) {
+            AUDIO_LOGW(TAG, "Resume attempt %lu at byte %lu failed", (unsigned long)r->retries,
+                       (unsigned long)r->offset);
+            continue;
+        }
+        r->resumes++;
+        uint32_t ms = (uint32_t)((audio_time_us() - t0) / 1000);
+        r->stalled_ms += ms;
+        AUDIO_LOGI(TAG, "Resumed at byte %lu after %lu ms%s", (unsigned long)r->offset, (unsigned long)ms,
+                   start < r->offset ? " (server ignored the range)" : "");
+        return true;
+    }
+    AUDIO_LOGE(TAG, "Giving up at byte %lu after %lu attempts", (unsigned long)r->offset,
+               (unsigned long)r->retries);
+    return false;
+}
+
+// Fills `len` across a resume too, keeping read()'s block-until-len contract
+static int resume_read(void *ctx, uint8_t *buf, int len) {
+    audio_resume_t *r = ctx;
+    int total = 0;
+    while (total < len) {
+        int n = r->inner.read(r->inner.ctx, buf + total, len - total);
+        if (n > 0) {
+            r->offset += n;
+            total += n;
+            continue;
+        }
+        // Without a length (chunked) a clean end of body cannot be told from a cut one
+        if (n == 0 && (r->length <= 0 || r->offset >= (uint32_t)r->length)) break;
+        AUDIO_LOGW(TAG, "Body %s at byte %lu of %d", n < 0 ? "read failed" : "ended early",
+                   (unsigned long)r->offset, r->length);
+        if (!reconnect(r)) return -1;
+    }
+    return total;
+}
+
+static void resume_close(void *ctx) {
+    audio_resume_t *r = ctx;
+    r->inner.close(r->inner.ctx);
+}
+
+void audio_resume_bind(audio_resume_t *r, const audio_source_t *inner, const audio_resume_config_t *cfg,
+                       audio_source_t *out) {
+    r->inner = *inner;
+    r->cfg = *cfg;
+    *out = (audio_source_t) {
+        .ctx = r,
+        .open = resume_open,
+        .read = resume_read,
+        .close = resume_close,
+    };
+}
@@ -0,0 +1,194 @@
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_spsc.h"
+
+// Readiness checks before a side sleeps: a few microseconds, worth it with
+// the two sides on different cores
+#define AUDIO_SPSC_SPIN 100
+
+// Orders: each side publishes its index with a sequentially consistent
+// store, then reads (and clears) the other side's waiting flag; a side about
+// to sleep sets its flag, then reads the other index the same way. One of
+// the two always sees the other, so a wake-up is never lost. Everything
+// else is relaxed, owned by one side.
+
+int audio_spsc_init(audio_spsc_t *r, uint8_t *buf, size_t capacity, const audio_signal_t *readable,
+                    const audio_signal_t *writable) {
+    if (capacity < 2 || capacity > UINT32_MAX / 2 + 1 || (capacity & (capacity - 1))) return AUDIO_ERR_FORMAT;
+    memset(r, 0, sizeof(*r));
+    atomic_init(&r->head, 0);
+    atomic_init(&r->gap_at, 0);
+    atomic_init(&r->writer_waiting, false);
+    atomic_init(&r->finished, false);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->reader_waiting, false);
+    r->buf = buf;
+    r->capacity = (uint32_t)capacity;
+    r->mask = (uint32_t)capacity - 1;
+    r->readable = *readable;
+    r->writable = *writable;
+    return AUDIO_OK;
+}
+
+// Sleeps on `sig` until ready() holds or the timeout passes, after a short
+// spin: the other side is often a block away from making it ready, and a
+// sleep and wake-up cost far more than a block
+static bool wait_for(audio_spsc_t *r, atomic_bool *waiting, const audio_signal_t *sig, uint32_t timeout_ms,
+                     bool (*ready)(audio_spsc_t *r, size_t arg), size_t arg) {
+    for (int i = 0; i < AUDIO_SPSC_SPIN; i++) {
+        if (ready(r, arg)) return true;
+        if (timeout_ms == 0) return false;
+    }
+    int64_t deadline_us = audio_time_us() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        if (ready(r, arg)) return true;
+        uint32_t wait_ms = timeout_ms;
+        if (timeout_ms != AUDIO_WAIT_FOREVER) {
+            int64_t left_us = deadline_us - audio_time_us();
+            if (left_us <= 0) return false;
+            wait_ms = (uint32_t)((left_us + 999) / 1000);
+        }
+        atomic_store(waiting, true);
+        if (!ready(r, arg)) sig->wait(sig->ctx, wait_ms);
+        atomic_store_explicit(waiting, false, memory_order_relaxed);
+    }
+}
+
+// Clears the flag it acts on, so a waiter is signalled once per wait
+static void wake(atomic_bool *waiting, const audio_signal_t *sig) {
+    if (atomic_load(waiting) && atomic_exchange(waiting, false)) sig->signal(sig->ctx);
+}
+
+// ---- producer ----
+
+// Where a `len`-byte slot goes: at head when it fits before the end of
+// storage, else at the start of the next lap. Whether there is room yet.
+static bool slot_free(audio_spsc_t *r, size_t len) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t free_bytes = r->capacity - (head - atomic_load(&r->tail));
+    uint32_t to_end = r->capacity - (head & r->mask);
+    if (to_end >= len) {
+        r->slot = head;
+        return free_bytes >= len;
+    }
+    r->slot = head + to_end;
+    return free_bytes >= to_end + len;
+}
+
+static bool spsc_acquire(void *ctx, void **slot, size_t len, uint32_t timeout_ms) {
+    audio_spsc_t *r = ctx;
+    // Half the storage always fits in an empty ring, on one side of the end or the other
+    if (len > r->capacity / 2) return false;
+    if (!wait_for(r, &r->writer_waiting, &r->writable, timeout_ms, slot_free, len)) return false;
+    *slot = r->buf + (r->slot & r->mask);
+    return true;
+}
+
+// An empty slot publishes nothing, not even the gap it would have skipped
+static void spsc_complete(void *ctx, void *slot, size_t used) {
+    audio_spsc_t *r = ctx;
+    if (used == 0) return;
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (r->slot != head) atomic_store_explicit(&r->gap_at, head, memory_order_relaxed);
+    atomic_store(&r->head, r->slot + (uint32_t)used);
+    wake(&r->reader_waiting, &r->readable);
+}
+
+static bool spsc_send(void *ctx, const void *data, size_t len, uint32_t timeout_ms) {
+    void *slot;
+    if (!spsc_acquire(ctx, &slot, len, timeout_ms)) return false;
+    memcpy(slot, data, len);
+    spsc_complete(ctx, slot, len);
+    return true;
+}
+
+static void spsc_finish(void *ctx) {
+    audio_spsc_t *r = ctx;
+    atomic_store(&r->finished, true);
+    r->readable.signal(r->readable.ctx);
+}
+
+// ---- consumer ----
+
+// Readable bytes at tail, up to the end of storage or a skipped gap; a gap
+// the tail has reached is released first. A gap always lies in the tail's
+// lap: the producer cannot skip to the next one before the tail is in it.
+static uint32_t span(audio_spsc_t *r) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load(&r->head);
+    uint32_t to_end = r->capacity - (tail & r->mask);
+    if (head - tail <= to_end) return head - tail;
+    uint32_t gap = atomic_load_explicit(&r->gap_at, memory_order_relaxed);
+    if ((gap & r->mask) == 0) return to_end;
+    if (gap != tail) return gap - tail;
+    atomic_store_explicit(&r->gap_at, 0, memory_order_relaxed);
+    tail += to_end;
+    atomic_store(&r->tail, tail);
+    wake(&r->writer_waiting, &r->writable);
+    return head - tail;
+}
+
+// finished is read before head: once it is seen, so is the last block
+static bool readable(audio_spsc_t *r, size_t unused) {
+    bool finished = atomic_load(&r->finished);
+    return span(r) > 0 || finished;
+}
+
+static void *spsc_receive(void *ctx, size_t *len, uint32_t timeout_ms) {
+    audio_spsc_t *r = ctx;
+    if (!wait_for(r, &r->reader_waiting, &r->readable, timeout_ms, readable, 0)) return NULL;
+    uint32_t n = span(r);
+    if (n == 0) return NULL;
+    r->outstanding = n;
+    *len = n;
+    return r->buf + (atomic_load_explicit(&r->tail, memory_order_relaxed) & r->mask);
+}
+
+static void spsc_return_item(void *ctx, void *item) {
+    audio_spsc_t *r = ctx;
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store(&r->tail, tail + r->outstanding);
+    r->outstanding = 0;
+    wake(&r->writer_waiting, &r->writable);
+}
+
+// ---- either side ----
+
+// Head before tail: a tail read later can only be further on, never past
+// the head it is compared with by more than that
+static uint32_t used_at(const audio_spsc_t *r, uint32_t *head) {
+    *head = atomic_load((atomic_uint *)&r->head);
+    uint32_t used = *head - atomic_load((atomic_uint *)&r->tail);
+    return (int32_t)used < 0 ? 0 : used;
+}
+
+size_t audio_spsc_used(const audio_spsc_t *r) {
+    uint32_t head;
+    return used_at(r, &head);
+}
+
+// The largest slot acquire() would hand out now
+static size_t spsc_free_size(void *ctx) {
+    audio_spsc_t *r = ctx;
+    uint32_t head;
+    uint32_t free_bytes = r->capacity - used_at(r, &head);
+    uint32_t to_end = r->capacity - (head & r->mask);
+    uint32_t largest = free_bytes;
+    if (free_bytes > to_end) largest = to_end > free_bytes - to_end ? to_end : free_bytes - to_end;
+    return largest < r->capacity / 2 ? largest : r->capacity / 2;
+}
+
+void audio_spsc_bind(audio_spsc_t *r, audio_ring_t *out) {
+    atomic_store(&r->finished, false);
+    *out = (audio_ring_t) {
+        .ctx = r,
+        .capacity = r->capacity,
+        .send = spsc_send,
+        .acquire = spsc_acquire,
+        .complete = spsc_complete,
+        .finish = spsc_finish,
+        .receive = spsc_receive,
+        .return_item = spsc_return_item,
+        .free_size = spsc_free_size,
+    };
+}
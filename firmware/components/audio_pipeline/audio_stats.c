@@ -0,0 +1,114 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "audio_stats.h"
+
+void audio_fill_hist_init(audio_fill_hist_t *h) {
+    memset(&h->counts, 0, sizeof(h->counts));
+    audio_lock_init(&h->lock);
+}
+
+void audio_fill_hist_add(audio_fill_hist_t *h, size_t used, size_t capacity) {
+    if (capacity == 0) return;
+    if (used > capacity) used = capacity;
+    uint32_t permille = (uint32_t)((uint64_t)used * 1000 / capacity);
+    // A full ring counts in the top bucket
+    size_t bucket = (size_t)((uint64_t)used * AUDIO_STATS_FILL_BUCKETS / capacity);
+    if (bucket >= AUDIO_STATS_FILL_BUCKETS) bucket = AUDIO_STATS_FILL_BUCKETS - 1;
+    audio_lock(&h->lock);
+    h->counts.counts[bucket]++;
+    if (permille > h->counts.max_permille) h->counts.max_permille = permille;
+    audio_unlock(&h->lock);
+}
+
+audio_fill_counts_t audio_fill_hist_take(audio_fill_hist_t *h) {
+    audio_lock(&h->lock);
+    audio_fill_counts_t out = h->counts;
+    memset(&h->counts, 0, sizeof(h->counts));
+    audio_unlock(&h->lock);
+    return out;
+}
+
+// Same bounded appends as audio_trace.c: `*pos` goes past `len` once anything is cut
+static void put(char *buf, size_t len, size_t *pos, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(*pos < len ? buf + *pos : NULL, *pos < len ? len - *pos : 0, fmt, ap);
+    va_end(ap);
+    *pos += n > 0 ? (size_t)n : 0;
+}
+
+static void put_string(char *buf, size_t len, size_t *pos, const char *s) {
+    put(buf, len, pos, "\"");
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put(buf, len, pos, "\\%c", c);
+        } else if (c < 0x20) {
+            put(buf, len, pos, "\\u%04x", c);
+        } else {
+            put(buf, len, pos, "%c", c);
+        }
+    }
+    put(buf, len, pos, "\"");
+}
+
+// Per mille as a percentage with one decimal, null when not measured
+static void put_permille(char *buf, size_t len, size_t *pos, int32_t permille) {
+    if (permille < 0) {
+        put(buf, len, pos, "null");
+    } else {
+        put(buf, len, pos, "%ld.%ld", (long)(permille / 10), (long)(permille % 10));
+    }
+}
+
+static void put_heap(char *buf, size_t len, size_t *pos, const char *key, const audio_stats_heap_t *h) {
+    put(buf, len, pos, "\"%s\":[%lu,%lu,%lu]", key, (unsigned long)h->free, (unsigned long)h->min_free,
+        (unsigned long)h->largest);
+}
+
+int audio_stats_format(const audio_stats_t *s, char *buf, size_t len) {
+    size_t pos = 0;
+    put(buf, len, &pos, "{\"seq\":%lu,\"uptime_s\":%lu,\"interval_ms\":%lu,\"cpu\":[", (unsigned long)s->seq,
+        (unsigned long)s->uptime_s, (unsigned long)s->interval_ms);
+    for (int i = 0; i < AUDIO_STATS_MAX_CORES; i++) {
+        if (i) put(buf, len, &pos, ",");
+        put_permille(buf, len, &pos, s->core_busy_permille[i]);
+    }
+    put(buf, len, &pos, "],\"tasks\":[");
+    for (size_t i = 0; i < s->task_count && i < AUDIO_STATS_MAX_TASKS; i++) {
+        const audio_stats_task_t *t = &s->tasks[i];
+        put(buf, len, &pos, "%s{\"name\":", i ? "," : "");
+        put_string(buf, len, &pos, t->name);
+        if (t->core < 0) {
+            put(buf, len, &pos, ",\"core\":null,\"cpu\":");
+        } else {
+            put(buf, len, &pos, ",\"core\":%d,\"cpu\":", t->core);
+        }
+        put_permille(buf, len, &pos, t->cpu_permille);
+        put(buf, len, &pos, ",\"stack_free\":%lu}", (unsigned long)t->stack_free);
+    }
+    put(buf, len, &pos, "],\"heap\":{");
+    put_heap(buf, len, &pos, "internal", &s->internal);
+    put(buf, len, &pos, ",");
+    put_heap(buf, len, &pos, "psram", &s->psram);
+    put(buf, len, &pos, ",");
+    put_heap(buf, len, &pos, "dma", &s->dma);
+    put(buf, len, &pos, "},\"ring\":{\"kb\":%lu,\"fill\":[", (unsigned long)s->ring_kb);
+    for (int i = 0; i < AUDIO_STATS_FILL_BUCKETS; i++) {
+        put(buf, len, &pos, "%s%lu", i ? "," : "", (unsigned long)s->ring_fill.counts[i]);
+    }
+    put(buf, len, &pos, "],\"max_pct\":");
+    put_permille(buf, len, &pos, (int32_t)s->ring_fill.max_permille);
+    put(buf, len, &pos, "},\"queue\":{\"depth\":%lu,\"max\":%lu,\"dropped\":%lu}", (unsigned long)s->queue_depth,
+        (unsigned long)s->queue_max_depth, (unsigned long)s->queue_dropped);
+    if (s->rssi == 0) {
+        put(buf, len, &pos, ",\"rssi\":null");
+    } else {
+        put(buf, len, &pos, ",\"rssi\":%d", s->rssi);
+    }
+    put(buf, len, &pos, ",\"mqtt\":{\"connects\":%lu,\"disconnects\":%lu},\"messages\":%lu,\"underruns\":%lu}",
+        (unsigned long)s->mqtt_connects, (unsigned long)s->mqtt_disconnects, (unsigned long)s->messages,
+        (unsigned long)s->underruns);
+    return pos < len ? (int)pos : -1;
+}
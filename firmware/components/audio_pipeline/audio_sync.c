@@ -0,0 +1,91 @@
+#include <string.h>
+#include "audio_port.h"
+#include "audio_sync.h"
+
+static const char *TAG = "AUDIO_SYNC";
+
+static int64_t frames_to_us(int64_t frames, uint32_t rate) {
+    return rate ? frames * 1000000 / rate : 0;
+}
+
+static int64_t us_to_frames(int64_t us, uint32_t rate) {
+    return us * rate / 1000000;
+}
+
+void audio_sync_init(audio_sync_t *s, const audio_clock_t *clock, int64_t play_at_us, bool correct_drift) {
+    memset(s, 0, sizeof(*s));
+    s->clock = *clock;
+    s->play_at_us = play_at_us;
+    s->correct_drift = correct_drift;
+}
+
+// Sleeps in slices of this while a cancellable start waits
+#define WAIT_SLICE_MS 10
+
+int64_t audio_sync_wait_until(const audio_clock_t *clock, int64_t at_us, const volatile bool *cancelled) {
+    int64_t now;
+    if (!clock->now(clock->ctx, &now)) return INT64_MIN;
+    // The scheduler's tick is far coarser than the target: sleep most of
+    // the way (in slices when the wait can be cancelled), then poll
+    while (at_us - now > AUDIO_SYNC_SPIN_US) {
+        if (cancelled && *cancelled) return now - at_us;
+        int64_t ms = (at_us - now - AUDIO_SYNC_SPIN_US) / 1000;
+        audio_sleep_ms((uint32_t)(cancelled && ms > WAIT_SLICE_MS ? WAIT_SLICE_MS : ms));
+        if (!clock->now(clock->ctx, &now)) return INT64_MIN;
+    }
+    while (clock->now(clock->ctx, &now) && now < at_us) {
+    }
+    return now - at_us;
+}
+
+bool audio_sync_start(audio_sync_t *s, uint32_t sample_rate) {
+    s->sample_rate = sample_rate;
+    int64_t late = audio_sync_wait_until(&s->clock, s->play_at_us - s->output_delay_us, &s->cancelled);
+    if (late == INT64_MIN) {
+        AUDIO_LOGW(TAG, "Shared clock not set, playing unsynchronized");
+        return false;
+    }
+    if (s->cancelled) return false;
+    s->stats.start_error_us = late;
+    if (late > AUDIO_SYNC_MAX_LATE_US) {
+        AUDIO_LOGW(TAG, "Started %.1f ms late, too late to join: playing unsynchronized", late / 1000.0);
+        return false;
+    }
+    if (late > AUDIO_SYNC_DEADBAND_US) {
+        s->skip_frames = us_to_frames(late, sample_rate);
+        AUDIO_LOGW(TAG, "Started %.1f ms late, skipping ahead", late / 1000.0);
+    }
+    return true;
+}
+
+uint32_t audio_sync_block(audio_sync_t *s, int64_t played_us, uint32_t frames, int32_t *repeat) {
+    *repeat = 0;
+    if (s->skip_frames) {
+        uint32_t skip = s->skip_frames < frames ? (uint32_t)s->skip_frames : frames;
+        s->skip_frames -= skip;
+        s->stats.skipped_frames += skip;
+        return skip;
+    }
+    int64_t now;
+    if (!s->correct_drift || !s->clock.now(s->clock.ctx, &now)) return 0;
+
+    // Clip position by the playback clock against shared time since the first write
+    int64_t offset_frames = (int64_t)s->stats.skipped_frames - s->stats.slipped_frames;
+    int64_t clip_us = played_us + frames_to_us(offset_frames, s->sample_rate);
+    int64_t error_us = clip_us - (now - (s->play_at_us - s->output_delay_us));
+    if (error_us < -AUDIO_SYNC_RESYNC_US) {
+        // Fell well behind (a stall): drop the difference now
+        s->skip_frames = us_to_frames(-error_us, s->sample_rate);
+        AUDIO_LOGW(TAG, "%lld ms behind, skipping ahead", (long long)(-error_us / 1000));
+        return audio_sync_block(s, played_us, frames, repeat);
+    }
+    s->stats.error_us = (int32_t)error_us;
+    int32_t abs_error = error_us < 0 ? (int32_t)-error_us : (int32_t)error_us;
+    if (abs_error > s->stats.max_error_us) s->stats.max_error_us = abs_error;
+    if (abs_error > AUDIO_SYNC_DEADBAND_US && frames > 1) {
+        *repeat = error_us > 0 ? 1 : -1;
+        s->stats.slipped_frames += *repeat;
+        s->stats.corrections++;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "audio_trace.h"
+
+static const char *const span_names[AUDIO_SPAN_COUNT] = {
+    "open", "headers", "first_byte", "prefill", "first_write", "played",
+};
+
+static int32_t since_ms(int64_t t_us, int64_t t_received_us) {
+    return t_us > 0 ? (int32_t)((t_us - t_received_us) / 1000) : -1;
+}
+
+void audio_trace_from_stats(audio_trace_t *t, int64_t t_received_us, const audio_pipeline_stats_t *s) {
+    const int64_t at[AUDIO_SPAN_COUNT] = {
+        s->t_open_us, s->t_source_open_us, s->t_first_byte_us,
+        s->t_prefill_us, s->t_first_write_us, s->t_played_us,
+    };
+    for (int i = 0; i < AUDIO_SPAN_COUNT; i++) t->at_ms[i] = since_ms(at[i], t_received_us);
+    t->bytes = s->bytes_processed > 0 ? (uint32_t)s->bytes_processed : 0;
+    int64_t us = s->t_complete_us - s->t_open_us;
+    // bits per ms = kbit/s
+    t->kbps = s->t_complete_us > 0 && us > 0 ? (uint32_t)((uint64_t)t->bytes * 8000 / (uint64_t)us) : 0;
+    t->underruns = s->underruns;
+    t->starved_ms = s->starved_ms;
+    // Cancelled as the urgent message arrived; the writer stamps the silence as played
+    t->preempt_ms = s->t_cancel_us > 0 && s->t_played_us >= s->t_cancel_us
+        ? (int32_t)((s->t_played_us - s->t_cancel_us) / 1000) : -1;
+}
+
+// Appends to a bounded buffer; `*pos` goes past `len` once anything is cut
+static void put(char *buf, size_t len, size_t *pos, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(*pos < len ? buf + *pos : NULL, *pos < len ? len - *pos : 0, fmt, ap);
+    va_end(ap);
+    *pos += n > 0 ? (size_t)n : 0;
+}
+
+static void put_string(char *buf, size_t len, size_t *pos, const char *s) {
+    put(buf, len, pos, "\"");
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put(buf, len, pos, "\\%c", c);
+        } else if (c < 0x20) {
+            put(buf, len, pos, "\\u%04x", c);
+        } else {
+            put(buf, len, pos, "%c", c);
+        }
+    }
+    put(buf, len, pos, "\"");
+}
+
+static void put_ms(char *buf, size_t len, size_t *pos, const char *key, int32_t ms) {
+    if (ms < 0) {
+        put(buf, len, pos, ",\"%s\":null", key);
+    } else {
+        put(buf, len, pos, ",\"%s\":%ld", key, (long)ms);
+    }
+}
+
+int audio_trace_format(const audio_trace_t *t, char *buf, size_t len) {
+    size_t pos = 0;
+    put(buf, len, &pos, "{\"seq\":%lu,\"file\":", (unsigned long)t->seq);
+    put_string(buf, len, &pos, t->filename);
+    for (int i = 0; i < AUDIO_SPAN_COUNT; i++) put_ms(buf, len, &pos, span_names[i], t->at_ms[i]);
+    put(buf, len, &pos, ",\"bytes\":%lu,\"kbps\":%lu,\"underruns\":%lu,\"starved_ms\":%lu",
+        (unsigned long)t->bytes, (unsigned long)t->kbps, (unsigned long)t->underruns,
+        (unsigned long)t->starved_ms);
+    put_ms(buf, len, &pos, "preempt_ms", t->preempt_ms);
+    put(buf, len, &pos, ",\"cached\":%s,\"ok\":%s}", t->cached ? "true" : "false", t->ok ? "true" : "false");
+    return pos < len ? (int)pos : -1;
+}
+
+void audio_trace_window_init(audio_trace_window_t *w) {
+    memset(w, 0, sizeof(*w));
+    audio_lock_init(&w->lock);
+}
+
+void audio_trace_window_add(audio_trace_window_t *w, const audio_trace_t *t) {
+    audio_lock(&w->lock);
+    memcpy(w->at_ms[w->next], t->at_ms, sizeof(t->at_ms));
+    w->next = (w->next + 1) % AUDIO_TRACE_WINDOW;
+    if (w->count < AUDIO_TRACE_WINDOW) w->count++;
+    audio_unlock(&w->lock);
+}
+
+static int32_t rank(const int32_t *sorted, uint32_t n, uint32_t pct) {
+    uint32_t r = (n * pct + 99) / 100;     // nearest rank, 1-based
+    return sorted[r > 0 ? r - 1 : 0];
+}
+
+audio_percentiles_t audio_trace_percentiles(audio_trace_window_t *w, audio_span_t span) {
+    int32_t v[AUDIO_TRACE_WINDOW];
+    uint32_t n = 0;
+    audio_lock(&w->lock);
+    for (size_t i = 0; i < w->count; i++) {
+        if (w->at_ms[i][span] >= 0) v[n++] = w->at_ms[i][span];
+    }
+    audio_unlock(&w->lock);
+
+    // Insertion sort: the window is small and sorted on request only
+    for (uint32_t i = 1; i < n; i++) {
+        int32_t x = v[i];
+        uint32_t j = i;
+        for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    if (n == 0) return (audio_percentiles_t) { 0, -1, -1, -1 };
+    return (audio_percentiles_t) { n, rank(v, n, 50), rank(v, n, 95), rank(v, n, 99) };
+}
+
+int audio_trace_format_summary(audio_trace_window_t *w, char *buf, size_t len) {
+    size_t pos = 0;
+    audio_lock(&w->lock);
+    size_t count = w->count;
+    audio_unlock(&w->lock);
+    put(buf, len, &pos, "{\"window\":%lu", (unsigned long)count);
+    for (int i = 0; i < AUDIO_SPAN_COUNT; i++) {
+        audio_percentiles_t p = audio_trace_percentiles(w, (audio_span_t)i);
+        if (p.n == 0) {
+            put(buf, len, &pos, ",\"%s\":null", span_names[i]);
+        } else {
+            put(buf, len, &pos, ",\"%s\":[%ld,%ld,%ld]", span_names[i], (long)p.p50, (long)p.p95, (long)p.p99);
+        }
+    }
+    put(buf, len, &pos, "}");
+    return pos < len ? (int)pos : -1;
+}
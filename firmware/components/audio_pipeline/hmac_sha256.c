@@ -0,0 +1,150 @@
+#include <string.h>
+#include "hmac_sha256.h"
+
+#if defined(ESP_PLATFORM)
+
+static void hash_start(hmac_sha256_t *h) {
+    mbedtls_sha256_init(&h->sha);
+    mbedtls_sha256_starts(&h->sha, 0);
+}
+
+static void hash_update(hmac_sha256_t *h, const void *data, size_t len) {
+    mbedtls_sha256_update(&h->sha, data, len);
+}
+
+static void hash_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]) {
+    mbedtls_sha256_finish(&h->sha, out);
+    mbedtls_sha256_free(&h->sha);
+}
+
+#else
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void compress(uint32_t s[8], const uint8_t *p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+static void hash_start(hmac_sha256_t *h) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(h->state, iv, sizeof(iv));
+    h->total = 0;
+    h->used = 0;
+}
+
+static void hash_update(hmac_sha256_t *h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    h->total += len;
+    if (h->used) {
+        size_t n = 64 - h->used < len ? 64 - h->used : len;
+        memcpy(h->block + h->used, p, n);
+        h->used += n;
+        p += n;
+        len -= n;
+        if (h->used < 64) return;
+        compress(h->state, h->block);
+        h->used = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64) compress(h->state, p);
+    memcpy(h->block, p, len);
+    h->used = len;
+}
+
+static void hash_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]) {
+    uint64_t bits = h->total * 8;
+    h->block[h->used++] = 0x80;
+    if (h->used > 56) {
+        memset(h->block + h->used, 0, 64 - h->used);
+        compress(h->state, h->block);
+        h->used = 0;
+    }
+    memset(h->block + h->used, 0, 56 - h->used);
+    for (int i = 0; i < 8; i++) h->block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    compress(h->state, h->block);
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(h->state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h->state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h->state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h->state[i];
+    }
+}
+
+#endif
+
+void sha256(const void *data, size_t len, uint8_t out[HMAC_SHA256_LEN]) {
+    hmac_sha256_t h;
+    hash_start(&h);
+    hash_update(&h, data, len);
+    hash_finish(&h, out);
+}
+
+void sha256_start(hmac_sha256_t *h) {
+    hash_start(h);
+}
+
+void sha256_update(hmac_sha256_t *h, const void *data, size_t len) {
+    hash_update(h, data, len);
+}
+
+void sha256_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]) {
+    hash_finish(h, out);
+}
+
+void hmac_sha256_start(hmac_sha256_t *h, const uint8_t *key, size_t key_len) {
+    uint8_t k[64] = { 0 };
+    if (key_len > sizeof(k)) {
+        sha256(key, key_len, k);
+    } else {
+        memcpy(k, key, key_len);
+    }
+    uint8_t ipad[64];
+    for (int i = 0; i < 64; i++) {
+        ipad[i] = k[i] ^ 0x36;
+        h->opad[i] = k[i] ^ 0x5c;
+    }
+    hash_start(h);
+    hash_update(h, ipad, sizeof(ipad));
+}
+
+void hmac_sha256_update(hmac_sha256_t *h, const void *data, size_t len) {
+    hash_update(h, data, len);
+}
+
+void hmac_sha256_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]) {
+    uint8_t inner[HMAC_SHA256_LEN];
+    hash_finish(h, inner);
+    hash_start(h);
+    hash_update(h, h->opad, sizeof(h->opad));
+    hash_update(h, inner, sizeof(inner));
+    hash_finish(h, out);
+}
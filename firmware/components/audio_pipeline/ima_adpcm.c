@@ -0,0 +1,106 @@
+#include "ima_adpcm.h"
+
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static inline int32_t clamp_index(int32_t index) {
+    return index < 0 ? 0 : (index > 88 ? 88 : index);
+}
+
+static inline int32_t clamp_sample(int32_t v) {
+    return v < INT16_MIN ? INT16_MIN : (v > INT16_MAX ? INT16_MAX : v);
+}
+
+static inline int16_t decode_nibble(ima_adpcm_state_t *st, uint8_t nibble) {
+    int32_t step = step_table[st->index];
+    int32_t diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    st->predictor = clamp_sample((nibble & 8) ? st->predictor - diff : st->predictor + diff);
+    st->index = clamp_index(st->index + index_table[nibble]);
+    return (int16_t)st->predictor;
+}
+
+size_t ima_adpcm_block_samples(size_t block_bytes, uint16_t channels) {
+    size_t header = (size_t)IMA_ADPCM_HEADER_BYTES * channels;
+    if (channels == 0 || block_bytes < header) return 0;
+    size_t data = block_bytes - header;
+    if (channels == 2) {
+        // Stereo data only comes in whole 4-byte groups per channel
+        data = data / 8 * 8;
+    }
+    return data * 2 / channels + 1;
+}
+
+size_t ima_adpcm_decode_block(const uint8_t *block, size_t block_bytes, uint16_t channels, int16_t *out) {
+    size_t frames = ima_adpcm_block_samples(block_bytes, channels);
+    if (frames == 0 || channels > 2) return 0;
+
+    ima_adpcm_state_t st[2];
+    for (uint16_t c = 0; c < channels; c++) {
+        const uint8_t *h = block + c * IMA_ADPCM_HEADER_BYTES;
+        st[c].predictor = (int16_t)(h[0] | (h[1] << 8));
+        st[c].index = clamp_index(h[2]);
+        out[c] = (int16_t)st[c].predictor;
+    }
+
+    const uint8_t *data = block + (size_t)IMA_ADPCM_HEADER_BYTES * channels;
+    if (channels == 1) {
+        int16_t *dst = out + 1;
+        for (size_t i = 0; i < (frames - 1) / 2; i++) {
+            *dst++ = decode_nibble(&st[0], data[i] & 0x0f);
+            *dst++ = decode_nibble(&st[0], data[i] >> 4);
+        }
+        return frames;
+    }
+
+    // Stereo: 4 bytes (8 samples) of left, then 4 bytes of right, repeating
+    size_t groups = (frames - 1) / 8;
+    for (size_t g = 0; g < groups; g++) {
+        for (uint16_t c = 0; c < 2; c++) {
+            const uint8_t *src = data + (g * 2 + c) * 4;
+            int16_t *dst = out + (1 + g * 8) * 2 + c;
+            for (int b = 0; b < 4; b++) {
+                *dst = decode_nibble(&st[c], src[b] & 0x0f);
+                dst += 2;
+                *dst = decode_nibble(&st[c], src[b] >> 4);
+                dst += 2;
+            }
+        }
+    }
+    return frames;
+}
+
+uint8_t ima_adpcm_encode_sample(ima_adpcm_state_t *st, int16_t sample) {
+    int32_t step = step_table[st->index];
+    int32_t diff = sample - st->predictor;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { nibble |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 1; }
+
+    // Track the decoder exactly so both sides stay in lockstep
+    decode_nibble(st, nibble);
+    return nibble;
+}
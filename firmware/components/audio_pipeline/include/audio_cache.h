@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+#include "audio_port.h"
+
+// LRU cache of decoded clips keyed by message filename.
+//
+// Each entry holds the pipeline's mono output as a canonical 44-byte PCM WAV,
+// so a hit is played by pointing the unchanged pipeline at an in-memory
+// source (audio_cache_source_bind) instead of HTTP. The RAM tier lives in
+// memory from `alloc` (PSRAM on the device) and is bounded by `budget`
+// bytes; an optional persistent store (a flash partition on the device) sits
+// below it. Store hits are promoted back into RAM.
+//
+// Entries are pinned while captured or played and are never evicted then.
+
+#define AUDIO_CACHE_KEY_MAX     64
+#define AUDIO_CACHE_MAX_ENTRIES 16
+#define AUDIO_CACHE_WAV_HEADER  44
+
+// Persistent lower tier. find() returns the stored size of `key` or -1.
+typedef struct {
+    void *ctx;
+    int (*find)(void *ctx, const char *key);
+    bool (*read)(void *ctx, const char *key, void *dst, size_t len);
+    bool (*write)(void *ctx, const char *key, const void *data, size_t len);
+} audio_cache_store_t;
+
+typedef struct {
+    char key[AUDIO_CACHE_KEY_MAX];
+    uint8_t *data;          // WAV header + PCM
+    size_t len;             // bytes filled
+    size_t size;            // bytes allocated
+    uint32_t last_use;      // LRU clock
+    uint16_t pins;
+    bool committed;         // complete clip, visible to lookups
+    bool stored;            // present in the persistent store
+} audio_cache_entry_t;
+
+typedef struct {
+    uint32_t hits;          // served from RAM
+    uint32_t store_hits;    // promoted from the persistent store
+    uint32_t misses;
+    uint32_t evictions;     // RAM entries dropped to make room
+    uint32_t rejects;       // clips that could not be cached (too big, all pinned)
+    uint32_t stored;        // entries written to the persistent store
+} audio_cache_counters_t;
+
+typedef struct {
+    audio_cache_entry_t entries[AUDIO_CACHE_MAX_ENTRIES];
+    size_t budget;
+    size_t used;
+    uint32_t clock;
+    void *(*alloc)(size_t size);    // released with free()
+    const audio_cache_store_t *store;
+    audio_cache_counters_t counters;
+    audio_lock_t lock;
+} audio_cache_t;
+
+// `store` may be NULL (RAM only).
+void audio_cache_init(audio_cache_t *c, size_t budget, void *(*alloc)(size_t), const audio_cache_store_t *store);
+void audio_cache_deinit(audio_cache_t *c);
+
+// Pinned entry for `key` (promoted from the store if needed), or NULL.
+audio_cache_entry_t *audio_cache_acquire(audio_cache_t *c, const char *key);
+void audio_cache_release(audio_cache_t *c, audio_cache_entry_t *e);
+// Whether acquire() would hit, from RAM or the store; pins and counts nothing.
+bool audio_cache_contains(audio_cache_t *c, const char *key);
+
+// Capture: reserve room for up to `max_pcm` bytes of mono PCM, evicting
+// least recently used entries. Returns a pinned, not yet visible entry, or
+// NULL when the clip cannot be cached. Only the capturing task touches the
+// entry until commit/abort, so append() takes no lock.
+audio_cache_entry_t *audio_cache_begin(audio_cache_t *c, const char *key, uint32_t sample_rate,
+                                       uint16_t bits_per_sample, size_t max_pcm);
+bool audio_cache_append(audio_cache_entry_t *e, const void *pcm, size_t len);
+void audio_cache_commit(audio_cache_t *c, audio_cache_entry_t *e);
+void audio_cache_abort(audio_cache_t *c, audio_cache_entry_t *e);
+
+// Write committed entries that are not yet in the store. Slow (flash erase
+// and program), so call it outside the latency path.
+void audio_cache_flush(audio_cache_t *c);
+
+audio_cache_counters_t audio_cache_counters(audio_cache_t *c);
+
+// audio_source_t over a pinned entry; open() ignores the URL.
+typedef struct {
+    const audio_cache_entry_t *entry;
+    size_t pos;
+} audio_cache_source_t;
+
+void audio_cache_source_bind(audio_cache_source_t *src, const audio_cache_entry_t *e, audio_source_t *out);
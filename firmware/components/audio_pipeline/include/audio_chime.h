@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+#include "audio_resample.h"
+
+// Alarm chimes stored in firmware rather than in every uploaded message.
+//
+// The chime image (built by tools/mkchimes.py and flashed to the "chimes"
+// partition) is a small table followed by raw mono PCM:
+//
+//   offset 0   "CHM1", u32 count
+//   offset 8   count x { u32 offset, u32 len, u32 sample_rate, u16 bits, u16 reserved }
+//   ...        PCM of each chime, 4-byte aligned, offsets from the image start
+//
+// All fields are little-endian. Chime ids are 1-based; 0 means "no chime".
+// On the device the image is memory-mapped, so a chime is played straight
+// from flash without being copied into RAM first.
+
+#define AUDIO_CHIME_MAGIC       "CHM1"
+#define AUDIO_CHIME_HEADER      8
+#define AUDIO_CHIME_ENTRY       16
+#define AUDIO_CHIME_MAX         32
+
+typedef struct {
+    const uint8_t *pcm;         // points into the image
+    size_t len;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+} audio_chime_t;
+
+// Look up chime `id` in `image`, validating the table against `size`.
+// Returns AUDIO_OK or AUDIO_ERR_FORMAT (bad image, unknown id).
+int audio_chime_find(const void *image, size_t size, unsigned id, audio_chime_t *out);
+
+int64_t audio_chime_duration_us(const audio_chime_t *c);
+
+// Hand the chime to the sink in AUDIO_CHUNK_BUFFER_SIZE pieces. Without a
+// resampler the pieces come directly from the image; with one, they are
+// converted to the sink's rate (out_rate) first. Returns AUDIO_OK,
+// AUDIO_ERR_FORMAT (rate the resampler cannot convert) or AUDIO_ERR_IO.
+int audio_chime_play(const audio_chime_t *c, const audio_sink_t *sink, audio_resampler_t *rs, uint32_t out_rate);
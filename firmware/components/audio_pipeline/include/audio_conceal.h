@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Click-free gaps when the network stalls. Sits in front of the sink and
+// always holds back the last fade's worth of audio, so that when the ring
+// runs dry mid-download the writer can still ramp what it holds down to
+// silence before the DMA runs out, instead of the driver cutting to
+// auto_clear zeros mid-waveform. The first audio after the gap ramps up
+// from silence.
+//
+// The fade is followed by AUDIO_CONCEAL_PAD_FRAMES of silence, which push
+// the ramp's end through downstream stages that delay audio (the DSP
+// limiter's look-ahead) before the stream stops.
+
+#define AUDIO_CONCEAL_FADE_MS     5
+#define AUDIO_CONCEAL_MAX_FRAMES  256
+#define AUDIO_CONCEAL_PAD_FRAMES  64
+
+typedef struct {
+    audio_sink_t next;
+    uint16_t bytes_per_sample;  // mono 16- or 32-bit
+    size_t fade_frames;
+    size_t held;                // bytes held back in tail
+    size_t fade_in_pos;         // frames of the fade-in done; fade_frames = none pending
+    uint8_t tail[AUDIO_CONCEAL_MAX_FRAMES * 4] __attribute__((aligned(16)));
+    uint8_t scratch[AUDIO_CONCEAL_MAX_FRAMES * 4] __attribute__((aligned(16)));
+} audio_conceal_t;
+
+// Starts a stream of mono `bits_per_sample` PCM at `sample_rate` into `next`
+void audio_conceal_bind(audio_conceal_t *c, const audio_sink_t *next, uint32_t sample_rate,
+                        uint16_t bits_per_sample, audio_sink_t *out);
+
+// The ring ran dry: writes the held audio faded to silence, then the pad.
+// The next write fades in. Returns AUDIO_OK or AUDIO_ERR_IO.
+int audio_conceal_fade_out(audio_conceal_t *c);
+
+// End of stream: writes the held audio as is
+int audio_conceal_finish(audio_conceal_t *c);
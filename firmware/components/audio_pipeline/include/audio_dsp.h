@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Fixed-point post-processing of mono 16-bit audio on its way to the I2S
+// channel, in this order:
+//
+//   EQ       up to AUDIO_DSP_MAX_BANDS biquads for the small speaker
+//            (high-pass, shelves, peaks), Direct Form I with Q28
+//            coefficients and 8 fractional bits of state, stored at half
+//            scale so EQ boost cannot clip
+//   gain     loudness make-up, up to +12 dB
+//   limiter  look-ahead peak limiter: audio is delayed one block of
+//            AUDIO_DSP_BLOCK frames, and each block's gain is already at or
+//            below what its loudest sample allows when it starts playing,
+//            so nothing clips. Gain falls within a block and recovers
+//            exponentially over release_ms
+//
+// Gain and limiter are one multiply, ramped in steps of 8 samples
+// (pcm_gain_ramp_s16, SIMD on the S3). The biquads are recursive and stay
+// scalar. Coefficients are designed in floating point at init only.
+
+#define AUDIO_DSP_MAX_BANDS 4
+#define AUDIO_DSP_BLOCK     32      // frames; limiter look-ahead (0.67 ms at 48 kHz)
+#define AUDIO_DSP_CHUNK     512     // frames processed per step by the sink wrapper
+#define AUDIO_DSP_COEF_Q    28
+#define AUDIO_DSP_STATE_Q   8
+#define AUDIO_DSP_MAX_GAIN_DB 12.0f
+
+typedef enum {
+    AUDIO_EQ_HIGHPASS,
+    AUDIO_EQ_LOWPASS,
+    AUDIO_EQ_PEAK,
+    AUDIO_EQ_LOWSHELF,
+    AUDIO_EQ_HIGHSHELF,
+} audio_eq_type_t;
+
+typedef struct {
+    audio_eq_type_t type;
+    float freq_hz;
+    float q;                    // 0.707 = Butterworth
+    float gain_db;              // peaks and shelves only
+} audio_eq_band_t;
+
+typedef struct {
+    float gain_db;
+    float limit_dbfs;           // limiter ceiling, <= 0
+    uint32_t release_ms;
+    size_t num_bands;
+    audio_eq_band_t bands[AUDIO_DSP_MAX_BANDS];
+} audio_dsp_config_t;
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2; // Q28, a0 normalized to 1
+    int32_t x1, x2, y1, y2;     // Q8 samples
+} audio_biquad_t;
+
+typedef struct {
+    audio_biquad_t eq[AUDIO_DSP_MAX_BANDS];
+    size_t num_bands;
+    int32_t gain_max;           // Q12 applied to the half-scale EQ output
+    int32_t ceiling;            // output peak allowed
+    int32_t release_q15;        // share of the way back to gain_max per block
+    int32_t gain;               // where the last emitted block ended, Q12
+    int32_t req_pending;        // highest gain the pending block allows
+    bool has_pending;
+    size_t fill;                // frames in cur
+    int16_t pending[AUDIO_DSP_BLOCK] __attribute__((aligned(16)));
+    int16_t cur[AUDIO_DSP_BLOCK] __attribute__((aligned(16)));
+    int16_t out[AUDIO_DSP_CHUNK + AUDIO_DSP_BLOCK] __attribute__((aligned(16)));
+    audio_sink_t next;          // downstream of the sink wrapper
+    uint32_t limited_blocks;    // blocks played below the make-up gain
+    uint64_t cycles;            // spent in process()
+    uint64_t samples;
+} audio_dsp_t;
+
+// Designs the filters for `sample_rate` and resets the stream state.
+// Returns AUDIO_OK, or AUDIO_ERR_FORMAT for a band at or above Nyquist or
+// with coefficients out of Q28 range.
+int audio_dsp_init(audio_dsp_t *d, const audio_dsp_config_t *cfg, uint32_t sample_rate);
+
+// Starts a new stream: clears filter and limiter state and the counters
+void audio_dsp_reset(audio_dsp_t *d);
+
+// Processes `frames` frames into `out` (room for frames + AUDIO_DSP_BLOCK)
+// and returns how many came out; output lags input by one to two blocks.
+size_t audio_dsp_process(audio_dsp_t *d, const int16_t *in, size_t frames, int16_t *out);
+
+// What is still delayed at the end of a stream (at most 2 * AUDIO_DSP_BLOCK)
+size_t audio_dsp_flush(audio_dsp_t *d, int16_t *out);
+
+// Sink that runs the chain in front of `next`. finish() flushes the delayed
+// tail into `next`, logs the cost and limiter activity and resets the
+// stream. Returns AUDIO_OK or AUDIO_ERR_IO.
+void audio_dsp_sink_bind(audio_dsp_t *d, const audio_sink_t *next, audio_sink_t *out);
+int audio_dsp_sink_finish(audio_dsp_t *d);
+
+// Average cost since reset, in audio_cycles() units
+uint32_t audio_dsp_cycles_per_sample(const audio_dsp_t *d);
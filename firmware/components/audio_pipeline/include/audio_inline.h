@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+#include "audio_port.h"
+#include "hmac_sha256.h"
+
+// Short clips delivered inside MQTT instead of through a signed URL. The
+// notification names the clip (inline_id, inline_bytes) and the WAV follows
+// on the same topic as binary chunks, each with a small header:
+//
+//   0  2  magic "RA"
+//   2  1  version (1)
+//   3  1  flags (bit 0: last chunk)
+//   4  4  clip id, little endian
+//   8  4  byte offset of the payload in the clip
+//  12  2  sequence number, from 0
+//  14  2  reserved (0)
+//
+// The MQTT task feeds each data event in; payloads are reassembled into a
+// buffer that holds the whole clip, so chunks keep arriving while an earlier
+// message plays. The playback worker reads the clip through an
+// audio_source_t that blocks only until the next chunk lands, so playback
+// starts on the first chunks rather than after the last.
+//
+// One clip at a time: a new clip takes the buffer over unless the worker is
+// already reading it, and a message whose clip was lost that way falls back
+// to its file_url. A missing or out-of-order chunk fails the clip, as does
+// no chunk for AUDIO_INLINE_STALL_MS.
+//
+// Chunks are not signed. When the signed notification gives the clip's
+// SHA-256, the clip is hashed as it lands and only handed to the worker once
+// all of it has arrived and matched, so nothing unverified is played; a
+// mismatch fails the clip like a gap. That gives up starting on the first
+// chunks.
+
+#define AUDIO_INLINE_HEADER_SIZE 16
+#define AUDIO_INLINE_VERSION     1
+#define AUDIO_INLINE_FLAG_LAST   0x01
+#define AUDIO_INLINE_STALL_MS    3000
+
+typedef struct {
+    uint8_t flags;
+    uint32_t clip_id;
+    uint32_t offset;
+    uint16_t seq;
+} audio_inline_header_t;
+
+typedef enum {
+    AUDIO_INLINE_IDLE,
+    AUDIO_INLINE_RECEIVING,
+    AUDIO_INLINE_COMPLETE,
+    AUDIO_INLINE_FAILED,
+} audio_inline_state_t;
+
+typedef struct {
+    uint32_t chunks;            // accepted
+    uint32_t duplicates;        // redelivered chunks, ignored
+    uint32_t stale;             // chunks of a clip no longer in the buffer
+    uint32_t gaps;              // clips failed by a missing or bad chunk
+    int64_t t_begin_us;         // notification
+    int64_t t_first_chunk_us;
+    int64_t t_complete_us;      // last byte in, 0 while receiving
+} audio_inline_stats_t;
+
+typedef struct {
+    uint8_t *buf;               // caller's, holds a whole clip
+    size_t capacity;
+    audio_signal_t signal;      // given by feed(), waited on by read()
+    audio_lock_t lock;
+
+    audio_inline_state_t state;
+    uint32_t clip_id;
+    uint32_t total;
+    uint32_t received;          // bytes in buf; read() only looks below this
+    uint16_t next_seq;
+    bool claimed;               // the worker is reading the clip
+    bool verify;                // digest below is expected of the clip
+    uint8_t digest[HMAC_SHA256_LEN];
+    hmac_sha256_t sha;          // over the bytes received, by feed() only
+    uint32_t read_pos;
+
+    bool in_chunk;              // the current MQTT message is a chunk being stored
+    bool in_last;               // ... and carries the last flag
+    audio_inline_stats_t stats;
+} audio_inline_t;
+
+void audio_inline_init(audio_inline_t *a, uint8_t *buf, size_t capacity, const audio_signal_t *signal);
+
+// Whether an MQTT payload starts with a chunk header
+bool audio_inline_is_chunk(const uint8_t *data, size_t len);
+
+// Decodes a chunk header; false if `data` is not one
+bool audio_inline_parse_header(const uint8_t *data, size_t len, audio_inline_header_t *h);
+
+// Writes a header into `out` (AUDIO_INLINE_HEADER_SIZE bytes), for tests and tools
+void audio_inline_write_header(const audio_inline_header_t *h, uint8_t *out);
+
+// Reserves the buffer for clip `id` of `total` bytes, whose SHA-256 must be
+// `sha256` unless that is NULL. False when the clip does not fit or the
+// buffer holds a clip the worker is reading.
+bool audio_inline_begin(audio_inline_t *a, uint32_t id, uint32_t total, const uint8_t *sha256);
+
+// One MQTT data event: bytes [offset, offset + len) of a `msg_len`-byte
+// message (esp-mqtt splits messages larger than its buffer). Call only for
+// messages whose first event passed audio_inline_is_chunk().
+void audio_inline_feed(audio_inline_t *a, const uint8_t *data, size_t len, size_t offset, size_t msg_len);
+
+// Hands clip `id` to the worker, false if it was replaced or failed. On
+// success `out` reads it until close(), which frees the buffer. A clip with
+// a digest is waited for until it is complete and has matched.
+bool audio_inline_claim(audio_inline_t *a, uint32_t id, audio_source_t *out);
+
+audio_inline_stats_t audio_inline_stats(audio_inline_t *a);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte source feeding the pipeline (esp_http_client on the device, a loopback
+// HTTP client on the host). Semantics mirror esp_http_client_read: read()
+// blocks until `len` bytes are available or the body ends.
+//
+// open_range() is optional (NULL when the backend cannot seek): it reopens
+// the body from byte `offset` with an HTTP Range request and sets *start to
+// where the new body actually begins, 0 when the server ignored the range.
+typedef struct {
+    void *ctx;
+    int (*open)(void *ctx, const char *url);                // content length, or < 0 on error
+    int (*read)(void *ctx, uint8_t *buf, int len);          // > 0 bytes read, 0 on EOF, < 0 on error
+    void (*close)(void *ctx);
+    int (*open_range)(void *ctx, const char *url, uint32_t offset, uint32_t *start);   // length from *start
+} audio_source_t;
+
+// Byte ring between the downloader and the writer (audio_spsc.h on the
+// device and the host; a FreeRTOS ring buffer fits too): send() blocks
+// until the whole block fits, receive() hands out one contiguous region
+// that must be returned.
+//
+// acquire()/complete() are the zero-copy alternative to send(): the producer
+// gets `len` contiguous bytes of ring storage, fills them in place and then
+// commits the first `used` bytes. They may be NULL when a backend cannot
+// offer contiguous slots; a given ring is fed through one of the two paths only.
+//
+// finish() marks the end of the stream: once everything before it has been
+// received, receive() returns NULL at once instead of waiting, so the
+// reader can block without a timeout. Called once per stream, after the
+// last block, and only while a reader is draining the ring.
+typedef struct {
+    void *ctx;
+    size_t capacity;
+    bool (*send)(void *ctx, const void *data, size_t len, uint32_t timeout_ms);
+    bool (*acquire)(void *ctx, void **slot, size_t len, uint32_t timeout_ms);
+    void (*complete)(void *ctx, void *slot, size_t used);
+    void (*finish)(void *ctx);
+    void *(*receive)(void *ctx, size_t *len, uint32_t timeout_ms);
+    void (*return_item)(void *ctx, void *item);
+    size_t (*free_size)(void *ctx);
+} audio_ring_t;
+
+// PCM sink (i2s_channel_write on the device, a real-time paced fake on the host).
+typedef struct {
+    void *ctx;
+    int (*write)(void *ctx, const void *buf, size_t len, size_t *written);
+} audio_sink_t;
+
+// Wakes a task waiting for data pushed from another (a binary semaphore on
+// the device): signal() any number of times, wait() returns once per batch.
+typedef struct {
+    void *ctx;
+    void (*signal)(void *ctx);
+    bool (*wait)(void *ctx, uint32_t timeout_ms);           // false on timeout
+} audio_signal_t;
+
+// Time shared by a group of devices, in microseconds (the SNTP-disciplined
+// wall clock on the device). now() fails until the clock has been set.
+typedef struct {
+    void *ctx;
+    bool (*now)(void *ctx, int64_t *us);
+} audio_clock_t;
+
+#define AUDIO_WAIT_FOREVER UINT32_MAX
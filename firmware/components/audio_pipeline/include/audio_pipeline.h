@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_conceal.h"
+#include "audio_io.h"
+#include "audio_prefill.h"
+#include "audio_resample.h"
+#include "audio_sync.h"
+#include "wav_header.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#define AUDIO_CHUNK_BUFFER_SIZE 4096
+
+// Jitter-buffer defaults, overridable per pipeline
+#ifdef CONFIG_AUDIO_PREFILL_MIN_MS
+#define AUDIO_PREFILL_MIN_MS CONFIG_AUDIO_PREFILL_MIN_MS
+#else
+#define AUDIO_PREFILL_MIN_MS 60
+#endif
+#ifdef CONFIG_AUDIO_PREFILL_SAFETY_PCT
+#define AUDIO_PREFILL_SAFETY_PCT CONFIG_AUDIO_PREFILL_SAFETY_PCT
+#else
+#define AUDIO_PREFILL_SAFETY_PCT 80
+#endif
+
+// Late writes within this much of the playback clock are scheduling jitter
+// absorbed by the I2S DMA queue, not underruns
+#define AUDIO_UNDERRUN_SLACK_US 5000
+// The writer hands ring items to the sink in blocks of at most this many
+// frames, checking for a cancel in between
+#define AUDIO_WRITE_BLOCK_FRAMES 256
+// With concealment, the writer fades out once the sink has less than this
+// left to play and the ring is still empty
+#define AUDIO_CONCEAL_GUARD_US  15000
+
+// Error codes returned by the pipeline (0 on success)
+#define AUDIO_OK             0
+#define AUDIO_ERR_IO        -1
+#define AUDIO_ERR_FORMAT    -2
+#define AUDIO_ERR_NO_MEM    -3
+#define AUDIO_ERR_START     -4
+#define AUDIO_ERR_CANCELLED -5
+
+typedef struct {
+    int64_t t_open_us;          // source open requested
+    int64_t t_source_open_us;   // source open returned (HTTP response headers in)
+    int64_t t_first_byte_us;    // first body byte read
+    int64_t t_headers_us;       // WAV header parsed
+    int64_t t_prefill_us;       // start threshold reached (writer launched)
+    int64_t t_first_write_us;   // first block handed to the sink
+    int64_t t_last_write_us;    // last block handed to the sink
+    int64_t t_complete_us;      // download finished
+    int64_t t_played_us;        // last sample audible; set by the caller's writer
+    int64_t t_cancel_us;        // audio_pipeline_cancel() called, 0 = played out
+    int content_length;
+    int bytes_processed;        // body bytes consumed from the source (incl. header)
+    uint32_t bytes_pushed;      // PCM bytes committed to the ring
+    uint32_t bytes_written;     // PCM bytes accepted by the sink, in the sink's format
+    uint32_t bytes_copied;      // bytes memcpy'd/memmove'd between source and ring
+    uint32_t prefill_bytes;     // PCM buffered when the writer was launched
+    uint32_t prefill_target_ms; // buffered audio the estimator asked for
+    uint32_t rate_permille;     // download speed at start, audio ms per second
+    bool predicted_underrun;    // estimator expected the ring to run dry
+    uint32_t underruns;         // writer fell behind the audio clock (sink starved)
+    uint32_t starved_ms;        // total time the sink had nothing to play
+    uint32_t concealed;         // gaps faded out ahead of the sink running dry
+    uint32_t bytes_discarded;   // ring PCM thrown away by the writer after a cancel
+} audio_pipeline_stats_t;
+
+typedef struct audio_pipeline audio_pipeline_t;
+
+// Optional copy of every PCM block committed to the ring, e.g. to capture
+// the decoded clip into the audio cache while it plays.
+typedef struct {
+    void *ctx;
+    void (*write)(void *ctx, const void *pcm, size_t len);
+} audio_pcm_tap_t;
+
+// Called from the download loop once enough audio is buffered. Must launch
+// the writer (which runs audio_pipeline_write_loop) and return false on failure.
+typedef bool (*audio_start_cb_t)(audio_pipeline_t *p);
+
+struct audio_pipeline {
+    audio_source_t source;
+    audio_ring_t ring;
+    audio_start_cb_t start_playback;
+    audio_pcm_tap_t tap;
+    void *user;
+
+    wav_info_t wav;
+    uint32_t out_sample_rate;   // format of the PCM pushed into the ring (mono)
+    uint16_t out_bits_per_sample;
+    // Fixed sink format: with sink_sample_rate set, the writer converts the
+    // ring's PCM to mono 16-bit at that rate through `resampler` (caller
+    // provided, zeroed once). 0 = the sink takes the out_* format as is.
+    uint32_t sink_sample_rate;
+    audio_resampler_t *resampler;
+    // Optional, caller provided: fade around gaps when the download stalls
+    // (audio_conceal.h). NULL = the writer just waits for data.
+    audio_conceal_t *conceal;
+    // Optional, caller initialized: hold the first write until a start time
+    // shared with other devices and track it from there (audio_sync.h).
+    // NULL = play as soon as the prefill is in.
+    audio_sync_t *sync;
+    size_t start_threshold;     // fixed prefill in bytes; 0 = estimate from download rate
+    uint32_t prefill_min_ms;    // 0 = AUDIO_PREFILL_MIN_MS
+    uint32_t prefill_safety_pct;// 0 = AUDIO_PREFILL_SAFETY_PCT
+    audio_prefill_t prefill;    // model set up by audio_pipeline_init
+    int64_t prefetch_us;        // network time the source spent on the body before open (audio_prefetch.h)
+    bool zero_copy;             // read straight into ring slots (needs ring.acquire)
+    volatile bool download_complete;
+    volatile bool cancelled;    // set by audio_pipeline_cancel(); open leaves it alone
+    bool player_started;
+
+    // Staging buffers, AUDIO_CHUNK_BUFFER_SIZE bytes and AUDIO_SIMD_ALIGN
+    // aligned. Set them before init to use preallocated memory, which deinit
+    // leaves alone; init allocates (and deinit frees) only the missing ones.
+    char *chunk_buffer;
+    char *mono_buffer;
+    bool owns_chunk_buffer;
+    bool owns_mono_buffer;
+
+    int64_t play_origin_us;     // writer's playback clock, see write_item()
+
+    audio_pipeline_stats_t stats;
+};
+
+// Allocate any working buffers not supplied and size the prefill model for the opened clip;
+// source, ring and start_playback must be set by the caller, open done first.
+int audio_pipeline_init(audio_pipeline_t *p);
+void audio_pipeline_deinit(audio_pipeline_t *p);
+
+// Open the source and parse/validate the WAV header into p->wav. The
+// decoder stage is picked from the header's format tag (PCM or IMA ADPCM);
+// out_sample_rate/out_bits_per_sample describe what reaches the ring.
+int audio_pipeline_open(audio_pipeline_t *p, const char *url);
+
+// Upper bound of the PCM the clip decodes to (what reaches the ring), from
+// the header and content length; 0 if unknown. Valid after init.
+size_t audio_pipeline_output_bytes(const audio_pipeline_t *p);
+
+// Stream the body into the ring, launching the writer as soon as the buffered
+// audio covers the rest of the download at the measured rate (see
+// audio_prefill.h), or at EOF for tiny files. Sets download_complete and,
+// if the writer runs, finishes the ring.
+// With zero_copy, each HTTP read lands directly in an acquired ring slot and
+// stereo is downmixed in place, so payload bytes are never copied.
+// Compressed input is decoded block by block between the reader and the ring.
+int audio_pipeline_download(audio_pipeline_t *p);
+
+// Stops the clip from any task: the download returns AUDIO_ERR_CANCELLED
+// after the read in progress, a scheduled start stops waiting, and the
+// writer throws away what is left in the ring instead of playing it, so the
+// download never blocks on a full ring. What the sink has already queued is
+// the caller's to silence. Set before open (on a zeroed pipeline), the
+// download stops before reading any audio.
+void audio_pipeline_cancel(audio_pipeline_t *p);
+
+// Writer side: drain the ring into the sink until the download has finished
+// it and it is empty, sleeping in receive() in between. Counts underruns against the playback clock for
+// comparison with the estimator's prediction. With `conceal`, it waits only
+// until the sink is about to run dry and then fades out, and fades back in
+// when data arrives.
+void audio_pipeline_write_loop(audio_pipeline_t *p, const audio_sink_t *sink);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Thin portability layer so the pipeline builds both under ESP-IDF and on a
+// Linux host. Only logging, a monotonic clock, a sleep, a cycle counter,
+// aligned allocation and a mutex for state shared between tasks are needed here;
+// everything that blocks (ring buffer, sink) is injected through audio_io.h.
+
+#define AUDIO_SIMD_ALIGN 16
+// Padding between fields written by different cores
+#define AUDIO_CACHE_LINE 64
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define AUDIO_LOGE(tag, fmt, ...) ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define AUDIO_LOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define AUDIO_LOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+
+static inline int64_t audio_time_us(void) {
+    return esp_timer_get_time();
+}
+
+static inline void audio_sleep_ms(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// CPU cycles, for per-sample cost of DSP kernels; wraps every ~18 s at 240 MHz
+static inline uint32_t audio_cycles(void) {
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+// Released with free()
+static inline void *audio_alloc_aligned(size_t size) {
+    return heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, size, MALLOC_CAP_DEFAULT);
+}
+
+typedef struct {
+    SemaphoreHandle_t handle;
+    StaticSemaphore_t storage;
+} audio_lock_t;
+
+static inline void audio_lock_init(audio_lock_t *l) {
+    l->handle = xSemaphoreCreateMutexStatic(&l->storage);
+}
+static inline void audio_lock(audio_lock_t *l) {
+    xSemaphoreTake(l->handle, portMAX_DELAY);
+}
+static inline void audio_unlock(audio_lock_t *l) {
+    xSemaphoreGive(l->handle);
+}
+#else
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 0 = errors only, 1 = + warnings, 2 = + info
+#ifndef AUDIO_HOST_LOG_LEVEL
+#define AUDIO_HOST_LOG_LEVEL 1
+#endif
+
+#define AUDIO_HOST_LOG(lvl, letter, tag, fmt, ...) \
+    do { if (AUDIO_HOST_LOG_LEVEL >= (lvl)) fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+#define AUDIO_LOGE(tag, fmt, ...) AUDIO_HOST_LOG(0, "E", tag, fmt, ##__VA_ARGS__)
+#define AUDIO_LOGW(tag, fmt, ...) AUDIO_HOST_LOG(1, "W", tag, fmt, ##__VA_ARGS__)
+#define AUDIO_LOGI(tag, fmt, ...) AUDIO_HOST_LOG(2, "I", tag, fmt, ##__VA_ARGS__)
+
+static inline int64_t audio_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline void audio_sleep_ms(uint32_t ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Time-stamp counter on x86 (reference cycles), nanoseconds elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint32_t audio_cycles(void) {
+    return (uint32_t)__rdtsc();
+}
+#else
+static inline uint32_t audio_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#endif
+
+// Released with free()
+static inline void *audio_alloc_aligned(size_t size) {
+    return aligned_alloc(AUDIO_SIMD_ALIGN, (size + AUDIO_SIMD_ALIGN - 1) & ~(size_t)(AUDIO_SIMD_ALIGN - 1));
+}
+
+typedef struct {
+    pthread_mutex_t handle;
+} audio_lock_t;
+
+static inline void audio_lock_init(audio_lock_t *l) {
+    pthread_mutex_init(&l->handle, NULL);
+}
+static inline void audio_lock(audio_lock_t *l) {
+    pthread_mutex_lock(&l->handle);
+}
+static inline void audio_unlock(audio_lock_t *l) {
+    pthread_mutex_unlock(&l->handle);
+}
+#endif
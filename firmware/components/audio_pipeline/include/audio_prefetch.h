@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Download-ahead for the next queued message. While the current clip plays
+// out, the worker opens the next message's source (connection, request,
+// response headers) and reads the start of its body into a fixed buffer,
+// one read per audio_prefetch_fill() so it can stop as soon as the writer
+// is free. The message then plays through audio_prefetch_bind(): the
+// buffered bytes first, then the rest of the body from the source, which
+// was left open, so its prefill is in by the time the previous clip ends.
+//
+// busy_us is the time the network took for what was buffered (open and
+// reads, not the waits in between). The pipeline adds it to the download
+// time its prefill estimate is measured over (audio_pipeline_t.prefetch_us),
+// so bytes that come out of the buffer at once do not make a slow link
+// look fast.
+
+#define AUDIO_PREFETCH_READ_SIZE 4096
+
+typedef struct {
+    audio_source_t inner;
+    uint8_t *buf;               // caller's, the memory budget
+    size_t capacity;
+    size_t len;                 // body bytes buffered
+    size_t off;                 // of those, already read back
+    int length;                 // inner open() result
+    bool opened;                // inner holds the body until close
+    bool eof;                   // the whole body is buffered
+    bool failed;                // a read failed; reading back reaches it again
+    int64_t busy_us;
+} audio_prefetch_t;
+
+void audio_prefetch_init(audio_prefetch_t *pf, uint8_t *buf, size_t capacity);
+
+// Opens `url` (the caller's, valid until close) through `inner`; the
+// content length, or < 0 on error with nothing left open
+int audio_prefetch_start(audio_prefetch_t *pf, const audio_source_t *inner, const char *url);
+
+// One more read into the buffer: bytes added, 0 once it is full or holds
+// the whole body, < 0 when the read failed
+int audio_prefetch_fill(audio_prefetch_t *pf);
+
+// `out` plays the prefetched body: open() returns the length start() got
+// without touching the network, and close() closes the inner source.
+void audio_prefetch_bind(audio_prefetch_t *pf, audio_source_t *out);
+
+// Closes the inner source of a prefetch that will not be played
+void audio_prefetch_abandon(audio_prefetch_t *pf);
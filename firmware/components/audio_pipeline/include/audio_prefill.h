@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Start-of-playback estimator for the jitter buffer.
+//
+// Everything is measured in microseconds of audio. If the download delivers
+// `a` seconds of audio per wall-clock second (a < 1), playback started with
+// B seconds buffered out of a T-second clip stays ahead of the download for
+// the whole clip iff B >= T * (1 - a). When a >= 1 only the jitter floor is
+// needed. The measured rate is discounted by safety_pct, and measured over
+// a window padded by rtt_us + min_us, so the burst that arrives with the
+// first segments doesn't trigger a premature start.
+
+typedef struct {
+    int64_t total_us;       // clip duration, 0 if unknown (chunked / streamed WAV)
+    int64_t min_us;         // jitter floor: never start with less than this buffered
+    int64_t max_us;         // most the ring can hold before the writer starts
+    int64_t rtt_us;         // request -> response headers
+    int safety_pct;         // share of the measured download rate that is trusted
+} audio_prefill_t;
+
+typedef struct {
+    int64_t required_us;    // buffered audio needed before starting
+    uint32_t rate_permille; // measured download speed, audio ms per wall-clock second
+    bool predict_underrun;  // the ring cannot hold enough to cover the clip
+} audio_prefill_estimate_t;
+
+// Estimate the prefill given `buffered_us` of audio received over
+// `elapsed_us` of download time.
+audio_prefill_estimate_t audio_prefill_estimate(const audio_prefill_t *m, int64_t buffered_us, int64_t elapsed_us);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_cache.h"
+#include "audio_port.h"
+
+// Bounded queue of playback requests between the MQTT handler and the one
+// long-lived playback worker.
+//
+// Messages are copied into caller-provided slots (static on the device), so
+// a burst of notifications neither allocates nor fragments the heap. What
+// happens when a message arrives depends on the policy:
+//
+//   FIFO         queue in order; a message arriving at a full queue is dropped
+//   DROP_OLDEST  queue in order; a full queue discards its oldest message
+//   COALESCE     a message whose filename is already queued replaces it in
+//                place (keeping its position, taking the newer URL);
+//                otherwise as DROP_OLDEST
+//
+// Messages carry a priority: the worker takes the highest first, oldest
+// among equals, and a full queue gives up its oldest message of the lowest
+// priority, or turns the new one away when everything queued outranks it
+// (under FIFO too, when the new message outranks something queued).
+//
+// The message being played has already left the queue and is never touched;
+// preempting it is up to the caller.
+
+#define AUDIO_MSG_URL_MAX 1536  // signed storage URLs run to ~1 KB
+
+typedef enum {
+    AUDIO_QUEUE_FIFO,
+    AUDIO_QUEUE_DROP_OLDEST,
+    AUDIO_QUEUE_COALESCE,
+} audio_queue_policy_t;
+
+typedef enum {
+    AUDIO_QUEUE_QUEUED,
+    AUDIO_QUEUE_COALESCED,      // replaced a queued message with the same filename
+    AUDIO_QUEUE_DISPLACED,      // queued after dropping the oldest lowest-priority message
+    AUDIO_QUEUE_REJECTED,       // queue full of messages it does not outrank, or invalid
+} audio_queue_result_t;
+
+typedef struct {
+    char url[AUDIO_MSG_URL_MAX];
+    char filename[AUDIO_CACHE_KEY_MAX];     // cache / coalescing key, may be empty
+    uint8_t chime;                          // chime id, 0 = none
+    uint8_t priority;                       // 0 = normal; higher plays first and preempts
+    uint32_t gap_ms;                        // silence between chime and voice
+    uint32_t inline_id;                     // clip sent over MQTT (audio_inline.h), 0 = none
+    int64_t play_at_us;                     // group start on the shared clock (audio_sync.h), 0 = on arrival
+    int64_t t_received_us;                  // MQTT arrival, origin of the latency spans
+    int64_t t_enqueued_us;                  // set by push, for queue wait time
+    uint32_t id;                            // set by push, kept when coalesced; tells a peeked message on pop
+} audio_msg_t;
+
+typedef struct {
+    uint32_t depth;             // messages waiting now
+    uint32_t max_depth;         // high-water mark
+    uint32_t enqueued;
+    uint32_t dequeued;
+    uint32_t coalesced;
+    uint32_t dropped;           // rejected or displaced
+} audio_queue_stats_t;
+
+typedef struct {
+    audio_msg_t *slots;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    audio_queue_policy_t policy;
+    uint32_t next_id;
+    audio_queue_stats_t stats;
+    audio_lock_t lock;
+} audio_queue_t;
+
+void audio_queue_init(audio_queue_t *q, audio_msg_t *slots, size_t capacity, audio_queue_policy_t policy);
+
+// Copies `msg` in; never blocks. The caller wakes the worker on anything
+// but AUDIO_QUEUE_REJECTED.
+audio_queue_result_t audio_queue_push(audio_queue_t *q, const audio_msg_t *msg);
+
+// Oldest message of the highest priority into `out`; false when empty.
+bool audio_queue_pop(audio_queue_t *q, audio_msg_t *out);
+
+// What pop would return now, left queued; false when empty. A more urgent
+// message, or a coalesce or displacement, may still change what pop returns.
+bool audio_queue_peek(audio_queue_t *q, audio_msg_t *out);
+
+audio_queue_stats_t audio_queue_stats(audio_queue_t *q);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Streaming sample-rate converter from any input rate to the sink's fixed
+// rate, mono 16-bit out. 32-bit input is narrowed on the way in.
+//
+// Polyphase windowed-sinc FIR: AUDIO_RESAMPLE_PHASES sub-filters of
+// AUDIO_RESAMPLE_TAPS taps, with the output linearly interpolated between
+// the two phases around each fractional position, so any pair of rates
+// works without a per-ratio table. The cutoff follows the lower of the two
+// rates, which makes the same filter the anti-imaging filter when
+// upsampling and the anti-aliasing filter when downsampling. Coefficients
+// are Q14 and accumulate in 32 bits.
+//
+// The output lags the input by AUDIO_RESAMPLE_TAPS / 2 input frames;
+// flush() pushes out the tail at the end of a stream.
+
+#define AUDIO_RESAMPLE_TAPS     32
+#define AUDIO_RESAMPLE_PHASES   64
+#define AUDIO_RESAMPLE_BLOCK    256         // input frames taken per step
+#define AUDIO_RESAMPLE_OUT      1024        // frames in the write() staging buffer
+#define AUDIO_RESAMPLE_COEF_Q   14
+#define AUDIO_RESAMPLE_FLUSH_MAX ((AUDIO_RESAMPLE_TAPS / 2 + 1) * 8 + 2)
+
+typedef struct {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint16_t in_bits;           // 16 or 32
+    bool passthrough;           // equal rates: samples only narrowed
+    uint64_t step;              // input frames per output frame, Q32
+    uint64_t pos;               // next output's position in hist, Q32
+    size_t hist_len;
+    int16_t hist[AUDIO_RESAMPLE_TAPS + AUDIO_RESAMPLE_BLOCK];
+    int16_t coef[AUDIO_RESAMPLE_PHASES + 1][AUDIO_RESAMPLE_TAPS];
+    int16_t out[AUDIO_RESAMPLE_OUT];
+} audio_resampler_t;
+
+// Starts a stream. Returns AUDIO_OK, or AUDIO_ERR_FORMAT for a zero rate,
+// a ratio beyond 1:8 either way or an unsupported bit depth.
+int audio_resample_init(audio_resampler_t *r, uint32_t in_rate, uint16_t in_bits, uint32_t out_rate);
+
+// Most frames process() can produce from `in_frames` input frames
+size_t audio_resample_max_out(const audio_resampler_t *r, size_t in_frames);
+
+// Converts `frames` input frames into `out` (room for max_out(frames)) and
+// returns the frames written.
+size_t audio_resample_process(audio_resampler_t *r, const void *in, size_t frames, int16_t *out);
+
+// Remaining output once the input has ended, at most AUDIO_RESAMPLE_FLUSH_MAX
+// frames; the stream must be re-initialized afterwards.
+size_t audio_resample_flush(audio_resampler_t *r, int16_t *out);
+
+// process() / flush() through the internal staging buffer into `sink`,
+// adding the bytes accepted to *bytes_written. Equal-rate 16-bit input goes
+// to the sink as is. Returns AUDIO_OK or AUDIO_ERR_IO.
+int audio_resample_write(audio_resampler_t *r, const void *in, size_t frames, const audio_sink_t *sink,
+                         uint32_t *bytes_written);
+int audio_resample_finish(audio_resampler_t *r, const audio_sink_t *sink, uint32_t *bytes_written);
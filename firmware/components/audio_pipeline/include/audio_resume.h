@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Resumes a download that fails mid-body instead of ending the clip early.
+// Wraps a source that supports open_range(): when a read errors, or the
+// body ends before its Content-Length, the wrapper reopens the URL from the
+// byte offset reached with an HTTP Range request and carries on, so the
+// pipeline keeps feeding the same ring and playback never restarts. A
+// server that ignores the range and answers 200 is skipped forward to the
+// offset.
+//
+// Reconnects back off exponentially from backoff_ms up to max_backoff_ms,
+// and stop after max_retries attempts per download or once the next attempt
+// would start past deadline_us, when the signed URL is no longer valid.
+// Then the read fails and the pipeline ends the message with AUDIO_ERR_IO.
+// A cancelled download (the pipeline's flag, in `cancelled`) stops waiting
+// within a few ms and does not retry.
+
+typedef struct {
+    uint32_t max_retries;       // reconnect attempts per download, 0 = never resume
+    uint32_t backoff_ms;        // wait before the first attempt, doubled after each failure
+    uint32_t max_backoff_ms;
+    int64_t deadline_us;        // audio_time_us() after which the URL has expired, 0 = none
+    const volatile bool *cancelled; // stop retrying once set, NULL = never
+} audio_resume_config_t;
+
+typedef struct {
+    audio_source_t inner;
+    audio_resume_config_t cfg;
+    const char *url;            // the caller's, valid until close
+    int length;                 // body length from open(), 0 = unknown (chunked)
+    uint32_t offset;            // body bytes delivered so far
+    uint32_t resumes;           // successful reopens
+    uint32_t retries;           // reopen attempts, successful or not
+    uint32_t skipped;           // bytes discarded after a 200 to a Range request
+    uint32_t stalled_ms;        // time from failure to resumed body
+} audio_resume_t;
+
+// `out` reads through `r`; counters reset on every open()
+void audio_resume_bind(audio_resume_t *r, const audio_source_t *inner, const audio_resume_config_t *cfg,
+                       audio_source_t *out);
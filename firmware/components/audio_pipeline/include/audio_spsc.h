@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_io.h"
+#include "audio_port.h"
+
+// Lock-free single-producer/single-consumer byte ring between the downloader
+// and the I2S writer, behind audio_ring_t.
+//
+// The producer and the consumer each own one free-running 32-bit index
+// (head, tail) and publish it with a single atomic store, so a block moves
+// with two atomic stores and no lock, critical section or scheduler call.
+// Each index sits on its own cache line with the fields only its owner
+// writes, so the two sides do not invalidate each other's line on every
+// block (the S3 keeps the struct in uncached internal RAM; the host does
+// not). The capacity is a power of two, so a position is a mask away.
+//
+// Slots are contiguous like RINGBUF_TYPE_NOSPLIT: acquire() hands out `len`
+// bytes of storage that fit before its end, skipping the tail gap when they
+// do not (counted as used until the reader passes it), and receive() hands
+// out everything readable up to the end of storage or a skipped gap in one
+// span. Since no slot straddles the end, every span holds whole blocks.
+//
+// Blocking goes through two injected signals, touched only when a side is
+// about to wait: it flags itself waiting, checks once more, then sleeps on
+// its signal, and the other side signals after publishing its index only
+// when that flag is set.
+//
+// One task produces and one consumes at a time; either role may move to
+// another task in between streams (main.c drains the ring from the worker),
+// as long as the handover synchronizes. receive() hands out one span at a
+// time: return it before the next.
+
+typedef struct {
+    // Producer: head and what it alone writes
+    _Alignas(AUDIO_CACHE_LINE) atomic_uint head;    // end of committed data
+    atomic_uint gap_at;         // start of a skipped tail gap, 0 (a lap boundary) when none
+    atomic_bool writer_waiting;
+    atomic_bool finished;       // end of stream: an empty ring ends receive()
+    uint32_t slot;              // index of the slot being filled
+
+    // Consumer: tail and what it alone writes
+    _Alignas(AUDIO_CACHE_LINE) atomic_uint tail;    // start of unread data
+    atomic_bool reader_waiting;
+    uint32_t outstanding;       // bytes of the span handed out by receive()
+
+    // Set once by init
+    _Alignas(AUDIO_CACHE_LINE) uint8_t *buf;
+    uint32_t capacity;
+    uint32_t mask;
+    audio_signal_t readable;    // producer -> a waiting consumer
+    audio_signal_t writable;    // consumer -> a waiting producer
+} audio_spsc_t;
+
+// `buf` is the caller's storage, `capacity` bytes and a power of two.
+// The signals must not be shared. AUDIO_ERR_FORMAT when the capacity is not
+// a power of two.
+int audio_spsc_init(audio_spsc_t *r, uint8_t *buf, size_t capacity, const audio_signal_t *readable,
+                    const audio_signal_t *writable);
+
+// Also starts a new stream (clears finished); slots may be up to half the
+// capacity
+void audio_spsc_bind(audio_spsc_t *r, audio_ring_t *out);
+
+// Bytes committed and not yet returned, skipped gaps included. From any
+// task: a snapshot of two atomic loads, for fill-level statistics.
+size_t audio_spsc_used(const audio_spsc_t *r);
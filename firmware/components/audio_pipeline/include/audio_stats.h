@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_port.h"
+
+// Device health snapshot, published as compact JSON like the per-message
+// traces (audio_trace.h) so an underrun or a slow message can be set against
+// what the device was doing: CPU per task and per core, heap per
+// capability, stack high-water marks, how full the playback ring ran, Wi-Fi
+// signal, the playback queue and MQTT reconnects. The platform fills it in;
+// the portable parts are the ring fill histogram and the JSON.
+
+#define AUDIO_STATS_MAX_TASKS 32
+#define AUDIO_STATS_MAX_CORES 2
+#define AUDIO_STATS_TASK_NAME_MAX 16    // configMAX_TASK_NAME_LEN
+#define AUDIO_STATS_FILL_BUCKETS 8      // eighths of the ring
+#define AUDIO_STATS_JSON_MAX 6144      // a full task list of escaped names fits
+
+typedef struct {
+    char name[AUDIO_STATS_TASK_NAME_MAX];
+    int8_t core;                // -1 = not pinned
+    int16_t cpu_permille;       // of one core over the interval; -1 = not measured
+    uint32_t stack_free;        // least stack ever free, bytes
+} audio_stats_task_t;
+
+typedef struct {
+    uint32_t free;
+    uint32_t min_free;          // low-water mark since boot
+    uint32_t largest;           // largest free block: falls as the heap fragments
+} audio_stats_heap_t;
+
+typedef struct {
+    uint32_t counts[AUDIO_STATS_FILL_BUCKETS];  // samples by fill, emptiest first
+    uint32_t max_permille;      // fullest sample
+} audio_fill_counts_t;
+
+// Ring fill sampled while a clip plays (from a timer on the device)
+typedef struct {
+    audio_fill_counts_t counts;
+    audio_lock_t lock;          // added to by the sampler, taken by the snapshot
+} audio_fill_hist_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t uptime_s;
+    uint32_t interval_ms;       // since the previous snapshot: what CPU and ring fill cover
+    int16_t core_busy_permille[AUDIO_STATS_MAX_CORES];  // -1 = not measured
+    audio_stats_task_t tasks[AUDIO_STATS_MAX_TASKS];
+    size_t task_count;
+    audio_stats_heap_t internal;
+    audio_stats_heap_t psram;
+    audio_stats_heap_t dma;
+    uint32_t ring_kb;
+    audio_fill_counts_t ring_fill;
+    uint32_t queue_depth;       // messages waiting now
+    uint32_t queue_max_depth;   // high-water mark since boot
+    uint32_t queue_dropped;     // rejected or displaced since boot
+    int8_t rssi;                // dBm, 0 = not associated
+    uint32_t mqtt_connects;     // since boot
+    uint32_t mqtt_disconnects;
+    uint32_t messages;          // played or failed since boot
+    uint32_t underruns;         // summed over those messages
+} audio_stats_t;
+
+void audio_fill_hist_init(audio_fill_hist_t *h);
+
+void audio_fill_hist_add(audio_fill_hist_t *h, size_t used, size_t capacity);
+
+// The counts since the previous take
+audio_fill_counts_t audio_fill_hist_take(audio_fill_hist_t *h);
+
+// Compact JSON into `buf`. Returns its length, or -1 if it did not fit.
+int audio_stats_format(const audio_stats_t *s, char *buf, size_t len);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// Synchronized playback for a group of devices playing the same clip. Every
+// device gets the same start time on a shared clock (play_at, SNTP time on
+// the device); the writer holds its first sample until then, or skips what
+// should already have played when it is late, and from there keeps the
+// clip's position on the shared clock. Later than AUDIO_SYNC_MAX_LATE_US the
+// group is too far into the clip to join: it plays from its start,
+// unsynchronized, rather than skipping most or all of it.
+//
+// The local clock the sink runs on and the shared clock drift apart (the
+// crystal's error, which SNTP slews out of the shared clock), so the writer
+// compares how far into the clip the sink is by its playback clock (audio
+// handed over since the first write, less the gaps it starved) with the
+// shared time since play_at. An error over AUDIO_SYNC_DEADBAND_US is
+// corrected by repeating or dropping one frame per AUDIO_SYNC_BLOCK_FRAMES,
+// which is inaudible and follows up to ~2000 ppm. Falling more than
+// AUDIO_SYNC_RESYNC_US behind (a stall) skips the difference at once.
+// A sample rate the I2S divider cannot hit exactly is not seen this way;
+// it is the same on every device of one build.
+//
+// A sink that is already running when the writer starts (I2S DMA cycling
+// through cleared buffers) plays a write only after the audio queued ahead
+// of it; output_delay_us moves the first write that much earlier.
+
+#define AUDIO_SYNC_DEADBAND_US   500
+#define AUDIO_SYNC_RESYNC_US     20000
+#define AUDIO_SYNC_MAX_LATE_US   500000
+#define AUDIO_SYNC_BLOCK_FRAMES  512
+// Sleep until this close to the start, then poll the clock
+#define AUDIO_SYNC_SPIN_US       2000
+
+typedef struct {
+    int64_t start_error_us;     // shared time of the first write minus its target (> 0 late)
+    uint32_t skipped_frames;    // dropped to catch up after a late start or a stall
+    int32_t slipped_frames;     // drift correction: + repeated, - dropped
+    uint32_t corrections;       // blocks that repeated or dropped frames
+    int32_t max_error_us;       // largest |error| once playing in step
+    int32_t error_us;           // at the last block; > 0 ahead of the shared clock
+} audio_sync_stats_t;
+
+typedef struct {
+    audio_clock_t clock;
+    int64_t play_at_us;         // first sample, on the shared clock
+    bool correct_drift;
+    int64_t output_delay_us;    // from a write to it being heard, 0 when at once
+    volatile bool cancelled;    // stops a start still waiting (audio_pipeline_cancel)
+
+    uint32_t sample_rate;       // of the frames being slipped
+    int64_t skip_frames;        // still to drop
+    audio_sync_stats_t stats;
+} audio_sync_t;
+
+// output_delay_us starts at 0; set it after init for a sink that needs it
+void audio_sync_init(audio_sync_t *s, const audio_clock_t *clock, int64_t play_at_us, bool correct_drift);
+
+// Blocks until the shared clock reaches `at_us`, or until `*cancelled` is
+// set when given (checked every few ms). Returns how late it is then in
+// microseconds (about 0 when it waited, < 0 when cancelled), or INT64_MIN
+// if the clock is not set.
+int64_t audio_sync_wait_until(const audio_clock_t *clock, int64_t at_us, const volatile bool *cancelled);
+
+// Writer side, before the first block: waits for play_at and, when already
+// past it, sets up the frames of `sample_rate` audio to skip. False when the
+// clock is not set or play_at is more than AUDIO_SYNC_MAX_LATE_US past (the
+// clip then plays unsynchronized), or the wait was cancelled.
+bool audio_sync_start(audio_sync_t *s, uint32_t sample_rate);
+
+// Writer side, before each block of at most AUDIO_SYNC_BLOCK_FRAMES frames:
+// returns how many frames to take off its start (to skip a late start, or a
+// resync), and in *repeat whether to play its last frame twice (1) or drop
+// it (-1) for drift. `played_us` is how much of the sink's audio has been
+// heard by the playback clock.
+uint32_t audio_sync_block(audio_sync_t *s, int64_t played_us, uint32_t frames, int32_t *repeat);
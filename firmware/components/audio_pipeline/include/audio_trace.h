@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_cache.h"
+#include "audio_pipeline.h"
+#include "audio_port.h"
+
+// Where a notification spent its time. Each message gets one record: the
+// moments it reached each stage of MQTT receive -> playback worker ->
+// I2S writer, in milliseconds since the MQTT message arrived, plus what the
+// download moved. Records are published as compact JSON, and a rolling
+// window of the last AUDIO_TRACE_WINDOW messages gives p50/p95/p99 per
+// stage on request.
+
+#define AUDIO_TRACE_WINDOW 64
+#define AUDIO_TRACE_JSON_MAX 512    // a record or a summary, formatted
+
+typedef enum {
+    AUDIO_SPAN_OPEN,            // source open requested (after queueing)
+    AUDIO_SPAN_HEADERS,         // HTTP response headers in
+    AUDIO_SPAN_FIRST_BYTE,      // first body byte
+    AUDIO_SPAN_PREFILL,         // enough buffered, writer launched
+    AUDIO_SPAN_FIRST_WRITE,     // first block to I2S
+    AUDIO_SPAN_PLAYED,          // last sample audible
+    AUDIO_SPAN_COUNT
+} audio_span_t;
+
+typedef struct {
+    uint32_t seq;
+    char filename[AUDIO_CACHE_KEY_MAX];
+    int32_t at_ms[AUDIO_SPAN_COUNT];   // since MQTT receive; -1 = not reached
+    uint32_t bytes;             // body bytes downloaded (incl. WAV header)
+    uint32_t kbps;              // download throughput, open to last byte
+    uint32_t underruns;
+    uint32_t starved_ms;        // total time I2S had nothing to play
+    int32_t preempt_ms;         // cancelled for an urgent message: from then to silent; -1 = played out
+    bool cached;                // played from the audio cache
+    bool ok;
+} audio_trace_t;
+
+// Fills the spans and counters from a finished (or failed) pipeline
+void audio_trace_from_stats(audio_trace_t *t, int64_t t_received_us, const audio_pipeline_stats_t *s);
+
+// Compact JSON into `buf`. Returns its length, or -1 if it did not fit.
+int audio_trace_format(const audio_trace_t *t, char *buf, size_t len);
+
+typedef struct {
+    int32_t at_ms[AUDIO_TRACE_WINDOW][AUDIO_SPAN_COUNT];
+    size_t next;
+    size_t count;
+    audio_lock_t lock;          // added to by the worker, read by the MQTT task
+} audio_trace_window_t;
+
+typedef struct {
+    uint32_t n;                 // messages in the window that reached the stage
+    int32_t p50, p95, p99;      // nearest rank, ms; -1 when n == 0
+} audio_percentiles_t;
+
+void audio_trace_window_init(audio_trace_window_t *w);
+
+// Adds a record, replacing the oldest once the window is full
+void audio_trace_window_add(audio_trace_window_t *w, const audio_trace_t *t);
+
+audio_percentiles_t audio_trace_percentiles(audio_trace_window_t *w, audio_span_t span);
+
+// Every stage's percentiles as compact JSON, like audio_trace_format()
+int audio_trace_format_summary(audio_trace_window_t *w, char *buf, size_t len);
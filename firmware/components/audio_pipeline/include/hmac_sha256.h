@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(ESP_PLATFORM)
+#include "mbedtls/sha256.h"
+#endif
+
+// Streaming HMAC-SHA256 (RFC 2104). On the device the hash runs on the
+// SHA accelerator through mbedtls (CONFIG_MBEDTLS_HARDWARE_SHA); the host
+// build uses a portable implementation with the same interface.
+
+#define HMAC_SHA256_LEN 32
+
+typedef struct {
+#if defined(ESP_PLATFORM)
+    mbedtls_sha256_context sha;
+#else
+    uint32_t state[8];
+    uint64_t total;             // bytes hashed
+    uint8_t block[64];
+    size_t used;                // bytes waiting in block
+#endif
+    uint8_t opad[64];           // key ^ 0x5c, for the outer hash
+} hmac_sha256_t;
+
+void hmac_sha256_start(hmac_sha256_t *h, const uint8_t *key, size_t key_len);
+void hmac_sha256_update(hmac_sha256_t *h, const void *data, size_t len);
+void hmac_sha256_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]);
+
+// One-shot SHA-256, for keys longer than a block and for tests
+void sha256(const void *data, size_t len, uint8_t out[HMAC_SHA256_LEN]);
+
+// Plain SHA-256 of data that arrives in pieces, in the same context
+void sha256_start(hmac_sha256_t *h);
+void sha256_update(hmac_sha256_t *h, const void *data, size_t len);
+void sha256_finish(hmac_sha256_t *h, uint8_t out[HMAC_SHA256_LEN]);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Microsoft/IMA ADPCM (WAVE_FORMAT_IMA_ADPCM, 4 bits per sample) block
+// decoder. A block starts with a 4-byte header per channel (first sample,
+// step index, reserved) followed by nibbles, low nibble first; stereo data
+// is interleaved in 4-byte (8-sample) groups per channel.
+
+#define IMA_ADPCM_HEADER_BYTES 4
+
+// Samples per channel contained in a block of `block_bytes` bytes.
+size_t ima_adpcm_block_samples(size_t block_bytes, uint16_t channels);
+
+// Decode one (possibly short, final) block into interleaved int16 PCM.
+// Returns the number of frames written to `out`, 0 if the block is malformed.
+size_t ima_adpcm_decode_block(const uint8_t *block, size_t block_bytes, uint16_t channels, int16_t *out);
+
+// Encoder state for one channel; used by the host tools to build test clips.
+typedef struct {
+    int32_t predictor;
+    int32_t index;
+} ima_adpcm_state_t;
+
+uint8_t ima_adpcm_encode_sample(ima_adpcm_state_t *st, int16_t sample);
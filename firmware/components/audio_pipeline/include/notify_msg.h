@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation-free decoder for the MQTT notification (docs/api.md). One pass
+// over the payload validates it as JSON and records where each known member's
+// string value lies, without copying or building a tree; unknown members are
+// skipped, so new fields from the functions never break older firmware.
+// Strings are unescaped only when copied out with notify_str_copy().
+//
+// Signed messages end with a "signature" member: the hex HMAC-SHA256 of the
+// message as it was before the member was appended, i.e. the payload up to
+// the comma in front of "signature", closed with "}". notify_msg_verify()
+// recomputes it over those bytes in place. The functions also sign a send
+// time and a random nonce, so notify_replay_check() can refuse a captured
+// message sent again later.
+
+#define NOTIFY_MAX_DEPTH 8      // nesting allowed inside unknown members
+
+typedef struct {
+    const char *p;              // points into the payload, not terminated
+    size_t len;                 // 0 and p == NULL when the member is absent
+    bool escaped;               // contains backslash escapes
+} notify_str_t;
+
+typedef struct {
+    notify_str_t file_url;
+    notify_str_t filename;
+    notify_str_t timestamp;
+    notify_str_t cmd;
+    notify_str_t signature;
+    notify_str_t inline_sha256; // hex SHA-256 of the inline clip
+    int32_t chime;              // -1 when absent or not an integer
+    int32_t gap_ms;
+    int32_t inline_id;          // clip following as MQTT chunks (audio_inline.h)
+    int32_t inline_bytes;
+    int32_t priority;           // higher preempts lower (audio_queue.h)
+    int64_t play_at;            // group start, ms since the Unix epoch (audio_sync.h)
+    int64_t sent_at;            // publish time, ms since the Unix epoch; -1 when absent
+    int64_t nonce;              // random per message, > 0; -1 when absent
+    size_t signed_len;          // payload bytes covered by the signature, 0 = unsigned
+} notify_msg_t;
+
+typedef enum {
+    NOTIFY_OK = 0,
+    NOTIFY_ERR_SYNTAX = -1,     // not a single JSON object
+    NOTIFY_ERR_DEPTH = -2,      // nested deeper than NOTIFY_MAX_DEPTH
+    NOTIFY_ERR_SIGNATURE = -3,  // "signature" is not the last member, or not a string
+} notify_result_t;
+
+notify_result_t notify_msg_parse(const char *json, size_t len, notify_msg_t *m);
+
+// Unescapes `s` into `dst` and terminates it. Returns the length, or -1 if
+// it does not fit in `cap` (dst then holds an empty string).
+int notify_str_copy(char *dst, size_t cap, notify_str_t s);
+
+// Whether `s` unescapes to exactly `lit`
+bool notify_str_eq(notify_str_t s, const char *lit);
+
+// Decodes `s` as exactly `n` bytes of hex into `out`
+bool notify_str_hex(notify_str_t s, uint8_t *out, size_t n);
+
+// Checks the signature of a parsed message against `key` in constant time.
+// An unsigned message never verifies.
+bool notify_msg_verify(const notify_msg_t *m, const char *json, const uint8_t *key, size_t key_len);
+
+// Signed messages the device has accepted, to refuse them when they come
+// again. Nonces are remembered in a ring; a message no newer than the newest
+// one pushed out of it is refused too, so a full ring never readmits one.
+#define NOTIFY_REPLAY_SLOTS 32
+
+typedef struct {
+    int64_t nonce[NOTIFY_REPLAY_SLOTS];
+    int64_t sent_at[NOTIFY_REPLAY_SLOTS];
+    size_t next;
+    size_t count;
+    int64_t floor_ms;           // newest sent_at forgotten, -1 = none yet
+} notify_replay_t;
+
+typedef enum {
+    NOTIFY_FRESH = 0,
+    NOTIFY_UNSTAMPED = -1,      // no sent_at or nonce
+    NOTIFY_STALE = -2,          // sent more than max_age_ms from now, either way
+    NOTIFY_REPLAYED = -3,       // nonce seen, or older than what was forgotten
+} notify_replay_result_t;
+
+void notify_replay_init(notify_replay_t *r);
+
+// Checks a verified message and remembers it when fresh. `now_ms` is Unix
+// time, < 0 while the clock is not set: only repeats are refused then.
+notify_replay_result_t notify_replay_check(notify_replay_t *r, const notify_msg_t *m, int64_t now_ms,
+                                           int64_t max_age_ms);
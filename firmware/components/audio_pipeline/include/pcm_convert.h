@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// PCM format-conversion kernels used between the HTTP reader and the ring.
+//
+// All kernels accept dst == src (in place). On the ESP32-S3 the 16-bit
+// kernels use the PIE 128-bit SIMD unit for 16-byte aligned buffers and
+// fall back to the portable loops otherwise; on the host the portable loops
+// are written so the compiler can auto-vectorize them. Results are
+// bit-identical across paths.
+
+// Gains are Q12 fixed point: 4096 = 1.0, max 32767 (~8x).
+#define PCM_GAIN_Q          12
+#define PCM_GAIN_UNITY      (1 << PCM_GAIN_Q)
+#define PCM_GAIN_MAX        32767
+
+// Interleaved stereo -> mono, (L >> 1) + (R >> 1). Cannot overflow.
+void pcm_downmix_s16(int16_t *dst, const int16_t *src, size_t frames);
+void pcm_downmix_s32(int32_t *dst, const int32_t *src, size_t frames);
+
+// 32-bit -> 16-bit with round-to-nearest and saturation.
+void pcm_narrow_s32_to_s16(int16_t *dst, const int32_t *src, size_t samples);
+
+// In-place gain with saturation. Inputs are first clamped to the range that
+// still fits after scaling, then multiplied and shifted by PCM_GAIN_Q.
+void pcm_gain_s16(int16_t *buf, size_t samples, int32_t gain_q12);
+
+// In-place gain moving from `from_q12` towards `to_q12` in steps of 8
+// samples: group k of G = ceil(samples / 8) is scaled by
+// from + (to - from) * (k + 1) / G. Unlike pcm_gain_s16 the input is not
+// clamped first; the caller keeps products in range (the limiter does by
+// construction), anything else saturates on the portable path only.
+void pcm_gain_ramp_s16(int16_t *buf, size_t samples, int32_t from_q12, int32_t to_q12);
+
+// Unoptimized references for tests and benchmarks.
+void pcm_downmix_s16_ref(int16_t *dst, const int16_t *src, size_t frames);
+void pcm_downmix_s32_ref(int32_t *dst, const int32_t *src, size_t frames);
+void pcm_narrow_s32_to_s16_ref(int16_t *dst, const int32_t *src, size_t samples);
+void pcm_gain_s16_ref(int16_t *buf, size_t samples, int32_t gain_q12);
+void pcm_gain_ramp_s16_ref(int16_t *buf, size_t samples, int32_t from_q12, int32_t to_q12);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+#define WAV_HEADER_MAX  4096    // give up if "data" has not started by then
+
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_IMA_ADPCM    0x0011
+
+// Largest IMA ADPCM block the pipeline decodes in one go (stereo 1024-byte
+// blocks decode to 1017 frames = 4068 bytes, which fits one 4 KB chunk)
+#define WAV_IMA_ADPCM_MAX_BLOCK 1024
+
+typedef struct {
+    uint16_t format_tag;
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    uint16_t block_align;
+    uint16_t samples_per_block; // IMA ADPCM only
+    uint32_t data_size;         // size of the "data" chunk as declared
+} wav_info_t;
+
+// Walk the RIFF chunks from `src` up to the start of the "data" payload,
+// skipping LIST/fact/JUNK chunks. Returns the number of header bytes
+// consumed, or < 0 if the stream is not a readable WAVE file.
+int wav_header_read(const audio_source_t *src, wav_info_t *info);
+
+// 16/32-bit PCM or 4-bit IMA ADPCM, mono or stereo.
+bool wav_format_supported(const wav_info_t *info);
+
+// Bits per sample of the PCM that the decoder stage produces.
+uint16_t wav_output_bits(const wav_info_t *info);
@@ -0,0 +1,340 @@
+#include <string.h>
+#include "hmac_sha256.h"
+#include "notify_msg.h"
+
+typedef struct {
+    const char *p;
+    const char *end;
+    int depth;
+} cursor_t;
+
+static void skip_ws(cursor_t *c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\n' || *c->p == '\r')) c->p++;
+}
+
+static int hex_digit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+// At the opening quote; leaves the cursor after the closing one
+static bool scan_string(cursor_t *c, notify_str_t *out) {
+    if (c->p >= c->end || *c->p != '"') return false;
+    const char *start = ++c->p;
+    bool escaped = false;
+    while (c->p < c->end) {
+        unsigned char ch = (unsigned char)*c->p;
+        if (ch == '"') {
+            *out = (notify_str_t) { .p = start, .len = (size_t)(c->p - start), .escaped = escaped };
+            c->p++;
+            return true;
+        }
+        if (ch < 0x20) return false;
+        if (ch == '\\') {
+            escaped = true;
+            if (++c->p >= c->end) return false;
+            if (*c->p == 'u') {
+                if (c->end - c->p < 5) return false;
+                for (int i = 1; i <= 4; i++) {
+                    if (hex_digit(c->p[i]) < 0) return false;
+                }
+                c->p += 4;
+            } else if (!strchr("\"\\/bfnrt", *c->p) || *c->p == '\0') {
+                return false;
+            }
+        }
+        c->p++;
+    }
+    return false;
+}
+
+// JSON number grammar; *value gets the integer when it is one and fits
+// (digits past 18 mark it as not fitting)
+static bool scan_number(cursor_t *c, int64_t *value) {
+    bool neg = c->p < c->end && *c->p == '-';
+    if (neg) c->p++;
+    if (c->p >= c->end || *c->p < '0' || *c->p > '9') return false;
+    int64_t v = 0;
+    bool integral = true;
+    int digits = 0;
+    if (*c->p == '0') {
+        c->p++;
+    } else {
+        while (c->p < c->end && *c->p >= '0' && *c->p <= '9') {
+            if (++digits <= 18) v = v * 10 + (*c->p - '0');
+            c->p++;
+        }
+    }
+    if (c->p < c->end && *c->p == '.') {
+        integral = false;
+        if (++c->p >= c->end || *c->p < '0' || *c->p > '9') return false;
+        while (c->p < c->end && *c->p >= '0' && *c->p <= '9') c->p++;
+    }
+    if (c->p < c->end && (*c->p == 'e' || *c->p == 'E')) {
+        integral = false;
+        c->p++;
+        if (c->p < c->end && (*c->p == '+' || *c->p == '-')) c->p++;
+        if (c->p >= c->end || *c->p < '0' || *c->p > '9') return false;
+        while (c->p < c->end && *c->p >= '0' && *c->p <= '9') c->p++;
+    }
+    if (neg) v = -v;
+    *value = integral && digits <= 18 ? v : -1;
+    return true;
+}
+
+static bool scan_literal(cursor_t *c, const char *lit) {
+    size_t n = strlen(lit);
+    if ((size_t)(c->end - c->p) < n || memcmp(c->p, lit, n) != 0) return false;
+    c->p += n;
+    return true;
+}
+
+static notify_result_t skip_value(cursor_t *c);
+
+// At '{' or '['; leaves the cursor after the matching bracket
+static notify_result_t skip_container(cursor_t *c) {
+    char close = *c->p == '{' ? '}' : ']';
+    bool object = close == '}';
+    if (++c->depth > NOTIFY_MAX_DEPTH) return NOTIFY_ERR_DEPTH;
+    c->p++;
+    skip_ws(c);
+    if (c->p < c->end && *c->p == close) {
+        c->p++;
+        c->depth--;
+        return NOTIFY_OK;
+    }
+    for (;;) {
+        if (object) {
+            notify_str_t key;
+            if (!scan_string(c, &key)) return NOTIFY_ERR_SYNTAX;
+            skip_ws(c);
+            if (c->p >= c->end || *c->p++ != ':') return NOTIFY_ERR_SYNTAX;
+        }
+        notify_result_t r = skip_value(c);
+        if (r != NOTIFY_OK) return r;
+        skip_ws(c);
+        if (c->p >= c->end) return NOTIFY_ERR_SYNTAX;
+        if (*c->p == close) {
+            c->p++;
+            c->depth--;
+            return NOTIFY_OK;
+        }
+        if (*c->p++ != ',') return NOTIFY_ERR_SYNTAX;
+        skip_ws(c);
+    }
+}
+
+static notify_result_t skip_value(cursor_t *c) {
+    skip_ws(c);
+    if (c->p >= c->end) return NOTIFY_ERR_SYNTAX;
+    notify_str_t s;
+    int64_t n;
+    switch (*c->p) {
+        case '{':
+        case '[': return skip_container(c);
+        case '"': return scan_string(c, &s) ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+        case 't': return scan_literal(c, "true") ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+        case 'f': return scan_literal(c, "false") ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+        case 'n': return scan_literal(c, "null") ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+        default: return scan_number(c, &n) ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+    }
+}
+
+static bool key_is(notify_str_t key, const char *name) {
+    return !key.escaped && key.len == strlen(name) && memcmp(key.p, name, key.len) == 0;
+}
+
+notify_result_t notify_msg_parse(const char *json, size_t len, notify_msg_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->chime = m->gap_ms = m->inline_id = m->inline_bytes = m->priority = -1;
+    m->play_at = m->sent_at = m->nonce = -1;
+    cursor_t c = { .p = json, .end = json + len };
+    skip_ws(&c);
+    if (c.p >= c.end || *c.p != '{') return NOTIFY_ERR_SYNTAX;
+    c.p++;
+    c.depth = 1;
+    skip_ws(&c);
+    bool empty = c.p < c.end && *c.p == '}';
+    if (empty) c.p++;
+    const char *member_start = NULL;    // the ',' before the current member
+    while (!empty) {
+        notify_str_t key;
+        if (!scan_string(&c, &key)) return NOTIFY_ERR_SYNTAX;
+        if (m->signature.p) return NOTIFY_ERR_SIGNATURE;
+        skip_ws(&c);
+        if (c.p >= c.end || *c.p++ != ':') return NOTIFY_ERR_SYNTAX;
+        skip_ws(&c);
+        if (c.p >= c.end) return NOTIFY_ERR_SYNTAX;
+
+        notify_str_t *field = key_is(key, "file_url") ? &m->file_url
+                            : key_is(key, "filename") ? &m->filename
+                            : key_is(key, "timestamp") ? &m->timestamp
+                            : key_is(key, "cmd") ? &m->cmd
+                            : key_is(key, "signature") ? &m->signature
+                            : key_is(key, "inline_sha256") ? &m->inline_sha256
+                            : NULL;
+        int32_t *number = key_is(key, "chime") ? &m->chime
+                        : key_is(key, "gap_ms") ? &m->gap_ms
+                        : key_is(key, "inline_id") ? &m->inline_id
+                        : key_is(key, "inline_bytes") ? &m->inline_bytes
+                        : key_is(key, "priority") ? &m->priority
+                        : NULL;
+        int64_t *number64 = key_is(key, "play_at") ? &m->play_at
+                          : key_is(key, "sent_at") ? &m->sent_at
+                          : key_is(key, "nonce") ? &m->nonce
+                          : NULL;
+        if (field == &m->signature) {
+            if (*c.p != '"' || !member_start) return NOTIFY_ERR_SIGNATURE;
+            m->signed_len = (size_t)(member_start - json);
+        }
+        if (field && *c.p == '"') {
+            if (!scan_string(&c, field)) return NOTIFY_ERR_SYNTAX;
+        } else if ((number || number64) && (*c.p == '-' || (*c.p >= '0' && *c.p <= '9'))) {
+            int64_t v;
+            if (!scan_number(&c, &v)) return NOTIFY_ERR_SYNTAX;
+            if (number64) {
+                *number64 = v;
+            } else {
+                *number = v >= INT32_MIN && v <= INT32_MAX ? (int32_t)v : -1;
+            }
+        } else {
+            // Known members of the wrong type count as absent, like cJSON_IsString() checks
+            notify_result_t r = skip_value(&c);
+            if (r != NOTIFY_OK) return r;
+        }
+
+        skip_ws(&c);
+        if (c.p >= c.end) return NOTIFY_ERR_SYNTAX;
+        if (*c.p == '}') {
+            c.p++;
+            break;
+        }
+        member_start = c.p;
+        if (*c.p++ != ',') return NOTIFY_ERR_SYNTAX;
+        skip_ws(&c);
+    }
+    skip_ws(&c);
+    // Tolerate the NUL some publishers send with the payload
+    if (c.p < c.end && *c.p == '\0' && c.p + 1 == c.end) c.p++;
+    return c.p == c.end ? NOTIFY_OK : NOTIFY_ERR_SYNTAX;
+}
+
+static size_t put_utf8(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xc0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xe0 | cp >> 12);
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | cp >> 18);
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+static uint32_t hex4(const char *p) {
+    return (uint32_t)(hex_digit(p[0]) << 12 | hex_digit(p[1]) << 8 | hex_digit(p[2]) << 4 | hex_digit(p[3]));
+}
+
+// Relies on notify_msg_parse() having validated the escapes
+int notify_str_copy(char *dst, size_t cap, notify_str_t s) {
+    if (cap == 0) return -1;
+    size_t o = 0;
+    for (size_t i = 0; i < s.len; i++) {
+        char tmp[4];
+        size_t n = 1;
+        tmp[0] = s.p[i];
+        if (s.p[i] == '\\') {
+            char e = s.p[++i];
+            if (e == 'u') {
+                uint32_t cp = hex4(s.p + i + 1);
+                i += 4;
+                if (cp >= 0xd800 && cp < 0xdc00 && i + 6 < s.len && s.p[i + 1] == '\\' && s.p[i + 2] == 'u') {
+                    uint32_t lo = hex4(s.p + i + 3);
+                    if (lo >= 0xdc00 && lo < 0xe000) {
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                        i += 6;
+                    }
+                }
+                if (cp >= 0xd800 && cp < 0xe000) cp = 0xfffd;    // unpaired surrogate
+                n = put_utf8(tmp, cp);
+            } else {
+                tmp[0] = e == 'b' ? '\b' : e == 'f' ? '\f' : e == 'n' ? '\n' : e == 'r' ? '\r' : e == 't' ? '\t' : e;
+            }
+        }
+        if (o + n >= cap) {
+            dst[0] = '\0';
+            return -1;
+        }
+        memcpy(dst + o, tmp, n);
+        o += n;
+    }
+    dst[o] = '\0';
+    return (int)o;
+}
+
+bool notify_str_eq(notify_str_t s, const char *lit) {
+    char buf[32];
+    size_t n = strlen(lit);
+    if (!s.escaped) return s.len == n && memcmp(s.p, lit, n) == 0;
+    return n < sizeof(buf) && notify_str_copy(buf, sizeof(buf), s) == (int)n && memcmp(buf, lit, n) == 0;
+}
+
+bool notify_str_hex(notify_str_t s, uint8_t *out, size_t n) {
+    if (s.len != 2 * n || s.escaped) return false;
+    for (size_t i = 0; i < n; i++) {
+        int hi = hex_digit(s.p[2 * i]), lo = hex_digit(s.p[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+bool notify_msg_verify(const notify_msg_t *m, const char *json, const uint8_t *key, size_t key_len) {
+    uint8_t want[HMAC_SHA256_LEN];
+    if (!m->signed_len || !notify_str_hex(m->signature, want, sizeof(want))) return false;
+    hmac_sha256_t h;
+    uint8_t got[HMAC_SHA256_LEN];
+    hmac_sha256_start(&h, key, key_len);
+    hmac_sha256_update(&h, json, m->signed_len);
+    hmac_sha256_update(&h, "}", 1);
+    hmac_sha256_finish(&h, got);
+    uint8_t diff = 0;
+    for (int i = 0; i < HMAC_SHA256_LEN; i++) diff |= got[i] ^ want[i];
+    return diff == 0;
+}
+
+void notify_replay_init(notify_replay_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->floor_ms = -1;
+}
+
+notify_replay_result_t notify_replay_check(notify_replay_t *r, const notify_msg_t *m, int64_t now_ms,
+                                           int64_t max_age_ms) {
+    if (m->sent_at < 0 || m->nonce <= 0) return NOTIFY_UNSTAMPED;
+    if (now_ms >= 0 && (m->sent_at < now_ms - max_age_ms || m->sent_at > now_ms + max_age_ms)) {
+        return NOTIFY_STALE;
+    }
+    if (m->sent_at <= r->floor_ms) return NOTIFY_REPLAYED;
+    for (size_t i = 0; i < r->count; i++) {
+        if (r->nonce[i] == m->nonce) return NOTIFY_REPLAYED;
+    }
+    if (r->count == NOTIFY_REPLAY_SLOTS && r->sent_at[r->next] > r->floor_ms) r->floor_ms = r->sent_at[r->next];
+    r->nonce[r->next] = m->nonce;
+    r->sent_at[r->next] = m->sent_at;
+    r->next = (r->next + 1) % NOTIFY_REPLAY_SLOTS;
+    if (r->count < NOTIFY_REPLAY_SLOTS) r->count++;
+    return NOTIFY_FRESH;
+}
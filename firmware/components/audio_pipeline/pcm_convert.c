@@ -0,0 +1,221 @@
+#include "pcm_convert.h"
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(CONFIG_AUDIO_PCM_SIMD)
+#define PCM_USE_PIE 1
+#else
+#define PCM_USE_PIE 0
+#endif
+
+// Keep the references scalar so benchmarks measure what vectorization buys
+#if defined(__GNUC__) && !defined(__clang__) && !defined(ESP_PLATFORM)
+#define PCM_NO_VECTORIZE __attribute__((optimize("no-tree-vectorize")))
+#else
+#define PCM_NO_VECTORIZE
+#endif
+
+static inline int16_t sat16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+// Input range [lo, hi] for which (x * gain) >> Q still fits in int16
+static inline void gain_limits(int32_t gain_q12, int16_t *lo, int16_t *hi) {
+    int32_t h = ((int32_t)INT16_MAX << PCM_GAIN_Q) / gain_q12;
+    int32_t l = ((int32_t)32768 << PCM_GAIN_Q) / gain_q12;
+    *hi = h > INT16_MAX ? INT16_MAX : (int16_t)h;
+    *lo = l > 32768 ? INT16_MIN : (int16_t)-l;
+}
+
+// ---- References ----
+
+PCM_NO_VECTORIZE
+void pcm_downmix_s16_ref(int16_t *dst, const int16_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        dst[i] = (int16_t)((src[2 * i] >> 1) + (src[2 * i + 1] >> 1));
+    }
+}
+
+PCM_NO_VECTORIZE
+void pcm_downmix_s32_ref(int32_t *dst, const int32_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        dst[i] = (src[2 * i] >> 1) + (src[2 * i + 1] >> 1);
+    }
+}
+
+PCM_NO_VECTORIZE
+void pcm_narrow_s32_to_s16_ref(int16_t *dst, const int32_t *src, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = sat16((int32_t)(((int64_t)src[i] + 0x8000) >> 16));
+    }
+}
+
+PCM_NO_VECTORIZE
+void pcm_gain_s16_ref(int16_t *buf, size_t samples, int32_t gain_q12) {
+    int16_t lo, hi;
+    gain_limits(gain_q12, &lo, &hi);
+    for (size_t i = 0; i < samples; i++) {
+        int32_t x = buf[i];
+        x = x > hi ? hi : (x < lo ? lo : x);
+        buf[i] = (int16_t)((x * gain_q12) >> PCM_GAIN_Q);
+    }
+}
+
+static inline int32_t ramp_step(int32_t from, int32_t to, size_t k, size_t groups) {
+    return from + (int32_t)((int64_t)(to - from) * (int64_t)(k + 1) / (int64_t)groups);
+}
+
+PCM_NO_VECTORIZE
+void pcm_gain_ramp_s16_ref(int16_t *buf, size_t samples, int32_t from_q12, int32_t to_q12) {
+    size_t groups = (samples + 7) / 8;
+    for (size_t i = 0; i < samples; i++) {
+        int32_t g = ramp_step(from_q12, to_q12, i / 8, groups);
+        buf[i] = sat16((buf[i] * g) >> PCM_GAIN_Q);
+    }
+}
+
+// ---- ESP32-S3 PIE (8 x int16 per 128-bit q register) ----
+
+#if PCM_USE_PIE
+static inline int pie_aligned(const void *a, const void *b) {
+    return ((((uintptr_t)a) | ((uintptr_t)b)) & 15) == 0;
+}
+
+// blocks of 8 output frames; src/dst 16-byte aligned
+static void downmix_s16_pie(int16_t *dst, const int16_t *src, size_t blocks) {
+    static const int16_t one = 1;
+    __asm__ volatile (
+        "movi       a8, 1\n"
+        "wsr.sar    a8\n"                       // products >> 1
+        "ee.vldbc.16 q6, %[one]\n"              // q6 = {1 x 8}
+        "loopnez    %[n], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"        // L0 R0 .. L3 R3
+        "ee.vld.128.ip q1, %[src], 16\n"        // L4 R4 .. L7 R7
+        "ee.vunzip.16 q0, q1\n"                 // q0 = L0..L7, q1 = R0..R7
+        "ee.vmul.s16 q0, q0, q6\n"              // L >> 1
+        "ee.vmul.s16 q1, q1, q6\n"              // R >> 1
+        "ee.vadds.s16 q2, q0, q1\n"
+        "ee.vst.128.ip q2, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(dst)
+        : [n] "r"(blocks), [one] "r"(&one)
+        : "a8", "memory");
+}
+
+// blocks of 8 samples; buf 16-byte aligned
+static void gain_s16_pie(int16_t *buf, size_t blocks, int16_t gain, int16_t lo, int16_t hi) {
+    int16_t *src = buf;
+    __asm__ volatile (
+        "movi       a8, %[q]\n"
+        "wsr.sar    a8\n"                       // products >> PCM_GAIN_Q
+        "ee.vldbc.16 q4, %[lo]\n"
+        "ee.vldbc.16 q5, %[hi]\n"
+        "ee.vldbc.16 q6, %[g]\n"
+        "loopnez    %[n], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vmin.s16 q0, q0, q5\n"              // clamp so the product fits
+        "ee.vmax.s16 q0, q0, q4\n"
+        "ee.vmul.s16 q0, q0, q6\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(buf)
+        : [n] "r"(blocks), [lo] "r"(&lo), [hi] "r"(&hi), [g] "r"(&gain), [q] "i"(PCM_GAIN_Q)
+        : "a8", "memory");
+}
+
+// blocks of 8 samples, each scaled by the next entry of `gains`; buf
+// 16-byte aligned
+static void gain_ramp_s16_pie(int16_t *buf, size_t blocks, const int16_t *gains) {
+    int16_t *src = buf;
+    __asm__ volatile (
+        "movi       a8, %[q]\n"
+        "wsr.sar    a8\n"                       // products >> PCM_GAIN_Q
+        "loopnez    %[n], 1f\n"
+        "ee.vldbc.16.ip q6, %[g], 2\n"          // this block's gain x 8
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vmul.s16 q0, q0, q6\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(buf), [g] "+r"(gains)
+        : [n] "r"(blocks), [q] "i"(PCM_GAIN_Q)
+        : "a8", "memory");
+}
+#endif
+
+// ---- Public kernels ----
+
+void pcm_downmix_s16(int16_t *dst, const int16_t *src, size_t frames) {
+    size_t i = 0;
+#if PCM_USE_PIE
+    if (pie_aligned(dst, src) && frames >= 8) {
+        downmix_s16_pie(dst, src, frames / 8);
+        i = frames & ~(size_t)7;
+    }
+#endif
+    for (; i < frames; i++) {
+        dst[i] = (int16_t)((src[2 * i] >> 1) + (src[2 * i + 1] >> 1));
+    }
+}
+
+void pcm_downmix_s32(int32_t *dst, const int32_t *src, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        dst[i] = (src[2 * i] >> 1) + (src[2 * i + 1] >> 1);
+    }
+}
+
+void pcm_narrow_s32_to_s16(int16_t *dst, const int32_t *src, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        // (x >> 16) with rounding; only INT32_MAX-ish inputs can round past 16 bits
+        int32_t x = src[i];
+        int32_t r = (x >> 16) + ((x >> 15) & 1);
+        dst[i] = (int16_t)(r > INT16_MAX ? INT16_MAX : r);
+    }
+}
+
+void pcm_gain_s16(int16_t *buf, size_t samples, int32_t gain_q12) {
+    if (gain_q12 == PCM_GAIN_UNITY) return;
+    if (gain_q12 > PCM_GAIN_MAX) gain_q12 = PCM_GAIN_MAX;
+    if (gain_q12 < 0) gain_q12 = 0;
+    if (gain_q12 == 0) {
+        for (size_t i = 0; i < samples; i++) buf[i] = 0;
+        return;
+    }
+    int16_t lo, hi;
+    gain_limits(gain_q12, &lo, &hi);
+    size_t i = 0;
+#if PCM_USE_PIE
+    if (pie_aligned(buf, buf) && samples >= 8) {
+        gain_s16_pie(buf, samples / 8, (int16_t)gain_q12, lo, hi);
+        i = samples & ~(size_t)7;
+    }
+#endif
+    for (; i < samples; i++) {
+        int32_t x = buf[i];
+        x = x > hi ? hi : (x < lo ? lo : x);
+        buf[i] = (int16_t)((x * gain_q12) >> PCM_GAIN_Q);
+    }
+}
+
+void pcm_gain_ramp_s16(int16_t *buf, size_t samples, int32_t from_q12, int32_t to_q12) {
+    size_t groups = (samples + 7) / 8;
+    size_t i = 0;
+#if PCM_USE_PIE
+    if (pie_aligned(buf, buf) && from_q12 <= PCM_GAIN_MAX && to_q12 <= PCM_GAIN_MAX) {
+        int16_t gains[64];
+        while (samples - i >= 8) {
+            size_t blocks = (samples - i) / 8;
+            if (blocks > 64) blocks = 64;
+            for (size_t k = 0; k < blocks; k++) gains[k] = (int16_t)ramp_step(from_q12, to_q12, i / 8 + k, groups);
+            gain_ramp_s16_pie(buf + i, blocks, gains);
+            i += blocks * 8;
+        }
+    }
+#endif
+    while (i < samples) {
+        int32_t g = ramp_step(from_q12, to_q12, i / 8, groups);
+        size_t end = samples - i < 8 ? samples : i + 8;
+        for (; i < end; i++) buf[i] = sat16((buf[i] * g) >> PCM_GAIN_Q);
+    }
+}
@@ -0,0 +1,80 @@
+#include <string.h>
+#include "ima_adpcm.h"
+#include "wav_header.h"
+
+static uint16_t rd_le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t rd_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void parse_fmt(const uint8_t *fmt, uint32_t fmt_len, wav_info_t *info) {
+    info->format_tag = rd_le16(fmt + 0);
+    info->num_channels = rd_le16(fmt + 2);
+    info->sample_rate = rd_le32(fmt + 4);
+    info->block_align = rd_le16(fmt + 12);
+    info->bits_per_sample = rd_le16(fmt + 14);
+    info->samples_per_block = fmt_len >= 20 ? rd_le16(fmt + 18) : 0;
+}
+
+static bool read_exact(const audio_source_t *src, uint8_t *buf, int len) {
+    return src->read(src->ctx, buf, len) == len;
+}
+
+int wav_header_read(const audio_source_t *src, wav_info_t *info) {
+    uint8_t buf[40];
+    int consumed = 12;
+    bool have_fmt = false;
+
+    memset(info, 0, sizeof(*info));
+    if (!read_exact(src, buf, 12) || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+
+    while (consumed + 8 <= WAV_HEADER_MAX) {
+        if (!read_exact(src, buf, 8)) return -1;
+        consumed += 8;
+        uint32_t chunk_len = rd_le32(buf + 4);
+
+        if (memcmp(buf, "data", 4) == 0) {
+            info->data_size = chunk_len;
+            return have_fmt ? consumed : -1;
+        }
+
+        uint32_t skip = chunk_len + (chunk_len & 1);  // chunks are word aligned
+        if (consumed + (int)skip > WAV_HEADER_MAX) return -1;
+        if (memcmp(buf, "fmt ", 4) == 0) {
+            if (chunk_len < 16) return -1;
+            uint32_t n = chunk_len < sizeof(buf) ? chunk_len : sizeof(buf);
+            if (!read_exact(src, buf, (int)n)) return -1;
+            parse_fmt(buf, n, info);
+            have_fmt = true;
+            skip -= n;
+            consumed += (int)n;
+        }
+        while (skip > 0) {
+            uint32_t n = skip < sizeof(buf) ? skip : sizeof(buf);
+            if (!read_exact(src, buf, (int)n)) return -1;
+            skip -= n;
+            consumed += (int)n;
+        }
+    }
+    return -1;
+}
+
+bool wav_format_supported(const wav_info_t *info) {
+    if (info->num_channels != 1 && info->num_channels != 2) return false;
+    if (info->format_tag == WAV_FORMAT_IMA_ADPCM) {
+        return info->bits_per_sample == 4 &&
+               info->block_align > IMA_ADPCM_HEADER_BYTES * info->num_channels &&
+               info->block_align <= WAV_IMA_ADPCM_MAX_BLOCK;
+    }
+    // WAVE_FORMAT_EXTENSIBLE files carry PCM too; trust bits/channels
+    return info->bits_per_sample == 16 || info->bits_per_sample == 32;
+}
+
+uint16_t wav_output_bits(const wav_info_t *info) {
+    return info->format_tag == WAV_FORMAT_IMA_ADPCM ? 16 : info->bits_per_sample;
+}
@@ -0,0 +1,90 @@
+// IMA ADPCM conformance and throughput check.
+//
+// Decodes a block produced by an independent encoder (CPython audioop, see
+// gen_adpcm_vectors.py) and compares against its decoder sample for sample,
+// re-encodes the same input to check the encoder stays bit-exact, checks a
+// stereo round trip, then reports decode throughput. Exits non-zero on any
+// mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adpcm_vectors.h"
+#include "audio_port.h"
+#include "ima_adpcm.h"
+
+#define REF_FRAMES (sizeof(adpcm_ref_pcm) / sizeof(adpcm_ref_pcm[0]))
+#define DEFAULT_ITERS 20000
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-22s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static int encode_mono(const int16_t *in, size_t frames, int32_t index, uint8_t *block) {
+    ima_adpcm_state_t st = { in[0], index };
+    block[0] = (uint8_t)in[0];
+    block[1] = (uint8_t)((uint16_t)in[0] >> 8);
+    block[2] = (uint8_t)index;
+    block[3] = 0;
+    uint8_t *p = block + IMA_ADPCM_HEADER_BYTES;
+    for (size_t i = 1; i + 1 < frames; i += 2) {
+        uint8_t lo = ima_adpcm_encode_sample(&st, in[i]);
+        uint8_t hi = ima_adpcm_encode_sample(&st, in[i + 1]);
+        *p++ = lo | (hi << 4);
+    }
+    return (int)(p - block);
+}
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERS;
+    int16_t out[2 * REF_FRAMES];
+
+    check("block_samples", ima_adpcm_block_samples(sizeof(adpcm_ref_block), 1) == REF_FRAMES &&
+                           ima_adpcm_block_samples(1024, 2) == 1017);
+
+    size_t n = ima_adpcm_decode_block(adpcm_ref_block, sizeof(adpcm_ref_block), 1, out);
+    check("decode_vs_audioop", n == REF_FRAMES && memcmp(out, adpcm_ref_pcm, sizeof(adpcm_ref_pcm)) == 0);
+
+    uint8_t block[2 * sizeof(adpcm_ref_block)];
+    int len = encode_mono(adpcm_ref_input, REF_FRAMES, adpcm_ref_block[2], block);
+    check("encode_vs_audioop", len == (int)sizeof(adpcm_ref_block) &&
+                               memcmp(block, adpcm_ref_block, sizeof(adpcm_ref_block)) == 0);
+
+    // Stereo: left = reference input, right = its negation, packed in
+    // 4-byte groups per channel. Each channel must decode like a mono block.
+    int16_t right_in[REF_FRAMES];
+    uint8_t mono_r[sizeof(adpcm_ref_block)];
+    int16_t dec_r[REF_FRAMES];
+    for (size_t i = 0; i < REF_FRAMES; i++) right_in[i] = (int16_t)-adpcm_ref_input[i];
+    encode_mono(right_in, REF_FRAMES, 0, mono_r);
+    ima_adpcm_decode_block(mono_r, sizeof(mono_r), 1, dec_r);
+    memcpy(block, adpcm_ref_block, 4);
+    memcpy(block + 4, mono_r, 4);
+    const uint8_t *l = adpcm_ref_block + 4, *r = mono_r + 4;
+    uint8_t *p = block + 8;
+    for (size_t g = 0; g < (REF_FRAMES - 1) / 8; g++) {
+        memcpy(p, l + g * 4, 4);
+        memcpy(p + 4, r + g * 4, 4);
+        p += 8;
+    }
+    n = ima_adpcm_decode_block(block, (size_t)(p - block), 2, out);
+    int stereo_ok = n == REF_FRAMES;
+    for (size_t i = 0; stereo_ok && i < n; i++) {
+        stereo_ok = out[2 * i] == adpcm_ref_pcm[i] && out[2 * i + 1] == dec_r[i];
+    }
+    check("decode_stereo", stereo_ok);
+
+    check("short_block_rejected", ima_adpcm_decode_block(adpcm_ref_block, 3, 1, out) == 0);
+
+    int64_t t0 = audio_time_us();
+    for (int i = 0; i < iters; i++) {
+        ima_adpcm_decode_block(adpcm_ref_block, sizeof(adpcm_ref_block), 1, out);
+    }
+    int64_t dt = audio_time_us() - t0;
+    printf("decode throughput      %.1f samples/us\n", dt > 0 ? (double)iters * REF_FRAMES / dt : 0.0);
+
+    return failures ? 1 : 0;
+}
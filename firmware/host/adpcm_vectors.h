@@ -0,0 +1,116 @@
+// Generated by gen_adpcm_vectors.py; do not edit.
+#pragma once
+
+#include <stdint.h>
+
+static const int16_t adpcm_ref_input[505] = {
+    0, 2356, 4769, 7194, 9579, 11866, 13988, 15878, 17460, 18664, 19418, 19659,
+    19334, 18407, 16859, 14696, 11952, 8690, 5008, 1034, -3075, -7136, -10948, -14299,
+    -16984, -18813, -19628, -19320, -17841, -15217, -11555, -7050, -1973, 3334, 8482, 13059,
+    16665, 18951, 19653, 18634, 15905, 11643, 6192, 46, -6192, -11866, -16329, -19030,
+    -19584, -17834, -13901, -8188, -1357, 5736, 12147, 16961, 19437, 19127, 15977, 10364,
+    3075, -4784, -11952, -17206, -19584, -18575, -14246, -7280, 1111, 9376, 15905, 19348,
+    18913, 14572, 7122, -1927, -10638, -17054, -19646, -17702, -11555, -2571, 7122, 15118,
+    19334, 18575, 12908, 3729, -6543, -15079, -19418, -18204, -11655, -1588, 9035, 16961,
+    19646, 16111, 7352, -3880, -13901, -19291, -18091, -10573, 740, 11866, 18735, 18712,
+    11655, 108, -11555, -18759, -18539, -10832, 1357, 13059, 19334, 17396, 7921, -5083,
+    -15905, -19627, -14415, -2510, 10638, 18813, 17993, 8412, -5366, -16541, -19418, -12376,
+    1111, 14086, 19653, 14696, 1727, -12256, -19489, -15786, -3075, 11468, 19398, 15932,
+    2953, -11866, -19520, -15177, -1357, 13379, 19660, 13311, -1727, -15694, -19288, -9941,
+    6192, 18145, 17573, 4694, -11555, -19614, -13548, 2418, 16665, 18575, 6543, -10495,
+    -19560, -13536, 3075, 17324, 17841, 4032, -13093, -19565, -9901, 8048, 19288, 14193,
+    -3075, -17742, -16984, -1280, 15610, 18575, 4769, -13424, -19334, -7337, 11555, 19607,
+    9035, -10232, -19659, -9941, 9579, 19656, 10113, -9646, -32111, 32111, -32111, 32111,
+    -32111, 32111, -32111, 32111, -32111, 32111, 3075, -16022, -17287, 879, 18091, 14696,
+    -5603, -19457, -10638, 10703, 19418, 4993, -15458, -17250, 1973, 18813, 12436, -9430,
+    -19520, -4993, 15905, 16491, -4168, -19457, -9362, 13059, 18233, -879, -18844, -11392,
+    11555, 18731, 123, -18683, -11455, 11866, 18455, -1188, -19159, -9565, 13901, 17130,
+    -4769, -19656, -5366, 16961, 13814, -10232, -18735, 1434, 19418, 7337, -16190, -14363,
+    10113, 18575, -2586, -19618, -5008, 17742, 11555, -13603, -16329, 8048, 19011, -1927,
+    -19628, -4032, 18455, 9294, -15905, -13536, 12436, 16624, -8482, -18575, 4409, 19510,
+    -494, -19614, -3075, 19091, 6192, -18145, -8815, 16961, 10948, -15694, -12626, 14468,
+    13901, -13379, -14828, 12496, 15458, -11866, -15832, 11518, 15977, -11468, -15905, 11717,
+    15610, -12256, -15069, 13059, 14246, -14086, -13093, 15275, 11555, -16541, -9579, 17769,
+    7122, -18813, -4168, 19499, 740, -19627, 3075, 18991, -7122, -17396, 11152, 14696,
+    -14828, -10832, 17736, 5884, -19418, -108, 19437, -6031, -17460, 11866, 13368, -16574,
+    -7352, 19291, 0, -19273, 7694, 16111, -14415, -9941, 18735, 1588, -19437, 7423,
+    15905, -15079, -8482, 19303, -1357, -18575, 11152, 12567, -17993, -2571, 19418, -8552,
+    -14415, 17054, 4168, -19565, 7921, 14572, -17168, -3486, 19418, -9376, -13093, 18262,
+    494, -18575, 12626, 9511, -19489, 4784, 15905, -16706, -3197, 19127, -11655, -9941,
+    19520, -5736, -14828, 17873, 0, -17834, 15069, 4934, -19288, 11866, 8815, -19660,
+    8815, 11643, -19418, 6265, 13548, -18951, 4409, 14696, -18539, 3334, 15226, -18352,
+    3075, 15217, -18455, 3638, 14665, -18813, 5008, 13492, -19288, 7136, 11555, -19632,
+    9901, 8690, -19489, 13059, 4769, -18407, 16190, -200, -15905, 18664, -5957, -11593,
+    19659, -11866, -5366, 18296, -16859, 2356, 13901, -19529, 10429, 6412, -18455, 16961,
+    -3197, -12803, 19659, -12685, -3075, 16657, -18844, 8328, 7694, -18575, 17287, -4844,
+    -10638, 19331, -15905, 2663, 12147, -19546, 15226, -1927, -12436, 19546, -15458, 2663,
+    11555, -19331, 16533, -4844, -9362, 18575, -18091, 8328, 5603, -16657, 19418, -12685,
+    -123, 12803, -19398, 16961, -6775, -6412, 16665, -19529, 13901, -2356, -10113, 18296,
+    -18913,
+};
+
+static const uint8_t adpcm_ref_block[256] = {
+    0, 0, 20, 0, 119, 119, 119, 6, 0, 128, 152, 169, 203, 188, 187, 187,
+    138, 56, 100, 83, 51, 36, 1, 169, 204, 204, 170, 137, 33, 69, 51, 34,
+    168, 205, 203, 154, 33, 68, 51, 130, 219, 188, 154, 64, 52, 20, 168, 204,
+    155, 48, 68, 3, 201, 203, 26, 82, 35, 168, 189, 138, 83, 35, 200, 172,
+    25, 68, 130, 203, 139, 66, 20, 201, 155, 64, 20, 184, 157, 49, 35, 218,
+    155, 83, 2, 188, 42, 52, 176, 173, 81, 2, 203, 41, 36, 201, 11, 52,
+    176, 141, 66, 161, 156, 65, 162, 204, 215, 247, 247, 247, 183, 138, 35, 184,
+    27, 22, 202, 32, 147, 172, 67, 192, 26, 5, 171, 65, 177, 28, 20, 172,
+    65, 176, 42, 132, 156, 51, 218, 64, 177, 43, 133, 140, 19, 187, 83, 201,
+    64, 192, 40, 178, 59, 148, 29, 131, 13, 3, 140, 4, 140, 4, 140, 4,
+    140, 132, 11, 132, 28, 147, 28, 163, 75, 194, 73, 192, 48, 201, 50, 156,
+    4, 28, 179, 74, 209, 64, 170, 19, 13, 164, 74, 184, 50, 141, 148, 59,
+    209, 49, 140, 164, 74, 184, 19, 29, 211, 64, 155, 165, 90, 185, 132, 75,
+    192, 3, 44, 193, 18, 45, 210, 18, 44, 193, 18, 61, 192, 148, 91, 169,
+    181, 72, 11, 211, 18, 61, 184, 165, 72, 28, 194, 2, 91, 154, 196, 18,
+    76, 154, 180, 17, 76, 138, 196, 2, 91, 27, 209, 164, 56, 77, 138, 211,
+};
+
+static const int16_t adpcm_ref_pcm[505] = {
+    0, 93, 292, 722, 1647, 3634, 7894, 15808, 16886, 17866, 18757, 19567,
+    18831, 18162, 16337, 14677, 12161, 8959, 5217, 688, -3572, -7446, -10968, -14170,
+    -17079, -18969, -19312, -19624, -17636, -15312, -11252, -7378, -1843, 3313, 8000, 13479,
+    17162, 19170, 19778, 18118, 15602, 11485, 6504, 477, -6817, -11719, -16176, -18607,
+    -19343, -17335, -14292, -8204, -910, 5953, 12193, 16245, 19928, 19259, 16216, 10128,
+    2834, -4029, -12052, -17445, -20386, -17712, -13660, -7030, 993, 8543, 15406, 19863,
+    19053, 13897, 6531, -2294, -10599, -15992, -18933, -18042, -10748, -1923, 6382, 16090,
+    20005, 18819, 13426, 4601, -6078, -16127, -20042, -18856, -11306, -2481, 8198, 18247,
+    19552, 15993, 6285, -2851, -13530, -20708, -16793, -10861, 1004, 12058, 19236, 17931,
+    11999, 134, -10920, -18098, -19403, -11098, 767, 11821, 18999, 17694, 7015, -5907,
+    -14593, -19330, -15024, -3277, 10937, 20492, 18755, 7701, -5221, -17381, -18960, -11782,
+    -35, 14179, 19912, 14701, 487, -12890, -18101, -16522, -3600, 12036, 18342, 16431,
+    4271, -13101, -20038, -13732, -355, 11805, 19701, 12523, -1834, -15211, -20422, -9368,
+    6425, 16936, 18847, 3211, -11504, -21059, -12373, 1841, 15218, 16955, 5901, -9892,
+    -20403, -14670, 4440, 17158, 19470, 4755, -12445, -19382, -8871, 8329, 19891, 13585,
+    -3615, -19802, -17700, -500, 15687, 17789, 4412, -14698, -17241, -5679, 13241, 20871,
+    9309, -9611, -17241, -10304, 8616, 21334, 9772, -9148, -32041, 14125, -30928, 30508,
+    -30928, 30508, -30928, 30508, -30928, 30508, 1839, -16782, -20167, 1376, 15366, 12823,
+    -3364, -18079, -12346, 10239, 19471, 5481, -17412, -14335, -345, 17460, 10523, -8397,
+    -21115, -4928, 13992, 16535, -4277, -18267, -10637, 14800, 18185, -3358, -17348, -9718,
+    11094, 19488, 1683, -19129, -10735, 12158, 21390, -3793, -20721, -11489, 13694, 17079,
+    -4464, -18454, -5736, 15076, 12278, -10615, -19847, -261, 17544, 5982, -17142, -14065,
+    11118, 21274, -269, -19855, -7137, 18300, 14915, -12785, -16509, 7190, 16422, -3164,
+    -20969, -4782, 18342, 9110, -16073, -12688, 15012, 18736, -11735, -15830, 2791, 19719,
+    -1824, -21410, -3605, 17207, 8813, -19167, -7995, 15704, 12627, -18152, -14057, 12012,
+    15397, -12303, -16027, 14444, 18539, -14979, -19074, 14444, 18539, -14979, -19074, 14444,
+    18539, -14979, -19074, 14444, 10349, -15720, -12335, 15365, 11641, -18830, -6544, 19525,
+    9369, -18331, -7159, 16540, 1152, -18434, 4459, 19847, -5336, -15492, 12208, 15932,
+    -14539, -10444, 15625, 5469, -22231, -3610, 20089, -7611, -18783, 11688, 15783, -17735,
+    -5449, 20620, -3079, -18467, 6716, 16872, -16983, -12888, 20630, 152, -18469, 5230,
+    14462, -16317, -12222, 21296, 818, -17803, 12668, 8573, -17496, -568, 20975, -9804,
+    -13899, 19619, 7333, -18736, 4963, 14195, -16584, -4298, 21771, -8700, -12795, 20723,
+    245, -18376, 12095, 8000, -18069, 5630, 14862, -15917, -3631, 22438, -14804, -10709,
+    22809, -5860, -17032, 20210, -268, -18889, 18353, 6067, -20002, 10469, 6374, -19695,
+    10776, 14871, -18647, 10022, 13746, -16725, 3753, 14925, -15546, 4932, 16104, -21138,
+    -660, 17961, -19281, 1197, 12369, -18102, 2376, 13548, -16923, 3555, 14727, -22515,
+    6154, 9878, -20593, 16269, 3983, -22086, 15156, 2870, -15751, 21491, -7178, -10902,
+    19569, -9100, -5376, 18323, -15532, 4946, 16118, -21124, 7545, 3821, -19878, 13977,
+    -6501, -10225, 20246, -16616, -4330, 14291, -16180, 4298, 8022, -15677, 18178, -2300,
+    -13472, 16999, -19863, 615, 11787, -18684, 18178, -2300, -13472, 16999, -11670, -498,
+    9658, -18042, 15476, -5002, -8726, 21745, -15117, 5361, 9085, -14614, 19241, -9428,
+    1744, 11900, -21955, 14907, -5571, -9295, 14404, -19451, 17411, -3067, -6791, 16908,
+    -16947,
+};
+
@@ -0,0 +1,632 @@
+// Host latency benchmark for the HTTP -> WAV header -> ring buffer -> I2S path.
+//
+// Serves a generated clip from a throttled loopback HTTP server, runs the
+// same audio_pipeline code as the firmware (downloader on the main thread,
+// writer on its own thread, like audio_playback_task / i2s_write_task) into
+// a fake I2S channel that plays at the real sample rate, and reports:
+//   ttfs_ms          open request -> first I2S write
+//   underruns        DMA queue ran dry mid-clip (and total starved ms)
+//   prefill_ms       audio buffered at start vs. what the estimator asked for,
+//                    and whether it predicted an underrun
+// With --replay the clip is captured into the audio cache and played a
+// second time from memory, as a repeated message would be on the device.
+// With --static-buffers both plays share staging buffers allocated once,
+// like the firmware's boot-time pool. --native-rate plays through the
+// resampler into a sink fixed at that rate, as the device's I2S channel is.
+// --stall-ms pauses the server halfway through the body; with --conceal the
+// writer fades out before the sink runs dry and fades back in, and
+// hard_stops counts gaps that started on an audible sample instead.
+// --drop-at cuts the connection at that body offset; with --resume the
+// download reopens with a Range request (audio_resume.h) and must deliver
+// the whole body without restarting playback.
+// --inline CHUNK sends the clip as MQTT chunks of that size instead
+// (audio_inline.h): a publisher thread stands in for the broker, paced at
+// --rate-kbps after one --latency-ms hop, and splits every chunk into
+// MQTT_FRAGMENT-byte data events as esp-mqtt does.
+// --preempt-at-ms MS has an urgent message arrive that long into playback:
+// the sink fades out and the pipeline is cancelled, as play_audio() does on
+// the device, and the same clip is then played again as the urgent one.
+//   preempt          arrival -> silent, -> download and writer done with
+//                    the connection and ring, -> the urgent clip's first write
+// --next plays the clip a second time straight after the first, as a
+// message queued behind it; with --prefetch-kb KB its connection, headers
+// and up to KB of body are fetched while the first plays out
+// (audio_prefetch.h), as the device worker does.
+//   next             last sample of the first clip -> first write of the
+//                    second, and what the prefetch buffered
+//   cpu_ms_per_s     downloader + writer CPU time per second of audio
+//   trace            the per-message span record the device publishes
+//                    (audio_trace.h), timed from the open request
+//
+// Exits non-zero when --max-ttfs-ms / --max-underruns / --max-preempt-ms
+// (the later of silent and done) / --max-gap-ms are exceeded so CI can
+// catch latency regressions without a board.
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "audio_cache.h"
+#include "audio_inline.h"
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "audio_prefetch.h"
+#include "audio_resume.h"
+#include "audio_trace.h"
+#include "fake_i2s.h"
+#include "host_http_source.h"
+#include "host_signal.h"
+#include "host_spsc.h"
+#include "http_file_server.h"
+#include "test_wav.h"
+
+// Mirrors i2s_init() in firmware/main/main.c
+#define DMA_DESC_NUM  32
+#define DMA_FRAME_NUM 480
+
+#define BENCH_CACHE_KEY "bench.wav"
+
+// esp-mqtt's receive buffer on the device (main.c)
+#define MQTT_FRAGMENT 4096
+
+typedef struct {
+    uint32_t sample_rate;
+    uint16_t channels;
+    uint16_t bits;
+    float seconds;
+    uint32_t rate_kbps;
+    uint32_t latency_ms;
+    uint32_t ring_kb;
+    bool zero_copy;
+    uint16_t adpcm_block;       // 0 = PCM, else IMA ADPCM block size
+    uint32_t prefill_kb;        // fixed start threshold; 0 = rate estimator
+    bool replay;                // play again from the audio cache
+    bool static_buffers;        // caller-owned staging buffers, as on the device
+    uint32_t native_rate;       // fixed sink rate; 0 = sink follows the clip
+    uint32_t stall_ms;          // server pause halfway through the body
+    bool conceal;               // fade around gaps (audio_conceal.h)
+    uint32_t drop_at;           // server cuts the connection once at this body offset
+    bool ignore_range;          // server answers Range requests with 200
+    uint32_t resume;            // reconnect attempts (audio_resume.h), 0 = off
+    uint32_t inline_chunk;      // deliver as MQTT chunks of this size, 0 = HTTP
+    uint32_t preempt_at_ms;     // cancel this far into playback, 0 = play out
+    double max_preempt_ms;
+    bool next;                  // a second message queued behind the first
+    uint32_t prefetch_kb;       // download-ahead budget for it, 0 = none
+    double max_gap_ms;
+    long max_hard_stops;
+    double max_ttfs_ms;
+    long max_underruns;
+} bench_opts_t;
+
+typedef struct {
+    audio_pipeline_t pipeline;
+    fake_i2s_t i2s;
+    audio_sink_t sink;
+    pthread_t writer;
+    int64_t download_cpu_us;
+    int64_t writer_cpu_us;
+    audio_cache_entry_t *capture;
+    bool capture_failed;
+    volatile bool played;       // writer done, last sample heard
+} bench_ctx_t;
+
+static int64_t thread_cpu_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *writer_thread(void *arg) {
+    bench_ctx_t *ctx = arg;
+    audio_pipeline_write_loop(&ctx->pipeline, &ctx->sink);
+    ctx->writer_cpu_us = thread_cpu_us();
+    fake_i2s_drain(&ctx->i2s);
+    // Faded out: the last sample was heard when the fade ended
+    ctx->pipeline.stats.t_played_us = ctx->i2s.t_silent_us ? ctx->i2s.t_silent_us : audio_time_us();
+    ctx->played = true;
+    return NULL;
+}
+
+static bool start_writer(audio_pipeline_t *p) {
+    bench_ctx_t *ctx = p->user;
+    if (p->sink_sample_rate) {
+        fake_i2s_init(&ctx->i2s, p->sink_sample_rate, sizeof(int16_t), DMA_DESC_NUM, DMA_FRAME_NUM);
+    } else {
+        uint16_t frame_bytes = p->out_bits_per_sample / 8;  // mono after downmix
+        fake_i2s_init(&ctx->i2s, p->out_sample_rate, frame_bytes, DMA_DESC_NUM, DMA_FRAME_NUM);
+    }
+    fake_i2s_bind(&ctx->i2s, &ctx->sink);
+    return pthread_create(&ctx->writer, NULL, writer_thread, ctx) == 0;
+}
+
+// Stands in for the urgent message: fades the sink and cancels the
+// pipeline once it has played `at_ms`
+typedef struct {
+    bench_ctx_t *ctx;
+    uint32_t at_ms;
+    int64_t t_cancel_us;
+} preempter_t;
+
+static void *preempt_thread(void *arg) {
+    preempter_t *pre = arg;
+    audio_pipeline_t *p = &pre->ctx->pipeline;
+    while (p->stats.t_first_write_us == 0) audio_sleep_ms(1);
+    audio_sleep_ms(pre->at_ms);
+    pre->t_cancel_us = audio_time_us();
+    fake_i2s_fade_out(&pre->ctx->i2s);
+    audio_pipeline_cancel(p);
+    return NULL;
+}
+
+static void cache_tap(void *ctx, const void *pcm, size_t len) {
+    bench_ctx_t *b = ctx;
+    if (!audio_cache_append(b->capture, pcm, len)) b->capture_failed = true;
+}
+
+// One play through the pipeline, like audio_playback_task: open, init,
+// download on this thread, writer on its own. With `cache`, the decoded
+// clip is captured under BENCH_CACHE_KEY.
+static char *pool_chunk;
+static char *pool_mono;
+static audio_resampler_t resampler;
+static audio_conceal_t conceal;
+
+// Once the body is in the connection is free, so like the device worker,
+// fetch the next message's head while this one plays out, one read at a
+// time until the writer is done or the budget is full
+static void prefetch_next(bench_ctx_t *ctx, audio_prefetch_t *ahead, const char *url) {
+    audio_source_t inner = ctx->pipeline.source;
+    inner.close(inner.ctx);
+    if (audio_prefetch_start(ahead, &inner, url) < 0) return;
+    while (!ctx->played && audio_prefetch_fill(ahead) > 0) {
+    }
+}
+
+static int run_once(bench_ctx_t *ctx, const bench_opts_t *opts, host_spsc_t *ring, audio_source_t source,
+                    const char *url, audio_cache_t *cache, audio_prefetch_t *ahead) {
+    audio_pipeline_t *p = &ctx->pipeline;
+    p->chunk_buffer = pool_chunk;
+    p->mono_buffer = pool_mono;
+    p->sink_sample_rate = opts->native_rate;
+    p->resampler = &resampler;
+    p->conceal = opts->conceal ? &conceal : NULL;
+    p->source = source;
+    p->start_playback = start_writer;
+    p->user = ctx;
+    p->zero_copy = opts->zero_copy;
+    p->start_threshold = (size_t)opts->prefill_kb * 1024;
+    host_spsc_bind(ring, &p->ring);
+
+    int64_t cpu0 = thread_cpu_us();
+    int rc = audio_pipeline_open(p, url);
+    if (rc == AUDIO_OK) rc = audio_pipeline_init(p);
+    if (rc == AUDIO_OK && cache) {
+        ctx->capture = audio_cache_begin(cache, BENCH_CACHE_KEY, p->out_sample_rate, p->out_bits_per_sample,
+                                         audio_pipeline_output_bytes(p));
+        if (ctx->capture) p->tap = (audio_pcm_tap_t) { .ctx = ctx, .write = cache_tap };
+    }
+    if (rc == AUDIO_OK) rc = audio_pipeline_download(p);
+    ctx->download_cpu_us = thread_cpu_us() - cpu0;
+    bool prefetched = rc == AUDIO_OK && ahead;
+    if (prefetched) prefetch_next(ctx, ahead, url);
+    if (p->player_started) pthread_join(ctx->writer, NULL);
+    if (!prefetched) p->source.close(p->source.ctx);
+    if (ctx->capture) {
+        if (rc == AUDIO_OK && !ctx->capture_failed) {
+            audio_cache_commit(cache, ctx->capture);
+        } else {
+            audio_cache_abort(cache, ctx->capture);
+        }
+    }
+    return rc;
+}
+
+// Prints the per-run lines and returns ttfs in ms.
+static double report(const bench_ctx_t *ctx) {
+    const audio_pipeline_t *p = &ctx->pipeline;
+    double audio_s = (double)p->stats.bytes_written / ctx->i2s.byte_rate;
+    double ttfs_ms = (p->stats.t_first_write_us - p->stats.t_open_us) / 1000.0;
+    double cpu_ms_per_s = audio_s > 0 ? (ctx->download_cpu_us + ctx->writer_cpu_us) / 1000.0 / audio_s : 0;
+
+    printf("headers_ms=%.1f prefill_ms=%.1f ttfs_ms=%.1f\n",
+           (p->stats.t_headers_us - p->stats.t_open_us) / 1000.0,
+           (p->stats.t_prefill_us - p->stats.t_open_us) / 1000.0, ttfs_ms);
+    printf("prefill_ms=%.1f target_ms=%u rate_x=%.2f predicted_underrun=%d est_underruns=%u\n",
+           p->stats.prefill_bytes * 1000.0 / (p->out_sample_rate * (p->out_bits_per_sample / 8)),
+           (unsigned)p->stats.prefill_target_ms, p->stats.rate_permille / 1000.0,
+           p->stats.predicted_underrun, (unsigned)p->stats.underruns);
+    printf("underruns=%u starved_ms=%.1f hard_stops=%u pcm_fnv=%08x\n", ctx->i2s.underruns,
+           ctx->i2s.starved_us / 1000.0, (unsigned)ctx->i2s.hard_stops, (unsigned)ctx->i2s.checksum);
+    printf("writer: underruns=%u starved_ms=%u concealed=%u\n", (unsigned)p->stats.underruns,
+           (unsigned)p->stats.starved_ms, (unsigned)p->stats.concealed);
+    printf("audio_s=%.2f cpu_ms_per_s=%.3f copied_per_byte=%.3f\n", audio_s, cpu_ms_per_s,
+           p->stats.bytes_processed ? (double)p->stats.bytes_copied / p->stats.bytes_processed : 0.0);
+    audio_trace_t trace = { .ok = true };
+    char json[AUDIO_TRACE_JSON_MAX];
+    audio_trace_from_stats(&trace, p->stats.t_open_us, &p->stats);
+    if (audio_trace_format(&trace, json, sizeof(json)) > 0) printf("trace=%s\n", json);
+    return ttfs_ms;
+}
+
+// Stands in for the broker: one hop of latency, then the chunks in order,
+// paced at the link rate, each delivered as MQTT_FRAGMENT-byte data events
+typedef struct {
+    audio_inline_t *clip;
+    const uint8_t *wav;
+    size_t wav_len;
+    uint32_t chunk;
+    uint32_t rate_bytes_per_s;
+    uint32_t latency_ms;
+    uint32_t clip_id;
+} publisher_t;
+
+static void *publisher_thread(void *arg) {
+    publisher_t *pub = arg;
+    static uint8_t msg[AUDIO_INLINE_HEADER_SIZE + 65536];
+    audio_sleep_ms(pub->latency_ms);
+    int64_t t0 = audio_time_us();
+    uint16_t seq = 0;
+    for (size_t off = 0; off < pub->wav_len; off += pub->chunk, seq++) {
+        size_t n = pub->wav_len - off < pub->chunk ? pub->wav_len - off : pub->chunk;
+        audio_inline_header_t h = {
+            .flags = off + n == pub->wav_len ? AUDIO_INLINE_FLAG_LAST : 0,
+            .clip_id = pub->clip_id,
+            .offset = (uint32_t)off,
+            .seq = seq,
+        };
+        audio_inline_write_header(&h, msg);
+        memcpy(msg + AUDIO_INLINE_HEADER_SIZE, pub->wav + off, n);
+        size_t msg_len = AUDIO_INLINE_HEADER_SIZE + n;
+        for (size_t f = 0; f < msg_len; f += MQTT_FRAGMENT) {
+            size_t len = msg_len - f < MQTT_FRAGMENT ? msg_len - f : MQTT_FRAGMENT;
+            audio_inline_feed(pub->clip, msg + f, len, f, msg_len);
+        }
+        if (pub->rate_bytes_per_s) {
+            int64_t due = t0 + (int64_t)((double)(off + n) * 1e6 / pub->rate_bytes_per_s);
+            int64_t now = audio_time_us();
+            if (due > now) audio_sleep_ms((uint32_t)((due - now) / 1000));
+        }
+    }
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--sample-rate HZ] [--channels N] [--bits N] [--seconds S]\n"
+            "          [--rate-kbps KBPS] [--latency-ms MS] [--ring-kb KB] [--zero-copy]\n"
+            "          [--adpcm BLOCK_BYTES] [--prefill-kb KB] [--replay] [--static-buffers]\n"
+            "          [--native-rate HZ] [--stall-ms MS] [--conceal]\n"
+            "          [--drop-at BYTES] [--ignore-range] [--resume RETRIES] [--inline CHUNK]\n"
+            "          [--preempt-at-ms MS] [--max-ttfs-ms MS] [--max-underruns N] [--max-hard-stops N]\n"
+            "          [--max-preempt-ms MS] [--next] [--prefetch-kb KB] [--max-gap-ms MS]\n", prog);
+}
+
+static int parse_opts(int argc, char **argv, bench_opts_t *o) {
+    static const struct option longopts[] = {
+        { "sample-rate",   required_argument, NULL, 'r' },
+        { "channels",      required_argument, NULL, 'c' },
+        { "bits",          required_argument, NULL, 'b' },
+        { "seconds",       required_argument, NULL, 's' },
+        { "rate-kbps",     required_argument, NULL, 'k' },
+        { "latency-ms",    required_argument, NULL, 'l' },
+        { "ring-kb",       required_argument, NULL, 'R' },
+        { "zero-copy",     no_argument,       NULL, 'z' },
+        { "adpcm",         required_argument, NULL, 'a' },
+        { "prefill-kb",    required_argument, NULL, 'P' },
+        { "replay",        no_argument,       NULL, 'y' },
+        { "static-buffers", no_argument,      NULL, 'S' },
+        { "native-rate",   required_argument, NULL, 'N' },
+        { "stall-ms",      required_argument, NULL, 'W' },
+        { "conceal",       no_argument,       NULL, 'C' },
+        { "drop-at",       required_argument, NULL, 'D' },
+        { "ignore-range",  no_argument,       NULL, 'I' },
+        { "resume",        required_argument, NULL, 'e' },
+        { "inline",        required_argument, NULL, 'i' },
+        { "preempt-at-ms", required_argument, NULL, 'p' },
+        { "max-preempt-ms", required_argument, NULL, 'M' },
+        { "next",          no_argument,       NULL, 'n' },
+        { "prefetch-kb",   required_argument, NULL, 'A' },
+        { "max-gap-ms",    required_argument, NULL, 'G' },
+        { "max-hard-stops", required_argument, NULL, 'H' },
+        { "max-ttfs-ms",   required_argument, NULL, 'T' },
+        { "max-underruns", required_argument, NULL, 'U' },
+        { NULL, 0, NULL, 0 },
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", longopts, NULL)) != -1) {
+        switch (c) {
+            case 'r': o->sample_rate = (uint32_t)atoi(optarg); break;
+            case 'c': o->channels = (uint16_t)atoi(optarg); break;
+            case 'b': o->bits = (uint16_t)atoi(optarg); break;
+            case 's': o->seconds = (float)atof(optarg); break;
+            case 'k': o->rate_kbps = (uint32_t)atoi(optarg); break;
+            case 'l': o->latency_ms = (uint32_t)atoi(optarg); break;
+            case 'R': o->ring_kb = (uint32_t)atoi(optarg); break;
+            case 'z': o->zero_copy = true; break;
+            case 'a': o->adpcm_block = (uint16_t)atoi(optarg); break;
+            case 'P': o->prefill_kb = (uint32_t)atoi(optarg); break;
+            case 'y': o->replay = true; break;
+            case 'S': o->static_buffers = true; break;
+            case 'N': o->native_rate = (uint32_t)atoi(optarg); break;
+            case 'W': o->stall_ms = (uint32_t)atoi(optarg); break;
+            case 'C': o->conceal = true; break;
+            case 'D': o->drop_at = (uint32_t)atoi(optarg); break;
+            case 'I': o->ignore_range = true; break;
+            case 'e': o->resume = (uint32_t)atoi(optarg); break;
+            case 'i': o->inline_chunk = (uint32_t)atoi(optarg); break;
+            case 'p': o->preempt_at_ms = (uint32_t)atoi(optarg); break;
+            case 'M': o->max_preempt_ms = atof(optarg); break;
+            case 'n': o->next = true; break;
+            case 'A': o->prefetch_kb = (uint32_t)atoi(optarg); break;
+            case 'G': o->max_gap_ms = atof(optarg); break;
+            case 'H': o->max_hard_stops = atol(optarg); break;
+            case 'T': o->max_ttfs_ms = atof(optarg); break;
+            case 'U': o->max_underruns = atol(optarg); break;
+            default: return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bench_opts_t opts = {
+        .sample_rate = 16000,
+        .channels = 1,
+        .bits = 16,
+        .seconds = 2.0f,
+        .rate_kbps = 2000,
+        .latency_ms = 50,
+        .ring_kb = 64,
+        .max_ttfs_ms = -1,
+        .max_underruns = -1,
+        .max_hard_stops = -1,
+        .max_preempt_ms = -1,
+        .max_gap_ms = -1,
+    };
+    if (parse_opts(argc, argv, &opts) < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t wav_len;
+    uint8_t *wav = opts.adpcm_block
+        ? test_wav_generate_adpcm(opts.sample_rate, opts.channels, opts.seconds, opts.adpcm_block, &wav_len)
+        : test_wav_generate(opts.sample_rate, opts.channels, opts.bits, opts.seconds, &wav_len);
+    if (!wav) return 1;
+
+    http_file_server_t server = {
+        .body = wav,
+        .body_len = wav_len,
+        .rate_bytes_per_s = opts.rate_kbps * 1000 / 8,
+        .latency_ms = opts.latency_ms,
+        .stall_ms = opts.stall_ms,
+        .drop_at = opts.drop_at,
+        .ignore_range = opts.ignore_range,
+    };
+    if (http_file_server_start(&server) < 0) {
+        fprintf(stderr, "failed to start loopback server\n");
+        return 1;
+    }
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/audio/bench.wav", (unsigned)server.port);
+
+    host_spsc_t ring;
+    if (host_spsc_init(&ring, (size_t)opts.ring_kb * 1024) < 0) {
+        fprintf(stderr, "--ring-kb must be a power of two\n");
+        return 1;
+    }
+
+    // Budget for one clip; --replay captures the first run and plays it back
+    audio_cache_t cache;
+    audio_cache_init(&cache, opts.replay ? wav_len * 8 + 64 * 1024 : 0, NULL, NULL);
+
+    if (opts.static_buffers) {
+        pool_chunk = audio_alloc_aligned(AUDIO_CHUNK_BUFFER_SIZE);
+        pool_mono = audio_alloc_aligned(AUDIO_CHUNK_BUFFER_SIZE);
+        if (!pool_chunk || !pool_mono) return 1;
+    }
+
+    bench_ctx_t ctx = { 0 };
+    host_http_source_t source;
+    audio_source_t http;
+    host_http_source_bind(&source, &http);
+    // Inline delivery: the clip buffer and the broker thread replace HTTP
+    static audio_inline_t clip;
+    host_signal_t clip_signal;
+    audio_signal_t signal;
+    pthread_t publisher;
+    publisher_t pub = {
+        .clip = &clip, .wav = wav, .wav_len = wav_len, .chunk = opts.inline_chunk,
+        .rate_bytes_per_s = opts.rate_kbps * 1000 / 8, .latency_ms = opts.latency_ms, .clip_id = 0x5eed,
+    };
+    if ((opts.preempt_at_ms || opts.next) && (opts.inline_chunk || opts.replay)) {
+        fprintf(stderr, "--preempt-at-ms and --next play over HTTP only\n");
+        return 2;
+    }
+    if (opts.preempt_at_ms && opts.next) {
+        fprintf(stderr, "--preempt-at-ms and --next do not combine\n");
+        return 2;
+    }
+    if (opts.inline_chunk) {
+        if (opts.inline_chunk > 65536) {
+            fprintf(stderr, "--inline chunks are at most 64 KB\n");
+            return 2;
+        }
+        host_signal_init(&clip_signal);
+        host_signal_bind(&clip_signal, &signal);
+        audio_inline_init(&clip, malloc(wav_len), wav_len, &signal);
+        if (!audio_inline_begin(&clip, pub.clip_id, (uint32_t)wav_len, NULL) ||
+            !audio_inline_claim(&clip, pub.clip_id, &http) ||
+            pthread_create(&publisher, NULL, publisher_thread, &pub) != 0) {
+            return 1;
+        }
+    }
+    // Same budget shape as the device defaults, scaled down for the loopback
+    audio_resume_t resume;
+    if (opts.resume) {
+        audio_resume_config_t rcfg = { .max_retries = opts.resume, .backoff_ms = 20, .max_backoff_ms = 200 };
+        audio_resume_bind(&resume, &http, &rcfg, &http);
+    }
+    preempter_t pre = { .ctx = &ctx, .at_ms = opts.preempt_at_ms };
+    pthread_t preempter;
+    if (opts.preempt_at_ms && pthread_create(&preempter, NULL, preempt_thread, &pre) != 0) return 1;
+    // Budget for the queued message's head, filled while the first plays
+    audio_prefetch_t ahead;
+    audio_prefetch_init(&ahead, malloc((size_t)opts.prefetch_kb * 1024), (size_t)opts.prefetch_kb * 1024);
+    int rc = run_once(&ctx, &opts, &ring, http, url, &cache, opts.next && opts.prefetch_kb ? &ahead : NULL);
+    double preempt_ms = 0;
+    if (opts.preempt_at_ms) {
+        int64_t t_done = audio_time_us();
+        pthread_join(preempter, NULL);
+        if (rc != AUDIO_ERR_CANCELLED) {
+            fprintf(stderr, "FAIL: clip ended before the preemption (%d)\n", rc);
+            return 1;
+        }
+        // The urgent message takes over the same ring and connection
+        bench_ctx_t urgent = { 0 };
+        rc = run_once(&urgent, &opts, &ring, http, url, NULL, NULL);
+        const audio_pipeline_stats_t *us = &urgent.pipeline.stats;
+        double silent_ms = (ctx.i2s.t_silent_us - pre.t_cancel_us) / 1000.0;
+        double done_ms = (t_done - pre.t_cancel_us) / 1000.0;
+        preempt_ms = silent_ms > done_ms ? silent_ms : done_ms;
+        printf("preempt: at_ms=%u silent_ms=%.1f done_ms=%.1f next_first_write_ms=%.1f discarded_bytes=%u "
+               "urgent_underruns=%u\n", (unsigned)opts.preempt_at_ms, silent_ms, done_ms,
+               (us->t_first_write_us - pre.t_cancel_us) / 1000.0, (unsigned)ctx.pipeline.stats.bytes_discarded,
+               (unsigned)urgent.i2s.underruns);
+        audio_pipeline_deinit(&urgent.pipeline);
+        if (rc != AUDIO_OK) {
+            fprintf(stderr, "urgent message failed: %d\n", rc);
+            return 1;
+        }
+    }
+    double gap_ms = 0;
+    if (opts.next && rc == AUDIO_OK) {
+        bench_ctx_t next = { 0 };
+        audio_source_t src = http;
+        if (opts.prefetch_kb) {
+            audio_prefetch_bind(&ahead, &src);
+            next.pipeline.prefetch_us = ahead.busy_us;
+        }
+        rc = run_once(&next, &opts, &ring, src, url, NULL, NULL);
+        const audio_pipeline_stats_t *ns = &next.pipeline.stats;
+        gap_ms = (ns->t_first_write_us - ctx.pipeline.stats.t_played_us) / 1000.0;
+        printf("next: gap_ms=%.1f prefetched_bytes=%u prefetch_busy_ms=%.1f prefill_ms=%u underruns=%u\n", gap_ms,
+               (unsigned)ahead.len, ahead.busy_us / 1000.0, (unsigned)ns->prefill_target_ms,
+               (unsigned)next.i2s.underruns);
+        if (next.i2s.underruns > ctx.i2s.underruns) ctx.i2s.underruns = next.i2s.underruns;
+        audio_pipeline_deinit(&next.pipeline);
+        if (rc != AUDIO_OK) {
+            fprintf(stderr, "queued message failed: %d\n", rc);
+            return 1;
+        }
+    }
+    free(ahead.buf);
+    http_file_server_stop(&server);
+    if (opts.inline_chunk) {
+        pthread_join(publisher, NULL);
+        audio_inline_stats_t is = audio_inline_stats(&clip);
+        printf("inline: chunks=%u chunk_bytes=%u first_chunk_ms=%.1f complete_ms=%.1f gaps=%u\n",
+               (unsigned)is.chunks, (unsigned)opts.inline_chunk, (is.t_first_chunk_us - is.t_begin_us) / 1000.0,
+               (is.t_complete_us - is.t_begin_us) / 1000.0, (unsigned)is.gaps);
+        free(clip.buf);
+        host_signal_deinit(&clip_signal);
+    }
+    if (opts.resume) {
+        printf("resume: resumes=%u retries=%u skipped=%u stalled_ms=%u range_requests=%u drops=%u\n",
+               (unsigned)resume.resumes, (unsigned)resume.retries, (unsigned)resume.skipped,
+               (unsigned)resume.stalled_ms, (unsigned)server.range_requests, (unsigned)server.drops);
+    }
+    if (rc != AUDIO_OK) {
+        fprintf(stderr, "pipeline failed: %d\n", rc);
+        return 1;
+    }
+    bool truncated = !opts.preempt_at_ms && ctx.pipeline.stats.bytes_processed < (int)wav_len;
+
+    audio_pipeline_t *p = &ctx.pipeline;
+    printf("format=%uHz/%uch/%s seconds=%.2f file_bytes=%zu link_kbps=%u latency_ms=%u ring_kb=%u zero_copy=%d "
+           "delivery=%s\n",
+           (unsigned)opts.sample_rate, (unsigned)opts.channels, opts.adpcm_block ? "adpcm" : (opts.bits == 16 ? "16bit" : "32bit"),
+           opts.seconds, wav_len, (unsigned)opts.rate_kbps, (unsigned)opts.latency_ms, (unsigned)opts.ring_kb, opts.zero_copy,
+           opts.inline_chunk ? "mqtt" : "http");
+    double ttfs_ms = report(&ctx);
+    uint32_t underruns = ctx.i2s.underruns;
+    uint32_t hard_stops = ctx.i2s.hard_stops;
+    uint32_t concealed = p->stats.concealed;
+    uint32_t first_fnv = ctx.i2s.checksum;
+    audio_pipeline_deinit(p);
+
+    if (opts.replay) {
+        // Second play of the same filename: served from the cache, no network
+        audio_cache_entry_t *hit = audio_cache_acquire(&cache, BENCH_CACHE_KEY);
+        if (!hit) {
+            fprintf(stderr, "FAIL: clip was not cached\n");
+            return 1;
+        }
+        audio_cache_source_t mem;
+        audio_source_t cached;
+        audio_cache_source_bind(&mem, hit, &cached);
+        bench_ctx_t replay = { 0 };
+        rc = run_once(&replay, &opts, &ring, cached, url, NULL, NULL);
+        audio_cache_release(&cache, hit);
+        if (rc != AUDIO_OK) {
+            fprintf(stderr, "replay failed: %d\n", rc);
+            return 1;
+        }
+        printf("replay:\n");
+        double replay_ttfs_ms = report(&replay);
+        audio_cache_counters_t cc = audio_cache_counters(&cache);
+        printf("cache hits=%u misses=%u evictions=%u rejects=%u\n", (unsigned)cc.hits, (unsigned)cc.misses,
+               (unsigned)cc.evictions, (unsigned)cc.rejects);
+        if (replay.i2s.checksum != first_fnv) {
+            fprintf(stderr, "FAIL: replay pcm differs\n");
+            return 1;
+        }
+        if (replay.i2s.underruns > underruns) underruns = replay.i2s.underruns;
+        if (replay_ttfs_ms > ttfs_ms) ttfs_ms = replay_ttfs_ms;
+        audio_pipeline_deinit(&replay.pipeline);
+    }
+
+    if (opts.static_buffers && (p->chunk_buffer != pool_chunk || p->mono_buffer != pool_mono)) {
+        fprintf(stderr, "FAIL: static buffers were released by deinit\n");
+        return 1;
+    }
+    free(pool_chunk);
+    free(pool_mono);
+    audio_cache_deinit(&cache);
+    host_spsc_deinit(&ring);
+    free(wav);
+
+    int fail = 0;
+    if (opts.max_ttfs_ms >= 0 && ttfs_ms > opts.max_ttfs_ms) {
+        fprintf(stderr, "FAIL: ttfs %.1f ms > %.1f ms\n", ttfs_ms, opts.max_ttfs_ms);
+        fail = 1;
+    }
+    if (opts.max_underruns >= 0 && (long)underruns > opts.max_underruns) {
+        fprintf(stderr, "FAIL: %u underruns > %ld\n", underruns, opts.max_underruns);
+        fail = 1;
+    }
+    if (opts.max_hard_stops >= 0 && (long)hard_stops > opts.max_hard_stops) {
+        fprintf(stderr, "FAIL: %u hard stops > %ld\n", hard_stops, opts.max_hard_stops);
+        fail = 1;
+    }
+    if (opts.max_preempt_ms >= 0 && preempt_ms > opts.max_preempt_ms) {
+        fprintf(stderr, "FAIL: preemption took %.1f ms > %.1f ms\n", preempt_ms, opts.max_preempt_ms);
+        fail = 1;
+    }
+    if (opts.max_gap_ms >= 0 && gap_ms > opts.max_gap_ms) {
+        fprintf(stderr, "FAIL: %.1f ms between queued clips > %.1f ms\n", gap_ms, opts.max_gap_ms);
+        fail = 1;
+    }
+    if (opts.resume && truncated) {
+        fprintf(stderr, "FAIL: body ended early after a drop\n");
+        fail = 1;
+    }
+    if (opts.conceal && opts.stall_ms && concealed == 0) {
+        fprintf(stderr, "FAIL: stall was not concealed\n");
+        fail = 1;
+    }
+    return fail;
+}
@@ -0,0 +1,140 @@
+// Audio cache behaviour: LRU eviction order, pinned entries surviving
+// eviction, oversized clips rejected, persistent-store write-back and
+// promotion, and the in-memory source serving the stored WAV.
+// Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_cache.h"
+
+#define CLIP_PCM 1000
+#define ENTRY_SIZE (AUDIO_CACHE_WAV_HEADER + CLIP_PCM)
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Persistent store stand-in: a handful of named blobs in memory
+typedef struct {
+    char key[4][AUDIO_CACHE_KEY_MAX];
+    uint8_t *data[4];
+    size_t len[4];
+    int writes;
+} mem_store_t;
+
+static int store_slot(mem_store_t *s, const char *key) {
+    for (int i = 0; i < 4; i++) {
+        if (s->data[i] && strcmp(s->key[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+static int store_find(void *ctx, const char *key) {
+    mem_store_t *s = ctx;
+    int i = store_slot(s, key);
+    return i < 0 ? -1 : (int)s->len[i];
+}
+
+static bool store_read(void *ctx, const char *key, void *dst, size_t len) {
+    mem_store_t *s = ctx;
+    int i = store_slot(s, key);
+    if (i < 0 || len != s->len[i]) return false;
+    memcpy(dst, s->data[i], len);
+    return true;
+}
+
+static bool store_write(void *ctx, const char *key, const void *data, size_t len) {
+    mem_store_t *s = ctx;
+    for (int i = 0; i < 4; i++) {
+        if (s->data[i]) continue;
+        strcpy(s->key[i], key);
+        s->data[i] = malloc(len);
+        memcpy(s->data[i], data, len);
+        s->len[i] = len;
+        s->writes++;
+        return true;
+    }
+    return false;
+}
+
+// Capture a clip whose samples are all `fill`
+static bool put(audio_cache_t *c, const char *key, uint8_t fill) {
+    uint8_t pcm[CLIP_PCM];
+    memset(pcm, fill, sizeof(pcm));
+    audio_cache_entry_t *e = audio_cache_begin(c, key, 16000, 16, CLIP_PCM);
+    if (!e) return false;
+    if (!audio_cache_append(e, pcm, 600) || !audio_cache_append(e, pcm + 600, 400)) {
+        audio_cache_abort(c, e);
+        return false;
+    }
+    audio_cache_commit(c, e);
+    return true;
+}
+
+static bool present(audio_cache_t *c, const char *key) {
+    audio_cache_entry_t *e = audio_cache_acquire(c, key);
+    if (e) audio_cache_release(c, e);
+    return e != NULL;
+}
+
+int main(void) {
+    audio_cache_t c;
+    audio_cache_init(&c, 3 * ENTRY_SIZE, NULL, NULL);
+
+    check("capture", put(&c, "a", 1) && put(&c, "b", 2) && put(&c, "c", 3));
+    check("hit", present(&c, "a"));                 // a is now most recent
+    check("lru_eviction", put(&c, "d", 4) && !present(&c, "b") && present(&c, "a"));
+
+    audio_cache_entry_t *pinned = audio_cache_acquire(&c, "c");
+    put(&c, "e", 5);
+    put(&c, "f", 6);
+    check("pinned_survives", pinned && pinned->data && strcmp(pinned->key, "c") == 0 && present(&c, "c"));
+    audio_cache_release(&c, pinned);
+
+    check("overflow_rejected", !audio_cache_begin(&c, "big", 16000, 16, 4 * ENTRY_SIZE));
+    audio_cache_entry_t *e = audio_cache_begin(&c, "short", 16000, 16, 10);
+    uint8_t junk[11] = { 0 };
+    check("append_bounded", e && !audio_cache_append(e, junk, sizeof(junk)));
+    if (e) audio_cache_abort(&c, e);
+
+    audio_cache_counters_t cc = audio_cache_counters(&c);
+    check("counters", cc.misses == 1 && cc.evictions >= 3 && cc.rejects == 1 && cc.hits >= 4);
+    printf("hits=%u misses=%u evictions=%u rejects=%u\n", (unsigned)cc.hits, (unsigned)cc.misses,
+           (unsigned)cc.evictions, (unsigned)cc.rejects);
+    audio_cache_deinit(&c);
+
+    // Write-back to the store, then promotion after RAM eviction
+    mem_store_t store = { 0 };
+    audio_cache_store_t st = { &store, store_find, store_read, store_write };
+    audio_cache_init(&c, ENTRY_SIZE, NULL, &st);
+    put(&c, "x", 7);
+    audio_cache_flush(&c);
+    audio_cache_flush(&c);
+    put(&c, "y", 8);                                // evicts x from RAM
+    check("contains", audio_cache_contains(&c, "x") && audio_cache_contains(&c, "y") &&
+                      !audio_cache_contains(&c, "z") && audio_cache_counters(&c).store_hits == 0);
+    audio_cache_entry_t *x = audio_cache_acquire(&c, "x");
+    cc = audio_cache_counters(&c);
+    check("store_written_once", store.writes == 1 && cc.stored == 1);
+    check("store_promotion", x && cc.store_hits == 1 && x->len == ENTRY_SIZE && x->data[AUDIO_CACHE_WAV_HEADER] == 7);
+
+    // The entry reads back as a mono 16-bit WAV
+    audio_cache_source_t mem;
+    audio_source_t src;
+    audio_cache_source_bind(&mem, x, &src);
+    uint8_t wav[ENTRY_SIZE];
+    int len = src.open(src.ctx, NULL);
+    int got = 0, n;
+    while ((n = src.read(src.ctx, wav + got, 300)) > 0) got += n;
+    check("source_reads_wav", len == ENTRY_SIZE && got == ENTRY_SIZE && memcmp(wav, "RIFF", 4) == 0 &&
+                              wav[22] == 1 && wav[34] == 16 && wav[40] == (CLIP_PCM & 0xff));
+    audio_cache_release(&c, x);
+    audio_cache_deinit(&c);
+    for (int i = 0; i < 4; i++) free(store.data[i]);
+
+    return failures ? 1 : 0;
+}
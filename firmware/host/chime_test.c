@@ -0,0 +1,125 @@
+// Chime image lookup and playback: table validation, unknown ids, and the
+// sink being fed straight from the image. With an argument, also checks an
+// image built by tools/mkchimes.py. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_chime.h"
+#include "audio_pipeline.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void wr_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// Two chimes: 300 bytes at 16 kHz and 10000 bytes at 44.1 kHz
+#define IMAGE_SIZE (AUDIO_CHIME_HEADER + 2 * AUDIO_CHIME_ENTRY + 300 + 10000)
+
+static void build_image(uint8_t *img) {
+    memset(img, 0, IMAGE_SIZE);
+    memcpy(img, AUDIO_CHIME_MAGIC, 4);
+    wr_le32(img + 4, 2);
+    uint32_t off = AUDIO_CHIME_HEADER + 2 * AUDIO_CHIME_ENTRY;
+    uint8_t *e = img + AUDIO_CHIME_HEADER;
+    wr_le32(e, off);
+    wr_le32(e + 4, 300);
+    wr_le32(e + 8, 16000);
+    e[12] = 16;
+    wr_le32(e + 16, off + 300);
+    wr_le32(e + 20, 10000);
+    wr_le32(e + 24, 44100);
+    e[28] = 16;
+    for (uint32_t i = off; i < IMAGE_SIZE; i++) img[i] = (uint8_t)i;
+}
+
+// Records where each write pointed, to prove playback does not copy
+typedef struct {
+    const uint8_t *first;
+    size_t total;
+    int writes;
+    bool contiguous;
+} capture_sink_t;
+
+static int capture_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    capture_sink_t *s = ctx;
+    if (!s->first) s->first = buf;
+    if ((const uint8_t *)buf != s->first + s->total) s->contiguous = false;
+    s->total += len;
+    s->writes++;
+    *written = len;
+    return 0;
+}
+
+static void check_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        failures++;
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *img = malloc((size_t)size);
+    size_t got = fread(img, 1, (size_t)size, f);
+    fclose(f);
+
+    audio_chime_t c;
+    unsigned count = 0;
+    int64_t total_ms = 0;
+    while (got == (size_t)size && audio_chime_find(img, got, count + 1, &c) == AUDIO_OK) {
+        printf("chime %u: %u Hz %u-bit, %u bytes, %ld ms\n", count + 1, (unsigned)c.sample_rate,
+               (unsigned)c.bits_per_sample, (unsigned)c.len, (long)(audio_chime_duration_us(&c) / 1000));
+        total_ms += audio_chime_duration_us(&c) / 1000;
+        count++;
+    }
+    check("mkchimes_image", count > 0 && total_ms > 0);
+    free(img);
+}
+
+int main(int argc, char **argv) {
+    static uint8_t img[IMAGE_SIZE];
+    build_image(img);
+
+    audio_chime_t a, b;
+    check("find", audio_chime_find(img, IMAGE_SIZE, 1, &a) == AUDIO_OK &&
+                  audio_chime_find(img, IMAGE_SIZE, 2, &b) == AUDIO_OK);
+    check("fields", a.len == 300 && a.sample_rate == 16000 && a.bits_per_sample == 16 &&
+                    b.len == 10000 && b.sample_rate == 44100 && b.pcm == a.pcm + 300);
+    check("duration", audio_chime_duration_us(&a) == 9375 && audio_chime_duration_us(&b) == 113378);
+
+    check("id_zero_is_none", audio_chime_find(img, IMAGE_SIZE, 0, &a) == AUDIO_ERR_FORMAT);
+    check("unknown_id", audio_chime_find(img, IMAGE_SIZE, 3, &a) == AUDIO_ERR_FORMAT);
+    check("truncated_image", audio_chime_find(img, IMAGE_SIZE - 1, 2, &a) == AUDIO_ERR_FORMAT &&
+                             audio_chime_find(img, 20, 1, &a) == AUDIO_ERR_FORMAT);
+    check("missing_image", audio_chime_find(NULL, 0, 1, &a) == AUDIO_ERR_FORMAT);
+    img[0] = 'X';
+    check("bad_magic", audio_chime_find(img, IMAGE_SIZE, 1, &a) == AUDIO_ERR_FORMAT);
+    img[0] = AUDIO_CHIME_MAGIC[0];
+
+    // Playback hands out pointers into the image in chunk-sized writes
+    audio_chime_find(img, IMAGE_SIZE, 2, &b);
+    capture_sink_t cap = { .contiguous = true };
+    audio_sink_t sink = { &cap, capture_write };
+    check("play_zero_copy", audio_chime_play(&b, &sink, NULL, 0) == AUDIO_OK && cap.first == b.pcm &&
+                            cap.contiguous && cap.total == b.len &&
+                            cap.writes == (int)((b.len + AUDIO_CHUNK_BUFFER_SIZE - 1) / AUDIO_CHUNK_BUFFER_SIZE));
+
+    // At a fixed output rate the chime is converted on the way out
+    static audio_resampler_t rs;
+    cap = (capture_sink_t) { .contiguous = true };
+    size_t frames = b.len / 2;
+    size_t expect = (frames * 48000 + 44099) / 44100;
+    check("play_resampled", audio_chime_play(&b, &sink, &rs, 48000) == AUDIO_OK &&
+                            cap.total == expect * sizeof(int16_t));
+
+    if (argc > 1) check_file(argv[1]);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+// Gap concealment (audio_conceal.h): transparent while audio flows, a
+// fade to exact silence plus pad when the ring runs dry, a fade-in after,
+// and no step larger than the signal's own slope at either edge, for
+// 16- and 32-bit audio and any write size. Exits non-zero on any failure.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_conceal.h"
+#include "audio_pipeline.h"
+
+#define RATE 48000
+#define FRAMES 4800
+#define CAPTURE_MAX (4 * FRAMES + 4096)
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+typedef struct {
+    uint8_t buf[CAPTURE_MAX * 4];
+    size_t len;
+} capture_t;
+
+static int capture_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    capture_t *c = ctx;
+    if (c->len + len > sizeof(c->buf)) return -1;
+    memcpy(c->buf + c->len, buf, len);
+    c->len += len;
+    *written = len;
+    return 0;
+}
+
+static capture_t cap;
+static audio_conceal_t conceal;
+
+// Largest step between neighbouring samples, at 16-bit scale
+static int32_t max_step(const uint8_t *buf, size_t frames, uint16_t bps) {
+    int32_t prev = 0, step = 0;
+    for (size_t i = 0; i < frames; i++) {
+        int32_t v = bps == 2 ? ((const int16_t *)buf)[i] : ((const int32_t *)buf)[i] >> 16;
+        if (i && abs(v - prev) > step) step = abs(v - prev);
+        prev = v;
+    }
+    return step;
+}
+
+// A 1 kHz tone written in `chunk`-frame pieces with a gap after `gap_at`
+// frames; returns the frame at which the fade-out's silence begins
+static size_t run(uint16_t bits, size_t chunk, size_t gap_at, uint8_t *tone) {
+    uint16_t bps = bits / 8;
+    for (size_t i = 0; i < FRAMES; i++) {
+        double v = 0.9 * sin(2 * M_PI * 1000 * i / RATE);
+        if (bps == 2) ((int16_t *)tone)[i] = (int16_t)lrint(v * 32767);
+        else ((int32_t *)tone)[i] = (int32_t)lrint(v * 2147483647.0);
+    }
+    audio_sink_t next = { .ctx = &cap, .write = capture_write }, sink;
+    cap.len = 0;
+    audio_conceal_bind(&conceal, &next, RATE, bits, &sink);
+    size_t silence_at = 0;
+    for (size_t i = 0; i < FRAMES;) {
+        size_t n = FRAMES - i < chunk ? FRAMES - i : chunk;
+        if (i < gap_at && i + n > gap_at) n = gap_at - i;
+        size_t written;
+        sink.write(sink.ctx, tone + i * bps, n * bps, &written);
+        i += n;
+        if (gap_at && i == gap_at) {
+            audio_conceal_fade_out(&conceal);
+            silence_at = cap.len / bps - AUDIO_CONCEAL_PAD_FRAMES;
+        }
+    }
+    audio_conceal_finish(&conceal);
+    return silence_at;
+}
+
+static uint8_t tone[FRAMES * 4];
+
+int main(void) {
+    const size_t fade = RATE * AUDIO_CONCEAL_FADE_MS / 1000;
+    // Sine slope at 0.9 FS, 1 kHz, 48 kHz: about 3.9k per sample at 16-bit scale
+    const int32_t slope = (int32_t)(0.9 * 32767 * 2 * M_PI * 1000 / RATE) + 2;
+
+    run(16, 480, 0, tone);
+    check("transparent", cap.len == FRAMES * 2 && memcmp(cap.buf, tone, cap.len) == 0);
+    run(16, 7, 0, tone);
+    check("transparent_small_writes", cap.len == FRAMES * 2 && memcmp(cap.buf, tone, cap.len) == 0);
+
+    static const struct { uint16_t bits; size_t chunk; } cases[] = { { 16, 480 }, { 16, 37 }, { 32, 480 }, { 32, 1000 } };
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        uint16_t bps = cases[k].bits / 8;
+        size_t gap_at = 2000;
+        size_t silence_at = run(cases[k].bits, cases[k].chunk, gap_at, tone);
+        char name[32];
+        snprintf(name, sizeof(name), "gap_%ubit_chunk%u", (unsigned)cases[k].bits, (unsigned)cases[k].chunk);
+        // Everything arrives once, plus the pad; the tail before the gap
+        // ends in silence and the audio after it starts from silence
+        int ok = cap.len == (FRAMES + AUDIO_CONCEAL_PAD_FRAMES) * bps && silence_at == gap_at;
+        int32_t last = bps == 2 ? ((int16_t *)cap.buf)[silence_at - 1] : ((int32_t *)cap.buf)[silence_at - 1] >> 16;
+        ok = ok && abs(last) <= 1 && max_step(cap.buf, cap.len / bps, bps) <= slope;
+        for (size_t i = 0; ok && i < AUDIO_CONCEAL_PAD_FRAMES; i++) {
+            ok = memcmp(cap.buf + (silence_at + i) * bps, "\0\0\0\0", bps) == 0;
+        }
+        // Untouched away from the edges
+        size_t resume = silence_at + AUDIO_CONCEAL_PAD_FRAMES;
+        ok = ok && memcmp(cap.buf, tone, (gap_at - fade) * bps) == 0 &&
+             memcmp(cap.buf + (resume + fade) * bps, tone + (gap_at + fade) * bps, (FRAMES - gap_at - fade) * bps) == 0;
+        check(name, ok);
+    }
+
+    // A gap before a whole fade has been held fades what there is
+    run(16, 480, 50, tone);
+    check("short_hold", cap.len == (FRAMES + AUDIO_CONCEAL_PAD_FRAMES) * 2 &&
+                        max_step(cap.buf, cap.len / 2, 2) <= slope);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+// Behaviour and cost of the post-processing chain (audio_dsp.h).
+//
+// Checks that the SIMD gain ramp matches its reference, that the limiter
+// keeps full-scale input with make-up gain under the ceiling (including a
+// step out of silence, which the look-ahead must catch), that a neutral
+// chain passes audio through, the EQ band responses, chunking invariance
+// and release. Then reports the cost in cycles per sample (TSC cycles on
+// x86) and the share of real time at 48 kHz.
+// The optional argument is the benchmark's iteration count.
+// Exits non-zero on any failure.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_dsp.h"
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "pcm_convert.h"
+
+#define RATE 48000
+#define FRAMES RATE             // one second
+#define DEFAULT_ITERS 50
+
+static int failures = 0;
+static audio_dsp_t dsp;
+
+static void check(const char *name, int ok) {
+    printf("%-28s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void tone(int16_t *pcm, size_t frames, double hz, double amp) {
+    for (size_t i = 0; i < frames; i++) pcm[i] = (int16_t)lrint(amp * 32767 * sin(2 * M_PI * hz * i / RATE));
+}
+
+// Whole buffer through the chain in `chunk`-frame pieces plus flush
+static size_t run(const audio_dsp_config_t *cfg, const int16_t *in, size_t frames, size_t chunk, int16_t *out) {
+    if (audio_dsp_init(&dsp, cfg, RATE) != AUDIO_OK) return 0;
+    size_t produced = 0;
+    for (size_t i = 0; i < frames; i += chunk) {
+        size_t n = frames - i < chunk ? frames - i : chunk;
+        produced += audio_dsp_process(&dsp, in + i, n, out + produced);
+    }
+    return produced + audio_dsp_flush(&dsp, out + produced);
+}
+
+static int peak(const int16_t *pcm, size_t from, size_t to) {
+    int p = 0;
+    for (size_t i = from; i < to; i++) p = abs(pcm[i]) > p ? abs(pcm[i]) : p;
+    return p;
+}
+
+static double gain_db(const int16_t *out, const int16_t *in, size_t frames) {
+    size_t skip = frames / 4;   // past filter settling
+    double so = 0, si = 0;
+    for (size_t i = skip; i < frames; i++) {
+        so += (double)out[i] * out[i];
+        si += (double)in[i] * in[i];
+    }
+    return 10 * log10(so / si);
+}
+
+static double band_gain(const audio_dsp_config_t *cfg, double hz, int16_t *in, int16_t *out) {
+    tone(in, FRAMES, hz, 0.25);
+    size_t n = run(cfg, in, FRAMES, 480, out);
+    return n == FRAMES ? gain_db(out, in, FRAMES) : 99;
+}
+
+static const audio_dsp_config_t speaker = {
+    .gain_db = 6, .limit_dbfs = -1, .release_ms = 100, .num_bands = 3,
+    .bands = {
+        { AUDIO_EQ_HIGHPASS, 150, 0.54f, 0 },   // 4th-order Butterworth
+        { AUDIO_EQ_HIGHPASS, 150, 1.31f, 0 },
+        { AUDIO_EQ_PEAK, 3000, 1.0f, 3 },
+    },
+};
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERS;
+    int16_t *in = audio_alloc_aligned(FRAMES * sizeof(int16_t));
+    int16_t *out = audio_alloc_aligned((FRAMES + 2 * AUDIO_DSP_BLOCK) * sizeof(int16_t));
+    int16_t *a = audio_alloc_aligned(FRAMES * sizeof(int16_t));
+    int16_t *b = audio_alloc_aligned(FRAMES * sizeof(int16_t));
+    if (!in || !out || !a || !b) return 1;
+
+    // Ramp kernel against its reference, rising, falling and flat
+    uint32_t seed = 1;
+    for (size_t i = 0; i < FRAMES; i++) in[i] = (int16_t)((seed = seed * 1103515245 + 12345) >> 16);
+    static const int32_t ramps[][2] = { { 0, 4096 }, { 8192, 1024 }, { 4096, 4096 }, { 32767, 30000 } };
+    int ramp_ok = 1;
+    for (size_t r = 0; r < sizeof(ramps) / sizeof(ramps[0]); r++) {
+        for (size_t len = 1; len < 100; len += 7) {
+            memcpy(a, in, len * sizeof(int16_t));
+            memcpy(b, in, len * sizeof(int16_t));
+            pcm_gain_ramp_s16_ref(a, len, ramps[r][0], ramps[r][1]);
+            pcm_gain_ramp_s16(b, len, ramps[r][0], ramps[r][1]);
+            ramp_ok &= memcmp(a, b, len * sizeof(int16_t)) == 0;
+        }
+    }
+    check("gain_ramp_matches_ref", ramp_ok);
+
+    // +12 dB on a full-scale tone, then silence into a full-scale step
+    audio_dsp_config_t loud = { .gain_db = 12, .limit_dbfs = -1, .release_ms = 50 };
+    int ceiling = (int)lrint(32767 * pow(10, -1 / 20.0));
+    tone(in, FRAMES, 1000, 0.99);
+    size_t n = run(&loud, in, FRAMES, 480, out);
+    check("limiter_ceiling", n == FRAMES && peak(out, 0, n) <= ceiling && peak(out, 0, n) > ceiling * 9 / 10);
+    memset(in, 0, FRAMES * sizeof(int16_t));
+    for (size_t i = FRAMES / 2 + 5; i < FRAMES; i++) in[i] = (i / 7) % 2 ? 32767 : -32768;
+    n = run(&loud, in, FRAMES, 100, out);
+    check("limiter_lookahead_step", n == FRAMES && peak(out, 0, n) <= ceiling);
+
+    // Loud burst then a quiet tone: gain returns to the make-up level
+    tone(in, FRAMES, 440, 0.05);
+    tone(in, FRAMES / 10, 440, 0.99);
+    n = run(&loud, in, FRAMES, 256, out);
+    double late = gain_db(out + FRAMES / 2, in + FRAMES / 2, FRAMES / 2);
+    check("limiter_release", n == FRAMES && fabs(late - 12) < 0.5);
+
+    // Neutral chain: 0 dB, no EQ, 0 dBFS ceiling passes audio within 1 LSB
+    audio_dsp_config_t neutral = { .gain_db = 0, .limit_dbfs = 0 };
+    tone(in, FRAMES, 1000, 0.5);
+    n = run(&neutral, in, FRAMES, 333, out);
+    int neutral_ok = n == FRAMES;
+    for (size_t i = 0; neutral_ok && i < n; i++) neutral_ok = abs(out[i] - in[i]) <= 1;
+    check("neutral_passthrough", neutral_ok);
+
+    // EQ responses: speaker high-pass and presence peak, limiter out of the way
+    audio_dsp_config_t eq = speaker;
+    eq.gain_db = 0;
+    eq.limit_dbfs = 0;
+    double g50 = band_gain(&eq, 50, in, out), g1k = band_gain(&eq, 1000, in, out);
+    double g3k = band_gain(&eq, 3000, in, out);
+    printf("eq: 50 Hz %.1f dB, 1 kHz %.1f dB, 3 kHz %.1f dB\n", g50, g1k, g3k);
+    check("eq_highpass", g50 < -30 && fabs(g1k) < 1.0);
+    check("eq_presence_peak", fabs(g3k - 3) < 0.5);
+    audio_dsp_config_t bad = { .num_bands = 1, .bands = { { AUDIO_EQ_PEAK, 30000, 1, 3 } } };
+    check("eq_rejects_above_nyquist", audio_dsp_init(&dsp, &bad, RATE) == AUDIO_ERR_FORMAT);
+
+    // Output does not depend on how the input is chunked
+    tone(in, FRAMES, 700, 0.9);
+    size_t na = run(&speaker, in, FRAMES, 1, a);
+    size_t nb = run(&speaker, in, FRAMES, 777, b);
+    check("chunking_invariant", na == FRAMES && nb == FRAMES && memcmp(a, b, FRAMES * sizeof(int16_t)) == 0);
+
+    // Cost of the full speaker chain (3 biquads, gain, limiter) and of the
+    // limiter alone, per output sample
+    audio_dsp_config_t lim_only = { .gain_db = 6, .limit_dbfs = -1, .release_ms = 100 };
+    const audio_dsp_config_t *cfgs[] = { &speaker, &lim_only };
+    const char *names[] = { "chain (3 biquads+limiter)", "gain+limiter only" };
+    for (int c = 0; c < 2; c++) {
+        uint64_t cycles = 0, samples = 0;
+        int64_t t0 = audio_time_us();
+        for (int it = 0; it < iters; it++) {
+            run(cfgs[c], in, FRAMES, AUDIO_DSP_CHUNK, out);
+            cycles += dsp.cycles;
+            samples += dsp.samples;
+        }
+        int64_t us = audio_time_us() - t0;
+        double ns = samples ? us * 1000.0 / samples : 0;
+        double rt = ns * RATE / 1e9;
+        printf("bench %-26s %.1f cycles/sample  %.2f ns/sample  %.3f%% of real time at 48 kHz\n", names[c],
+               samples ? (double)cycles / samples : 0, ns, rt * 100);
+        // Generous: the S3 runs ~10x slower than a desktop core
+        check("realtime_budget", rt < 0.01);
+    }
+
+    free(in); free(out); free(a); free(b);
+    return failures ? 1 : 0;
+}
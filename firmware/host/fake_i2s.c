@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "audio_port.h"
+#include "fake_i2s.h"
+
+// Scheduler jitter on the host; shorter gaps are not audible dropouts
+#define FAKE_I2S_JITTER_US 1000
+// -40 dBFS
+#define FAKE_I2S_CLICK_LEVEL 328
+
+static void sleep_us(int64_t us) {
+    if (us <= 0) return;
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+void fake_i2s_init(fake_i2s_t *s, uint32_t sample_rate, uint16_t bytes_per_frame,
+                   uint32_t dma_desc_num, uint32_t dma_frame_num) {
+    memset(s, 0, sizeof(*s));
+    s->byte_rate = sample_rate * bytes_per_frame;
+    s->bytes_per_frame = bytes_per_frame;
+    s->dma_capacity = (size_t)dma_desc_num * dma_frame_num * bytes_per_frame;
+    s->dma_buffer_bytes = (size_t)dma_frame_num * bytes_per_frame;
+    s->checksum = 2166136261u;
+}
+
+// Advance the virtual playback clock to now.
+static void update(fake_i2s_t *s) {
+    int64_t now = audio_time_us();
+    double consumed = (double)(now - s->last_update_us) * s->byte_rate / 1e6;
+    if (s->first_write_us && !s->t_silent_us && consumed > s->queued) {
+        // Ran dry: the driver would have been emitting auto_clear silence
+        int64_t starved = (int64_t)((consumed - s->queued) * 1e6 / s->byte_rate);
+        if (starved > FAKE_I2S_JITTER_US) {
+            s->underruns++;
+            s->starved_us += starved;
+            if (abs(s->last_sample) > FAKE_I2S_CLICK_LEVEL) s->hard_stops++;
+        }
+    }
+    s->queued = consumed > s->queued ? 0 : s->queued - consumed;
+    s->last_update_us = now;
+}
+
+static int fake_i2s_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    fake_i2s_t *s = ctx;
+    const uint8_t *bytes = buf;
+    for (size_t i = 0; i < len; i++) {
+        s->checksum = (s->checksum ^ bytes[i]) * 16777619u;
+    }
+    if (s->first_write_us == 0) {
+        s->last_update_us = audio_time_us();
+    } else {
+        update(s);
+    }
+
+    size_t remaining = len;
+    while (remaining > 0) {
+        double space = (double)s->dma_capacity - s->queued;
+        if (space < 1.0) {
+            // Queue full: wait for the next descriptor to play out
+            size_t want = remaining < s->dma_buffer_bytes ? remaining : s->dma_buffer_bytes;
+            sleep_us((int64_t)(want * 1e6 / s->byte_rate));
+            update(s);
+            continue;
+        }
+        size_t n = remaining < (size_t)space ? remaining : (size_t)space;
+        s->queued += n;
+        remaining -= n;
+        if (s->first_write_us == 0) {
+            s->first_write_us = s->last_update_us;
+        }
+    }
+
+    // Mono frames; 32-bit samples compared at 16-bit scale
+    if (len >= s->bytes_per_frame) {
+        const uint8_t *last = bytes + len - s->bytes_per_frame;
+        if (s->bytes_per_frame == sizeof(int16_t)) {
+            int16_t v;
+            memcpy(&v, last, sizeof(v));
+            s->last_sample = v;
+        } else {
+            int32_t v;
+            memcpy(&v, last, sizeof(v));
+            s->last_sample = v >> 16;
+        }
+    }
+    s->bytes_written += len;
+    *written = len;
+    return 0;
+}
+
+void fake_i2s_drain(fake_i2s_t *s) {
+    if (s->t_silent_us) {
+        sleep_us(s->t_silent_us - audio_time_us());
+        s->t_drained_us = s->t_silent_us;
+        s->queued = 0;
+        return;
+    }
+    update(s);
+    s->t_drained_us = s->last_update_us + (int64_t)(s->queued * 1e6 / s->byte_rate);
+    sleep_us((int64_t)(s->queued * 1e6 / s->byte_rate));
+    s->queued = 0;
+}
+
+void fake_i2s_fade_out(fake_i2s_t *s) {
+    if (s->t_silent_us) return;
+    s->t_silent_us = audio_time_us() + (int64_t)(3 * s->dma_buffer_bytes * 1e6 / s->byte_rate);
+}
+
+void fake_i2s_bind(fake_i2s_t *s, audio_sink_t *out) {
+    *out = (audio_sink_t) {
+        .ctx = s,
+        .write = fake_i2s_write,
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include "audio_io.h"
+
+// Stand-in for i2s_channel_write: a DMA queue of fixed size drained at the
+// real sample rate. write() blocks while the queue is full, exactly like the
+// driver with portMAX_DELAY, and any moment the queue runs dry between the
+// first write and the final drain is counted as an underrun. Running dry
+// right after a sample louder than FAKE_I2S_CLICK_LEVEL is also counted as
+// a hard stop: the driver's auto_clear zeros then cut the waveform, which
+// is heard as a click.
+//
+// fade_out() stands in for the device's DMA fader (esp_i2s_fader_t): the
+// buffer playing and the next one are heard out, the one after fades, and
+// from then on the output is silent while writes keep being paced as before.
+typedef struct {
+    uint32_t byte_rate;         // bytes consumed per second
+    size_t dma_capacity;        // dma_desc_num * dma_frame_num * frame bytes
+    size_t dma_buffer_bytes;    // one descriptor; a full queue frees this much at a time
+
+    double queued;              // bytes still waiting in the "DMA"
+    int64_t last_update_us;
+    int64_t first_write_us;
+    uint32_t underruns;
+    uint32_t hard_stops;
+    int64_t starved_us;
+    uint16_t bytes_per_frame;
+    int32_t last_sample;        // 16-bit scale
+    uint64_t bytes_written;
+    uint32_t checksum;          // FNV-1a over every byte written, to compare pipeline variants
+    int64_t t_drained_us;       // the last byte written finished playing (set by drain)
+    volatile int64_t t_silent_us; // fade_out() done, output silent from here; 0 = not faded
+} fake_i2s_t;
+
+void fake_i2s_init(fake_i2s_t *s, uint32_t sample_rate, uint16_t bytes_per_frame,
+                   uint32_t dma_desc_num, uint32_t dma_frame_num);
+void fake_i2s_bind(fake_i2s_t *s, audio_sink_t *out);
+
+// Block until everything queued has been "played", or after fade_out()
+// until the fade is over.
+void fake_i2s_drain(fake_i2s_t *s);
+
+// Fades out what is playing within three DMA buffers (the device's worst
+// case); callable from any thread
+void fake_i2s_fade_out(fake_i2s_t *s);
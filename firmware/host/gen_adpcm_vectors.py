@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Regenerate adpcm_vectors.h from CPython's audioop IMA ADPCM codec.
+
+audioop (Python <= 3.12) is an independent reference implementation; its
+nibble stream is high-nibble first, WAV blocks are low-nibble first.
+"""
+import audioop
+import math
+import struct
+import sys
+
+RATE = 16000
+SPB = 505  # 256-byte mono block
+
+
+def block(samples, index):
+    first = samples[0]
+    pcm = struct.pack("<%dh" % (len(samples) - 1), *samples[1:])
+    nibbles, _ = audioop.lin2adpcm(pcm, 2, (first, index))
+    swapped = bytes(((b & 0x0F) << 4) | (b >> 4) for b in nibbles)
+    decoded = audioop.adpcm2lin(nibbles, 2, (first, index))[0]
+    ref = [first] + list(struct.unpack("<%dh" % (len(samples) - 1), decoded))
+    header = struct.pack("<hBB", first, index, 0)
+    return header + swapped, ref
+
+
+def emit(out, name, data, ctype, per_line):
+    out.write("static const %s %s[%d] = {\n" % (ctype, name, len(data)))
+    for i in range(0, len(data), per_line):
+        out.write("    " + ", ".join(str(v) for v in data[i:i + per_line]) + ",\n")
+    out.write("};\n\n")
+
+
+def main():
+    # Chirp with a loud transient so the step index climbs and decays.
+    samples = []
+    for i in range(SPB):
+        v = 0.6 * math.sin(2 * math.pi * (300 + 6 * i) * i / RATE)
+        if 200 <= i < 210:
+            v = 0.98 if i % 2 else -0.98
+        samples.append(int(v * 32767))
+    blk, ref = block(samples, 20)
+
+    out = sys.stdout
+    out.write("// Generated by gen_adpcm_vectors.py; do not edit.\n#pragma once\n\n#include <stdint.h>\n\n")
+    emit(out, "adpcm_ref_input", samples, "int16_t", 12)
+    emit(out, "adpcm_ref_block", list(blk), "uint8_t", 16)
+    emit(out, "adpcm_ref_pcm", ref, "int16_t", 12)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,127 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "host_http_source.h"
+
+static int parse_url(const char *url, char *host, size_t host_cap, uint16_t *port, const char **path) {
+    const char *p = strstr(url, "://");
+    p = p ? p + 3 : url;
+    const char *colon = strchr(p, ':');
+    const char *slash = strchr(p, '/');
+    if (!colon || (slash && slash < colon)) return -1;
+    size_t host_len = (size_t)(colon - p);
+    if (host_len >= host_cap) return -1;
+    memcpy(host, p, host_len);
+    host[host_len] = '\0';
+    *port = (uint16_t)atoi(colon + 1);
+    *path = slash ? slash : "/";
+    return 0;
+}
+
+// Sends the GET (from byte `offset` when > 0) and reads the headers.
+// Returns the content length and sets *status, or -1.
+static int request(host_http_source_t *src, const char *url, uint32_t offset, int *status) {
+    char host[64];
+    uint16_t port;
+    const char *path;
+    src->pending_len = src->pending_off = 0;
+    if (parse_url(url, host, sizeof(host), &port, &path) < 0) return -1;
+
+    src->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (src->fd < 0) return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 ||
+        connect(src->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        return -1;
+    }
+
+    char req[512], range[48] = "";
+    if (offset > 0) snprintf(range, sizeof(range), "Range: bytes=%lu-\r\n", (unsigned long)offset);
+    int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n", path, host, range);
+    if (send(src->fd, req, (size_t)n, MSG_NOSIGNAL) != n) return -1;
+
+    // Read the status line and headers; keep any body bytes that came along
+    char hdr[sizeof(src->pending) + 1];
+    size_t len = 0;
+    char *end = NULL;
+    while (!end) {
+        if (len >= sizeof(hdr) - 1) return -1;
+        ssize_t r = recv(src->fd, hdr + len, sizeof(hdr) - 1 - len, 0);
+        if (r <= 0) return -1;
+        len += (size_t)r;
+        hdr[len] = '\0';
+        end = strstr(hdr, "\r\n\r\n");
+    }
+    if (strncmp(hdr, "HTTP/1.1 2", 10) != 0 && strncmp(hdr, "HTTP/1.0 2", 10) != 0) return -1;
+    *status = atoi(hdr + 9);
+
+    int content_length = 0;
+    for (char *line = strstr(hdr, "\r\n"); line && line < end; line = strstr(line + 2, "\r\n")) {
+        if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+            content_length = atoi(line + 17);
+        }
+    }
+
+    size_t header_len = (size_t)(end + 4 - hdr);
+    src->pending_len = len - header_len;
+    memcpy(src->pending, hdr + header_len, src->pending_len);
+    return content_length;
+}
+
+static int source_open(void *ctx, const char *url) {
+    int status;
+    return request(ctx, url, 0, &status);
+}
+
+// 206 continues at `offset`; a 200 sends the whole body again
+static int source_open_range(void *ctx, const char *url, uint32_t offset, uint32_t *start) {
+    int status = 0;
+    int len = request(ctx, url, offset, &status);
+    if (len < 0) return -1;
+    *start = status == 206 ? offset : 0;
+    return len;
+}
+
+// Like esp_http_client_read: keep reading until len bytes or end of body.
+static int source_read(void *ctx, uint8_t *buf, int len) {
+    host_http_source_t *src = ctx;
+    int total = 0;
+    if (src->pending_off < src->pending_len) {
+        size_t n = src->pending_len - src->pending_off;
+        if (n > (size_t)len) n = (size_t)len;
+        memcpy(buf, src->pending + src->pending_off, n);
+        src->pending_off += n;
+        total = (int)n;
+    }
+    while (total < len) {
+        ssize_t r = recv(src->fd, buf + total, (size_t)(len - total), 0);
+        if (r < 0) return total > 0 ? total : -1;
+        if (r == 0) break;
+        total += (int)r;
+    }
+    return total;
+}
+
+static void source_close(void *ctx) {
+    host_http_source_t *src = ctx;
+    if (src->fd >= 0) {
+        close(src->fd);
+        src->fd = -1;
+    }
+}
+
+void host_http_source_bind(host_http_source_t *src, audio_source_t *out) {
+    src->fd = -1;
+    *out = (audio_source_t) {
+        .ctx = src,
+        .open = source_open,
+        .read = source_read,
+        .close = source_close,
+        .open_range = source_open_range,
+    };
+}
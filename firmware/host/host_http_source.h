@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include "audio_io.h"
+
+// Minimal blocking HTTP/1.1 GET client behind audio_source_t, for
+// "http://127.0.0.1:<port>/<path>" URLs served by http_file_server.
+typedef struct {
+    int fd;
+    char pending[1024];     // body bytes received together with the headers
+    size_t pending_len;
+    size_t pending_off;
+} host_http_source_t;
+
+void host_http_source_bind(host_http_source_t *src, audio_source_t *out);
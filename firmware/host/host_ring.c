@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_ring.h"
+
+int host_ring_init(host_ring_t *r, size_t capacity) {
+    memset(r, 0, sizeof(*r));
+    r->buf = malloc(capacity);
+    if (!r->buf) return -1;
+    r->capacity = capacity;
+    r->end = capacity;
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    return 0;
+}
+
+void host_ring_deinit(host_ring_t *r) {
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    free(r->buf);
+    r->buf = NULL;
+}
+
+// Wait on the condition; returns false once the deadline has passed.
+static bool wait_until(host_ring_t *r, const struct timespec *deadline) {
+    if (!deadline) {
+        pthread_cond_wait(&r->cond, &r->lock);
+        return true;
+    }
+    return pthread_cond_timedwait(&r->cond, &r->lock, deadline) != ETIMEDOUT;
+}
+
+static struct timespec *make_deadline(struct timespec *ts, uint32_t timeout_ms) {
+    if (timeout_ms == AUDIO_WAIT_FOREVER) return NULL;
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+static bool ring_send(void *ctx, const void *data, size_t len, uint32_t timeout_ms) {
+    host_ring_t *r = ctx;
+    struct timespec ts;
+    struct timespec *deadline = make_deadline(&ts, timeout_ms);
+    if (len > r->capacity) return false;
+
+    pthread_mutex_lock(&r->lock);
+    while (r->capacity - r->used < len) {
+        if (timeout_ms == 0 || !wait_until(r, deadline)) {
+            pthread_mutex_unlock(&r->lock);
+            return false;
+        }
+    }
+    size_t first = r->capacity - r->head;
+    if (first > len) first = len;
+    memcpy(r->buf + r->head, data, first);
+    memcpy(r->buf, (const uint8_t *)data + first, len - first);
+    r->head = (r->head + len) % r->capacity;
+    r->used += len;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    return true;
+}
+
+// Reader reached a skipped gap: release it and continue at the start.
+static void skip_gap(host_ring_t *r) {
+    if (r->tail == r->end && r->end != r->capacity) {
+        r->used -= r->capacity - r->end;
+        r->end = r->capacity;
+        r->tail = 0;
+    }
+}
+
+static bool ring_acquire(void *ctx, void **slot, size_t len, uint32_t timeout_ms) {
+    host_ring_t *r = ctx;
+    struct timespec ts;
+    struct timespec *deadline = make_deadline(&ts, timeout_ms);
+    if (len > r->capacity / 2) return false;
+
+    pthread_mutex_lock(&r->lock);
+    while (1) {
+        bool full = r->used == r->capacity;
+        if (!full && r->head >= r->tail) {
+            if (r->capacity - r->head >= len) break;
+            if (r->tail > len) {
+                // Skip the unusable tail and take the slot at the start
+                r->used += r->capacity - r->head;
+                r->end = r->head;
+                r->head = 0;
+                break;
+            }
+        } else if (!full && r->tail - r->head >= len) {
+            break;
+        }
+        if (timeout_ms == 0 || !wait_until(r, deadline)) {
+            pthread_mutex_unlock(&r->lock);
+            return false;
+        }
+    }
+    *slot = r->buf + r->head;
+    pthread_mutex_unlock(&r->lock);
+    return true;
+}
+
+static void ring_complete(void *ctx, void *slot, size_t used) {
+    host_ring_t *r = ctx;
+    (void)slot;
+    pthread_mutex_lock(&r->lock);
+    r->head += used;
+    if (r->head == r->capacity) r->head = 0;
+    r->used += used;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void *ring_receive(void *ctx, size_t *len, uint32_t timeout_ms) {
+    host_ring_t *r = ctx;
+    struct timespec ts;
+    struct timespec *deadline = make_deadline(&ts, timeout_ms);
+
+    pthread_mutex_lock(&r->lock);
+    skip_gap(r);
+    while (r->used == 0) {
+        if (r->finished || timeout_ms == 0 || !wait_until(r, deadline)) {
+            pthread_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        skip_gap(r);
+    }
+    // Hand out the contiguous part only, like a byte buffer split at the wrap
+    size_t avail = r->end - r->tail;
+    if (avail > r->used) avail = r->used;
+    void *item = r->buf + r->tail;
+    r->outstanding = avail;
+    *len = avail;
+    pthread_mutex_unlock(&r->lock);
+    return item;
+}
+
+static void ring_return_item(void *ctx, void *item) {
+    host_ring_t *r = ctx;
+    (void)item;
+    pthread_mutex_lock(&r->lock);
+    r->tail = (r->tail + r->outstanding) % r->capacity;
+    r->used -= r->outstanding;
+    r->outstanding = 0;
+    skip_gap(r);
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void ring_finish(void *ctx) {
+    host_ring_t *r = ctx;
+    pthread_mutex_lock(&r->lock);
+    r->finished = true;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static size_t ring_free_size(void *ctx) {
+    host_ring_t *r = ctx;
+    pthread_mutex_lock(&r->lock);
+    size_t free_size = r->capacity - r->used;
+    pthread_mutex_unlock(&r->lock);
+    return free_size;
+}
+
+void host_ring_bind(host_ring_t *r, audio_ring_t *out) {
+    pthread_mutex_lock(&r->lock);
+    r->finished = false;
+    pthread_mutex_unlock(&r->lock);
+    *out = (audio_ring_t) {
+        .ctx = r,
+        .capacity = r->capacity,
+        .send = ring_send,
+        .acquire = ring_acquire,
+        .complete = ring_complete,
+        .finish = ring_finish,
+        .receive = ring_receive,
+        .return_item = ring_return_item,
+        .free_size = ring_free_size,
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include "audio_io.h"
+
+// pthread stand-in for a FreeRTOS RINGBUF_TYPE_BYTEBUF. acquire()/complete()
+// hand out contiguous slots like RINGBUF_TYPE_NOSPLIT: when a slot does not
+// fit before the end of storage, the tail gap is skipped (counted as used
+// until the reader passes it).
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t head;        // write index
+    size_t tail;        // read index
+    size_t end;         // end of valid data; < capacity while a skipped gap exists
+    size_t used;        // data bytes plus any skipped gap
+    size_t outstanding; // bytes handed out by receive() and not yet returned
+    bool finished;      // producer is done; an empty ring ends receive()
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} host_ring_t;
+
+int host_ring_init(host_ring_t *r, size_t capacity);
+void host_ring_deinit(host_ring_t *r);
+// Also starts a new stream (clears finished).
+void host_ring_bind(host_ring_t *r, audio_ring_t *out);
@@ -0,0 +1,47 @@
+#include <time.h>
+#include "host_signal.h"
+
+static void signal_give(void *ctx) {
+    host_signal_t *s = ctx;
+    pthread_mutex_lock(&s->lock);
+    s->pending = true;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static bool signal_wait(void *ctx, uint32_t timeout_ms) {
+    host_signal_t *s = ctx;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&s->lock);
+    int rc = 0;
+    while (!s->pending && rc == 0) {
+        rc = timeout_ms == AUDIO_WAIT_FOREVER ? pthread_cond_wait(&s->cond, &s->lock)
+                                              : pthread_cond_timedwait(&s->cond, &s->lock, &deadline);
+    }
+    bool got = s->pending;
+    s->pending = false;
+    pthread_mutex_unlock(&s->lock);
+    return got;
+}
+
+void host_signal_init(host_signal_t *s) {
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->pending = false;
+}
+
+void host_signal_deinit(host_signal_t *s) {
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+}
+
+void host_signal_bind(host_signal_t *s, audio_signal_t *out) {
+    *out = (audio_signal_t) { .ctx = s, .signal = signal_give, .wait = signal_wait };
+}
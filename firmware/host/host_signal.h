@@ -0,0 +1,16 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "audio_io.h"
+
+// pthread stand-in for a FreeRTOS binary semaphore behind audio_signal_t
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool pending;
+} host_signal_t;
+
+void host_signal_init(host_signal_t *s);
+void host_signal_deinit(host_signal_t *s);
+void host_signal_bind(host_signal_t *s, audio_signal_t *out);
@@ -0,0 +1,27 @@
+#include <stdlib.h>
+#include "host_spsc.h"
+
+int host_spsc_init(host_spsc_t *s, size_t capacity) {
+    audio_signal_t readable, writable;
+    s->buf = malloc(capacity);
+    if (!s->buf) return -1;
+    host_signal_init(&s->readable);
+    host_signal_init(&s->writable);
+    host_signal_bind(&s->readable, &readable);
+    host_signal_bind(&s->writable, &writable);
+    int rc = audio_spsc_init(&s->ring, s->buf, capacity, &readable, &writable);
+    if (rc < 0) host_spsc_deinit(s);
+    return rc;
+}
+
+void host_spsc_deinit(host_spsc_t *s) {
+    if (!s->buf) return;
+    host_signal_deinit(&s->readable);
+    host_signal_deinit(&s->writable);
+    free(s->buf);
+    s->buf = NULL;
+}
+
+void host_spsc_bind(host_spsc_t *s, audio_ring_t *out) {
+    audio_spsc_bind(&s->ring, out);
+}
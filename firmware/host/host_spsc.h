@@ -0,0 +1,20 @@
+#pragma once
+
+#include "audio_spsc.h"
+#include "host_signal.h"
+
+// audio_spsc.h over heap storage with host_signal.h signals: the ring the
+// host harness runs the pipeline on (host_ring.h remains the FreeRTOS-style
+// baseline ring_bench compares it with)
+typedef struct {
+    audio_spsc_t ring;
+    host_signal_t readable;
+    host_signal_t writable;
+    uint8_t *buf;
+} host_spsc_t;
+
+// < 0 when out of memory or `capacity` is not a power of two
+int host_spsc_init(host_spsc_t *s, size_t capacity);
+void host_spsc_deinit(host_spsc_t *s);
+// Also starts a new stream (clears finished)
+void host_spsc_bind(host_spsc_t *s, audio_ring_t *out);
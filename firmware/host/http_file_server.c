@@ -0,0 +1,156 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "audio_port.h"
+#include "http_file_server.h"
+
+static void sleep_ms(uint32_t ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int send_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Read until the blank line that ends the request headers.
+static int read_request(int fd, char *buf, size_t cap) {
+    size_t len = 0;
+    while (len + 1 < cap) {
+        ssize_t n = recv(fd, buf + len, cap - 1 - len, 0);
+        if (n <= 0) return -1;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n")) return (int)len;
+    }
+    return -1;
+}
+
+// "Range: bytes=N-" -> N, or 0 without one
+static size_t range_start(const char *req) {
+    const char *r = strcasestr(req, "\r\nRange: bytes=");
+    return r ? strtoul(r + 15, NULL, 10) : 0;
+}
+
+static void serve(http_file_server_t *srv, int fd) {
+    char req[2048];
+    if (read_request(fd, req, sizeof(req)) < 0) return;
+
+    if (srv->latency_ms) sleep_ms(srv->latency_ms);
+
+    size_t from = range_start(req);
+    if (from) srv->range_requests++;
+    if (srv->ignore_range || from >= srv->body_len) from = 0;
+    char hdr[320];
+    int n;
+    if (from) {
+        n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 206 Partial Content\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Range: bytes %zu-%zu/%zu\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     srv->content_type ? srv->content_type : "audio/wav", from, srv->body_len - 1,
+                     srv->body_len, srv->body_len - from);
+    } else {
+        n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     srv->content_type ? srv->content_type : "audio/wav", srv->body_len);
+    }
+    if (send_all(fd, hdr, (size_t)n) < 0) return;
+
+    size_t chunk = srv->send_chunk ? srv->send_chunk : 1460;
+    int64_t t0 = audio_time_us();
+    size_t sent = from;
+    bool stalled = false;
+    while (sent < srv->body_len && !srv->stop) {
+        if (srv->stall_ms && !stalled && sent >= srv->body_len / 2) {
+            sleep_ms(srv->stall_ms);
+            t0 += (int64_t)srv->stall_ms * 1000;
+            stalled = true;
+        }
+        size_t len = srv->body_len - sent < chunk ? srv->body_len - sent : chunk;
+        if (srv->drop_at && !srv->drops && sent < srv->drop_at && sent + len >= srv->drop_at) {
+            // Cut the connection as a Wi-Fi drop or proxy reset would
+            send_all(fd, srv->body + sent, srv->drop_at - sent);
+            srv->drops++;
+            return;
+        }
+        if (send_all(fd, srv->body + sent, len) < 0) return;
+        sent += len;
+        if (srv->rate_bytes_per_s) {
+            // Pace against the start time so rounding does not accumulate
+            int64_t due = t0 + (int64_t)((double)(sent - from) * 1e6 / srv->rate_bytes_per_s);
+            int64_t now = audio_time_us();
+            if (due > now) {
+                struct timespec ts = { .tv_sec = (due - now) / 1000000, .tv_nsec = ((due - now) % 1000000) * 1000 };
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+}
+
+static void *server_thread(void *arg) {
+    http_file_server_t *srv = arg;
+    while (!srv->stop) {
+        int fd = accept(srv->listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        srv->requests++;
+        serve(srv, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+int http_file_server_start(http_file_server_t *srv) {
+    srv->stop = 0;
+    srv->requests = 0;
+    srv->range_requests = 0;
+    srv->drops = 0;
+    srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (srv->listen_fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(srv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        .sin_port = 0,
+    };
+    socklen_t addr_len = sizeof(addr);
+    if (bind(srv->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(srv->listen_fd, 4) < 0 ||
+        getsockname(srv->listen_fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(srv->listen_fd);
+        return -1;
+    }
+    srv->port = ntohs(addr.sin_port);
+    return pthread_create(&srv->thread, NULL, server_thread, srv) == 0 ? 0 : -1;
+}
+
+void http_file_server_stop(http_file_server_t *srv) {
+    srv->stop = 1;
+    // Unblock accept()
+    shutdown(srv->listen_fd, SHUT_RDWR);
+    close(srv->listen_fd);
+    pthread_join(srv->thread, NULL);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Loopback HTTP/1.1 server standing in for Firebase Storage. Serves one
+// in-memory object to any GET, throttled to a configurable rate so Wi-Fi
+// and TLS costs can be approximated on a workstation. Honours
+// "Range: bytes=N-" with a 206 like Storage does.
+typedef struct {
+    const uint8_t *body;
+    size_t body_len;
+    const char *content_type;
+    uint32_t rate_bytes_per_s;  // 0 = unthrottled
+    uint32_t latency_ms;        // delay before the response (handshake + RTT)
+    size_t send_chunk;          // bytes per send() burst
+    uint32_t stall_ms;          // one pause halfway through the body (a Wi-Fi stall)
+    size_t drop_at;             // close the connection once at this body offset, 0 = never
+    int ignore_range;           // answer Range requests with the whole body (200)
+
+    int listen_fd;
+    uint16_t port;
+    volatile int stop;
+    pthread_t thread;
+    uint32_t requests;
+    uint32_t range_requests;
+    uint32_t drops;
+} http_file_server_t;
+
+int http_file_server_start(http_file_server_t *srv);
+void http_file_server_stop(http_file_server_t *srv);
@@ -0,0 +1,181 @@
+// Inline clips over MQTT (audio_inline.h): chunks split into data events
+// reassemble byte for byte; a reader started before the last chunk streams
+// the clip as it lands; redelivered and stale chunks are ignored; a gap, an
+// early last flag and a stall fail the clip; a new clip replaces one not yet
+// claimed but never one being read; a clip with a digest is handed over only
+// once complete and matching. Exits non-zero on any failure.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_inline.h"
+#include "audio_port.h"
+#include "host_signal.h"
+
+#define CLIP_LEN 20000
+#define CHUNK    4096
+#define FRAGMENT 1000
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-30s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint8_t clip_body[CLIP_LEN];
+
+// Publishes chunk `seq` of clip `id` as esp-mqtt would deliver it
+static void send_chunk(audio_inline_t *a, uint32_t id, uint16_t seq, bool last_flag) {
+    static uint8_t msg[AUDIO_INLINE_HEADER_SIZE + CHUNK];
+    uint32_t off = (uint32_t)seq * CHUNK;
+    size_t n = CLIP_LEN - off < CHUNK ? CLIP_LEN - off : CHUNK;
+    audio_inline_header_t h = {
+        .flags = last_flag || off + n == CLIP_LEN ? AUDIO_INLINE_FLAG_LAST : 0,
+        .clip_id = id,
+        .offset = off,
+        .seq = seq,
+    };
+    audio_inline_write_header(&h, msg);
+    memcpy(msg + AUDIO_INLINE_HEADER_SIZE, clip_body + off, n);
+    size_t msg_len = AUDIO_INLINE_HEADER_SIZE + n;
+    for (size_t f = 0; f < msg_len; f += FRAGMENT) {
+        audio_inline_feed(a, msg + f, msg_len - f < FRAGMENT ? msg_len - f : FRAGMENT, f, msg_len);
+    }
+}
+
+#define CHUNKS ((CLIP_LEN + CHUNK - 1) / CHUNK)
+
+// Reads the whole clip through the claimed source; bytes read, -1 on error
+static int read_all(audio_source_t *src, uint8_t *out) {
+    int total = src->open(src->ctx, NULL);
+    int got = 0;
+    while (got < total) {
+        int n = src->read(src->ctx, out + got, 1500);
+        if (n < 0) {
+            src->close(src->ctx);
+            return -1;
+        }
+        if (n == 0) break;
+        got += n;
+    }
+    src->close(src->ctx);
+    return got;
+}
+
+typedef struct {
+    audio_inline_t *a;
+    uint32_t id;
+} feeder_t;
+
+static void *feeder_thread(void *arg) {
+    feeder_t *f = arg;
+    for (uint16_t seq = 0; seq < CHUNKS; seq++) {
+        audio_sleep_ms(10);
+        send_chunk(f->a, f->id, seq, false);
+    }
+    return NULL;
+}
+
+int main(void) {
+    for (int i = 0; i < CLIP_LEN; i++) clip_body[i] = (uint8_t)(i * 31 + (i >> 8));
+    static uint8_t buf[32768], out[CLIP_LEN];
+    host_signal_t hs;
+    audio_signal_t signal;
+    host_signal_init(&hs);
+    host_signal_bind(&hs, &signal);
+    audio_inline_t a;
+    audio_inline_init(&a, buf, sizeof(buf), &signal);
+    audio_source_t src;
+
+    audio_inline_header_t h = { .flags = AUDIO_INLINE_FLAG_LAST, .clip_id = 0xdeadbeef, .offset = 123456, .seq = 65535 };
+    uint8_t raw[AUDIO_INLINE_HEADER_SIZE];
+    audio_inline_write_header(&h, raw);
+    audio_inline_header_t back;
+    check("header round trip", audio_inline_parse_header(raw, sizeof(raw), &back) && back.flags == h.flags &&
+                                   back.clip_id == h.clip_id && back.offset == h.offset && back.seq == h.seq);
+    check("json is not a chunk", !audio_inline_is_chunk((const uint8_t *)"{\"file_url\":\"x\"}", 16));
+
+    // Whole clip in before the claim, split into fragments, with a redelivery
+    audio_inline_begin(&a, 1, CLIP_LEN, NULL);
+    for (uint16_t seq = 0; seq < CHUNKS; seq++) {
+        send_chunk(&a, 1, seq, false);
+        if (seq == 1) send_chunk(&a, 1, seq, false);
+    }
+    send_chunk(&a, 99, 0, false);
+    audio_inline_stats_t s = audio_inline_stats(&a);
+    check("complete before claim", a.state == AUDIO_INLINE_COMPLETE && s.chunks == CHUNKS);
+    check("duplicate and stale ignored", s.duplicates == 1 && s.stale == 1);
+    memset(out, 0, sizeof(out));
+    check("reassembled byte for byte", audio_inline_claim(&a, 1, &src) && read_all(&src, out) == CLIP_LEN &&
+                                           memcmp(out, clip_body, CLIP_LEN) == 0);
+    check("close frees the buffer", a.state == AUDIO_INLINE_IDLE && !audio_inline_claim(&a, 1, &src));
+
+    // Claimed before the first chunk: reads follow the feeder
+    audio_inline_begin(&a, 2, CLIP_LEN, NULL);
+    check("claim while receiving", audio_inline_claim(&a, 2, &src));
+    check("busy while being read", !audio_inline_begin(&a, 3, CLIP_LEN, NULL));
+    feeder_t f = { &a, 2 };
+    pthread_t feeder;
+    pthread_create(&feeder, NULL, feeder_thread, &f);
+    memset(out, 0, sizeof(out));
+    int got = read_all(&src, out);
+    pthread_join(feeder, NULL);
+    s = audio_inline_stats(&a);
+    check("streams while receiving", got == CLIP_LEN && memcmp(out, clip_body, CLIP_LEN) == 0);
+    check("first chunk before the last", s.t_first_chunk_us < s.t_complete_us);
+
+    // A missing chunk fails the clip and the reader sees a read error
+    audio_inline_begin(&a, 4, CLIP_LEN, NULL);
+    send_chunk(&a, 4, 0, false);
+    send_chunk(&a, 4, 2, false);
+    s = audio_inline_stats(&a);
+    check("gap fails the clip", a.state == AUDIO_INLINE_FAILED && s.gaps == 1);
+    check("failed clip not claimed", !audio_inline_claim(&a, 4, &src));
+
+    audio_inline_begin(&a, 5, CLIP_LEN, NULL);
+    send_chunk(&a, 5, 0, true);
+    check("early last flag fails", a.state == AUDIO_INLINE_FAILED);
+
+    check("too big refused", !audio_inline_begin(&a, 6, sizeof(buf) + 1, NULL));
+
+    // A new clip takes over one nobody claimed
+    audio_inline_begin(&a, 7, CLIP_LEN, NULL);
+    send_chunk(&a, 7, 0, false);
+    check("replace unclaimed", audio_inline_begin(&a, 8, CLIP_LEN, NULL) && !audio_inline_claim(&a, 7, &src));
+    send_chunk(&a, 7, 1, false);
+    check("old clip's chunks stale", audio_inline_stats(&a).stale == 1 && a.received == 0);
+
+    // The publisher goes quiet after two chunks: the read fails after the stall
+    check("claim replacement", audio_inline_claim(&a, 8, &src));
+    send_chunk(&a, 8, 0, false);
+    send_chunk(&a, 8, 1, false);
+    int64_t t0 = audio_time_us();
+    got = read_all(&src, out);
+    int64_t waited_ms = (audio_time_us() - t0) / 1000;
+    check("stall fails the read", got < 0 && waited_ms >= AUDIO_INLINE_STALL_MS - 100);
+
+    // With a digest the claim waits for the whole clip, then reads it at once
+    uint8_t digest[HMAC_SHA256_LEN];
+    sha256(clip_body, CLIP_LEN, digest);
+    audio_inline_begin(&a, 9, CLIP_LEN, digest);
+    f = (feeder_t) { &a, 9 };
+    pthread_create(&feeder, NULL, feeder_thread, &f);
+    bool claimed = audio_inline_claim(&a, 9, &src);
+    bool complete = a.state == AUDIO_INLINE_COMPLETE;
+    memset(out, 0, sizeof(out));
+    got = claimed ? read_all(&src, out) : -1;
+    pthread_join(feeder, NULL);
+    check("digest waits for the clip", claimed && complete && got == CLIP_LEN &&
+                                           memcmp(out, clip_body, CLIP_LEN) == 0);
+
+    digest[0] ^= 1;
+    audio_inline_begin(&a, 10, CLIP_LEN, digest);
+    for (uint16_t seq = 0; seq < CHUNKS; seq++) send_chunk(&a, 10, seq, false);
+    check("digest mismatch fails", a.state == AUDIO_INLINE_FAILED && !audio_inline_claim(&a, 10, &src));
+
+    host_signal_deinit(&hs);
+    if (failures) printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
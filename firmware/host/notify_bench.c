@@ -0,0 +1,122 @@
+// Decode cost of an MQTT notification: the allocation-free decoder
+// (notify_msg.h) against the cJSON DOM the firmware used before, on a
+// payload shaped like the functions' (a ~1 KB signed storage URL).
+//
+// Reports microseconds per message for each path, the HMAC-SHA256 check
+// on its own, and for cJSON the heap allocations and peak heap bytes per
+// message. The cJSON column is built when the host has libcjson (as the
+// ESP-IDF json component is); otherwise only the decoder is timed.
+// Usage: notify_bench [iterations]. Exits non-zero if the decoders disagree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_port.h"
+#include "hmac_sha256.h"
+#include "notify_msg.h"
+#if HAVE_CJSON
+#include <cjson/cJSON.h>
+#endif
+
+#define DEFAULT_ITERS 100000
+#define URL_MAX 1536
+
+static const char *KEY = "bench-secret";
+
+// Same steps as the MQTT handler: decode, then copy out the fields
+static bool decode_notify(const char *msg, size_t len, bool verify, char *url, char *name) {
+    notify_msg_t m;
+    if (notify_msg_parse(msg, len, &m) != NOTIFY_OK) return false;
+    if (verify && !notify_msg_verify(&m, msg, (const uint8_t *)KEY, strlen(KEY))) return false;
+    return notify_str_copy(url, URL_MAX, m.file_url) > 0 && notify_str_copy(name, 64, m.filename) >= 0 &&
+           m.chime == 2;
+}
+
+#if HAVE_CJSON
+static size_t allocs, live, peak;
+
+static void *count_malloc(size_t n) {
+    size_t *p = malloc(n + sizeof(size_t));
+    if (!p) return NULL;
+    *p = n;
+    allocs++;
+    live += n;
+    if (live > peak) peak = live;
+    return p + 1;
+}
+
+static void count_free(void *ptr) {
+    if (!ptr) return;
+    size_t *p = (size_t *)ptr - 1;
+    live -= *p;
+    free(p);
+}
+
+static bool decode_cjson(const char *msg, size_t len, char *url, char *name) {
+    cJSON *root = cJSON_ParseWithLength(msg, len);
+    if (!root) return false;
+    cJSON *url_item = cJSON_GetObjectItem(root, "file_url");
+    cJSON *name_item = cJSON_GetObjectItem(root, "filename");
+    cJSON *chime_item = cJSON_GetObjectItem(root, "chime");
+    bool ok = cJSON_IsString(url_item) && strlen(url_item->valuestring) < URL_MAX && cJSON_IsString(name_item) &&
+              cJSON_IsNumber(chime_item) && chime_item->valueint == 2;
+    if (ok) {
+        strcpy(url, url_item->valuestring);
+        snprintf(name, 64, "%s", name_item->valuestring);
+    }
+    cJSON_Delete(root);
+    return ok;
+}
+#endif
+
+int main(int argc, char **argv) {
+    long iters = argc > 1 ? atol(argv[1]) : DEFAULT_ITERS;
+
+    char body[2048], msg[2048];
+    int n = snprintf(body, sizeof(body), "{\"file_url\":\"https://storage.googleapis.com/remotealarm.appspot.com/"
+                     "audio/0b7e4c1a-5d2f-4e8b-9a61-3f0c2d7e8b41.wav?X-Goog-Algorithm=GOOG4-RSA-SHA256&"
+                     "X-Goog-Credential=firebase-adminsdk%%40remotealarm.iam.gserviceaccount.com%%2F20261018%%2F"
+                     "auto%%2Fstorage%%2Fgoog4_request&X-Goog-Date=20261018T160000Z&X-Goog-Expires=600&"
+                     "X-Goog-SignedHeaders=host&X-Goog-Signature=");
+    for (int i = 0; i < 512; i++) body[n++] = "0123456789abcdef"[(i * 7) % 16];
+    n += snprintf(body + n, sizeof(body) - n, "\",\"timestamp\":\"2026-10-18T16:00:00.000Z\","
+                  "\"filename\":\"0b7e4c1a-5d2f-4e8b-9a61-3f0c2d7e8b41.wav\",\"chime\":2,\"gap_ms\":2000}");
+    uint8_t mac[HMAC_SHA256_LEN];
+    hmac_sha256_t h;
+    hmac_sha256_start(&h, (const uint8_t *)KEY, strlen(KEY));
+    hmac_sha256_update(&h, body, (size_t)n);
+    hmac_sha256_finish(&h, mac);
+    memcpy(msg, body, (size_t)n - 1);
+    int len = n - 1 + sprintf(msg + n - 1, ",\"signature\":\"");
+    for (int i = 0; i < HMAC_SHA256_LEN; i++) len += sprintf(msg + len, "%02x", mac[i]);
+    len += sprintf(msg + len, "\"}");
+
+    static char url[URL_MAX], name[64];
+    bool ok = decode_notify(msg, (size_t)len, true, url, name);
+    printf("payload_bytes=%d url_bytes=%zu\n", len, strlen(url));
+
+    int64_t t0 = audio_time_us();
+    for (long i = 0; i < iters; i++) ok &= decode_notify(msg, (size_t)len, false, url, name);
+    double parse_us = (double)(audio_time_us() - t0) / iters;
+    t0 = audio_time_us();
+    for (long i = 0; i < iters; i++) ok &= decode_notify(msg, (size_t)len, true, url, name);
+    double verify_us = (double)(audio_time_us() - t0) / iters;
+    printf("notify_msg: %.3f us/msg, %.3f us/msg with HMAC, 0 allocations\n", parse_us, verify_us);
+
+#if HAVE_CJSON
+    static char url2[URL_MAX], name2[64];
+    cJSON_Hooks hooks = { .malloc_fn = count_malloc, .free_fn = count_free };
+    cJSON_InitHooks(&hooks);
+    ok &= decode_cjson(msg, (size_t)len, url2, name2) && strcmp(url, url2) == 0 && strcmp(name, name2) == 0;
+    size_t per_msg = allocs;
+    t0 = audio_time_us();
+    for (long i = 0; i < iters; i++) ok &= decode_cjson(msg, (size_t)len, url2, name2);
+    double cjson_us = (double)(audio_time_us() - t0) / iters;
+    printf("cjson:      %.3f us/msg, %zu allocations, %zu peak heap bytes per message\n", cjson_us, per_msg, peak);
+    printf("speedup=%.1fx\n", cjson_us / parse_us);
+#else
+    printf("cjson: not found on this host, comparison skipped\n");
+#endif
+    if (!ok) fprintf(stderr, "FAIL: decode mismatch\n");
+    return ok ? 0 : 1;
+}
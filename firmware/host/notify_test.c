@@ -0,0 +1,351 @@
+// MQTT notification decoder (notify_msg.h) and HMAC-SHA256 (hmac_sha256.h).
+//
+// Checks SHA-256 and HMAC against the FIPS 180 / RFC 4231 vectors, decodes
+// the documented payloads, escapes, unknown and mistyped members, and signed
+// messages as the functions produce them, and the refusal of stale and
+// replayed ones. Then fuzzes: random notifications
+// with random escapes must decode to exactly what was encoded, and mutated
+// copies (flipped, dropped, inserted bytes, truncation) are parsed from
+// exact-size heap buffers, so ASan catches any read past the payload. A
+// mutated message may only verify if its signed bytes are unchanged.
+// Usage: notify_test [fuzz iterations]. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hmac_sha256.h"
+#include "notify_msg.h"
+
+#define DEFAULT_ITERS 20000
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-30s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint32_t rng_state = 0x2545f491u;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void to_hex(const uint8_t *in, size_t n, char *out) {
+    for (size_t i = 0; i < n; i++) sprintf(out + 2 * i, "%02x", in[i]);
+}
+
+static bool digest_is(const uint8_t *d, const char *hex) {
+    char got[2 * HMAC_SHA256_LEN + 1];
+    to_hex(d, HMAC_SHA256_LEN, got);
+    return strcmp(got, hex) == 0;
+}
+
+static void hmac(const char *key, size_t key_len, const char *data, size_t len, uint8_t *out) {
+    hmac_sha256_t h;
+    hmac_sha256_start(&h, (const uint8_t *)key, key_len);
+    hmac_sha256_update(&h, data, len);
+    hmac_sha256_finish(&h, out);
+}
+
+// What the functions publish: sign the payload, then append the signature
+static size_t sign(const char *body, const char *key, char *out) {
+    uint8_t mac[HMAC_SHA256_LEN];
+    char hex[2 * HMAC_SHA256_LEN + 1];
+    size_t len = strlen(body);
+    hmac(key, strlen(key), body, len, mac);
+    to_hex(mac, sizeof(mac), hex);
+    memcpy(out, body, len - 1);
+    return (size_t)sprintf(out + len - 1, ",\"signature\":\"%s\"}", hex) + len - 1;
+}
+
+static bool parse(const char *json, notify_msg_t *m) {
+    return notify_msg_parse(json, strlen(json), m) == NOTIFY_OK;
+}
+
+static void test_vectors(void) {
+    uint8_t d[HMAC_SHA256_LEN];
+    sha256("abc", 3, d);
+    check("sha256 abc", digest_is(d, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    const char *two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256(two, strlen(two), d);
+    check("sha256 two blocks", digest_is(d, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+    // Split updates across block boundaries hash the same
+    hmac_sha256_t h;
+    uint8_t split[HMAC_SHA256_LEN];
+    hmac_sha256_start(&h, (const uint8_t *)"key", 3);
+    for (size_t i = 0; i < strlen(two); i += 7) {
+        hmac_sha256_update(&h, two + i, strlen(two) - i < 7 ? strlen(two) - i : 7);
+    }
+    hmac_sha256_finish(&h, split);
+    hmac("key", 3, two, strlen(two), d);
+    check("hmac split updates", memcmp(split, d, sizeof(d)) == 0);
+
+    // RFC 4231 test cases 1, 2 and 6 (key longer than a block)
+    char key1[20];
+    memset(key1, 0x0b, sizeof(key1));
+    hmac(key1, sizeof(key1), "Hi There", 8, d);
+    check("hmac rfc4231 #1", digest_is(d, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"));
+    hmac("Jefe", 4, "what do ya want for nothing?", 28, d);
+    check("hmac rfc4231 #2", digest_is(d, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+    char key6[131];
+    memset(key6, 0xaa, sizeof(key6));
+    const char *msg6 = "Test Using Larger Than Block-Size Key - Hash Key First";
+    hmac(key6, sizeof(key6), msg6, strlen(msg6), d);
+    check("hmac rfc4231 #6", digest_is(d, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"));
+}
+
+static void test_decode(void) {
+    notify_msg_t m;
+    char buf[256];
+    check("documented payload",
+          parse("{\"file_url\":\"https://storage.googleapis.com/b/audio/a.wav?X-Goog-Signature=ab\","
+                "\"timestamp\":\"2026-02-09T12:34:56.789Z\",\"filename\":\"a.wav\",\"content_type\":\"audio/wav\","
+                "\"chime\":2,\"gap_ms\":1500}", &m) &&
+          notify_str_copy(buf, sizeof(buf), m.file_url) > 0 &&
+          strcmp(buf, "https://storage.googleapis.com/b/audio/a.wav?X-Goog-Signature=ab") == 0 &&
+          notify_str_eq(m.filename, "a.wav") && m.chime == 2 && m.gap_ms == 1500 && !m.signed_len);
+
+    check("escapes", parse("{\"filename\":\"a\\\"b\\\\c\\/d\\n\\u00e9\\ud83d\\ude00\\ud800x\"}", &m) &&
+                     notify_str_copy(buf, sizeof(buf), m.filename) > 0 &&
+                     strcmp(buf, "a\"b\\c/d\n\xc3\xa9\xf0\x9f\x98\x80\xef\xbf\xbdx") == 0);
+    check("copy too long", parse("{\"filename\":\"abcdef\"}", &m) &&
+                           notify_str_copy(buf, 6, m.filename) == -1 && buf[0] == '\0' &&
+                           notify_str_copy(buf, 7, m.filename) == 6);
+    check("command", parse(" {\"cmd\" : \"lat\\u0065ncy\"}\n", &m) && notify_str_eq(m.cmd, "latency") &&
+                     !m.file_url.p);
+    check("unknown members skipped",
+          parse("{\"v\":2,\"meta\":{\"a\":[1,2.5e3,{\"b\":null}],\"c\":true},\"file_url\":\"u\",\"x\":-0.5}", &m) &&
+          notify_str_eq(m.file_url, "u"));
+    check("mistyped members absent",
+          parse("{\"file_url\":5,\"filename\":[\"a\"],\"chime\":\"2\",\"gap_ms\":1.5}", &m) && !m.file_url.p &&
+          !m.filename.p && m.chime == -1 && m.gap_ms == -1);
+    check("out of range integer", parse("{\"chime\":99999999999}", &m) && m.chime == -1);
+    check("64-bit play_at", parse("{\"play_at\":1792310400123}", &m) && m.play_at == 1792310400123LL);
+    check("play_at absent or too long", parse("{\"chime\":1}", &m) && m.play_at == -1 &&
+                                            parse("{\"play_at\":12345678901234567890}", &m) && m.play_at == -1);
+    check("priority", parse("{\"priority\":2}", &m) && m.priority == 2 && parse("{}", &m) && m.priority == -1);
+    uint8_t digest[2];
+    check("inline_sha256 hex", parse("{\"inline_sha256\":\"a0Ff\"}", &m) &&
+                               notify_str_hex(m.inline_sha256, digest, 2) && digest[0] == 0xa0 &&
+                               digest[1] == 0xff && !notify_str_hex(m.inline_sha256, digest, 1) &&
+                               parse("{\"inline_sha256\":\"a0fg\"}", &m) &&
+                               !notify_str_hex(m.inline_sha256, digest, 2));
+    check("trailing NUL accepted", notify_msg_parse("{\"cmd\":\"x\"}", 12, &m) == NOTIFY_OK);
+    check("empty object", parse("{}", &m) && !m.file_url.p);
+
+    static const char *bad[] = {
+        "", "[]", "{", "{\"a\":}", "{\"a\" 1}", "{\"a\":1,}", "{,}", "{\"a\":01}", "{\"a\":1.}", "{\"a\":tru}",
+        "{\"a\":\"\\x\"}", "{\"a\":\"\\u12g4\"}", "{\"a\":\"\x01\"}", "{\"a\":1}x", "{\"a\":1}{}", "{'a':1}",
+        "{\"a\":[1,]}", "{\"a\":-}", "{\"a\":1e}", "{\"a\":\"abc}",
+    };
+    bool all_rejected = true;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (parse(bad[i], &m)) {
+            printf("  accepted: %s\n", bad[i]);
+            all_rejected = false;
+        }
+    }
+    check("malformed rejected", all_rejected);
+    check("depth limit", notify_msg_parse("{\"a\":[[[[[[[[1]]]]]]]]}", 23, &m) == NOTIFY_ERR_DEPTH &&
+                         parse("{\"a\":[[[[[[1]]]]]]}", &m));
+}
+
+static void test_replay(void) {
+    static notify_replay_t r;
+    notify_msg_t m;
+    const int64_t now = 1792310400000LL, age = 120000;
+    notify_replay_init(&r);
+    check("stamped accepted", parse("{\"sent_at\":1792310399000,\"nonce\":77}", &m) && m.nonce == 77 &&
+                              notify_replay_check(&r, &m, now, age) == NOTIFY_FRESH);
+    check("nonce replayed", notify_replay_check(&r, &m, now, age) == NOTIFY_REPLAYED &&
+                            notify_replay_check(&r, &m, -1, age) == NOTIFY_REPLAYED);
+    check("unstamped refused", parse("{\"cmd\":\"stats\"}", &m) &&
+                               notify_replay_check(&r, &m, now, age) == NOTIFY_UNSTAMPED &&
+                               parse("{\"sent_at\":1792310400000,\"nonce\":0}", &m) &&
+                               notify_replay_check(&r, &m, now, age) == NOTIFY_UNSTAMPED);
+    check("stale refused", parse("{\"sent_at\":1792310279999,\"nonce\":5}", &m) &&
+                           notify_replay_check(&r, &m, now, age) == NOTIFY_STALE &&
+                           parse("{\"sent_at\":1792310520001,\"nonce\":5}", &m) &&
+                           notify_replay_check(&r, &m, now, age) == NOTIFY_STALE);
+    check("no clock: nonce only", notify_replay_check(&r, &m, -1, age) == NOTIFY_FRESH);
+
+    // Once a nonce is pushed out of the ring, nothing as old gets back in
+    notify_replay_init(&r);
+    m.sent_at = now - 1000;
+    m.nonce = 1;
+    notify_replay_check(&r, &m, now, age);
+    for (int i = 0; i < NOTIFY_REPLAY_SLOTS; i++) {
+        m.sent_at = now + i;
+        m.nonce = 100 + i;
+        notify_replay_check(&r, &m, now, age);
+    }
+    m.sent_at = now - 1000;
+    m.nonce = 1;
+    bool forgotten = notify_replay_check(&r, &m, now, age) == NOTIFY_REPLAYED;
+    m.sent_at = now + NOTIFY_REPLAY_SLOTS;
+    m.nonce = 2;
+    check("evicted stays refused", forgotten && notify_replay_check(&r, &m, now, age) == NOTIFY_FRESH);
+}
+
+static void test_signature(void) {
+    notify_msg_t m;
+    char msg[512];
+    const char *key = "shared-secret";
+    const char *body = "{\"file_url\":\"https://s/a.wav?sig=1\",\"timestamp\":\"2026-10-18T16:00:00Z\","
+                       "\"filename\":\"a.wav\",\"chime\":1}";
+    size_t len = sign(body, key, msg);
+    check("signed verifies", notify_msg_parse(msg, len, &m) == NOTIFY_OK && m.signed_len == strlen(body) - 1 &&
+                             notify_msg_verify(&m, msg, (const uint8_t *)key, strlen(key)));
+    check("wrong key rejected", !notify_msg_verify(&m, msg, (const uint8_t *)"other", 5));
+    msg[20] ^= 1;
+    check("tampered rejected", notify_msg_parse(msg, len, &m) == NOTIFY_OK &&
+                               !notify_msg_verify(&m, msg, (const uint8_t *)key, strlen(key)));
+    check("unsigned rejected", parse(body, &m) && !notify_msg_verify(&m, body, (const uint8_t *)key, strlen(key)));
+    check("signature not last", notify_msg_parse("{\"a\":1,\"signature\":\"00\",\"b\":2}", 30, &m) ==
+                                NOTIFY_ERR_SIGNATURE);
+    check("signature alone", parse("{\"signature\":\"00\"}", &m) == false);
+    check("short signature", parse("{\"a\":1,\"signature\":\"abcd\"}", &m) &&
+                             !notify_msg_verify(&m, "{\"a\":1,\"signature\":\"abcd\"}", (const uint8_t *)key, 13));
+}
+
+// ---- fuzzing ----
+
+static const char *const URL_CHARS = "abcXYZ0189-._~:/?#[]@!$&'()*+,;=%";
+
+// A random string value, JSON-encoded into `enc`, raw (UTF-8) into `raw`
+static void random_string(char *enc, size_t *enc_len, char *raw, size_t *raw_len, size_t max) {
+    size_t n = rng() % max, e = 0, r = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t kind = rng() % 16;
+        if (kind < 10) {
+            char ch = URL_CHARS[rng() % strlen(URL_CHARS)];
+            enc[e++] = raw[r++] = ch;
+        } else if (kind < 12) {
+            static const char esc[] = "\"\\/\b\f\n\r\t";
+            static const char code[] = "\"\\/bfnrt";
+            int k = (int)(rng() % 8);
+            enc[e++] = '\\';
+            enc[e++] = code[k];
+            raw[r++] = esc[k];
+        } else if (kind < 14) {
+            uint32_t cp = 0x20 + rng() % 0xd000;    // BMP, below the surrogates
+            e += (size_t)sprintf(enc + e, "\\u%04X", (unsigned)cp);
+            if (cp < 0x80) {
+                raw[r++] = (char)cp;
+            } else if (cp < 0x800) {
+                raw[r++] = (char)(0xc0 | cp >> 6);
+                raw[r++] = (char)(0x80 | (cp & 0x3f));
+            } else {
+                raw[r++] = (char)(0xe0 | cp >> 12);
+                raw[r++] = (char)(0x80 | ((cp >> 6) & 0x3f));
+                raw[r++] = (char)(0x80 | (cp & 0x3f));
+            }
+        } else {
+            uint32_t cp = 0x10000 + rng() % 0x100000;
+            e += (size_t)sprintf(enc + e, "\\u%04x\\u%04x", (unsigned)(0xd800 + ((cp - 0x10000) >> 10)),
+                                 (unsigned)(0xdc00 + ((cp - 0x10000) & 0x3ff)));
+            raw[r++] = (char)(0xf0 | cp >> 18);
+            raw[r++] = (char)(0x80 | ((cp >> 12) & 0x3f));
+            raw[r++] = (char)(0x80 | ((cp >> 6) & 0x3f));
+            raw[r++] = (char)(0x80 | (cp & 0x3f));
+        }
+    }
+    enc[e] = raw[r] = '\0';
+    *enc_len = e;
+    *raw_len = r;
+}
+
+typedef struct {
+    char url[1024], filename[256];
+    size_t url_len, filename_len;
+    int32_t chime;
+} fuzz_fields_t;
+
+// A notification in the functions' shape, with random extra members
+static size_t random_message(char *out, fuzz_fields_t *f) {
+    char url[4096], name[1024];
+    size_t url_len, name_len;
+    random_string(url, &url_len, f->url, &f->url_len, 200);
+    random_string(name, &name_len, f->filename, &f->filename_len, 40);
+    f->chime = (int32_t)(rng() % 4);
+    size_t n = (size_t)sprintf(out, "{\"file_url\":\"%s\"", url);
+    if (rng() % 2) n += (size_t)sprintf(out + n, ",\"extra\":{\"list\":[1,-2.5e-3,true,null,\"s\"]}");
+    n += (size_t)sprintf(out + n, ",\"filename\":\"%s\",\"chime\":%d,\"gap_ms\":%u}", name, (int)f->chime,
+                         (unsigned)(rng() % 10000));
+    return n;
+}
+
+static void fuzz(long iters) {
+    static const char *key = "fuzz-key";
+    static char body[8192], msg[8192], copy[2048];
+    long roundtrip_fail = 0, bad_accept = 0, parsed = 0;
+    for (long it = 0; it < iters; it++) {
+        fuzz_fields_t f;
+        random_message(body, &f);
+        size_t len = sign(body, key, msg);
+
+        notify_msg_t m;
+        if (notify_msg_parse(msg, len, &m) != NOTIFY_OK || !notify_msg_verify(&m, msg, (const uint8_t *)key, 8) ||
+            notify_str_copy(copy, sizeof(copy), m.file_url) != (int)f.url_len ||
+            memcmp(copy, f.url, f.url_len) != 0 ||
+            notify_str_copy(copy, sizeof(copy), m.filename) != (int)f.filename_len ||
+            memcmp(copy, f.filename, f.filename_len) != 0 || m.chime != f.chime) {
+            if (roundtrip_fail++ == 0) printf("  round trip failed: %s\n", msg);
+        }
+
+        // Mutate a copy and parse it from an exact-size allocation
+        size_t mlen = len;
+        char *mut = malloc(len + 8);
+        memcpy(mut, msg, len);
+        int edits = 1 + (int)(rng() % 4);
+        for (int e = 0; e < edits && mlen > 0; e++) {
+            size_t at = rng() % mlen;
+            switch (rng() % 5) {
+                case 0: mut[at] ^= (char)(1u << (rng() % 8)); break;
+                case 1: memmove(mut + at, mut + at + 1, mlen - at - 1); mlen--; break;
+                case 2:
+                    memmove(mut + at + 1, mut + at, mlen - at);
+                    mut[at] = "{}[]\",:\\0u-e. "[rng() % 15];
+                    mlen++;
+                    break;
+                case 3: mlen = at; break;
+                default: mut[at] = (char)rng(); break;
+            }
+        }
+        char *exact = malloc(mlen ? mlen : 1);
+        memcpy(exact, mut, mlen);
+        free(mut);
+        if (notify_msg_parse(exact, mlen, &m) == NOTIFY_OK) {
+            parsed++;
+            notify_str_t *strs[] = { &m.file_url, &m.filename, &m.timestamp, &m.cmd, &m.signature };
+            for (size_t i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+                if (strs[i]->p && (strs[i]->p < exact || strs[i]->p + strs[i]->len > exact + mlen)) bad_accept++;
+                notify_str_copy(copy, sizeof(copy), *strs[i]);
+                notify_str_eq(*strs[i], "latency");
+            }
+            if (notify_msg_verify(&m, exact, (const uint8_t *)key, 8) &&
+                (m.signed_len != strlen(body) - 1 || memcmp(exact, msg, m.signed_len) != 0)) {
+                bad_accept++;
+            }
+        }
+        free(exact);
+    }
+    printf("fuzz: %ld messages, %ld mutants parsed\n", iters, parsed);
+    check("fuzz round trip", roundtrip_fail == 0);
+    check("fuzz mutants contained", bad_accept == 0);
+}
+
+int main(int argc, char **argv) {
+    long iters = argc > 1 ? atol(argv[1]) : DEFAULT_ITERS;
+    test_vectors();
+    test_decode();
+    test_signature();
+    test_replay();
+    fuzz(iters);
+    return failures ? 1 : 0;
+}
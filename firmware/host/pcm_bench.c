@@ -0,0 +1,113 @@
+// Microbenchmark and equivalence check for the PCM conversion kernels.
+//
+// For each kernel, runs the scalar reference and the optimized entry point
+// (auto-vectorized on the host) over the same random input, verifies the
+// outputs are bit-identical and reports throughput in samples/us.
+// Exits non-zero on any mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_port.h"
+#include "pcm_convert.h"
+
+#define BLOCK_FRAMES 2048   // one 4 KB chunk of stereo int16
+#define DEFAULT_ITERS 20000
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void fill_random(void *buf, size_t bytes) {
+    uint8_t *p = buf;
+    for (size_t i = 0; i < bytes; i++) p[i] = (uint8_t)rng();
+}
+
+static int failures = 0;
+
+static void report(const char *name, int64_t ref_us, int64_t opt_us, size_t samples, int ok) {
+    double ref_rate = ref_us > 0 ? (double)samples / ref_us : 0;
+    double opt_rate = opt_us > 0 ? (double)samples / opt_us : 0;
+    printf("%-22s ref=%8.1f  opt=%8.1f samples/us  speedup=%.2fx  %s\n",
+           name, ref_rate, opt_rate, opt_rate > 0 && ref_rate > 0 ? opt_rate / ref_rate : 0.0,
+           ok ? "match" : "MISMATCH");
+    if (!ok) failures++;
+}
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERS;
+    size_t frames = BLOCK_FRAMES;
+
+    int16_t *s16_in = audio_alloc_aligned(frames * 2 * sizeof(int16_t));
+    int32_t *s32_in = audio_alloc_aligned(frames * 2 * sizeof(int32_t));
+    int16_t *out16_a = audio_alloc_aligned(frames * 2 * sizeof(int16_t));
+    int16_t *out16_b = audio_alloc_aligned(frames * 2 * sizeof(int16_t));
+    int32_t *out32_a = audio_alloc_aligned(frames * 2 * sizeof(int32_t));
+    int32_t *out32_b = audio_alloc_aligned(frames * 2 * sizeof(int32_t));
+    if (!s16_in || !s32_in || !out16_a || !out16_b || !out32_a || !out32_b) return 1;
+    fill_random(s16_in, frames * 2 * sizeof(int16_t));
+    fill_random(s32_in, frames * 2 * sizeof(int32_t));
+    // Make sure the extremes are covered
+    s16_in[0] = INT16_MIN; s16_in[1] = INT16_MIN; s16_in[2] = INT16_MAX; s16_in[3] = INT16_MAX;
+    s32_in[0] = INT32_MIN; s32_in[1] = INT32_MIN; s32_in[2] = INT32_MAX; s32_in[3] = INT32_MAX;
+
+    int64_t t0, ref_us, opt_us;
+
+#define BENCH(call, dst_us) \
+    do { t0 = audio_time_us(); for (int it = 0; it < iters; it++) { call; } dst_us = audio_time_us() - t0; } while (0)
+
+    BENCH(pcm_downmix_s16_ref(out16_a, s16_in, frames), ref_us);
+    BENCH(pcm_downmix_s16(out16_b, s16_in, frames), opt_us);
+    report("downmix_s16", ref_us, opt_us, frames * (size_t)iters,
+           memcmp(out16_a, out16_b, frames * sizeof(int16_t)) == 0);
+
+    BENCH(pcm_downmix_s32_ref(out32_a, s32_in, frames), ref_us);
+    BENCH(pcm_downmix_s32(out32_b, s32_in, frames), opt_us);
+    report("downmix_s32", ref_us, opt_us, frames * (size_t)iters,
+           memcmp(out32_a, out32_b, frames * sizeof(int32_t)) == 0);
+
+    BENCH(pcm_narrow_s32_to_s16_ref(out16_a, s32_in, frames * 2), ref_us);
+    BENCH(pcm_narrow_s32_to_s16(out16_b, s32_in, frames * 2), opt_us);
+    report("narrow_s32_to_s16", ref_us, opt_us, frames * 2 * (size_t)iters,
+           memcmp(out16_a, out16_b, frames * 2 * sizeof(int16_t)) == 0);
+
+    static const int32_t gains[] = { PCM_GAIN_UNITY / 2, PCM_GAIN_UNITY, PCM_GAIN_UNITY * 2, PCM_GAIN_MAX };
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        char name[32];
+        snprintf(name, sizeof(name), "gain_s16 (x%.2f)", (double)gains[g] / PCM_GAIN_UNITY);
+        // Gain is in place: re-seed the working buffer each iteration
+        BENCH((memcpy(out16_a, s16_in, frames * 2 * sizeof(int16_t)),
+               pcm_gain_s16_ref(out16_a, frames * 2, gains[g])), ref_us);
+        BENCH((memcpy(out16_b, s16_in, frames * 2 * sizeof(int16_t)),
+               pcm_gain_s16(out16_b, frames * 2, gains[g])), opt_us);
+        report(name, ref_us, opt_us, frames * 2 * (size_t)iters,
+               memcmp(out16_a, out16_b, frames * 2 * sizeof(int16_t)) == 0);
+    }
+
+    // Limiter ramp: gain moves every 8 samples, falling then rising
+    static const int32_t ramps[][2] = { { PCM_GAIN_UNITY * 4, PCM_GAIN_UNITY / 2 }, { 0, PCM_GAIN_MAX } };
+    for (size_t r = 0; r < sizeof(ramps) / sizeof(ramps[0]); r++) {
+        char name[32];
+        snprintf(name, sizeof(name), "gain_ramp_s16 (%s)", ramps[r][0] > ramps[r][1] ? "down" : "up");
+        BENCH((memcpy(out16_a, s16_in, frames * 2 * sizeof(int16_t)),
+               pcm_gain_ramp_s16_ref(out16_a, frames * 2, ramps[r][0], ramps[r][1])), ref_us);
+        BENCH((memcpy(out16_b, s16_in, frames * 2 * sizeof(int16_t)),
+               pcm_gain_ramp_s16(out16_b, frames * 2, ramps[r][0], ramps[r][1])), opt_us);
+        report(name, ref_us, opt_us, frames * 2 * (size_t)iters,
+               memcmp(out16_a, out16_b, frames * 2 * sizeof(int16_t)) == 0);
+    }
+
+    // In-place downmix (zero-copy path) must match out-of-place
+    memcpy(out16_a, s16_in, frames * 2 * sizeof(int16_t));
+    pcm_downmix_s16(out16_a, out16_a, frames);
+    pcm_downmix_s16_ref(out16_b, s16_in, frames);
+    report("downmix_s16 in place", 1, 1, 1, memcmp(out16_a, out16_b, frames * sizeof(int16_t)) == 0);
+
+    free(s16_in); free(s32_in); free(out16_a); free(out16_b); free(out32_a); free(out32_b);
+    return failures ? 1 : 0;
+}
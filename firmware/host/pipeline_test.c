@@ -0,0 +1,158 @@
+// Download path of the pipeline (audio_pipeline.h) against an in-memory
+// body: chunks after the data chunk (LIST, id3) never reach the ring in the
+// copying, zero-copy and ADPCM paths; a placeholder data size reads to the
+// end of the body; a ring that refuses a block fails the download instead
+// of dropping audio; and a body prefetched without a Content-Length plays
+// in full. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_prefetch.h"
+#include "host_spsc.h"
+#include "test_wav.h"
+
+#define RING_SIZE (128 * 1024)
+#define TRAILER_LEN 1000
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool chunked;               // no Content-Length: open() reports 0
+} mem_source_t;
+
+static int mem_open(void *ctx, const char *url) {
+    mem_source_t *m = ctx;
+    m->pos = 0;
+    return m->chunked ? 0 : (int)m->len;
+}
+
+static int mem_read(void *ctx, uint8_t *buf, int len) {
+    mem_source_t *m = ctx;
+    size_t n = m->len - m->pos < (size_t)len ? m->len - m->pos : (size_t)len;
+    memcpy(buf, m->data + m->pos, n);
+    m->pos += n;
+    return (int)n;
+}
+
+static void mem_close(void *ctx) {
+}
+
+// No writer: the ring holds the whole clip and is drained afterwards
+static bool no_writer(audio_pipeline_t *p) {
+    return true;
+}
+
+static bool refuse_send(void *ctx, const void *data, size_t len, uint32_t timeout_ms) {
+    return false;
+}
+
+// `wav` with a LIST chunk of 0x7f bytes after the data chunk
+static uint8_t *with_trailer(const uint8_t *wav, size_t len, size_t *out_len) {
+    uint8_t *out = malloc(len + 8 + TRAILER_LEN);
+    memcpy(out, wav, len);
+    memcpy(out + len, "LIST", 4);
+    uint32_t n = TRAILER_LEN;
+    memcpy(out + len + 4, &n, 4);
+    memset(out + len + 8, 0x7f, TRAILER_LEN);
+    *out_len = len + 8 + TRAILER_LEN;
+    return out;
+}
+
+static host_spsc_t spsc;
+
+// Plays `wav` into the ring, through a prefetch of `prefetch_len` bytes when
+// not 0; the PCM bytes it held, or -1 on a failed download
+static long run_source(const uint8_t *wav, size_t len, bool chunked, size_t prefetch_len, bool zero_copy,
+                       bool refuse, size_t *consumed) {
+    static audio_pipeline_t p;
+    static audio_prefetch_t pf;
+    static uint8_t pf_buf[8192];
+    mem_source_t m = { wav, len, 0, chunked };
+    memset(&p, 0, sizeof(p));
+    p.source = (audio_source_t) { .ctx = &m, .open = mem_open, .read = mem_read, .close = mem_close };
+    if (prefetch_len) {
+        audio_prefetch_init(&pf, pf_buf, prefetch_len < sizeof(pf_buf) ? prefetch_len : sizeof(pf_buf));
+        if (audio_prefetch_start(&pf, &p.source, "mem") < 0) return -1;
+        while (audio_prefetch_fill(&pf) > 0) {
+        }
+        audio_prefetch_bind(&pf, &p.source);
+    }
+    host_spsc_bind(&spsc, &p.ring);
+    if (refuse) p.ring.send = refuse_send;
+    p.start_playback = no_writer;
+    p.start_threshold = RING_SIZE;
+    p.zero_copy = zero_copy;
+    if (audio_pipeline_open(&p, "mem") != AUDIO_OK || audio_pipeline_init(&p) != AUDIO_OK) return -1;
+    int ret = audio_pipeline_download(&p);
+    long total = 0;
+    size_t n;
+    void *item;
+    while ((item = p.ring.receive(p.ring.ctx, &n, 0)) != NULL) {
+        total += (long)n;
+        p.ring.return_item(p.ring.ctx, item);
+    }
+    audio_pipeline_deinit(&p);
+    *consumed = m.pos;
+    return ret == AUDIO_OK ? total : -1;
+}
+
+static long run(const uint8_t *wav, size_t len, bool zero_copy, bool refuse, size_t *consumed) {
+    return run_source(wav, len, false, 0, zero_copy, refuse, consumed);
+}
+
+int main(void) {
+    if (host_spsc_init(&spsc, RING_SIZE) < 0) return 1;
+    size_t mono_len, stereo_len, adpcm_len, len, consumed;
+    uint8_t *mono = test_wav_generate(16000, 1, 16, 1.0f, &mono_len);
+    uint8_t *stereo = test_wav_generate(16000, 2, 16, 1.0f, &stereo_len);
+    uint8_t *adpcm = test_wav_generate_adpcm(16000, 1, 1.0f, 256, &adpcm_len);
+    long pcm_bytes = (long)(mono_len - 44);
+
+    uint8_t *w = with_trailer(mono, mono_len, &len);
+    check("copy_stops_at_data_end", run(w, len, false, false, &consumed) == pcm_bytes && consumed == mono_len);
+    check("zero_copy_stops_at_data", run(w, len, true, false, &consumed) == pcm_bytes && consumed == mono_len);
+    free(w);
+
+    // Stereo is downmixed: half the data chunk reaches the ring
+    w = with_trailer(stereo, stereo_len, &len);
+    check("stereo_copy_trailer", run(w, len, false, false, &consumed) == (long)(stereo_len - 44) / 2);
+    check("stereo_zero_copy_trailer", run(w, len, true, false, &consumed) == (long)(stereo_len - 44) / 2);
+    free(w);
+
+    w = with_trailer(adpcm, adpcm_len, &len);
+    long adpcm_pcm = run(adpcm, adpcm_len, false, false, &consumed);
+    check("adpcm_stops_at_data_end", adpcm_pcm > 0 && run(w, len, false, false, &consumed) == adpcm_pcm &&
+                                     consumed == adpcm_len);
+    free(w);
+
+    // A streamed WAV with no size yet: the whole body is audio
+    memset(mono + 40, 0, 4);
+    check("placeholder_reads_body", run(mono, mono_len, false, false, &consumed) == pcm_bytes &&
+                                    consumed == mono_len);
+
+    // Chunked: the length is unknown, not zero; the buffer holds part or all of it
+    check("prefetch_no_length", run_source(mono, mono_len, true, 4096, false, false, &consumed) == pcm_bytes &&
+                                consumed == mono_len);
+    size_t short_len;
+    uint8_t *short_wav = test_wav_generate(16000, 1, 16, 0.1f, &short_len);
+    check("prefetch_no_length_whole", run_source(short_wav, short_len, true, 8192, true, false, &consumed) ==
+                                      (long)(short_len - 44));
+    free(short_wav);
+    check("refused_send_fails", run(mono, mono_len, false, true, &consumed) == -1 && consumed < mono_len);
+
+    free(mono);
+    free(stereo);
+    free(adpcm);
+    host_spsc_deinit(&spsc);
+    return failures ? 1 : 0;
+}
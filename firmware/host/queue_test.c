@@ -0,0 +1,200 @@
+// Playback queue policies: FIFO rejecting at capacity, drop-oldest,
+// coalescing by filename, priority order and displacement, depth metrics,
+// and concurrent producers against one consumer losing or duplicating
+// nothing. Exits non-zero on any failure.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "audio_queue.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static audio_msg_t msg(const char *filename, const char *url) {
+    audio_msg_t m = { 0 };
+    snprintf(m.url, sizeof(m.url), "%s", url);
+    snprintf(m.filename, sizeof(m.filename), "%s", filename);
+    return m;
+}
+
+// Filenames popped in order, joined: "a,b,c"
+static void drain(audio_queue_t *q, char *out, size_t len) {
+    audio_msg_t m;
+    out[0] = '\0';
+    while (audio_queue_pop(q, &m)) {
+        if (out[0]) strncat(out, ",", len - strlen(out) - 1);
+        strncat(out, m.filename, len - strlen(out) - 1);
+    }
+}
+
+static audio_msg_t slots[3];
+
+static void push_all(audio_queue_t *q, const char *names, audio_queue_result_t *last) {
+    char name[2] = { 0 };
+    for (const char *c = names; *c; c++) {
+        name[0] = *c;
+        audio_msg_t m = msg(name, "https://storage/x");
+        *last = audio_queue_push(q, &m);
+    }
+}
+
+static audio_queue_result_t push_prio(audio_queue_t *q, const char *name, uint8_t priority) {
+    audio_msg_t m = msg(name, "https://storage/x");
+    m.priority = priority;
+    return audio_queue_push(q, &m);
+}
+
+#define PRODUCERS 4
+#define PER_PRODUCER 2000
+#define SHARED_SLOTS 16
+
+static audio_queue_t shared;
+static audio_msg_t shared_slots[SHARED_SLOTS];
+
+static void *producer(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (int i = 0; i < PER_PRODUCER; i++) {
+        audio_msg_t m = { 0 };
+        snprintf(m.url, sizeof(m.url), "u");
+        snprintf(m.filename, sizeof(m.filename), "%d:%d", id, i);
+        // Each producer has at most one push in flight, so this never overflows
+        while (audio_queue_stats(&shared).depth > SHARED_SLOTS - PRODUCERS) {
+            sched_yield();
+        }
+        if (audio_queue_push(&shared, &m) != AUDIO_QUEUE_QUEUED) break;
+    }
+    return NULL;
+}
+
+int main(void) {
+    audio_queue_t q;
+    audio_queue_result_t r;
+    char order[64];
+
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_FIFO);
+    push_all(&q, "abcd", &r);
+    drain(&q, order, sizeof(order));
+    check("fifo_rejects_new", r == AUDIO_QUEUE_REJECTED && strcmp(order, "a,b,c") == 0);
+    audio_queue_stats_t st = audio_queue_stats(&q);
+    check("fifo_stats", st.enqueued == 3 && st.dropped == 1 && st.max_depth == 3 && st.depth == 0 &&
+                        st.dequeued == 3);
+
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_DROP_OLDEST);
+    push_all(&q, "abcde", &r);
+    drain(&q, order, sizeof(order));
+    check("drop_oldest", r == AUDIO_QUEUE_DISPLACED && strcmp(order, "c,d,e") == 0 &&
+                         audio_queue_stats(&q).dropped == 2);
+
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_COALESCE);
+    push_all(&q, "aba", &r);
+    audio_msg_t newer = msg("b", "https://storage/b?fresh");
+    audio_queue_result_t rb = audio_queue_push(&q, &newer);
+    audio_msg_t m;
+    audio_queue_pop(&q, &m);
+    audio_msg_t second;
+    audio_queue_pop(&q, &second);
+    check("coalesce_in_place", r == AUDIO_QUEUE_COALESCED && rb == AUDIO_QUEUE_COALESCED &&
+                               strcmp(m.filename, "a") == 0 && strcmp(second.url, "https://storage/b?fresh") == 0 &&
+                               !audio_queue_pop(&q, &m));
+    st = audio_queue_stats(&q);
+    check("coalesce_stats", st.coalesced == 2 && st.enqueued == 2 && st.max_depth == 2);
+
+    // Unnamed messages are never coalesced
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_COALESCE);
+    audio_msg_t anon = msg("", "https://storage/anon");
+    audio_queue_push(&q, &anon);
+    audio_queue_push(&q, &anon);
+    check("anonymous_not_coalesced", audio_queue_stats(&q).depth == 2);
+    audio_msg_t empty = msg("z", "");
+    check("empty_url_rejected", audio_queue_push(&q, &empty) == AUDIO_QUEUE_REJECTED);
+
+    // Urgent first, oldest first among equals
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_DROP_OLDEST);
+    push_prio(&q, "a", 0);
+    push_prio(&q, "b", 2);
+    push_prio(&q, "c", 1);
+    drain(&q, order, sizeof(order));
+    check("priority_order", strcmp(order, "b,c,a") == 0);
+    push_prio(&q, "a", 1);
+    push_prio(&q, "b", 1);
+    push_prio(&q, "c", 0);
+    r = push_prio(&q, "d", 1);
+    drain(&q, order, sizeof(order));
+    check("priority_fifo_among_equals", r == AUDIO_QUEUE_DISPLACED && strcmp(order, "a,b,d") == 0);
+
+    // A full queue gives up its oldest lowest message, never one that outranks the new one
+    push_prio(&q, "a", 2);
+    push_prio(&q, "b", 1);
+    push_prio(&q, "c", 1);
+    r = push_prio(&q, "d", 0);
+    audio_queue_result_t r2 = push_prio(&q, "e", 1);
+    drain(&q, order, sizeof(order));
+    check("priority_displacement", r == AUDIO_QUEUE_REJECTED && r2 == AUDIO_QUEUE_DISPLACED &&
+                                   strcmp(order, "a,c,e") == 0);
+
+    // FIFO still turns away equals, but not a message that outranks one queued
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_FIFO);
+    push_all(&q, "abc", &r);
+    r = push_prio(&q, "d", 0);
+    r2 = push_prio(&q, "e", 3);
+    drain(&q, order, sizeof(order));
+    check("priority_fifo_urgent", r == AUDIO_QUEUE_REJECTED && r2 == AUDIO_QUEUE_DISPLACED &&
+                                  strcmp(order, "e,b,c") == 0);
+
+    // Peek leaves the next message queued; an urgent one pushed after it
+    // is what pop returns, and the id tells the two apart
+    audio_queue_init(&q, slots, 3, AUDIO_QUEUE_COALESCE);
+    push_prio(&q, "a", 0);
+    push_prio(&q, "b", 0);
+    audio_msg_t peeked;
+    bool got_peek = audio_queue_peek(&q, &peeked);
+    push_prio(&q, "c", 1);
+    audio_queue_pop(&q, &m);
+    audio_queue_pop(&q, &second);
+    check("peek_then_urgent", got_peek && strcmp(peeked.filename, "a") == 0 && audio_queue_stats(&q).depth == 1 &&
+                              strcmp(m.filename, "c") == 0 && m.id != peeked.id && second.id == peeked.id);
+    // A coalesced repeat keeps the id it was peeked with
+    audio_queue_peek(&q, &peeked);
+    newer = msg("b", "https://storage/b?fresh");
+    audio_queue_push(&q, &newer);
+    audio_queue_pop(&q, &m);
+    check("peek_coalesced", m.id == peeked.id && strcmp(m.url, "https://storage/b?fresh") == 0 &&
+                            !audio_queue_peek(&q, &m));
+
+    // Concurrent producers, one consumer: everything arrives exactly once
+    audio_queue_init(&shared, shared_slots, SHARED_SLOTS, AUDIO_QUEUE_FIFO);
+    pthread_t threads[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) pthread_create(&threads[i], NULL, producer, (void *)(intptr_t)i);
+    static unsigned char seen[PRODUCERS][PER_PRODUCER];
+    int next[PRODUCERS] = { 0 };
+    int got = 0;
+    bool ordered = true;
+    while (got < PRODUCERS * PER_PRODUCER) {
+        if (!audio_queue_pop(&shared, &m)) {
+            sched_yield();
+            continue;
+        }
+        int id, i;
+        if (sscanf(m.filename, "%d:%d", &id, &i) != 2 || id < 0 || id >= PRODUCERS) break;
+        if (i != next[id]++) ordered = false;
+        seen[id][i]++;
+        got++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+    bool once = true;
+    for (int id = 0; id < PRODUCERS; id++) {
+        for (int i = 0; i < PER_PRODUCER; i++) once = once && seen[id][i] == 1;
+    }
+    st = audio_queue_stats(&shared);
+    check("concurrent_exactly_once", once && ordered && st.dropped == 0 &&
+                                     st.dequeued == PRODUCERS * PER_PRODUCER);
+    printf("concurrent: enqueued=%u max_depth=%u\n", (unsigned)st.enqueued, (unsigned)st.max_depth);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+// Quality and throughput of the streaming resampler.
+//
+// Sine tones are converted between the rates the device meets and compared
+// with the ideal tone at the output rate: the best-fit sinusoid at the known
+// frequency is the reference and everything else (harmonics, images, noise)
+// counts as THD+N. Tones above the output Nyquist frequency must be
+// suppressed rather than aliased. Also checks output length, DC gain,
+// independence from how the input is chunked and bit-exact pass-through.
+// The optional argument is the benchmark's iteration count.
+// Exits non-zero on any failure.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "audio_resample.h"
+
+#define DEFAULT_ITERS 200
+#define TONE_SECONDS 0.5
+
+static int failures = 0;
+static audio_resampler_t rs;
+
+static void check(const char *name, int ok) {
+    printf("%-30s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static int16_t *tone(uint32_t rate, double hz, double amp, size_t frames) {
+    int16_t *pcm = malloc(frames * sizeof(int16_t));
+    for (size_t i = 0; i < frames; i++) pcm[i] = (int16_t)lrint(amp * 32767 * sin(2 * M_PI * hz * i / rate));
+    return pcm;
+}
+
+// Whole stream through the resampler in `chunk`-frame pieces plus flush
+static size_t convert(const int16_t *in, size_t frames, uint32_t in_rate, uint32_t out_rate, size_t chunk,
+                      int16_t *out) {
+    audio_resample_init(&rs, in_rate, 16, out_rate);
+    size_t produced = 0;
+    for (size_t i = 0; i < frames; i += chunk) {
+        size_t n = frames - i < chunk ? frames - i : chunk;
+        produced += audio_resample_process(&rs, in + i, n, out + produced);
+    }
+    return produced + audio_resample_flush(&rs, out + produced);
+}
+
+// Residual after removing the best-fit sinusoid at `hz`, relative to it, in
+// dB over the steady-state middle of the output
+static double thd_n_db(const int16_t *out, size_t frames, uint32_t rate, double hz) {
+    size_t skip = AUDIO_RESAMPLE_TAPS * 8;
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for (size_t i = skip; i < frames - skip; i++) {
+        double s = sin(2 * M_PI * hz * i / rate), c = cos(2 * M_PI * hz * i / rate);
+        ss += s * s; sc += s * c; cc += c * c;
+        ys += out[i] * s; yc += out[i] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+    double sig = 0, err = 0;
+    for (size_t i = skip; i < frames - skip; i++) {
+        double ref = a * sin(2 * M_PI * hz * i / rate) + b * cos(2 * M_PI * hz * i / rate);
+        sig += ref * ref;
+        err += (out[i] - ref) * (out[i] - ref);
+    }
+    return 10 * log10(err / sig);
+}
+
+static double rms(const int16_t *pcm, size_t from, size_t to) {
+    double sum = 0;
+    for (size_t i = from; i < to; i++) sum += (double)pcm[i] * pcm[i];
+    return sqrt(sum / (to - from));
+}
+
+static void quality(uint32_t in_rate, uint32_t out_rate, double hz, double max_db) {
+    size_t frames = (size_t)(in_rate * TONE_SECONDS);
+    int16_t *in = tone(in_rate, hz, 0.5, frames);
+    int16_t *out = malloc((frames * 8 + AUDIO_RESAMPLE_FLUSH_MAX) * sizeof(int16_t));
+    size_t n = convert(in, frames, in_rate, out_rate, 97, out);
+    size_t expect = (size_t)(((uint64_t)frames * out_rate + in_rate - 1) / in_rate);
+    double db = thd_n_db(out, n, out_rate, hz);
+    char name[64];
+    snprintf(name, sizeof(name), "thd_n %u->%u %.0fHz", (unsigned)in_rate, (unsigned)out_rate, hz);
+    printf("%-30s %.1f dB (limit %.0f) frames=%zu expect=%zu\n", name, db, max_db, n, expect);
+    check(name, db <= max_db && n == expect);
+    free(in);
+    free(out);
+}
+
+// A tone above the output Nyquist frequency must not fold back into band
+static void aliasing(uint32_t in_rate, uint32_t out_rate, double hz, double max_db) {
+    size_t frames = (size_t)(in_rate * TONE_SECONDS);
+    int16_t *in = tone(in_rate, hz, 0.5, frames);
+    int16_t *out = malloc((frames + AUDIO_RESAMPLE_FLUSH_MAX) * sizeof(int16_t));
+    size_t n = convert(in, frames, in_rate, out_rate, 256, out);
+    size_t skip = AUDIO_RESAMPLE_TAPS * 2;
+    double db = 20 * log10((rms(out, skip, n - skip) + 1e-9) / rms(in, 0, frames));
+    char name[64];
+    snprintf(name, sizeof(name), "alias %u->%u %.0fHz", (unsigned)in_rate, (unsigned)out_rate, hz);
+    printf("%-30s %.1f dB (limit %.0f)\n", name, db, max_db);
+    check(name, db <= max_db);
+    free(in);
+    free(out);
+}
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERS;
+
+    // Clip and chime rates up to the default 48 kHz output, and back down
+    quality(16000, 48000, 1000, -70);
+    quality(16000, 48000, 5000, -70);
+    quality(22050, 48000, 1000, -70);
+    quality(44100, 48000, 1000, -70);
+    quality(44100, 48000, 10000, -70);
+    quality(8000, 44100, 1000, -70);
+    quality(48000, 44100, 1000, -70);
+    quality(48000, 16000, 1000, -70);
+    aliasing(48000, 16000, 12000, -65);
+    aliasing(44100, 22050, 15000, -65);
+
+    // Output length is independent of chunking, and so is every sample
+    size_t frames = 16000;
+    int16_t *in = tone(16000, 440, 0.9, frames);
+    int16_t *a = malloc((frames * 3 + AUDIO_RESAMPLE_FLUSH_MAX) * sizeof(int16_t));
+    int16_t *b = malloc((frames * 3 + AUDIO_RESAMPLE_FLUSH_MAX) * sizeof(int16_t));
+    size_t na = convert(in, frames, 16000, 48000, frames, a);
+    size_t nb = convert(in, frames, 16000, 48000, 1, b);
+    check("chunking_invariant", na == nb && memcmp(a, b, na * sizeof(int16_t)) == 0);
+
+    // Unity DC gain: a constant comes out as the same constant
+    for (size_t i = 0; i < frames; i++) in[i] = 12345;
+    na = convert(in, frames, 22050, 48000, 300, a);
+    int dc_ok = 1;
+    for (size_t i = AUDIO_RESAMPLE_TAPS * 4; i < na - AUDIO_RESAMPLE_TAPS * 4; i++) dc_ok &= abs(a[i] - 12345) <= 1;
+    check("dc_gain", dc_ok);
+
+    // Full-scale square wave: overshoot saturates instead of wrapping
+    for (size_t i = 0; i < frames; i++) in[i] = (i / 20) % 2 ? INT16_MIN : INT16_MAX;
+    na = convert(in, frames, 16000, 48000, 512, a);
+    int sat_ok = 1;
+    for (size_t i = 1; i < na; i++) sat_ok &= abs(a[i] - a[i - 1]) < 40000;
+    check("saturates", sat_ok);
+
+    // Equal rates pass 16-bit audio unchanged and narrow 32-bit audio
+    free(in);
+    in = tone(48000, 1000, 0.5, frames);
+    na = convert(in, frames, 48000, 48000, 333, a);
+    check("passthrough_exact", na == frames && memcmp(a, in, frames * sizeof(int16_t)) == 0);
+    int32_t wide[4] = { 0x12348000, -0x10000, INT32_MAX, INT32_MIN };
+    audio_resample_init(&rs, 48000, 32, 48000);
+    na = audio_resample_process(&rs, wide, 4, a);
+    check("passthrough_narrow", na == 4 && a[0] == 0x1235 && a[1] == -1 && a[2] == INT16_MAX && a[3] == INT16_MIN);
+    check("rejects_bad_ratio", audio_resample_init(&rs, 8000, 16, 96000) == AUDIO_ERR_FORMAT &&
+                               audio_resample_init(&rs, 16000, 24, 48000) == AUDIO_ERR_FORMAT);
+
+    // Throughput for the common 16 kHz clip -> 48 kHz output case
+    free(in);
+    in = tone(16000, 1000, 0.5, frames);
+    int64_t t0 = audio_time_us();
+    size_t out_frames = 0;
+    for (int it = 0; it < iters; it++) out_frames += convert(in, frames, 16000, 48000, 1024, a);
+    int64_t us = audio_time_us() - t0;
+    double rate = us > 0 ? (double)out_frames / us : 0;
+    printf("bench 16000->48000: %.1f out samples/us (%.0fx real time)\n", rate, rate * 1e6 / 48000);
+
+    free(in);
+    free(a);
+    free(b);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// The lock-free SPSC ring (audio_spsc.h) against the mutex ring standing in
+// for the FreeRTOS ring buffer (host_ring.h).
+//
+// Checks first: a capacity that is not a power of two is refused, a slot
+// that does not fit before the end skips the tail gap and the reader passes
+// it, a receive on an empty ring times out, data committed before finish()
+// is read before receive() ends, and oversized slots are refused. Then
+// streams the same bytes through both rings between two threads, zero-copy
+// slots of the pipeline's chunk size and of a small block, and verifies
+// every byte arrives once and in order; then times the rings alone, the
+// slots left unfilled.
+//
+// Reports throughput and the time per block through both sides of the ring,
+// and how many blocks one receive() handed out.
+// Usage: ring_bench [MB per run]
+// Exits non-zero on any failure.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "host_ring.h"
+#include "host_spsc.h"
+
+#define RING_SIZE (64 * 1024)   // RINGBUF_SIZE_KB in firmware/main/main.c
+#define DEFAULT_MB 64
+#define VERIFY_BYTES (16 * 1024 * 1024 + 1)
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Byte `i` of the stream: nothing lines up with a power of two
+static uint8_t pattern(uint64_t i) {
+    return (uint8_t)(i ^ (i >> 7) ^ (i >> 17));
+}
+
+static void put(const audio_ring_t *ring, const char *text) {
+    void *slot;
+    ring->acquire(ring->ctx, &slot, strlen(text), AUDIO_WAIT_FOREVER);
+    memcpy(slot, text, strlen(text));
+    ring->complete(ring->ctx, slot, strlen(text));
+}
+
+// The next span as a string, "" when receive() returned NULL
+static const char *take(const audio_ring_t *ring, uint32_t timeout_ms) {
+    static char out[64];
+    size_t len;
+    void *item = ring->receive(ring->ctx, &len, timeout_ms);
+    if (!item) return "";
+    memcpy(out, item, len);
+    out[len] = '\0';
+    ring->return_item(ring->ctx, item);
+    return out;
+}
+
+static void unit_checks(void) {
+    host_spsc_t s;
+    check("rejects_non_power_of_two", host_spsc_init(&s, 24) == AUDIO_ERR_FORMAT);
+
+    host_spsc_init(&s, 16);
+    audio_ring_t ring;
+    host_spsc_bind(&s, &ring);
+    void *slot;
+    check("rejects_oversized_slot", !ring.acquire(ring.ctx, &slot, 9, 0) && ring.free_size(ring.ctx) == 8);
+
+    // 6 + 6 bytes, then 6 that fit only after skipping the last 4
+    put(&ring, "abcdef");
+    bool first = strcmp(take(&ring, 0), "abcdef") == 0;
+    put(&ring, "ghijkl");
+    put(&ring, "mnopqr");
+    bool before_gap = strcmp(take(&ring, 0), "ghijkl") == 0;
+    bool after_gap = strcmp(take(&ring, 0), "mnopqr") == 0;
+    check("gap_skipped", first && before_gap && after_gap && audio_spsc_used(&s.ring) == 0);
+
+    int64_t t0 = audio_time_us();
+    bool empty = take(&ring, 50)[0] == '\0';
+    int64_t waited_ms = (audio_time_us() - t0) / 1000;
+    check("receive_timeout", empty && waited_ms >= 50 && waited_ms < 500);
+
+    put(&ring, "st");
+    ring.finish(ring.ctx);
+    bool data_first = strcmp(take(&ring, AUDIO_WAIT_FOREVER), "st") == 0;
+    check("finish_after_data", data_first && take(&ring, AUDIO_WAIT_FOREVER)[0] == '\0');
+    host_spsc_bind(&s, &ring);
+    check("bind_restarts_stream", take(&ring, 0)[0] == '\0' && ring.free_size(ring.ctx) == 8);
+    host_spsc_deinit(&s);
+}
+
+typedef struct {
+    const audio_ring_t *ring;
+    size_t block;
+    uint64_t total;
+    bool verify;
+} stream_t;
+
+// Slots of `block` bytes, every seventh one committed short; filled with the
+// pattern when verifying, else left as they are so only the ring is timed
+static void *producer(void *arg) {
+    stream_t *st = arg;
+    uint64_t off = 0;
+    for (uint64_t n = 0; off < st->total; n++) {
+        void *slot;
+        if (!st->ring->acquire(st->ring->ctx, &slot, st->block, AUDIO_WAIT_FOREVER)) break;
+        size_t used = n % 7 == 6 ? st->block / 3 : st->block;
+        if (used > st->total - off) used = (size_t)(st->total - off);
+        uint8_t *p = slot;
+        for (size_t i = 0; st->verify && i < used; i++) p[i] = pattern(off + i);
+        st->ring->complete(st->ring->ctx, slot, used);
+        off += used;
+    }
+    st->ring->finish(st->ring->ctx);
+    return NULL;
+}
+
+static void run_stream(const char *name, const audio_ring_t *ring, size_t block, uint64_t total, bool verify) {
+    stream_t st = { .ring = ring, .block = block, .total = total, .verify = verify };
+    pthread_t thread;
+    int64_t t0 = audio_time_us();
+    pthread_create(&thread, NULL, producer, &st);
+    uint64_t off = 0;
+    uint64_t items = 0;
+    bool exact = true;
+    size_t len;
+    void *item;
+    while ((item = ring->receive(ring->ctx, &len, AUDIO_WAIT_FOREVER)) != NULL) {
+        const uint8_t *p = item;
+        for (size_t i = 0; verify && i < len; i++) exact = exact && p[i] == pattern(off + i);
+        off += len;
+        items++;
+        ring->return_item(ring->ctx, item);
+    }
+    pthread_join(thread, NULL);
+    int64_t us = audio_time_us() - t0;
+    char label[40];
+    snprintf(label, sizeof(label), "%s_%zu_exact", name, block);
+    if (verify) {
+        check(label, exact && off == total);
+        return;
+    }
+    double blocks = (double)total / block;
+    printf("%-6s block=%5zu  %8.1f MB/s  %7.0f ns/block  %6.2f blocks/item\n", name, block,
+           us > 0 ? (double)total / us : 0.0, us * 1000.0 / blocks, items ? blocks / items : 0.0);
+    if (off != total) failures++;
+}
+
+int main(int argc, char **argv) {
+    uint64_t total = (uint64_t)(argc > 1 ? atoi(argv[1]) : DEFAULT_MB) * 1024 * 1024;
+    unit_checks();
+
+    host_spsc_t s;
+    host_ring_t mutex_ring;
+    if (host_spsc_init(&s, RING_SIZE) < 0 || host_ring_init(&mutex_ring, RING_SIZE) < 0) return 1;
+    static const size_t blocks[] = { AUDIO_CHUNK_BUFFER_SIZE, 256 };
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        audio_ring_t ring;
+        for (int verify = 1; verify >= 0; verify--) {
+            host_spsc_bind(&s, &ring);
+            run_stream("spsc", &ring, blocks[i], verify ? VERIFY_BYTES : total, verify);
+            host_ring_bind(&mutex_ring, &ring);
+            run_stream("mutex", &ring, blocks[i], verify ? VERIFY_BYTES : total, verify);
+        }
+    }
+    host_ring_deinit(&mutex_ring);
+    host_spsc_deinit(&s);
+    return failures ? 1 : 0;
+}
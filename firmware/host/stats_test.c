@@ -0,0 +1,83 @@
+// Device health snapshots (audio_stats.h): ring fill bucketing and the
+// reset on take, the JSON with unmeasured values as null, a full task list
+// with hostile names still fitting, and truncation. Exits non-zero on any
+// failure.
+
+#include <stdio.h>
+#include <string.h>
+#include "audio_stats.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static audio_fill_hist_t hist;
+static audio_stats_t stats;
+
+int main(void) {
+    // 64 KB ring: empty, an eighth less a byte, an eighth, half, full, past full
+    audio_fill_hist_init(&hist);
+    static const size_t used[] = { 0, 8191, 8192, 32768, 65536, 70000 };
+    for (size_t i = 0; i < sizeof(used) / sizeof(used[0]); i++) audio_fill_hist_add(&hist, used[i], 65536);
+    audio_fill_hist_add(&hist, 10, 0);     // no ring: ignored
+    audio_fill_counts_t c = audio_fill_hist_take(&hist);
+    check("fill_buckets", c.counts[0] == 2 && c.counts[1] == 1 && c.counts[4] == 1 && c.counts[7] == 2 &&
+                          c.max_permille == 1000);
+    audio_fill_counts_t again = audio_fill_hist_take(&hist);
+    check("fill_take_resets", again.counts[0] == 0 && again.counts[7] == 0 && again.max_permille == 0);
+
+    stats = (audio_stats_t) {
+        .seq = 3, .uptime_s = 3600, .interval_ms = 60000,
+        .core_busy_permille = { 123, -1 },
+        .tasks = {
+            { "audio", 1, 401, 1460 },
+            { "mqtt_task", -1, -1, 2200 },
+        },
+        .task_count = 2,
+        .internal = { 120000, 90000, 65536 },
+        .psram = { 7000000, 6900000, 4000000 },
+        .dma = { 100000, 80000, 32768 },
+        .ring_kb = 64,
+        .queue_depth = 1, .queue_max_depth = 4, .queue_dropped = 0,
+        .rssi = -61,
+        .mqtt_connects = 3, .mqtt_disconnects = 2,
+        .messages = 41, .underruns = 1,
+    };
+    stats.ring_fill = c;
+    char json[AUDIO_STATS_JSON_MAX];
+    int n = audio_stats_format(&stats, json, sizeof(json));
+    const char *expect = "{\"seq\":3,\"uptime_s\":3600,\"interval_ms\":60000,\"cpu\":[12.3,null],\"tasks\":["
+                         "{\"name\":\"audio\",\"core\":1,\"cpu\":40.1,\"stack_free\":1460},"
+                         "{\"name\":\"mqtt_task\",\"core\":null,\"cpu\":null,\"stack_free\":2200}],"
+                         "\"heap\":{\"internal\":[120000,90000,65536],\"psram\":[7000000,6900000,4000000],"
+                         "\"dma\":[100000,80000,32768]},\"ring\":{\"kb\":64,\"fill\":[2,1,0,0,1,0,0,2],"
+                         "\"max_pct\":100.0},\"queue\":{\"depth\":1,\"max\":4,\"dropped\":0},\"rssi\":-61,"
+                         "\"mqtt\":{\"connects\":3,\"disconnects\":2},\"messages\":41,\"underruns\":1}";
+    check("snapshot_json", n == (int)strlen(expect) && strcmp(json, expect) == 0);
+    if (n < 0 || strcmp(json, expect) != 0) printf("got: %s\n", json);
+    check("snapshot_truncated", audio_stats_format(&stats, json, 100) == -1);
+
+    stats.rssi = 0;
+    audio_stats_format(&stats, json, sizeof(json));
+    check("not_associated", strstr(json, "\"rssi\":null,") != NULL);
+
+    // Every task slot taken, each name all escapes, all counters at their widest
+    memset(&stats, 0xff, sizeof(stats));
+    stats.task_count = AUDIO_STATS_MAX_TASKS;
+    for (size_t i = 0; i < AUDIO_STATS_MAX_TASKS; i++) {
+        memset(stats.tasks[i].name, '\n', AUDIO_STATS_TASK_NAME_MAX - 1);
+        stats.tasks[i].name[AUDIO_STATS_TASK_NAME_MAX - 1] = '\0';
+        stats.tasks[i].core = 1;
+        stats.tasks[i].cpu_permille = 1000;
+    }
+    stats.core_busy_permille[0] = stats.core_busy_permille[1] = 1000;
+    stats.rssi = -100;
+    n = audio_stats_format(&stats, json, sizeof(json));
+    printf("longest: %d bytes\n", n);
+    check("snapshot_max_fits", n > 0);
+
+    return failures ? 1 : 0;
+}
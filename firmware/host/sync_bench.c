@@ -0,0 +1,258 @@
+// Synchronized group playback (audio_sync.h) with several simulated devices
+// in one process. A broker thread fans one notification with a play_at out
+// to every device; each device parses it, downloads the clip from its own
+// loopback server (its own link rate and latency), and plays it through its
+// own pipeline, ring and fake I2S sink, scheduled on its own view of the
+// shared clock.
+//
+// Each device's sink runs off its local clock, which is off from true time
+// by --ppm (alternating sign, scaled per device: the I2S divider error and
+// crystal error SNTP cannot see); its shared clock is true time plus an SNTP
+// error of up to --sntp-error-ms. One device is given a link too slow to be
+// ready by play_at and has to join late (sync_test covers one too late to).
+//
+// Reports, in true time, when each device played the clip's first and last
+// sample relative to the schedule, and the spread between devices.
+// Usage: sync_bench [--devices N] [--seconds S] [--lead-ms MS] [--ppm PPM]
+//                   [--sntp-error-ms MS] [--no-drift] [--max-spread-ms MS]
+// Exits non-zero if the end spread exceeds --max-spread-ms.
+
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "audio_sync.h"
+#include "fake_i2s.h"
+#include "host_http_source.h"
+#include "host_spsc.h"
+#include "http_file_server.h"
+#include "notify_msg.h"
+#include "test_wav.h"
+
+// Mirrors i2s_init() in firmware/main/main.c
+#define DMA_DESC_NUM  32
+#define DMA_FRAME_NUM 480
+#define MAX_DEVICES   8
+#define SAMPLE_RATE   16000
+// A device past play_at when its download begins, but by less than
+// AUDIO_SYNC_MAX_LATE_US: about 250 ms late to start
+#define LATE_LATENCY_MS 400
+
+typedef struct {
+    int devices;
+    float seconds;
+    uint32_t lead_ms;
+    double ppm;
+    double sntp_error_ms;
+    bool drift;
+    double max_spread_ms;
+} sync_opts_t;
+
+typedef struct {
+    int index;
+    double ppm;                 // sink rate error against true time
+    int64_t sntp_error_us;
+    int64_t t0_us;              // host time the simulation started
+    int64_t epoch_us;           // true time at t0 (Unix microseconds)
+
+    http_file_server_t server;
+    host_spsc_t ring;
+    host_http_source_t http;
+    audio_pipeline_t pipeline;
+    audio_sync_t sync;
+    fake_i2s_t i2s;
+    audio_sink_t sink;
+    pthread_t writer, thread;
+    bool drift;
+
+    const char *note;           // published by the broker
+    size_t note_len;
+    volatile bool delivered;
+    int rc;
+} device_t;
+
+// The host clock stands in for the device's local clock, which the sink
+// follows; true time runs at (1 - ppm) of it
+static int64_t true_time_us(const device_t *d, int64_t host_us) {
+    return d->epoch_us + (int64_t)((double)(host_us - d->t0_us) * (1.0 - d->ppm * 1e-6));
+}
+
+static bool sim_clock_now(void *ctx, int64_t *us) {
+    device_t *d = ctx;
+    *us = true_time_us(d, audio_time_us()) + d->sntp_error_us;
+    return true;
+}
+
+static void *writer_thread(void *arg) {
+    device_t *d = arg;
+    audio_pipeline_write_loop(&d->pipeline, &d->sink);
+    fake_i2s_drain(&d->i2s);
+    return NULL;
+}
+
+static bool start_writer(audio_pipeline_t *p) {
+    device_t *d = p->user;
+    fake_i2s_init(&d->i2s, p->out_sample_rate, p->out_bits_per_sample / 8, DMA_DESC_NUM, DMA_FRAME_NUM);
+    fake_i2s_bind(&d->i2s, &d->sink);
+    return pthread_create(&d->writer, NULL, writer_thread, d) == 0;
+}
+
+// One device: wait for the notification, then play it like play_message()
+static void *device_thread(void *arg) {
+    device_t *d = arg;
+    while (!d->delivered) audio_sleep_ms(1);
+    notify_msg_t note;
+    char url[128];
+    if (notify_msg_parse(d->note, d->note_len, &note) != NOTIFY_OK || note.play_at < 0 ||
+        notify_str_copy(url, sizeof(url), note.file_url) <= 0) {
+        d->rc = AUDIO_ERR_FORMAT;
+        return NULL;
+    }
+    audio_clock_t clock = { .ctx = d, .now = sim_clock_now };
+    audio_sync_init(&d->sync, &clock, note.play_at * 1000, d->drift);
+
+    audio_pipeline_t *p = &d->pipeline;
+    host_http_source_bind(&d->http, &p->source);
+    host_spsc_bind(&d->ring, &p->ring);
+    p->start_playback = start_writer;
+    p->user = d;
+    p->sync = &d->sync;
+    d->rc = audio_pipeline_open(p, url);
+    if (d->rc == AUDIO_OK) d->rc = audio_pipeline_init(p);
+    if (d->rc == AUDIO_OK) d->rc = audio_pipeline_download(p);
+    if (p->player_started) pthread_join(d->writer, NULL);
+    p->source.close(p->source.ctx);
+    audio_pipeline_deinit(p);
+    return NULL;
+}
+
+static int parse_opts(int argc, char **argv, sync_opts_t *o) {
+    static const struct option longopts[] = {
+        { "devices",       required_argument, NULL, 'n' },
+        { "seconds",       required_argument, NULL, 's' },
+        { "lead-ms",       required_argument, NULL, 'l' },
+        { "ppm",           required_argument, NULL, 'p' },
+        { "sntp-error-ms", required_argument, NULL, 'e' },
+        { "no-drift",      no_argument,       NULL, 'D' },
+        { "max-spread-ms", required_argument, NULL, 'M' },
+        { 0, 0, 0, 0 },
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", longopts, NULL)) != -1) {
+        switch (c) {
+            case 'n': o->devices = atoi(optarg); break;
+            case 's': o->seconds = (float)atof(optarg); break;
+            case 'l': o->lead_ms = (uint32_t)atoi(optarg); break;
+            case 'p': o->ppm = atof(optarg); break;
+            case 'e': o->sntp_error_ms = atof(optarg); break;
+            case 'D': o->drift = false; break;
+            case 'M': o->max_spread_ms = atof(optarg); break;
+            default: return -1;
+        }
+    }
+    return o->devices >= 2 && o->devices <= MAX_DEVICES ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    sync_opts_t opts = {
+        .devices = 4,
+        .seconds = 6.0f,
+        .lead_ms = 1000,
+        .ppm = 300,
+        .drift = true,
+        .max_spread_ms = -1,
+    };
+    if (parse_opts(argc, argv, &opts) < 0) {
+        fprintf(stderr, "usage: %s [--devices 2-%d] [--seconds S] [--lead-ms MS] [--ppm PPM] "
+                "[--sntp-error-ms MS] [--no-drift] [--max-spread-ms MS]\n", argv[0], MAX_DEVICES);
+        return 2;
+    }
+
+    size_t wav_len;
+    uint8_t *wav = test_wav_generate(SAMPLE_RATE, 1, 16, opts.seconds, &wav_len);
+    if (!wav) return 1;
+    static device_t dev[MAX_DEVICES];
+    int64_t t0 = audio_time_us();
+    int64_t epoch = (int64_t)time(NULL) * 1000000;
+    for (int i = 0; i < opts.devices; i++) {
+        device_t *d = &dev[i];
+        // +ppm, -ppm, +ppm/2, -ppm/2, ...; likewise the SNTP error
+        double scale = (i % 2 ? -1.0 : 1.0) / (1 + i / 2);
+        d->index = i;
+        d->ppm = opts.ppm * scale;
+        d->sntp_error_us = (int64_t)(opts.sntp_error_ms * 1000 * scale);
+        d->t0_us = t0;
+        d->epoch_us = epoch;
+        d->drift = opts.drift;
+        // The last device cannot be ready by play_at
+        bool late = i == opts.devices - 1;
+        d->server = (http_file_server_t) {
+            .body = wav,
+            .body_len = wav_len,
+            .rate_bytes_per_s = (late ? 400 : 1000 + 500 * (uint32_t)i) * 1000 / 8,
+            .latency_ms = late ? LATE_LATENCY_MS : 20 + 60 * (uint32_t)i,
+        };
+        if (http_file_server_start(&d->server) < 0 || host_spsc_init(&d->ring, 64 * 1024) < 0) return 1;
+        if (pthread_create(&d->thread, NULL, device_thread, d) != 0) return 1;
+    }
+
+    // The broker: one message, delivered to each device a few ms apart
+    int64_t play_at_ms = (true_time_us(&dev[0], audio_time_us()) + (int64_t)opts.lead_ms * 1000) / 1000;
+    static char notes[MAX_DEVICES][256];
+    for (int i = 0; i < opts.devices; i++) {
+        device_t *d = &dev[i];
+        int n = snprintf(notes[i], sizeof(notes[i]),
+                         "{\"file_url\":\"http://127.0.0.1:%u/audio/group.wav\",\"filename\":\"group.wav\","
+                         "\"play_at\":%lld}", (unsigned)d->server.port, (long long)play_at_ms);
+        d->note = notes[i];
+        d->note_len = (size_t)n;
+        d->delivered = true;
+        audio_sleep_ms(5);
+    }
+
+    int failed = 0;
+    double first_min = 1e9, first_max = -1e9, last_min = 1e9, last_max = -1e9;
+    double clip_us = (double)(wav_len - 44) / 2 * 1e6 / SAMPLE_RATE;
+    printf("devices=%d seconds=%.1f lead_ms=%u ppm=%.0f sntp_error_ms=%.2f drift_correction=%d\n", opts.devices,
+           opts.seconds, (unsigned)opts.lead_ms, opts.ppm, opts.sntp_error_ms, opts.drift);
+    for (int i = 0; i < opts.devices; i++) {
+        device_t *d = &dev[i];
+        pthread_join(d->thread, NULL);
+        http_file_server_stop(&d->server);
+        host_spsc_deinit(&d->ring);
+        if (d->rc != AUDIO_OK) {
+            fprintf(stderr, "device %d failed: %d\n", i, d->rc);
+            failed = 1;
+            continue;
+        }
+        const audio_sync_stats_t *s = &d->sync.stats;
+        // When the clip's first sample would have played (the late device
+        // skipped it) and when its last one did, against the schedule
+        double first_ms = (true_time_us(d, d->i2s.first_write_us) - play_at_ms * 1000 -
+                           (double)s->skipped_frames * 1e6 / SAMPLE_RATE) / 1000.0;
+        double last_ms = (true_time_us(d, d->i2s.t_drained_us) - play_at_ms * 1000 - clip_us) / 1000.0;
+        printf("device %d: ppm=%+.0f sntp_error_ms=%+.2f start_error_ms=%.2f skipped_ms=%.1f slipped=%d "
+               "corrections=%u max_error_ms=%.2f first_ms=%+.2f last_ms=%+.2f underruns=%u\n",
+               i, d->ppm, d->sntp_error_us / 1000.0, s->start_error_us / 1000.0,
+               s->skipped_frames * 1000.0 / SAMPLE_RATE, (int)s->slipped_frames, (unsigned)s->corrections,
+               s->max_error_us / 1000.0, first_ms, last_ms, (unsigned)d->i2s.underruns);
+        first_min = fmin(first_min, first_ms);
+        first_max = fmax(first_max, first_ms);
+        last_min = fmin(last_min, last_ms);
+        last_max = fmax(last_max, last_ms);
+    }
+    double spread_ms = last_max - last_min;
+    printf("spread: first_ms=%.2f last_ms=%.2f\n", first_max - first_min, spread_ms);
+    free(wav);
+    if (failed) return 1;
+    if (opts.max_spread_ms >= 0 && spread_ms > opts.max_spread_ms) {
+        fprintf(stderr, "FAIL: devices %.2f ms apart at the end (max %.2f)\n", spread_ms, opts.max_spread_ms);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Scheduled start (audio_sync.h) on a clock the test sets: a start on time
+// or a little late joins the group, skipping what it missed; one more than
+// AUDIO_SYNC_MAX_LATE_US late, or with the clock not set, plays the clip
+// from its start unsynchronized. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include "audio_sync.h"
+
+#define RATE 16000
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+typedef struct {
+    int64_t now_us;
+    bool set;
+} test_clock_t;
+
+static bool test_now(void *ctx, int64_t *us) {
+    test_clock_t *c = ctx;
+    *us = c->now_us;
+    return c->set;
+}
+
+static test_clock_t tc = { 1792310400000000LL, true };
+static audio_sync_t sync;
+
+// Starts a clip scheduled `late_us` before the test clock's now
+static bool start_late(int64_t late_us) {
+    audio_clock_t clock = { .ctx = &tc, .now = test_now };
+    audio_sync_init(&sync, &clock, tc.now_us - late_us, true);
+    return audio_sync_start(&sync, RATE);
+}
+
+int main(void) {
+    check("on_time", start_late(0) && sync.skip_frames == 0 && sync.stats.start_error_us == 0);
+
+    int32_t repeat;
+    check("late_skips_ahead", start_late(200000) && sync.skip_frames == RATE / 5 &&
+                              audio_sync_block(&sync, 0, 512, &repeat) == 512 && repeat == 0);
+    check("late_at_limit_joins", start_late(AUDIO_SYNC_MAX_LATE_US) &&
+                                 sync.skip_frames == (int64_t)AUDIO_SYNC_MAX_LATE_US * RATE / 1000000);
+
+    // Past the limit the whole clip plays, nothing skipped
+    check("too_late_unsynchronized", !start_late(AUDIO_SYNC_MAX_LATE_US + 1) && sync.skip_frames == 0 &&
+                                     sync.stats.start_error_us == AUDIO_SYNC_MAX_LATE_US + 1);
+    check("minutes_late", !start_late(600 * 1000000LL) && sync.skip_frames == 0);
+
+    // The sink's queue counts against the start
+    audio_clock_t clock = { .ctx = &tc, .now = test_now };
+    audio_sync_init(&sync, &clock, tc.now_us, true);
+    sync.output_delay_us = 30000;
+    check("output_delay_counts", audio_sync_start(&sync, RATE) && sync.skip_frames == RATE * 3 / 100);
+
+    tc.set = false;
+    check("clock_not_set", !start_late(0));
+
+    return failures ? 1 : 0;
+}
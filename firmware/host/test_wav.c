@@ -0,0 +1,141 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ima_adpcm.h"
+#include "test_wav.h"
+
+static void wr_le16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void wr_le32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+// 220 Hz -> 2 kHz sweep, left/right a quarter period apart
+static double sweep(double *phase, uint32_t i, uint32_t frames, uint32_t sample_rate, uint16_t channel) {
+    if (channel == 0) {
+        double f = 220.0 + (2000.0 - 220.0) * i / frames;
+        *phase += 2.0 * M_PI * f / sample_rate;
+    }
+    return 0.5 * sin(*phase + channel * M_PI / 2);
+}
+
+uint8_t *test_wav_generate(uint32_t sample_rate, uint16_t channels, uint16_t bits,
+                           float seconds, size_t *out_len) {
+    uint32_t frames = (uint32_t)(sample_rate * seconds);
+    uint32_t block_align = channels * bits / 8;
+    uint32_t data_len = frames * block_align;
+    uint8_t *wav = malloc(44 + data_len);
+    if (!wav) return NULL;
+
+    memcpy(wav, "RIFF", 4);
+    wr_le32(wav + 4, 36 + data_len);
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    wr_le32(wav + 16, 16);
+    wr_le16(wav + 20, 1);
+    wr_le16(wav + 22, channels);
+    wr_le32(wav + 24, sample_rate);
+    wr_le32(wav + 28, sample_rate * block_align);
+    wr_le16(wav + 32, (uint16_t)block_align);
+    wr_le16(wav + 34, bits);
+    memcpy(wav + 36, "data", 4);
+    wr_le32(wav + 40, data_len);
+
+    uint8_t *p = wav + 44;
+    double phase = 0.0;
+    for (uint32_t i = 0; i < frames; i++) {
+        for (uint16_t c = 0; c < channels; c++) {
+            double v = sweep(&phase, i, frames, sample_rate, c);
+            if (bits == 16) {
+                wr_le16(p, (uint16_t)(int16_t)(v * 32767));
+                p += 2;
+            } else {
+                wr_le32(p, (uint32_t)(int32_t)(v * 2147483647.0));
+                p += 4;
+            }
+        }
+    }
+
+    *out_len = 44 + data_len;
+    return wav;
+}
+
+uint8_t *test_wav_generate_adpcm(uint32_t sample_rate, uint16_t channels, float seconds,
+                                 uint16_t block_align, size_t *out_len) {
+    uint32_t frames = (uint32_t)(sample_rate * seconds);
+    uint32_t spb = (uint32_t)ima_adpcm_block_samples(block_align, channels);
+    uint32_t blocks = (frames + spb - 1) / spb;
+    uint32_t data_len = blocks * block_align;
+    size_t header_len = 12 + 8 + 20 + 8 + 4 + 8;
+    uint8_t *wav = calloc(1, header_len + data_len);
+    int16_t *pcm = calloc((size_t)blocks * spb * channels, sizeof(int16_t));
+    if (!wav || !pcm) {
+        free(wav);
+        free(pcm);
+        return NULL;
+    }
+
+    double phase = 0.0;
+    for (uint32_t i = 0; i < frames; i++) {
+        for (uint16_t c = 0; c < channels; c++) {
+            pcm[i * channels + c] = (int16_t)(sweep(&phase, i, frames, sample_rate, c) * 32767);
+        }
+    }
+
+    memcpy(wav, "RIFF", 4);
+    wr_le32(wav + 4, (uint32_t)(header_len - 8 + data_len));
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    wr_le32(wav + 16, 20);
+    wr_le16(wav + 20, 0x0011);
+    wr_le16(wav + 22, channels);
+    wr_le32(wav + 24, sample_rate);
+    wr_le32(wav + 28, (uint32_t)((uint64_t)sample_rate * block_align / spb));
+    wr_le16(wav + 32, block_align);
+    wr_le16(wav + 34, 4);
+    wr_le16(wav + 36, 2);
+    wr_le16(wav + 38, (uint16_t)spb);
+    memcpy(wav + 40, "fact", 4);
+    wr_le32(wav + 44, 4);
+    wr_le32(wav + 48, frames);
+    memcpy(wav + 52, "data", 4);
+    wr_le32(wav + 56, data_len);
+
+    ima_adpcm_state_t st[2] = { { 0, 0 }, { 0, 0 } };
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint8_t *blk = wav + header_len + (size_t)b * block_align;
+        const int16_t *src = pcm + (size_t)b * spb * channels;
+        for (uint16_t c = 0; c < channels; c++) {
+            st[c].predictor = src[c];
+            wr_le16(blk + c * 4, (uint16_t)src[c]);
+            blk[c * 4 + 2] = (uint8_t)st[c].index;
+        }
+        uint8_t *data = blk + 4 * channels;
+        if (channels == 1) {
+            for (uint32_t i = 1; i < spb; i += 2) {
+                uint8_t lo = ima_adpcm_encode_sample(&st[0], src[i]);
+                uint8_t hi = ima_adpcm_encode_sample(&st[0], src[i + 1]);
+                *data++ = lo | (hi << 4);
+            }
+        } else {
+            for (uint32_t g = 0; g < (spb - 1) / 8; g++) {
+                for (uint16_t c = 0; c < 2; c++) {
+                    for (int k = 0; k < 8; k += 2) {
+                        uint32_t i = 1 + g * 8 + k;
+                        uint8_t lo = ima_adpcm_encode_sample(&st[c], src[i * 2 + c]);
+                        uint8_t hi = ima_adpcm_encode_sample(&st[c], src[(i + 1) * 2 + c]);
+                        *data++ = lo | (hi << 4);
+                    }
+                }
+            }
+        }
+    }
+
+    free(pcm);
+    *out_len = header_len + data_len;
+    return wav;
+}
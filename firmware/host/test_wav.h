@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Build an in-memory canonical WAV (sine sweep) for the host harness.
+// Returns a malloc'd buffer of *out_len bytes, or NULL.
+uint8_t *test_wav_generate(uint32_t sample_rate, uint16_t channels, uint16_t bits,
+                           float seconds, size_t *out_len);
+
+// Same sweep, 16-bit, encoded as an IMA ADPCM WAV with the given block size.
+uint8_t *test_wav_generate_adpcm(uint32_t sample_rate, uint16_t channels, float seconds,
+                                 uint16_t block_align, size_t *out_len);
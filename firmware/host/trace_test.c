@@ -0,0 +1,79 @@
+// Per-message latency records (audio_trace.h): spans from pipeline stats,
+// the JSON record and its escaping and truncation, and rolling-window
+// percentiles. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <string.h>
+#include "audio_trace.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok) {
+    printf("%-26s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static audio_trace_window_t window;
+
+int main(void) {
+    // Received at 1 s; every stage 10 ms apart, download of 250 KB in 1 s
+    audio_pipeline_stats_t s = {
+        .t_open_us = 1010000, .t_source_open_us = 1020000, .t_first_byte_us = 1030000,
+        .t_prefill_us = 1040000, .t_first_write_us = 1050000, .t_played_us = 3060000,
+        .t_complete_us = 2010000, .bytes_processed = 250000, .underruns = 2, .starved_ms = 130,
+    };
+    audio_trace_t t = { .seq = 7, .ok = true };
+    strcpy(t.filename, "alarm.wav");
+    audio_trace_from_stats(&t, 1000000, &s);
+    check("spans_from_stats", t.at_ms[AUDIO_SPAN_OPEN] == 10 && t.at_ms[AUDIO_SPAN_FIRST_WRITE] == 50 &&
+                              t.at_ms[AUDIO_SPAN_PLAYED] == 2060 && t.kbps == 2000 && t.underruns == 2);
+
+    char json[AUDIO_TRACE_JSON_MAX];
+    int n = audio_trace_format(&t, json, sizeof(json));
+    const char *expect = "{\"seq\":7,\"file\":\"alarm.wav\",\"open\":10,\"headers\":20,\"first_byte\":30,"
+                         "\"prefill\":40,\"first_write\":50,\"played\":2060,\"bytes\":250000,\"kbps\":2000,"
+                         "\"underruns\":2,\"starved_ms\":130,\"preempt_ms\":null,\"cached\":false,\"ok\":true}";
+    check("record_json", n == (int)strlen(expect) && strcmp(json, expect) == 0);
+    check("record_truncated", audio_trace_format(&t, json, 40) == -1);
+
+    // Cancelled 1.5 s in for an urgent message, silent 20 ms later
+    s.t_cancel_us = 2500000;
+    s.t_played_us = 2520000;
+    audio_trace_from_stats(&t, 1000000, &s);
+    audio_trace_format(&t, json, sizeof(json));
+    check("record_preempted", t.preempt_ms == 20 && strstr(json, "\"preempt_ms\":20,"));
+
+    // A message that failed before the writer started, with a hostile name
+    audio_pipeline_stats_t failed = { .t_open_us = 1005000, .t_source_open_us = 1100000 };
+    audio_trace_t f = { .seq = 8 };
+    strcpy(f.filename, "a\"b\\c\n");
+    audio_trace_from_stats(&f, 1000000, &failed);
+    audio_trace_format(&f, json, sizeof(json));
+    check("record_escaped_unreached", strstr(json, "\"file\":\"a\\\"b\\\\c\\u000a\"") &&
+                                      strstr(json, "\"first_byte\":null") && strstr(json, "\"kbps\":0") &&
+                                      strstr(json, "\"ok\":false"));
+    // Longest name, all escapes, still fits
+    memset(f.filename, '"', sizeof(f.filename) - 1);
+    f.filename[sizeof(f.filename) - 1] = '\0';
+    check("record_max_fits", audio_trace_format(&f, json, sizeof(json)) > 0);
+
+    // 1..100 ms through a window of 64: only the last 64 (37..100) count
+    audio_trace_window_init(&window);
+    check("empty_window", audio_trace_percentiles(&window, AUDIO_SPAN_OPEN).p50 == -1);
+    for (int i = 1; i <= 100; i++) {
+        audio_trace_t r = { 0 };
+        for (int k = 0; k < AUDIO_SPAN_COUNT; k++) r.at_ms[k] = (101 - i) * (k + 1);
+        r.at_ms[AUDIO_SPAN_PREFILL] = i % 2 ? -1 : i;      // every other one never started
+        audio_trace_window_add(&window, &r);
+    }
+    audio_percentiles_t p = audio_trace_percentiles(&window, AUDIO_SPAN_OPEN);
+    check("window_percentiles", p.n == 64 && p.p50 == 32 && p.p95 == 61 && p.p99 == 64);
+    p = audio_trace_percentiles(&window, AUDIO_SPAN_PREFILL);
+    check("unreached_excluded", p.n == 32 && p.p50 == 68 && p.p99 == 100);
+
+    n = audio_trace_format_summary(&window, json, sizeof(json));
+    printf("summary: %s\n", json);
+    check("summary_json", n > 0 && strncmp(json, "{\"window\":64,\"open\":[32,61,64],", 31) == 0);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+#include <string.h>
+#include "audio_cache_flash.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_CACHE_FLASH
+
+static const char *TAG = "CACHE_FLASH";
+
+#define SLOT_MAGIC      0x41434331  // "ACC1"
+#define SLOT_HEADER     128         // clip data starts here within a slot
+#define SECTOR_SIZE     4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;       // write order, for replacing the oldest
+    uint32_t len;
+    char key[AUDIO_CACHE_KEY_MAX];
+} slot_header_t;
+
+typedef struct {
+    const esp_partition_t *part;
+    size_t slot_size;
+    uint32_t next_seq;
+    slot_header_t slots[CONFIG_AUDIO_CACHE_FLASH_SLOTS];
+} flash_store_t;
+
+static flash_store_t store;
+
+static int slot_of(const char *key) {
+    for (int i = 0; i < CONFIG_AUDIO_CACHE_FLASH_SLOTS; i++) {
+        if (store.slots[i].magic == SLOT_MAGIC && strcmp(store.slots[i].key, key) == 0) return i;
+    }
+    return -1;
+}
+
+static int flash_find(void *ctx, const char *key) {
+    int i = slot_of(key);
+    return i < 0 ? -1 : (int)store.slots[i].len;
+}
+
+static bool flash_read(void *ctx, const char *key, void *dst, size_t len) {
+    int i = slot_of(key);
+    if (i < 0 || len > store.slots[i].len) return false;
+    return esp_partition_read(store.part, i * store.slot_size + SLOT_HEADER, dst, len) == ESP_OK;
+}
+
+// Data first, header last: a clip interrupted by a reset has no valid
+// header and the slot reads as free.
+static bool flash_write(void *ctx, const char *key, const void *data, size_t len) {
+    if (len > store.slot_size - SLOT_HEADER) return false;
+    int victim = slot_of(key);
+    for (int i = 0; victim < 0 && i < CONFIG_AUDIO_CACHE_FLASH_SLOTS; i++) {
+        if (store.slots[i].magic != SLOT_MAGIC) victim = i;
+    }
+    if (victim < 0) {
+        victim = 0;
+        for (int i = 1; i < CONFIG_AUDIO_CACHE_FLASH_SLOTS; i++) {
+            if (store.slots[i].seq < store.slots[victim].seq) victim = i;
+        }
+    }
+
+    size_t base = victim * store.slot_size;
+    size_t erase_len = (SLOT_HEADER + len + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+    memset(&store.slots[victim], 0, sizeof(slot_header_t));
+    slot_header_t hdr = { .magic = SLOT_MAGIC, .seq = store.next_seq++, .len = len };
+    strncpy(hdr.key, key, sizeof(hdr.key) - 1);
+
+    int64_t t0 = esp_timer_get_time();
+    if (esp_partition_erase_range(store.part, base, erase_len) != ESP_OK ||
+        esp_partition_write(store.part, base + SLOT_HEADER, data, len) != ESP_OK ||
+        esp_partition_write(store.part, base, &hdr, sizeof(hdr)) != ESP_OK) {
+        return false;
+    }
+    store.slots[victim] = hdr;
+    ESP_LOGI(TAG, "Stored %s in slot %d (%u bytes, %ld ms)", key, victim, (unsigned)len,
+             (long)((esp_timer_get_time() - t0) / 1000));
+    return true;
+}
+
+esp_err_t audio_cache_flash_init(audio_cache_store_t *out) {
+    store.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "audiocache");
+    if (!store.part) {
+        ESP_LOGW(TAG, "No \"audiocache\" partition, flash tier disabled");
+        return ESP_ERR_NOT_FOUND;
+    }
+    store.slot_size = store.part->size / CONFIG_AUDIO_CACHE_FLASH_SLOTS / SECTOR_SIZE * SECTOR_SIZE;
+    if (store.slot_size <= SLOT_HEADER) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int used = 0;
+    for (int i = 0; i < CONFIG_AUDIO_CACHE_FLASH_SLOTS; i++) {
+        slot_header_t *h = &store.slots[i];
+        if (esp_partition_read(store.part, i * store.slot_size, h, sizeof(*h)) != ESP_OK ||
+            h->magic != SLOT_MAGIC || h->len > store.slot_size - SLOT_HEADER) {
+            memset(h, 0, sizeof(*h));
+            continue;
+        }
+        h->key[AUDIO_CACHE_KEY_MAX - 1] = '\0';
+        if (h->seq >= store.next_seq) store.next_seq = h->seq + 1;
+        used++;
+    }
+    ESP_LOGI(TAG, "%d/%d slots of %u KB in use", used, CONFIG_AUDIO_CACHE_FLASH_SLOTS,
+             (unsigned)(store.slot_size / 1024));
+
+    *out = (audio_cache_store_t) {
+        .ctx = &store,
+        .find = flash_find,
+        .read = flash_read,
+        .write = flash_write,
+    };
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t audio_cache_flash_init(audio_cache_store_t *out) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
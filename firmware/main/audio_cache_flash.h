@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_err.h"
+#include "audio_cache.h"
+
+// Persistent audio_cache tier on the "audiocache" data partition. The
+// partition is split into CONFIG_AUDIO_CACHE_FLASH_SLOTS equal slots, each a
+// small header followed by the clip; a new clip replaces a free slot or the
+// oldest one. Headers are indexed in RAM at init.
+esp_err_t audio_cache_flash_init(audio_cache_store_t *out);
@@ -0,0 +1,117 @@
+#include "audio_mem.h"
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "esp_audio_io.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "AUDIO_MEM";
+
+// Indices in internal RAM, each on its own line; the storage goes by size
+static audio_spsc_t ring;
+static esp_signal_t ring_readable;
+static esp_signal_t ring_writable;
+
+esp_err_t audio_mem_init(audio_mem_pool_t *pool, size_t ring_size, size_t inline_size, size_t prefetch_size) {
+    const uint32_t dma = MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT;
+    pool->chunk_buffer = heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, AUDIO_CHUNK_BUFFER_SIZE, dma);
+    pool->mono_buffer = heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, AUDIO_CHUNK_BUFFER_SIZE, dma);
+    if (!pool->chunk_buffer || !pool->mono_buffer) {
+        ESP_LOGE(TAG, "Failed to allocate staging buffers");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Zeroed: the resamplers rebuild their tables only when the rates change
+    pool->writer_resampler = heap_caps_calloc(1, sizeof(audio_resampler_t), MALLOC_CAP_INTERNAL);
+    pool->chime_resampler = heap_caps_calloc(1, sizeof(audio_resampler_t), MALLOC_CAP_INTERNAL);
+    if (!pool->writer_resampler || !pool->chime_resampler) {
+        ESP_LOGE(TAG, "Failed to allocate resamplers");
+        return ESP_ERR_NO_MEM;
+    }
+    pool->writer_dsp = heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, sizeof(audio_dsp_t), MALLOC_CAP_INTERNAL);
+    pool->chime_dsp = heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, sizeof(audio_dsp_t), MALLOC_CAP_INTERNAL);
+    if (!pool->writer_dsp || !pool->chime_dsp) {
+        ESP_LOGE(TAG, "Failed to allocate DSP state");
+        return ESP_ERR_NO_MEM;
+    }
+    pool->conceal = heap_caps_aligned_alloc(AUDIO_SIMD_ALIGN, sizeof(audio_conceal_t), MALLOC_CAP_INTERNAL);
+    if (!pool->conceal) {
+        ESP_LOGE(TAG, "Failed to allocate concealment buffers");
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t *storage = heap_caps_malloc(ring_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    pool->ring_in_psram = storage != NULL;
+    if (!storage) storage = heap_caps_malloc(ring_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!storage) {
+        ESP_LOGE(TAG, "Failed to allocate %u byte ring", (unsigned)ring_size);
+        return ESP_ERR_NO_MEM;
+    }
+    audio_signal_t readable, writable;
+    esp_signal_bind(&ring_readable, &readable);
+    esp_signal_bind(&ring_writable, &writable);
+    if (audio_spsc_init(&ring, storage, ring_size, &readable, &writable) != AUDIO_OK) {
+        ESP_LOGE(TAG, "Ring size %u is not a power of two", (unsigned)ring_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    pool->ring = &ring;
+    pool->ring_size = ring_size;
+    ESP_LOGI(TAG, "Staging buffers in internal RAM, %u KB ring in %s", (unsigned)(ring_size / 1024),
+             pool->ring_in_psram ? "PSRAM" : "internal RAM");
+
+    // Inline clips are a latency shortcut, not a requirement: without the
+    // memory every message takes its file_url
+    pool->inline_buffer = NULL;
+    pool->inline_size = 0;
+    if (inline_size) {
+        pool->inline_buffer = heap_caps_malloc(inline_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (pool->inline_buffer) {
+            pool->inline_size = inline_size;
+            ESP_LOGI(TAG, "%u KB inline clip buffer in PSRAM", (unsigned)(inline_size / 1024));
+        } else {
+            ESP_LOGW(TAG, "No PSRAM for the %u KB inline clip buffer, clips download by URL",
+                     (unsigned)(inline_size / 1024));
+        }
+    }
+
+    // Likewise download-ahead: without it the next message fetches after this one
+    pool->prefetch_buffer = NULL;
+    pool->prefetch_size = 0;
+    if (prefetch_size) {
+        pool->prefetch_buffer = heap_caps_malloc(prefetch_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (pool->prefetch_buffer) {
+            pool->prefetch_size = prefetch_size;
+            ESP_LOGI(TAG, "%u KB download-ahead buffer in PSRAM", (unsigned)(prefetch_size / 1024));
+        } else {
+            ESP_LOGW(TAG, "No PSRAM for the %u KB download-ahead buffer, messages download in turn",
+                     (unsigned)(prefetch_size / 1024));
+        }
+    }
+    return ESP_OK;
+}
+
+audio_mem_stats_t audio_mem_stats(void) {
+    return (audio_mem_stats_t) {
+        .internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        .internal_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        .internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+        .psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        .psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM),
+        .psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+        .dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA),
+        .dma_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DMA),
+        .dma_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA),
+    };
+}
+
+void audio_mem_report(const char *when, const TaskHandle_t *tasks, size_t count) {
+    audio_mem_stats_t s = audio_mem_stats();
+    ESP_LOGI(TAG, "%s: internal %u free (min %u, largest %u), PSRAM %u free (largest %u)", when,
+             (unsigned)s.internal_free, (unsigned)s.internal_min_free, (unsigned)s.internal_largest,
+             (unsigned)s.psram_free, (unsigned)s.psram_largest);
+    for (size_t i = 0; i < count; i++) {
+        if (!tasks[i]) continue;
+        ESP_LOGI(TAG, "  %-12s stack high-water %u bytes free", pcTaskGetName(tasks[i]),
+                 (unsigned)uxTaskGetStackHighWaterMark(tasks[i]));
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "audio_conceal.h"
+#include "audio_dsp.h"
+#include "audio_resample.h"
+#include "audio_spsc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Audio memory allocated once at boot, placed by what touches it, so a
+// message allocates nothing and days of uptime cannot fragment the heap:
+//   staging buffers   internal DMA-capable RAM; the conversion kernels and
+//                     i2s_channel_write read them every chunk
+//   ring storage      PSRAM when fitted, internal RAM otherwise; the large
+//   inline clip,      jitter buffer, the MQTT clip buffer and the next
+//   prefetch          message's head, touched once per byte
+//   resamplers, DSP,  internal RAM; filter tables and state touched for
+//   concealment       every output sample
+typedef struct {
+    char *chunk_buffer;         // AUDIO_CHUNK_BUFFER_SIZE each, SIMD aligned
+    char *mono_buffer;
+    audio_spsc_t *ring;         // lock-free, between the worker and the writer
+    size_t ring_size;
+    bool ring_in_psram;
+    uint8_t *inline_buffer;     // a whole inline clip (audio_inline.h), NULL when off
+    size_t inline_size;
+    uint8_t *prefetch_buffer;   // the next message's head (audio_prefetch.h), NULL when off
+    size_t prefetch_size;
+    audio_resampler_t *writer_resampler;    // voice clips, on the I2S writer
+    audio_resampler_t *chime_resampler;     // chimes, on the chime task
+    audio_dsp_t *writer_dsp;                // post-processing, one per writer
+    audio_dsp_t *chime_dsp;
+    audio_conceal_t *conceal;               // fades around stalls, on the writer
+} audio_mem_pool_t;
+
+// ring_size is a power of two; inline_size 0 leaves inline clips off,
+// prefetch_size 0 download-ahead
+esp_err_t audio_mem_init(audio_mem_pool_t *pool, size_t ring_size, size_t inline_size, size_t prefetch_size);
+
+typedef struct {
+    size_t internal_free;
+    size_t internal_min_free;   // low-water mark since boot
+    size_t internal_largest;    // largest free block: falls as the heap fragments
+    size_t psram_free;
+    size_t psram_min_free;
+    size_t psram_largest;
+    size_t dma_free;            // DMA-capable: staging buffers, I2S and Wi-Fi draw on it
+    size_t dma_min_free;
+    size_t dma_largest;
+} audio_mem_stats_t;
+
+audio_mem_stats_t audio_mem_stats(void);
+
+// Logs audio_mem_stats() and the stack high-water mark of each task
+void audio_mem_report(const char *when, const TaskHandle_t *tasks, size_t count);
@@ -0,0 +1,41 @@
+#include "chime_flash.h"
+#include "audio_pipeline.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+
+static const char *TAG = "CHIMES";
+
+static const void *image;
+static size_t image_size;
+static esp_partition_mmap_handle_t image_map;
+
+esp_err_t chime_flash_init(void) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "chimes");
+    if (!part) {
+        ESP_LOGW(TAG, "No \"chimes\" partition, notifications play without a chime");
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &image, &image_map);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map chimes: %s", esp_err_to_name(err));
+        image = NULL;
+        return err;
+    }
+    image_size = part->size;
+
+    audio_chime_t c;
+    unsigned count = 0;
+    while (audio_chime_find(image, image_size, count + 1, &c) == AUDIO_OK) count++;
+    if (count == 0) {
+        ESP_LOGW(TAG, "\"chimes\" partition holds no chime image (flash it with idf.py flash)");
+        esp_partition_munmap(image_map);
+        image = NULL;
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "%u chimes mapped", count);
+    return ESP_OK;
+}
+
+esp_err_t chime_flash_get(unsigned id, audio_chime_t *out) {
+    return audio_chime_find(image, image_size, id, out) == AUDIO_OK ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "esp_err.h"
+#include "audio_chime.h"
+
+// Alarm chimes on the "chimes" data partition, written at flash time from
+// tools/mkchimes.py. The partition is memory-mapped once at init and stays
+// mapped, so chimes play straight from flash through the cache.
+esp_err_t chime_flash_init(void);
+
+// Chime `id` (1-based) from the mapped image. Returns ESP_ERR_NOT_FOUND for
+// an unknown id or when the partition is missing or holds no valid image.
+esp_err_t chime_flash_get(unsigned id, audio_chime_t *out);
@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_audio_io.h"
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "AUDIO_IO";
+
+static TickType_t ms_to_ticks(uint32_t timeout_ms) {
+    return timeout_ms == AUDIO_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+}
+
+// ---- HTTP source ----
+
+static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
+    esp_http_source_t *src = evt->user_data;
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "Connection") == 0 &&
+        strcasecmp(evt->header_value, "close") == 0) {
+        src->server_close = true;
+    }
+    return ESP_OK;
+}
+
+// "https://host:port/path" -> "host:port"
+static void url_host(const char *url, char *out, size_t out_len) {
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    size_t n = strcspn(start, "/?#");
+    if (n >= out_len) n = out_len - 1;
+    memcpy(out, start, n);
+    out[n] = '\0';
+}
+
+static esp_http_client_handle_t http_client_create(esp_http_source_t *src, const char *url) {
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = http_event_handler,
+        .user_data = src,
+        .buffer_size = 8192,
+        .buffer_size_tx = 4096,
+        .timeout_ms = 10000,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        // TCP keepalive so a connection the server or NAT silently dropped
+        // is noticed before the next notification needs it
+        .keep_alive_enable = true,
+        .keep_alive_idle = 30,
+        .keep_alive_interval = 10,
+        .keep_alive_count = 3,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,
+#endif
+    };
+    return esp_http_client_init(&config);
+}
+
+// Sends the request, returning the content length or -1. A kept-alive
+// connection the server has already closed fails either on write or while
+// waiting for headers.
+static int64_t http_request(esp_http_source_t *src) {
+    src->server_close = false;
+    esp_err_t err = esp_http_client_open(src->client, 0);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(err));
+        return -1;
+    }
+    return esp_http_client_fetch_headers(src->client);
+}
+
+static int http_source_open(void *ctx, const char *url) {
+    esp_http_source_t *src = ctx;
+    int64_t t0 = esp_timer_get_time();
+    char host[sizeof(src->host)];
+    url_host(url, host, sizeof(host));
+    bool reused = src->client != NULL && src->connected && strcmp(host, src->host) == 0;
+
+    if (!src->client) {
+        src->client = http_client_create(src, url);
+        if (!src->client) {
+            return -1;
+        }
+    } else {
+        if (!reused) {
+            esp_http_client_close(src->client);
+        }
+        if (esp_http_client_set_url(src->client, url) != ESP_OK) {
+            ESP_LOGE(TAG, "Invalid URL");
+            return -1;
+        }
+    }
+    strcpy(src->host, host);
+
+    src->requests++;
+    int64_t len = http_request(src);
+    if (len < 0 && reused) {
+        ESP_LOGW(TAG, "Kept-alive connection was closed by the server, reconnecting");
+        esp_http_client_close(src->client);
+        src->retries++;
+        reused = false;
+        len = http_request(src);
+    }
+    if (!reused) src->connects++;
+    src->connected = len >= 0;
+    if (len < 0) {
+        ESP_LOGE(TAG, "HTTP request failed");
+        esp_http_client_close(src->client);
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "HTTP %d in %ld ms (%s connection, %lu/%lu requests reused)",
+             esp_http_client_get_status_code(src->client), (long)((esp_timer_get_time() - t0) / 1000),
+             reused ? "kept-alive" : "new", (unsigned long)(src->requests - src->connects),
+             (unsigned long)src->requests);
+    return (int)len;
+}
+
+// Reopens from `offset` on a new connection (the interrupted one cannot be
+// reused) and reports where the server actually started: 206 honours the
+// range, 200 resends the whole body.
+static int http_source_open_range(void *ctx, const char *url, uint32_t offset, uint32_t *start) {
+    esp_http_source_t *src = ctx;
+    if (!src->client) return -1;
+    esp_http_client_close(src->client);
+    src->connected = false;
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)offset);
+    esp_http_client_set_header(src->client, "Range", range);
+    int len = http_source_open(ctx, url);
+    esp_http_client_delete_header(src->client, "Range");
+    if (len < 0) return -1;
+
+    int status = esp_http_client_get_status_code(src->client);
+    if (status != 206 && status != 200) {
+        ESP_LOGW(TAG, "Range request answered with HTTP %d", status);
+        esp_http_client_close(src->client);
+        src->connected = false;
+        return -1;
+    }
+    *start = status == 206 ? offset : 0;
+    return len;
+}
+
+static int http_source_read(void *ctx, uint8_t *buf, int len) {
+    esp_http_source_t *src = ctx;
+    return esp_http_client_read(src->client, (char *)buf, len);
+}
+
+// Keep the connection only if the body was read to the end (otherwise the
+// next response would start mid-stream) and the server did not ask to close.
+static void http_source_close(void *ctx) {
+    esp_http_source_t *src = ctx;
+    if (!src->client) return;
+    if (!src->connected || src->server_close || !esp_http_client_is_complete_data_received(src->client)) {
+        esp_http_client_close(src->client);
+        src->connected = false;
+    }
+}
+
+void esp_http_source_bind(esp_http_source_t *src, audio_source_t *out) {
+    *out = (audio_source_t) {
+        .ctx = src,
+        .open = http_source_open,
+        .read = http_source_read,
+        .close = http_source_close,
+        .open_range = http_source_open_range,
+    };
+}
+
+void esp_http_source_destroy(esp_http_source_t *src) {
+    if (src->client) {
+        esp_http_client_close(src->client);
+        esp_http_client_cleanup(src->client);
+        src->client = NULL;
+    }
+    src->connected = false;
+}
+
+// ---- FreeRTOS no-split ring buffer ----
+//
+// xRingbufferSendAcquire() only works on RINGBUF_TYPE_NOSPLIT buffers and
+// commits the full acquired size, so every slot carries a small prefix with
+// the number of bytes the producer actually filled. A slot marked
+// SLOT_END is the end-of-stream marker from finish().
+
+#define SLOT_END UINT32_MAX
+
+typedef struct {
+    uint32_t used;
+} slot_hdr_t;
+
+static bool rb_acquire(void *ctx, void **slot, size_t len, uint32_t timeout_ms) {
+    void *item;
+    if (xRingbufferSendAcquire((RingbufHandle_t)ctx, &item, sizeof(slot_hdr_t) + len,
+                               ms_to_ticks(timeout_ms)) != pdTRUE) {
+        return false;
+    }
+    *slot = (uint8_t *)item + sizeof(slot_hdr_t);
+    return true;
+}
+
+static void rb_complete(void *ctx, void *slot, size_t used) {
+    slot_hdr_t *hdr = (slot_hdr_t *)((uint8_t *)slot - sizeof(slot_hdr_t));
+    hdr->used = used;
+    xRingbufferSendComplete((RingbufHandle_t)ctx, hdr);
+}
+
+// Copying producers go through the same slots
+static bool rb_send(void *ctx, const void *data, size_t len, uint32_t timeout_ms) {
+    void *slot;
+    if (!rb_acquire(ctx, &slot, len, timeout_ms)) return false;
+    memcpy(slot, data, len);
+    rb_complete(ctx, slot, len);
+    return true;
+}
+
+static void rb_finish(void *ctx) {
+    void *slot;
+    // The writer is draining the ring, so a slot frees up
+    if (rb_acquire(ctx, &slot, 0, AUDIO_WAIT_FOREVER)) {
+        slot_hdr_t *hdr = (slot_hdr_t *)slot - 1;
+        hdr->used = SLOT_END;
+        xRingbufferSendComplete((RingbufHandle_t)ctx, hdr);
+    }
+}
+
+static void *rb_receive(void *ctx, size_t *len, uint32_t timeout_ms) {
+    size_t item_size;
+    slot_hdr_t *hdr = xRingbufferReceive((RingbufHandle_t)ctx, &item_size, ms_to_ticks(timeout_ms));
+    if (!hdr) return NULL;
+    if (hdr->used == SLOT_END) {
+        vRingbufferReturnItem((RingbufHandle_t)ctx, hdr);
+        return NULL;
+    }
+    *len = hdr->used;
+    return hdr + 1;
+}
+
+static void rb_return_item(void *ctx, void *item) {
+    vRingbufferReturnItem((RingbufHandle_t)ctx, (uint8_t *)item - sizeof(slot_hdr_t));
+}
+
+static size_t rb_free_size(void *ctx) {
+    return xRingbufferGetCurFreeSize((RingbufHandle_t)ctx);
+}
+
+void esp_ringbuf_bind(RingbufHandle_t rb, size_t capacity, audio_ring_t *out) {
+    *out = (audio_ring_t) {
+        .ctx = rb,
+        .capacity = capacity,
+        .send = rb_send,
+        .acquire = rb_acquire,
+        .complete = rb_complete,
+        .finish = rb_finish,
+        .receive = rb_receive,
+        .return_item = rb_return_item,
+        .free_size = rb_free_size,
+    };
+}
+
+// ---- I2S sink ----
+
+static int i2s_sink_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    esp_i2s_sink_t *sink = ctx;
+    return i2s_channel_write(sink->tx_handle, buf, len, written, portMAX_DELAY) == ESP_OK ? 0 : -1;
+}
+
+void esp_i2s_sink_bind(esp_i2s_sink_t *sink, audio_sink_t *out) {
+    *out = (audio_sink_t) {
+        .ctx = sink,
+        .write = i2s_sink_write,
+    };
+}
+
+// ---- I2S fader ----
+
+enum { FADER_IDLE, FADER_REQUESTED, FADER_MUTING };
+
+void esp_i2s_fader_init(esp_i2s_fader_t *f, uint32_t desc_num) {
+    memset(f, 0, sizeof(*f));
+    f->desc_num = desc_num < ESP_I2S_FADER_MAX_DESC ? desc_num : ESP_I2S_FADER_MAX_DESC;
+}
+
+static IRAM_ATTR void fade_buffer(int16_t *pcm, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        pcm[i] = (int16_t)((int32_t)pcm[i] * (int32_t)(samples - i) / (int32_t)samples);
+    }
+}
+
+IRAM_ATTR void esp_i2s_fader_on_sent(esp_i2s_fader_t *f, const i2s_event_data_t *event) {
+    // IDF 5.2 passes the address of the descriptor's buffer pointer
+    uint8_t *sent = *(uint8_t **)event->data;
+    uint32_t i = 0;
+    while (i < f->learned && f->bufs[i] != sent) i++;
+    if (i == f->learned) {
+        // The channel starts at the first descriptor on every enable, so
+        // a buffer not seen before always follows the last one mapped
+        if (f->learned == f->desc_num) return;
+        f->bufs[f->learned++] = sent;
+        f->buf_size = event->size;
+    }
+    uint32_t n = f->desc_num;
+    if (f->learned < n) return;
+
+    uint32_t next = (i + 2) % n;
+    if (f->state == FADER_REQUESTED) {
+        // The buffer now playing is heard out; the one after it fades
+        fade_buffer((int16_t *)f->bufs[next], f->buf_size / sizeof(int16_t));
+        f->fade_index = next;
+        memset(f->bufs[(i + 3) % n], 0, f->buf_size);
+        f->state = FADER_MUTING;
+    } else if (f->state == FADER_MUTING) {
+        if (i == f->fade_index) {
+            f->t_silent_us = esp_timer_get_time();
+            f->silent = true;
+        }
+        // Whatever the writer queued after the fade never plays
+        memset(f->bufs[next], 0, f->buf_size);
+    }
+}
+
+bool esp_i2s_fader_fade_out(esp_i2s_fader_t *f) {
+    if (f->learned < f->desc_num || f->buf_size == 0) return false;
+    if (f->state == FADER_IDLE) f->state = FADER_REQUESTED;
+    return true;
+}
+
+bool esp_i2s_fader_active(const esp_i2s_fader_t *f) {
+    return f->state != FADER_IDLE;
+}
+
+int64_t esp_i2s_fader_wait_silent(esp_i2s_fader_t *f, uint32_t timeout_ms) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (!f->silent) {
+        if (esp_timer_get_time() > deadline) return 0;
+        vTaskDelay(1);
+    }
+    return f->t_silent_us;
+}
+
+void esp_i2s_fader_reset(esp_i2s_fader_t *f) {
+    if (f->state != FADER_IDLE) {
+        for (uint32_t i = 0; i < f->learned; i++) memset(f->bufs[i], 0, f->buf_size);
+    }
+    f->state = FADER_IDLE;
+    f->silent = false;
+    f->t_silent_us = 0;
+}
+
+// ---- signal ----
+
+static void sig_give(void *ctx) {
+    xSemaphoreGive(((esp_signal_t *)ctx)->handle);
+}
+
+static bool sig_wait(void *ctx, uint32_t timeout_ms) {
+    return xSemaphoreTake(((esp_signal_t *)ctx)->handle, ms_to_ticks(timeout_ms)) == pdTRUE;
+}
+
+void esp_signal_bind(esp_signal_t *sig, audio_signal_t *out) {
+    sig->handle = xSemaphoreCreateBinaryStatic(&sig->storage);
+    *out = (audio_signal_t) {
+        .ctx = sig,
+        .signal = sig_give,
+        .wait = sig_wait,
+    };
+}
+
+// ---- clock ----
+
+// Anything before this is the clock counting from boot, not SNTP time
+#define CLOCK_SET_AFTER_S 1700000000
+
+static bool clock_now(void *ctx, int64_t *us) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec < CLOCK_SET_AFTER_S) return false;
+    *us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    return true;
+}
+
+void esp_clock_bind(audio_clock_t *out) {
+    *out = (audio_clock_t) {
+        .ctx = NULL,
+        .now = clock_now,
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "esp_http_client.h"
+#include "driver/i2s_std.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
+#include "audio_io.h"
+
+// ESP-IDF backends for the portable audio_pipeline interfaces.
+
+// One long-lived client per source: the connection is kept open between
+// downloads from the same host (HTTP/1.1 keep-alive) and, when it has been
+// dropped, the next connect resumes the cached TLS session instead of doing
+// a full handshake (CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS).
+typedef struct {
+    esp_http_client_handle_t client;
+    bool connected;             // client holds an open connection
+    char host[128];             // host[:port] of that connection
+    bool server_close;          // response carried "Connection: close"
+    uint32_t requests;
+    uint32_t connects;          // requests that needed a new TCP/TLS connection
+    uint32_t retries;           // kept-alive connection found dead, reconnected
+} esp_http_source_t;
+
+typedef struct {
+    i2s_chan_handle_t tx_handle;
+} esp_i2s_sink_t;
+
+// Fades out what the I2S DMA ring is playing within a few buffers, for a
+// clip preempted mid-sentence. A write reaches the speaker only a whole
+// ring later (the DMA cycles through every descriptor), so stopping the
+// writer alone would leave up to a ring of audio playing, and disabling the
+// channel would cut it off with a click. Driven from the on_sent callback,
+// which learns the ring's buffers in play order during the first cycle:
+// once asked, it fades the buffer after the one now playing and zeroes
+// every buffer as it comes up from then on. Mono 16-bit only, like the
+// channel main.c sets up.
+#define ESP_I2S_FADER_MAX_DESC 32
+
+typedef struct {
+    uint8_t *bufs[ESP_I2S_FADER_MAX_DESC];  // in play order
+    uint32_t desc_num;
+    uint32_t learned;           // buffers mapped so far
+    size_t buf_size;
+    volatile int state;
+    uint32_t fade_index;        // the buffer faded
+    volatile int64_t t_silent_us;   // esp_timer time the fade ended
+    volatile bool silent;
+} esp_i2s_fader_t;
+
+// Binary semaphore: signals given while nobody waits collapse into one
+typedef struct {
+    SemaphoreHandle_t handle;
+    StaticSemaphore_t storage;
+} esp_signal_t;
+
+// Binds without touching src->client, so a static source keeps its
+// connection across messages; zero-initialize it once before first use.
+void esp_http_source_bind(esp_http_source_t *src, audio_source_t *out);
+// Drops the connection and frees the client (and the cached TLS session).
+void esp_http_source_destroy(esp_http_source_t *src);
+// The ring the pipeline ran on before audio_spsc.h, kept for ring_bench.h.
+// rb must be RINGBUF_TYPE_NOSPLIT: blocks travel in slots (copied in by
+// send() or filled in place via acquire/complete), and finish() queues an
+// end-of-stream slot.
+void esp_ringbuf_bind(RingbufHandle_t rb, size_t capacity, audio_ring_t *out);
+void esp_i2s_sink_bind(esp_i2s_sink_t *sink, audio_sink_t *out);
+// Creates the semaphore; call once
+void esp_signal_bind(esp_signal_t *sig, audio_signal_t *out);
+
+void esp_i2s_fader_init(esp_i2s_fader_t *f, uint32_t desc_num);
+// From the channel's on_sent callback (ISR), before anything else touches the buffer
+void esp_i2s_fader_on_sent(esp_i2s_fader_t *f, const i2s_event_data_t *event);
+// Any task: starts the fade. False when the ring is not mapped yet (the
+// first cycle after boot); the caller then lets it drain.
+bool esp_i2s_fader_fade_out(esp_i2s_fader_t *f);
+// Whether a fade was started since the last reset
+bool esp_i2s_fader_active(const esp_i2s_fader_t *f);
+// Blocks until a started fade has ended; its esp_timer time, or 0 on timeout
+int64_t esp_i2s_fader_wait_silent(esp_i2s_fader_t *f, uint32_t timeout_ms);
+// With the channel disabled: clears the ring, whose unsent buffers still
+// hold the preempted audio, and ends the fade before the next enable
+void esp_i2s_fader_reset(esp_i2s_fader_t *f);
+
+// The system wall clock, kept to SNTP time; fails until the first sync has
+// set it
+void esp_clock_bind(audio_clock_t *out);
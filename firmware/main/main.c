@@ -1,20 +1,42 @@
-﻿#include <string.h>
+﻿#include <stdio.h>
+#include <string.h>
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "esp_crt_bundle.h"
 #include "mqtt_client.h"
-#include "esp_http_client.h"
-#include "esp_tls.h"
-#include "cJSON.h"
 #include "driver/i2s_std.h"
-#include "freertos/ringbuf.h"
+#include "esp_heap_caps.h"
+#include "audio_cache.h"
+#include "audio_cache_flash.h"
+#include "audio_chime.h"
+#include "audio_dsp.h"
+#include "audio_inline.h"
+#include "audio_pipeline.h"
+#include "audio_prefetch.h"
+#include "audio_queue.h"
+#include "audio_resume.h"
+#include "audio_spsc.h"
+#include "audio_stats.h"
+#include "audio_sync.h"
+#include "audio_trace.h"
+#include "audio_mem.h"
+#include "esp_audio_io.h"
+#include "notify_msg.h"
+#include "chime_flash.h"
+#include "ring_bench.h"
+#include "task_stats.h"
+#include "wifi_cache.h"
 
 static const char *TAG = "REMOTE_ALARM";
 
@@ -25,37 +47,237 @@ static const char *TAG = "REMOTE_ALARM";
 #define MQTT_USER      CONFIG_MQTT_USERNAME
 #define MQTT_PASS      CONFIG_MQTT_PASSWORD
 #define MQTT_TOPIC     CONFIG_MQTT_TOPIC
+#define STATUS_TOPIC   CONFIG_MQTT_STATUS_TOPIC
+#define STATS_TOPIC    CONFIG_MQTT_STATS_TOPIC
+#define GROUP_TOPIC    CONFIG_MQTT_GROUP_TOPIC
+#define SNTP_SERVER    CONFIG_SNTP_SERVER
+// Every message must carry a valid, fresh signature when set (docs/api.md)
+#define HMAC_SECRET    CONFIG_HMAC_SECRET
+#define NOTIFY_MAX_AGE_MS ((int64_t)CONFIG_NOTIFY_MAX_AGE_S * 1000)
 
 // I2S configuration
 #define I2S_BCK_IO     (GPIO_NUM_6)  // Connect to Amp BCLK
 #define I2S_WS_IO      (GPIO_NUM_5)  // Connect to Amp LRC
 #define I2S_DO_IO      (GPIO_NUM_12)  // Connect to Amp DIN
-#define CHUNK_BUFFER_SIZE 4096
+#define I2S_DMA_DESC_NUM 32
+#define I2S_DMA_FRAME_NUM 480
+// The channel runs through cleared DMA buffers once enabled, so a write is
+// heard about one DMA ring later
+#define I2S_OUTPUT_DELAY_US ((int64_t)I2S_DMA_DESC_NUM * I2S_DMA_FRAME_NUM * 1000000 / CONFIG_AUDIO_OUTPUT_SAMPLE_RATE)
+// A power of two (audio_spsc.h)
 #define RINGBUF_SIZE_KB 64
 #define RING_BUFFER_SIZE (RINGBUF_SIZE_KB * 1024)
 
+// Resumed downloads back off from CONFIG_AUDIO_RESUME_BACKOFF_MS up to this
+#define RESUME_MAX_BACKOFF_MS 2000
+// Notifications with a signed URL fit in one data event; inline clip chunks
+// larger than this arrive in several (audio_inline_feed)
+#define MQTT_BUFFER_SIZE 4096
+
+// Silence between the chime and the voice when the message does not say
+#define CHIME_GAP_DEFAULT_MS 2000
+#define CHIME_GAP_MAX_MS     10000
+
+// How often the playback ring's fill is sampled while a clip plays
+#define RING_FILL_SAMPLE_MS 50
+
+// A play_at further ahead than this is a clock gone wrong on one side
+#define PLAY_AT_MAX_LEAD_MS 60000
+
+// A preempted chime's gap is checked this often; the DMA fade takes three
+// buffers at most, waited for with this much margin
+#define PREEMPT_POLL_MS 10
+#define FADE_WAIT_MS    100
+
+#if CONFIG_AUDIO_QUEUE_POLICY_FIFO
+#define AUDIO_QUEUE_POLICY AUDIO_QUEUE_FIFO
+#elif CONFIG_AUDIO_QUEUE_POLICY_DROP_OLDEST
+#define AUDIO_QUEUE_POLICY AUDIO_QUEUE_DROP_OLDEST
+#else
+#define AUDIO_QUEUE_POLICY AUDIO_QUEUE_COALESCE
+#endif
+
+#ifdef CONFIG_AUDIO_CONCEAL
+#define AUDIO_CONCEAL_ENABLED true
+#else
+#define AUDIO_CONCEAL_ENABLED false
+#endif
+
+#ifdef CONFIG_AUDIO_DSP
+#define AUDIO_DSP_ENABLED true
+#else
+#define AUDIO_DSP_ENABLED false
+#endif
+
+#ifdef CONFIG_AUDIO_ZERO_COPY
+#define AUDIO_ZERO_COPY true
+#else
+#define AUDIO_ZERO_COPY false
+#endif
+
+#ifdef CONFIG_AUDIO_SYNC_DRIFT
+#define AUDIO_SYNC_DRIFT_ENABLED true
+#else
+#define AUDIO_SYNC_DRIFT_ENABLED false
+#endif
+
 static EventGroupHandle_t wifi_event_group;
 static i2s_chan_handle_t tx_handle = NULL;
-static RingbufHandle_t audio_rb = NULL;
+// Ring and staging buffers for every message, allocated once at boot
+static audio_mem_pool_t audio_mem;
 static TaskHandle_t i2s_task_handle = NULL;
-static volatile bool audio_download_complete = false;
+static TaskHandle_t chime_task_handle = NULL;
+// Long-lived tasks run on static stacks (bytes) so they never touch the heap
+// Real-time audio on one core, downloads and TLS with the network stack on
+// the other (Kconfig "Task topology")
+#define TASK_CORE(core) ((core) < 0 ? tskNO_AFFINITY : (BaseType_t)(core))
+#define AUDIO_CORE      TASK_CORE(CONFIG_AUDIO_CORE)
+#define DOWNLOAD_CORE   TASK_CORE(CONFIG_AUDIO_DOWNLOAD_CORE)
+
+#define PLAYBACK_STACK_SIZE 8192
+#define I2S_STACK_SIZE      4096
+#define CHIME_STACK_SIZE    3072
+#define STATS_STACK_SIZE    4096
+static StackType_t playback_stack[PLAYBACK_STACK_SIZE];
+static StackType_t i2s_stack[I2S_STACK_SIZE];
+static StackType_t chime_stack[CHIME_STACK_SIZE];
+static StackType_t stats_stack[STATS_STACK_SIZE];
+static StaticTask_t playback_tcb, i2s_tcb, chime_tcb, stats_tcb;
+static StaticSemaphore_t chime_done_buf, playback_done_buf;
+// The message the writer plays next, handed over with a task notification
+static audio_pipeline_t *writer_pipeline;
+// Given by the writer once the message's last sample has left the DMA
+static SemaphoreHandle_t playback_done;
+// DMA buffers still to be sent before the final write is audible, 0 = idle
+static volatile uint32_t drain_countdown;
+// Lives across messages so downloads reuse the connection / TLS session
+static esp_http_source_t http_source;
+// Reopens the download with a Range request when it fails mid-body
+static audio_resume_t http_resume;
+// Short clips received over MQTT, read by the playback worker as they land
+static audio_inline_t inline_clip;
+static esp_signal_t inline_signal;
+// The MQTT message being delivered in fragments is an inline chunk
+static bool mqtt_in_chunk;
+// Decoded clips keyed by message filename (PSRAM, optional flash tier)
+static audio_cache_t audio_cache;
+// SNTP time, for messages scheduled with play_at
+static audio_clock_t shared_clock;
+// Signed messages already acted on; only touched from the MQTT task
+static notify_replay_t replay_guard;
+static audio_sync_t playback_sync;
+static audio_cache_store_t audio_cache_store;
+// Given when the chime and its gap are over and the voice may take the I2S
+// channel; taken by the voice writer (or by the playback task if it never starts)
+static SemaphoreHandle_t chime_done;
+// Notifications waiting for the playback worker (copied into static slots)
+static audio_queue_t playback_queue;
+static audio_msg_t playback_slots[CONFIG_AUDIO_QUEUE_DEPTH];
+static TaskHandle_t playback_task_handle = NULL;
+static esp_mqtt_client_handle_t mqtt_client;
+// Latency spans of the last messages, for percentiles on request
+static audio_trace_window_t trace_window;
+static uint32_t trace_seq;
+// Health snapshots (audio_stats.h), published every CONFIG_AUDIO_STATS_INTERVAL_S
+// and on {"cmd":"stats"}; each counter has one writer
+static TaskHandle_t stats_task_handle = NULL;
+static audio_fill_hist_t ring_fill;
+static volatile uint32_t mqtt_connects, mqtt_disconnects;     // MQTT task
+static volatile uint32_t messages_played, underruns_total;    // playback worker
+// The message being played, for a more urgent one to preempt (playback_lock)
+static audio_lock_t playback_lock;
+static bool playback_active;
+static uint8_t playback_priority;
+static audio_pipeline_t *playback_pipeline;     // once play_message has set it up
+// Set on preemption; the download, chime, gap and writer all stop on it
+static volatile bool playback_preempted;
+// Fades the DMA ring out under a preempted message
+static esp_i2s_fader_t i2s_fader;
+// Head of the next queued message, fetched while the current one plays out
+static audio_prefetch_t prefetch;
+static audio_msg_t prefetch_msg;
+// The prefetched message can follow the current clip in the DMA queue; read
+// by the writer once its clip is written
+static volatile bool handover_ready;
+// The writer kept the channel enabled for the next clip; set before it
+// gives playback_done, cleared by the worker
+static volatile bool writer_held;
 
 #define WIFI_CONNECTED_BIT BIT0
 
+// Boot milestones, esp_timer microseconds; logged once MQTT is subscribed
+typedef struct {
+    int64_t app_main_us;
+    int64_t wifi_start_us;
+    int64_t associated_us;
+    int64_t got_ip_us;
+    int64_t audio_ready_us;     // memory, I2S and tasks up, while associating
+    int64_t mqtt_ready_us;
+    bool cached_ap;             // joined the AP from the NVS cache, no full scan
+} boot_times_t;
+
+static boot_times_t boot_times;
+// Connecting to the cached AP until it is joined or fails once
+static bool wifi_using_cache;
+
+static void log_boot_times(void) {
+    const boot_times_t *b = &boot_times;
+    ESP_LOGI(TAG, "Boot to ready in %lld ms: app_main %lld, Wi-Fi start %lld, associated %lld (%s), IP %lld, "
+             "audio ready %lld, MQTT subscribed %lld", (long long)(b->mqtt_ready_us / 1000),
+             (long long)(b->app_main_us / 1000), (long long)(b->wifi_start_us / 1000),
+             (long long)(b->associated_us / 1000), b->cached_ap ? "cached AP" : "scanned",
+             (long long)(b->got_ip_us / 1000), (long long)(b->audio_ready_us / 1000),
+             (long long)(b->mqtt_ready_us / 1000));
+}
+
+// The AP just joined, for the next boot
+static void wifi_remember_ap(void) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+    wifi_cache_t cache = { .channel = ap.primary };
+    snprintf(cache.ssid, sizeof(cache.ssid), "%s", WIFI_SSID);
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    wifi_cache_save(&cache);
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data) {
+    int64_t now = esp_timer_get_time();
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        boot_times.wifi_start_us = now;
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        if (!boot_times.associated_us) {
+            boot_times.associated_us = now;
+            boot_times.cached_ap = wifi_using_cache;
+        }
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (wifi_using_cache) {
+            // Moved, switched off or replaced: forget it and scan as usual
+            ESP_LOGI(TAG, "Cached AP not joined, scanning");
+            wifi_using_cache = false;
+            wifi_cache_clear();
+            wifi_config_t wifi_config;
+            esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+            wifi_config.sta.bssid_set = false;
+            wifi_config.sta.channel = 0;
+            esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        }
         esp_wifi_connect();
         ESP_LOGI(TAG, "Retrying WiFi connection...");
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        if (!boot_times.got_ip_us) boot_times.got_ip_us = now;
+        // Joined: a later disconnect (AP reboot, signal) is not a stale cache
+        wifi_using_cache = false;
+        wifi_remember_ap();
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
 
+// Starts association and returns; WIFI_CONNECTED_BIT is set on the IP.
+// A cached AP is joined on its channel and BSSID without a full scan.
 static void wifi_init(void) {
     wifi_event_group = xEventGroupCreate();
     ESP_ERROR_CHECK(esp_netif_init());
@@ -84,24 +306,54 @@ static void wifi_init(void) {
             .password = WIFI_PASS,
         },
     };
+    wifi_cache_t cache;
+    if (wifi_cache_load(&cache) && strcmp(cache.ssid, WIFI_SSID) == 0) {
+        wifi_config.sta.channel = cache.channel;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+        wifi_using_cache = true;
+        ESP_LOGI(TAG, "Joining cached AP on channel %u", cache.channel);
+    }
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+}
 
-    xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
-    ESP_LOGI(TAG, "WiFi connected");
+static void time_sync_cb(struct timeval *tv) {
+    ESP_LOGI(TAG, "SNTP sync: %lld.%06ld", (long long)tv->tv_sec, (long)tv->tv_usec);
+}
+
+// Runs in the background; scheduled messages play on arrival until the
+// first sync. Later syncs slew the clock rather than step it, so a clip
+// being kept in step never sees a jump.
+static void shared_clock_init(void) {
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER);
+    cfg.smooth_sync = true;
+    cfg.sync_cb = time_sync_cb;
+    if (esp_netif_sntp_init(&cfg) != ESP_OK) ESP_LOGW(TAG, "SNTP not started, play_at ignored");
+    esp_clock_bind(&shared_clock);
+}
+
+// Once the writer queues its last bytes, at most every DMA buffer still holds
+// unsent audio; when the last of them has been sent the clip is over.
+static IRAM_ATTR bool i2s_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    esp_i2s_fader_on_sent(&i2s_fader, event);
+    if (drain_countdown == 0 || --drain_countdown > 0) return false;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(i2s_task_handle, &woken);
+    return woken == pdTRUE;
 }
 
 static void i2s_init(void) {
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
-    chan_cfg.dma_desc_num = 32;
-    chan_cfg.dma_frame_num = 480;
+    chan_cfg.dma_desc_num = I2S_DMA_DESC_NUM;
+    chan_cfg.dma_frame_num = I2S_DMA_FRAME_NUM;
     chan_cfg.auto_clear = true;
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle, NULL));
 
-    // Initial config with default 16kHz - will be reconfigured when playing audio
+    // One format for the device's lifetime; clips and chimes are resampled to it
     i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(16000),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(CONFIG_AUDIO_OUTPUT_SAMPLE_RATE),
         .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,
@@ -117,266 +369,745 @@ static void i2s_init(void) {
         },
     };
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle, &std_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
+    // Callbacks can only be registered while the channel is disabled; it is
+    // enabled only while something plays, so idle DMA raises no interrupts
+    esp_i2s_fader_init(&i2s_fader, I2S_DMA_DESC_NUM);
+    i2s_event_callbacks_t cbs = { .on_sent = i2s_on_sent };
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(tx_handle, &cbs, NULL));
     ESP_LOGI(TAG, "I2S initialized");
 }
 
-static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
-    return ESP_OK;
+#ifdef CONFIG_AUDIO_DSP
+// Speaker chain from Kconfig, at the fixed I2S rate
+static void dsp_init(void) {
+    audio_dsp_config_t cfg = {
+        .gain_db = CONFIG_AUDIO_DSP_GAIN_DB,
+        .limit_dbfs = CONFIG_AUDIO_DSP_LIMIT_DBFS,
+        .release_ms = CONFIG_AUDIO_DSP_RELEASE_MS,
+    };
+    if (CONFIG_AUDIO_DSP_HIGHPASS_HZ > 0) {
+        // 4th-order Butterworth as two sections
+        cfg.bands[cfg.num_bands++] = (audio_eq_band_t) { AUDIO_EQ_HIGHPASS, CONFIG_AUDIO_DSP_HIGHPASS_HZ, 0.54f, 0 };
+        cfg.bands[cfg.num_bands++] = (audio_eq_band_t) { AUDIO_EQ_HIGHPASS, CONFIG_AUDIO_DSP_HIGHPASS_HZ, 1.31f, 0 };
+    }
+    if (CONFIG_AUDIO_DSP_PRESENCE_DB != 0) {
+        cfg.bands[cfg.num_bands++] = (audio_eq_band_t) {
+            AUDIO_EQ_PEAK, CONFIG_AUDIO_DSP_PRESENCE_HZ, 1.0f, CONFIG_AUDIO_DSP_PRESENCE_DB
+        };
+    }
+    if (audio_dsp_init(audio_mem.writer_dsp, &cfg, CONFIG_AUDIO_OUTPUT_SAMPLE_RATE) != AUDIO_OK) {
+        ESP_LOGW(TAG, "Speaker EQ not realizable at %d Hz, gain and limiter only", CONFIG_AUDIO_OUTPUT_SAMPLE_RATE);
+        cfg.num_bands = 0;
+        audio_dsp_init(audio_mem.writer_dsp, &cfg, CONFIG_AUDIO_OUTPUT_SAMPLE_RATE);
+    }
+    audio_dsp_init(audio_mem.chime_dsp, &cfg, CONFIG_AUDIO_OUTPUT_SAMPLE_RATE);
+    ESP_LOGI(TAG, "DSP: %+d dB, limit %d dBFS, %u EQ bands", CONFIG_AUDIO_DSP_GAIN_DB, CONFIG_AUDIO_DSP_LIMIT_DBFS,
+             (unsigned)cfg.num_bands);
 }
+#endif
 
+// I2S sink, behind the DSP chain when it is enabled
+static void bind_output(esp_i2s_sink_t *i2s_sink, audio_dsp_t *dsp, audio_sink_t *out) {
+    audio_sink_t i2s_out;
+    esp_i2s_sink_bind(i2s_sink, &i2s_out);
+    if (AUDIO_DSP_ENABLED) {
+        audio_dsp_sink_bind(dsp, &i2s_out, out);
+    } else {
+        *out = i2s_out;
+    }
+}
+
+// Waits until everything queued for DMA has been sent; esp_timer time then
+static int64_t i2s_drain(void) {
+    // One buffer period per descriptor at most; the timeout only guards
+    // against a driver that stops reporting
+    int64_t t0 = esp_timer_get_time();
+    drain_countdown = I2S_DMA_DESC_NUM;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)) == 0) {
+        drain_countdown = 0;
+        ESP_LOGW(TAG, "I2S drain not reported, stopping anyway");
+    }
+    int64_t t = esp_timer_get_time();
+    ESP_LOGI(TAG, "I2S drained in %lld ms", (long long)((t - t0) / 1000));
+    return t;
+}
+
+// Lives for the device's lifetime and sleeps on its notification between
+// messages instead of being created for each one. Notified with no
+// pipeline, it ends a handover the next clip did not take.
 static void i2s_write_task(void *pvParameters) {
-    size_t item_size;
-    size_t bytes_written;
-    
-    ESP_LOGI(TAG, "I2S writer task started");
-    while (1) {
-        // Receive data from ring buffer
-        void *item = xRingbufferReceive(audio_rb, &item_size, pdMS_TO_TICKS(100));
-        if (item) {
-            i2s_channel_write(tx_handle, item, item_size, &bytes_written, portMAX_DELAY);
-            vRingbufferReturnItem(audio_rb, item);
-        } else if (audio_download_complete) {
-            // Buffer empty and download finished - double check one last time with 0-wait
-            void *last_check = xRingbufferReceive(audio_rb, &item_size, 0);
-            if (!last_check) break;
-            i2s_channel_write(tx_handle, last_check, item_size, &bytes_written, portMAX_DELAY);
-            vRingbufferReturnItem(audio_rb, last_check);
+    esp_i2s_sink_t i2s_sink = { .tx_handle = tx_handle };
+    audio_sink_t sink;
+    bind_output(&i2s_sink, audio_mem.writer_dsp, &sink);
+    bool held = false;          // channel left running for the next clip
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        audio_pipeline_t *p = writer_pipeline;
+        if (!p) {
+            i2s_drain();
+            i2s_channel_disable(tx_handle);
+            held = false;
+            xSemaphoreGive(playback_done);
+            continue;
         }
+
+        // A chime owns the channel until it and the gap have played out
+        xSemaphoreTake(chime_done, portMAX_DELAY);
+        if (!held) {
+            esp_i2s_fader_reset(&i2s_fader);
+            ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
+        }
+        held = false;
+
+        ESP_LOGI(TAG, "I2S writer started");
+        audio_pipeline_write_loop(p, &sink);
+        if (AUDIO_DSP_ENABLED) audio_dsp_sink_finish(audio_mem.writer_dsp);
+
+        if (p->cancelled && esp_i2s_fader_active(&i2s_fader)) {
+            // Preempted: what the DMA still holds is faded, not drained
+            int64_t t_silent = esp_i2s_fader_wait_silent(&i2s_fader, FADE_WAIT_MS);
+            p->stats.t_played_us = t_silent ? t_silent : esp_timer_get_time();
+        } else if (handover_ready && !p->cancelled && p->stats.bytes_written > 0) {
+            // The next clip is already buffered: it follows this one in the
+            // DMA queue, whose full ring is still to be heard
+            p->stats.t_played_us = esp_timer_get_time() + I2S_OUTPUT_DELAY_US;
+            held = true;
+            ESP_LOGI(TAG, "I2S kept running for the next message");
+        } else if (p->stats.bytes_written > 0) {
+            p->stats.t_played_us = i2s_drain();
+        }
+        if (!held) i2s_channel_disable(tx_handle);
+        writer_held = held;
+        xSemaphoreGive(playback_done);
     }
-    
-    ESP_LOGI(TAG, "I2S writer task finishing (waiting for DMA to drain)...");
-    
-    // Give enough time for the final ~1s of audio in the DMA buffer to clear
-    vTaskDelay(pdMS_TO_TICKS(1200));
+}
 
-    i2s_channel_disable(tx_handle);
-    i2s_task_handle = NULL;
-    vTaskDelete(NULL);
+static bool start_i2s_writer(audio_pipeline_t *p) {
+    writer_pipeline = p;
+    xTaskNotifyGive(i2s_task_handle);
+    return true;
 }
 
-static void audio_playback_task(void *pvParameters) {
-    char *url = (char *)pvParameters;
-    audio_download_complete = false;
+typedef struct {
+    audio_chime_t chime;
+    uint32_t gap_ms;
+    int64_t play_at_us;         // shared-clock start, 0 = now
+} chime_request_t;
 
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .buffer_size = 8192,
-        .buffer_size_tx = 4096,
-        .timeout_ms = 10000,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-
-    esp_err_t err = esp_http_client_open(client, 0);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection: %s", esp_err_to_name(err));
-        esp_http_client_cleanup(client);
-        free(url);
-        vTaskDelete(NULL);
-        return;
+static chime_request_t chime_request;
+
+// Chime writes fail once its message is preempted, which ends audio_chime_play()
+static int chime_sink_write(void *ctx, const void *buf, size_t len, size_t *written) {
+    const audio_sink_t *next = ctx;
+    if (playback_preempted) return -1;
+    return next->write(next->ctx, buf, len, written);
+}
+
+// Plays the chime straight from the mapped partition while the voice clip
+// downloads, then keeps the channel through the gap. Sleeps on its
+// notification between messages.
+static void chime_task(void *pvParameters) {
+    chime_request_t *req = &chime_request;
+    esp_i2s_sink_t i2s_sink = { .tx_handle = tx_handle };
+    audio_sink_t out;
+    bind_output(&i2s_sink, audio_mem.chime_dsp, &out);
+    audio_sink_t sink = { .ctx = &out, .write = chime_sink_write };
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (req->play_at_us) {
+            audio_sync_wait_until(&shared_clock, req->play_at_us - I2S_OUTPUT_DELAY_US, &playback_preempted);
+        }
+        if (playback_preempted) {
+            xSemaphoreGive(chime_done);
+            continue;
+        }
+        esp_i2s_fader_reset(&i2s_fader);
+        ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
+        int64_t t0 = esp_timer_get_time();
+        if (audio_chime_play(&req->chime, &sink, audio_mem.chime_resampler, CONFIG_AUDIO_OUTPUT_SAMPLE_RATE) ==
+            AUDIO_ERR_FORMAT) {
+            ESP_LOGW(TAG, "Chime at %lu Hz cannot be played at %d Hz", (unsigned long)req->chime.sample_rate,
+                     CONFIG_AUDIO_OUTPUT_SAMPLE_RATE);
+        }
+        if (AUDIO_DSP_ENABLED) audio_dsp_sink_finish(audio_mem.chime_dsp);
+
+        // Writes return once the tail is queued for DMA, so time the gap from
+        // the chime's audible end rather than from here. A preemption cuts
+        // it short once the fader has silenced the chime.
+        int64_t gap_end = t0 + audio_chime_duration_us(&req->chime) + (int64_t)req->gap_ms * 1000;
+        while (!playback_preempted && esp_timer_get_time() < gap_end) vTaskDelay(pdMS_TO_TICKS(PREEMPT_POLL_MS));
+        if (playback_preempted && esp_i2s_fader_active(&i2s_fader)) {
+            esp_i2s_fader_wait_silent(&i2s_fader, FADE_WAIT_MS);
+        }
+        i2s_channel_disable(tx_handle);
+
+        xSemaphoreGive(chime_done);
+    }
+}
+
+static bool start_chime(const audio_msg_t *msg, int64_t play_at_us) {
+    if (msg->chime == 0) return false;
+    if (chime_flash_get(msg->chime, &chime_request.chime) != ESP_OK) {
+        ESP_LOGW(TAG, "Chime %u not available, playing the message only", msg->chime);
+        return false;
     }
+    chime_request.gap_ms = msg->gap_ms;
+    chime_request.play_at_us = play_at_us;
+    xTaskNotifyGive(chime_task_handle);
+    return true;
+}
 
-    int content_length = esp_http_client_fetch_headers(client);
-    ESP_LOGI(TAG, "Streaming audio (%d bytes)...", content_length);
+typedef struct {
+    audio_cache_entry_t *entry;
+    bool failed;
+} cache_capture_t;
 
-    // Initial read for WAV header
-    uint8_t header[44];
-    int r = esp_http_client_read(client, (char*)header, 44);
-    if (r != 44) {
-        ESP_LOGE(TAG, "Failed to read WAV header");
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        free(url);
-        vTaskDelete(NULL);
-        return;
+static void cache_capture_write(void *ctx, const void *pcm, size_t len) {
+    cache_capture_t *cap = ctx;
+    if (!audio_cache_append(cap->entry, pcm, len)) cap->failed = true;
+}
+
+static void *cache_alloc(size_t size) {
+    // PSRAM when present; heap_caps memory is released with free()
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    return p ? p : malloc(size);
+}
+
+// Audio a failed message pushed before its writer started would otherwise
+// be played by the next one
+static void ring_drain(const audio_ring_t *ring) {
+    size_t len;
+    void *item;
+    while ((item = ring->receive(ring->ctx, &len, 0)) != NULL) {
+        ring->return_item(ring->ctx, item);
     }
+}
 
-    uint16_t num_channels = header[22] | (header[23] << 8);
-    uint32_t sample_rate = header[24] | (header[25] << 8) | (header[26] << 16) | (header[27] << 24);
-    uint16_t bits_per_sample = header[34] | (header[35] << 8);
-    
-    ESP_LOGI(TAG, "WAV: %lu Hz, %u channels, %u bits", (unsigned long)sample_rate, (unsigned)num_channels, (unsigned)bits_per_sample);
-
-    // Validate supported formats: 16/32-bit, 1/2 channels
-    if ((bits_per_sample != 16 && bits_per_sample != 32) || (num_channels != 1 && num_channels != 2)) {
-        ESP_LOGE(TAG, "Unsupported WAV format: %u-bit, %u channels (Only 16/32-bit, 1/2 channels supported)", bits_per_sample, num_channels);
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        free(url);
-        vTaskDelete(NULL);
+// Queued to the status topic rather than published, so the worker never
+// waits on the network
+static void publish_status(const char *json, int len) {
+    if (mqtt_client) esp_mqtt_client_enqueue(mqtt_client, STATUS_TOPIC, json, len, 0, 0, true);
+}
+
+static void publish_trace(const audio_msg_t *msg, const audio_pipeline_t *pipeline, bool cached, bool ok) {
+    static audio_trace_t trace;
+    static char json[AUDIO_TRACE_JSON_MAX];
+    memset(&trace, 0, sizeof(trace));
+    trace.seq = ++trace_seq;
+    strcpy(trace.filename, msg->filename);
+    trace.cached = cached;
+    trace.ok = ok;
+    audio_trace_from_stats(&trace, msg->t_received_us, &pipeline->stats);
+    audio_trace_window_add(&trace_window, &trace);
+    int len = audio_trace_format(&trace, json, sizeof(json));
+    if (len > 0) {
+        ESP_LOGI(TAG, "Trace: %s", json);
+        publish_status(json, len);
+    }
+}
+
+// Makes `p` the pipeline a preemption cancels, NULL once it is done with;
+// one preempted before it got here is cancelled at once
+static void playback_attach(audio_pipeline_t *p) {
+    audio_lock(&playback_lock);
+    playback_pipeline = p;
+    if (p && playback_preempted) audio_pipeline_cancel(p);
+    audio_unlock(&playback_lock);
+}
+
+// Closes the message's source once; its connection may already have gone
+// to the next message's prefetch
+static void release_source(audio_pipeline_t *p) {
+    if (p->source.close) p->source.close(p->source.ctx);
+    p->source.close = NULL;
+}
+
+// Ends a handover the next clip will not take: the writer plays out what
+// the DMA still holds and stops the channel
+static void release_channel(void) {
+    if (!writer_held) return;
+    writer_held = false;
+    writer_pipeline = NULL;
+    xTaskNotifyGive(i2s_task_handle);
+    xSemaphoreTake(playback_done, portMAX_DELAY);
+}
+
+static void end_playback(const audio_msg_t *msg, audio_pipeline_t *pipeline, audio_cache_entry_t *cached,
+                         bool ok) {
+    playback_attach(NULL);
+    release_source(pipeline);
+    // Without a writer nobody else waits for the chime, whose request the
+    // next message would overwrite, or takes over a channel left running
+    if (!pipeline->player_started) {
+        xSemaphoreTake(chime_done, portMAX_DELAY);
+        release_channel();
+    }
+    ring_drain(&pipeline->ring);
+    if (cached) audio_cache_release(&audio_cache, cached);
+    const audio_pipeline_stats_t *st = &pipeline->stats;
+    if (st->t_cancel_us) {
+        // Cancelled as the urgent message arrived
+        ESP_LOGI(TAG, "Preempted: silent after %lld ms, worker free after %lld ms, %lu bytes discarded",
+                 (long long)(st->t_played_us ? (st->t_played_us - st->t_cancel_us) / 1000 : 0),
+                 (long long)((esp_timer_get_time() - st->t_cancel_us) / 1000), (unsigned long)st->bytes_discarded);
+    }
+    messages_played++;
+    underruns_total += st->underruns;
+    publish_trace(msg, pipeline, cached != NULL, ok);
+}
+
+// Resume only while the message's signed URL is still valid
+static void bind_http(const audio_msg_t *msg, const volatile bool *cancelled, audio_source_t *out) {
+    audio_resume_config_t resume_cfg = {
+        .max_retries = CONFIG_AUDIO_RESUME_RETRIES,
+        .backoff_ms = CONFIG_AUDIO_RESUME_BACKOFF_MS,
+        .max_backoff_ms = RESUME_MAX_BACKOFF_MS,
+        .deadline_us = msg->t_received_us + (int64_t)CONFIG_AUDIO_URL_TTL_S * 1000000,
+        .cancelled = cancelled,
+    };
+    audio_source_t http;
+    esp_http_source_bind(&http_source, &http);
+    audio_resume_bind(&http_resume, &http, &resume_cfg, out);
+}
+
+// While `current` plays out, fetches the head of the message queued behind
+// it over the connection its download is done with, one read at a time
+// until the writer has finished or the budget is full
+static void prefetch_next(audio_pipeline_t *current, const audio_msg_t *msg) {
+    // Also ends a prefetch `current` was played from, before prefetch_msg changes
+    release_source(current);
+    if (!audio_mem.prefetch_buffer || !audio_queue_peek(&playback_queue, &prefetch_msg)) return;
+    // Played without the network, or the clip this one is caching
+    const char *name = prefetch_msg.filename;
+    if (!prefetch_msg.url[0] || prefetch_msg.inline_id ||
+        (name[0] && (strcmp(name, msg->filename) == 0 || audio_cache_contains(&audio_cache, name)))) {
         return;
     }
+    // Reconnects stop on a preemption of this message or, later, the next
+    audio_source_t http;
+    bind_http(&prefetch_msg, &playback_preempted, &http);
+    if (audio_prefetch_start(&prefetch, &http, prefetch_msg.url) < 0) {
+        ESP_LOGW(TAG, "Prefetch failed, the next message downloads in turn");
+        return;
+    }
+    // A chime or a play_at needs the channel stopped in between
+    handover_ready = !prefetch_msg.chime && !prefetch_msg.play_at_us;
+    while (!playback_preempted && uxSemaphoreGetCount(playback_done) == 0 && audio_prefetch_fill(&prefetch) > 0) {
+    }
+    ESP_LOGI(TAG, "Prefetched %u bytes of %s in %lld ms", (unsigned)prefetch.len, name[0] ? name : "the next message",
+             (long long)(prefetch.busy_us / 1000));
+}
+
+// The message's group start, or 0 once the group is too far into the clip
+// to join: it may have waited in the queue well past play_at
+static int64_t group_start_us(const audio_msg_t *msg) {
+    int64_t now_us;
+    if (!msg->play_at_us || !shared_clock.now(shared_clock.ctx, &now_us)) return msg->play_at_us;
+    if (now_us - msg->play_at_us <= AUDIO_SYNC_MAX_LATE_US) return msg->play_at_us;
+    ESP_LOGW(TAG, "play_at %lld ms past when dequeued, playing unsynchronized",
+             (long long)((now_us - msg->play_at_us) / 1000));
+    return 0;
+}
 
-    // Disable channel before reconfiguring (ignore state errors)
-    esp_err_t dis_err = i2s_channel_disable(tx_handle);
-    if (dis_err != ESP_OK && dis_err != ESP_ERR_INVALID_STATE) {
-        ESP_LOGE(TAG, "Unexpected I2S disable error: %s", esp_err_to_name(dis_err));
+static void play_message(const audio_msg_t *msg) {
+    audio_pipeline_t pipeline = {
+        .start_playback = start_i2s_writer,
+        .zero_copy = AUDIO_ZERO_COPY,
+        .chunk_buffer = audio_mem.chunk_buffer,
+        .mono_buffer = audio_mem.mono_buffer,
+        .sink_sample_rate = CONFIG_AUDIO_OUTPUT_SAMPLE_RATE,
+        .resampler = audio_mem.writer_resampler,
+        .conceal = AUDIO_CONCEAL_ENABLED ? audio_mem.conceal : NULL,
+    };
+    audio_spsc_bind(audio_mem.ring, &pipeline.ring);
+
+    // Its head was fetched while the previous message played out, and then
+    // it follows that clip in the DMA queue; otherwise the channel stops first
+    bool prefetched = prefetch.opened && prefetch_msg.id == msg->id;
+    if (!prefetched) {
+        audio_prefetch_abandon(&prefetch);
+        release_channel();
     }
 
-    // Reconfigure I2S
-    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate);
-    ESP_ERROR_CHECK(i2s_channel_reconfig_std_clock(tx_handle, &clk_cfg));
-    i2s_data_bit_width_t bit_width = (bits_per_sample == 16) ? I2S_DATA_BIT_WIDTH_16BIT : I2S_DATA_BIT_WIDTH_32BIT;
-    i2s_std_slot_config_t slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bit_width, I2S_SLOT_MODE_MONO);
-    ESP_ERROR_CHECK(i2s_channel_reconfig_std_slot(tx_handle, &slot_cfg));
+    // The chime is heard right away; the voice clip is fetched meanwhile
+    int64_t play_at_us = group_start_us(msg);
+    bool chimed = start_chime(msg, play_at_us);
+    if (!chimed) xSemaphoreGive(chime_done);
+
+    // Scheduled with the group: the voice starts after the chime and gap
+    // as timed on the shared clock, wherever the download is by then
+    if (play_at_us) {
+        int64_t voice_at = play_at_us;
+        if (chimed) voice_at += audio_chime_duration_us(&chime_request.chime) + (int64_t)msg->gap_ms * 1000;
+        audio_sync_init(&playback_sync, &shared_clock, voice_at, AUDIO_SYNC_DRIFT_ENABLED);
+        playback_sync.output_delay_us = I2S_OUTPUT_DELAY_US;
+        pipeline.sync = &playback_sync;
+    }
+    // From here a more urgent message cancels this one
+    playback_attach(&pipeline);
 
-    // Create ring buffer (use a slightly larger buffer for better jitter tolerance)
-    audio_rb = xRingbufferCreate(RING_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
-    if (!audio_rb) {
-        ESP_LOGE(TAG, "Failed to create audio ring buffer!");
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        free(url);
-        vTaskDelete(NULL);
+    // A clip heard before plays from the cache without touching the network
+    // then a clip sent inline, and the signed URL when it was not or was lost
+    audio_cache_source_t cache_source;
+    audio_cache_entry_t *cached =
+        !prefetched && msg->filename[0] ? audio_cache_acquire(&audio_cache, msg->filename) : NULL;
+    bool inlined = false;
+    if (prefetched) {
+        audio_prefetch_bind(&prefetch, &pipeline.source);
+        pipeline.prefetch_us = prefetch.busy_us;
+    } else if (cached) {
+        ESP_LOGI(TAG, "Cache hit for %s", msg->filename);
+        audio_cache_source_bind(&cache_source, cached, &pipeline.source);
+    } else if (msg->inline_id && audio_inline_claim(&inline_clip, msg->inline_id, &pipeline.source)) {
+        inlined = true;
+    } else if (!msg->url[0]) {
+        ESP_LOGW(TAG, "Inline clip lost and no URL to fall back on");
+        end_playback(msg, &pipeline, NULL, false);
         return;
+    } else {
+        bind_http(msg, &pipeline.cancelled, &pipeline.source);
     }
 
-    // Wait until we have enough data to start playback (Jitter Buffer)
-    const int start_threshold = RING_BUFFER_SIZE / 2; // Start at 50% full
-    char *chunk_buffer = malloc(CHUNK_BUFFER_SIZE);
-    char *mono_buffer = malloc(CHUNK_BUFFER_SIZE);
-    if (!chunk_buffer || !mono_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate audio buffers!");
-        vRingbufferDelete(audio_rb);
-        audio_rb = NULL;
-        free(chunk_buffer);
-        free(mono_buffer);
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        free(url);
-        vTaskDelete(NULL);
+    if (audio_pipeline_open(&pipeline, msg->url) != AUDIO_OK || audio_pipeline_init(&pipeline) != AUDIO_OK) {
+        end_playback(msg, &pipeline, cached, false);
         return;
     }
-    int sample_size = bits_per_sample / 8;
-    int bytes_processed = 44;
-    bool player_started = false;
-    int bytes_in_chunk = 0;
-    int frame_size = sample_size * num_channels;
 
-    ESP_LOGI(TAG, "Buffering...");
+    // Downloads are captured into the cache as they play
+    cache_capture_t capture = { 0 };
+    size_t pcm_bytes = audio_pipeline_output_bytes(&pipeline);
+    if (!cached && msg->filename[0] && pcm_bytes > 0) {
+        capture.entry = audio_cache_begin(&audio_cache, msg->filename, pipeline.out_sample_rate,
+                                          pipeline.out_bits_per_sample, pcm_bytes);
+        if (capture.entry) {
+            pipeline.tap = (audio_pcm_tap_t) { .ctx = &capture, .write = cache_capture_write };
+        }
+    }
 
-    while (1) {
-        int read_len = esp_http_client_read(client, chunk_buffer + bytes_in_chunk, CHUNK_BUFFER_SIZE - bytes_in_chunk);
-        if (read_len <= 0) break;
-
-        int total_len = read_len + bytes_in_chunk;
-        int frames = total_len / frame_size;
-        int bytes_to_process = frames * frame_size;
-
-        if (frames > 0) {
-            size_t push_len = 0;
-            if (num_channels == 2) {
-                if (bits_per_sample == 16) {
-                    int16_t *src = (int16_t *)chunk_buffer;
-                    int16_t *dst = (int16_t *)mono_buffer;
-                    for (int i = 0; i < frames; i++) {
-                        dst[i] = src[i * 2];
-                    }
-                } else if (bits_per_sample == 32) {
-                    int32_t *src = (int32_t *)chunk_buffer;
-                    int32_t *dst = (int32_t *)mono_buffer;
-                    for (int i = 0; i < frames; i++) {
-                        dst[i] = src[i * 2];
-                    }
-                }
-                push_len = frames * sample_size;
-                xRingbufferSend(audio_rb, mono_buffer, push_len, portMAX_DELAY);
-            } else {
-                push_len = bytes_to_process;
-                xRingbufferSend(audio_rb, chunk_buffer, bytes_to_process, portMAX_DELAY);
-            }
-            bytes_processed += bytes_to_process;
+    int ret = audio_pipeline_download(&pipeline);
 
-            // Slide leftover bytes to the start of the buffer
-            bytes_in_chunk = total_len - bytes_to_process;
-            if (bytes_in_chunk > 0) {
-                memmove(chunk_buffer, chunk_buffer + bytes_to_process, bytes_in_chunk);
-            }
+    ESP_LOGI(TAG, "Download complete (%d bytes), waiting for playback to finish...", pipeline.stats.bytes_processed);
+    if (inlined) {
+        audio_inline_stats_t is = audio_inline_stats(&inline_clip);
+        ESP_LOGI(TAG, "Inline: %lu chunks, first after %lld ms, complete after %lld ms, %lu duplicates",
+                 (unsigned long)is.chunks, (long long)((is.t_first_chunk_us - is.t_begin_us) / 1000),
+                 (long long)(is.t_complete_us ? (is.t_complete_us - is.t_begin_us) / 1000 : -1),
+                 (unsigned long)is.duplicates);
+    } else if (!cached && http_resume.retries) {
+        ESP_LOGI(TAG, "Resumed %lu times in %lu attempts, %lu ms reconnecting, %lu bytes re-sent",
+                 (unsigned long)http_resume.resumes, (unsigned long)http_resume.retries,
+                 (unsigned long)http_resume.stalled_ms, (unsigned long)http_resume.skipped);
+    }
+
+    if (ret == AUDIO_OK) prefetch_next(&pipeline, msg);
+    // The writer gives this once the last sample has been heard, or queued
+    // ahead of the next clip
+    if (pipeline.player_started) xSemaphoreTake(playback_done, portMAX_DELAY);
+    handover_ready = false;
+    if (pipeline.sync) {
+        const audio_sync_stats_t *ss = &playback_sync.stats;
+        ESP_LOGI(TAG, "Sync: started %+lld us from play_at, %lu frames skipped, %ld slipped in %lu corrections, "
+                 "max error %ld us", (long long)ss->start_error_us, (unsigned long)ss->skipped_frames,
+                 (long)ss->slipped_frames, (unsigned long)ss->corrections, (long)ss->max_error_us);
+    }
+
+    audio_pipeline_deinit(&pipeline);
+
+    if (capture.entry) {
+        if (ret == AUDIO_OK && !capture.failed) {
+            audio_cache_commit(&audio_cache, capture.entry);
         } else {
-            bytes_in_chunk = total_len; // Just keep the partial frame for next read
+            audio_cache_abort(&audio_cache, capture.entry);
         }
+        // Flash writes stall both cores, so persist only once playback is
+        // over, not while the DMA runs into the next clip
+        if (!writer_held) audio_cache_flush(&audio_cache);
+    }
+    audio_cache_counters_t cc = audio_cache_counters(&audio_cache);
+    ESP_LOGI(TAG, "Cache: %lu hits, %lu flash hits, %lu misses, %lu evictions, %lu rejects",
+             (unsigned long)cc.hits, (unsigned long)cc.store_hits, (unsigned long)cc.misses,
+             (unsigned long)cc.evictions, (unsigned long)cc.rejects);
 
-        // Start playback once threshold is reached or download is tiny
-        if (!player_started) {
-            size_t buffered = RING_BUFFER_SIZE - xRingbufferGetCurFreeSize(audio_rb);
-            if (buffered >= start_threshold) {
-                ESP_LOGI(TAG, "Buffer threshold reached, starting playback");
-                ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
-                if (xTaskCreate(i2s_write_task, "i2s_task", 4096, NULL, 15, &i2s_task_handle) != pdPASS) {
-                    ESP_LOGE(TAG, "Failed to create playback task!");
-                    i2s_task_handle = NULL;
-                    break;
-                }
-                player_started = true;
-            }
+    ESP_LOGI(TAG, "Playback finished.");
+    end_playback(msg, &pipeline, cached, ret == AUDIO_OK);
+}
+
+// Takes the next message and marks it playing in one step, so a more
+// urgent one pushed meanwhile is either taken instead or preempts it
+static bool playback_next(audio_msg_t *msg) {
+    audio_lock(&playback_lock);
+    bool got = audio_queue_pop(&playback_queue, msg);
+    playback_active = got;
+    playback_priority = got ? msg->priority : 0;
+    playback_preempted = false;
+    audio_unlock(&playback_lock);
+    return got;
+}
+
+// The one task that plays messages, one after another, so concurrent
+// notifications never share the ring, the I2S channel or the writer.
+static void playback_worker_task(void *pvParameters) {
+    static audio_msg_t msg;
+    const TaskHandle_t tasks[] = { xTaskGetCurrentTaskHandle(), i2s_task_handle, chime_task_handle };
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (playback_next(&msg)) {
+            audio_queue_stats_t qs = audio_queue_stats(&playback_queue);
+            ESP_LOGI(TAG, "Playing %s after %ld ms queued (%lu waiting, max %lu, %lu coalesced, %lu dropped)",
+                     msg.filename[0] ? msg.filename : "message",
+                     (long)((esp_timer_get_time() - msg.t_enqueued_us) / 1000), (unsigned long)qs.depth,
+                     (unsigned long)qs.max_depth, (unsigned long)qs.coalesced, (unsigned long)qs.dropped);
+            task_stats_mark();
+            play_message(&msg);
+            audio_lock(&playback_lock);
+            playback_active = false;
+            audio_unlock(&playback_lock);
+            audio_mem_report("After playback", tasks, sizeof(tasks) / sizeof(tasks[0]));
+            task_stats_report("Playback");
         }
+        // What the queue no longer holds a message for
+        audio_prefetch_abandon(&prefetch);
+        release_channel();
     }
+}
 
-    // Signal completion
-    audio_download_complete = true;
-    
-    // If download finished but player never started (tiny file), start it now
-    if (!player_started) {
-        ESP_LOGI(TAG, "Tiny file, starting playback immediately");
-        ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
-        if (xTaskCreate(i2s_write_task, "i2s_task", 4096, NULL, 15, &i2s_task_handle) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to create playback task!");
-            i2s_task_handle = NULL;
+// A message more urgent than the one playing: fade that one out within a
+// few DMA buffers and stop its download, chime and writer, so the worker
+// moves on to the new one at once
+static void preempt_playback(uint8_t priority) {
+    audio_lock(&playback_lock);
+    if (playback_active && !playback_preempted && priority > playback_priority) {
+        playback_preempted = true;
+        bool faded = esp_i2s_fader_fade_out(&i2s_fader);
+        if (playback_pipeline) audio_pipeline_cancel(playback_pipeline);
+        ESP_LOGI(TAG, "Preempting priority %u playback for priority %u%s", playback_priority, priority,
+                 faded ? "" : " (DMA ring not mapped yet, letting it drain)");
+    }
+    audio_unlock(&playback_lock);
+}
+
+static void play_audio(const notify_msg_t *note, int64_t t_received_us) {
+    // Built only by the MQTT task; push copies it into a queue slot
+    static audio_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.t_received_us = t_received_us;
+    // The clip's chunks follow this message on the topic: reserve the buffer
+    // now so none are missed. Without it the message still plays by URL.
+    // Chunks are unsigned, so with a secret the clip must match the signed
+    // SHA-256 before it plays.
+    uint8_t clip_sha[HMAC_SHA256_LEN];
+    bool has_sha = notify_str_hex(note->inline_sha256, clip_sha, sizeof(clip_sha));
+    if (note->inline_id > 0 && note->inline_bytes > 0 && audio_mem.inline_buffer) {
+        if (HMAC_SECRET[0] && !has_sha) {
+            ESP_LOGW(TAG, "Inline clip without a SHA-256, using the URL");
+        } else if (audio_inline_begin(&inline_clip, (uint32_t)note->inline_id, (uint32_t)note->inline_bytes,
+                                      HMAC_SECRET[0] ? clip_sha : NULL)) {
+            msg.inline_id = (uint32_t)note->inline_id;
         } else {
-            player_started = true;
+            ESP_LOGI(TAG, "Inline clip of %ld bytes not taken, using the URL", (long)note->inline_bytes);
         }
     }
+    if (notify_str_copy(msg.url, sizeof(msg.url), note->file_url) <= 0 && !msg.inline_id) {
+        ESP_LOGE(TAG, "URL empty or too long (%u bytes), ignoring message", (unsigned)note->file_url.len);
+        return;
+    }
+    // A name that does not fit stays empty: the clip is then neither cached nor coalesced
+    notify_str_copy(msg.filename, sizeof(msg.filename), note->filename);
+    if (note->chime > 0 && note->chime <= AUDIO_CHIME_MAX) {
+        int gap_ms = note->gap_ms;
+        msg.chime = (uint8_t)note->chime;
+        msg.gap_ms = gap_ms < 0 ? CHIME_GAP_DEFAULT_MS : gap_ms > CHIME_GAP_MAX_MS ? CHIME_GAP_MAX_MS : gap_ms;
+    }
+    msg.priority = note->priority < 0 ? 0 : note->priority > UINT8_MAX ? UINT8_MAX : (uint8_t)note->priority;
+    int64_t now_us;
+    if (note->play_at > 0 && shared_clock.now(shared_clock.ctx, &now_us)) {
+        int64_t lead_ms = note->play_at - now_us / 1000;
+        if (lead_ms > PLAY_AT_MAX_LEAD_MS) {
+            ESP_LOGW(TAG, "play_at %lld ms ahead, playing on arrival", (long long)lead_ms);
+        } else if (-lead_ms * 1000 > AUDIO_SYNC_MAX_LATE_US) {
+            ESP_LOGW(TAG, "play_at %lld ms past, playing on arrival", (long long)-lead_ms);
+        } else {
+            msg.play_at_us = note->play_at * 1000;
+        }
+    }
+    if (audio_queue_push(&playback_queue, &msg) != AUDIO_QUEUE_REJECTED) {
+        preempt_playback(msg.priority);
+        xTaskNotifyGive(playback_task_handle);
+    }
+}
 
-    ESP_LOGI(TAG, "Download complete (%d bytes), waiting for writer task to finish...", bytes_processed);
+// p50/p95/p99 of each stage over the trace window, sent on {"cmd":"latency"}
+static void publish_latency_summary(void) {
+    static char json[AUDIO_TRACE_JSON_MAX];
+    int len = audio_trace_format_summary(&trace_window, json, sizeof(json));
+    if (len > 0) {
+        ESP_LOGI(TAG, "Latency: %s", json);
+        publish_status(json, len);
+    }
+}
+
+// On the esp_timer task; a clip that has just ended may add one sample
+static void ring_fill_sample(void *arg) {
+    if (playback_active) audio_fill_hist_add(&ring_fill, audio_spsc_used(audio_mem.ring), audio_mem.ring_size);
+}
 
-    // Wait for writer task to finish and self-delete
-    while (i2s_task_handle != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(100));
+// The app's own tasks, by stack high-water mark only, when FreeRTOS
+// run-time stats are off
+static void stats_own_tasks(audio_stats_t *s) {
+    const struct { TaskHandle_t handle; BaseType_t core; } tasks[] = {
+        { playback_task_handle, DOWNLOAD_CORE }, { i2s_task_handle, AUDIO_CORE },
+        { chime_task_handle, AUDIO_CORE }, { stats_task_handle, DOWNLOAD_CORE },
+    };
+    for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+        if (!tasks[i].handle) continue;
+        audio_stats_task_t *t = &s->tasks[s->task_count++];
+        snprintf(t->name, sizeof(t->name), "%s", pcTaskGetName(tasks[i].handle));
+        t->core = tasks[i].core == tskNO_AFFINITY ? -1 : (int8_t)tasks[i].core;
+        t->cpu_permille = -1;
+        t->stack_free = uxTaskGetStackHighWaterMark(tasks[i].handle);
     }
+}
 
-    vRingbufferDelete(audio_rb);
-    audio_rb = NULL;
-    free(chunk_buffer);
-    free(mono_buffer);
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
-    free(url);
-    ESP_LOGI(TAG, "Playback task finished.");
-    vTaskDelete(NULL);
+static void stats_collect(audio_stats_t *s) {
+    for (int c = 0; c < AUDIO_STATS_MAX_CORES; c++) s->core_busy_permille[c] = -1;
+    if (!task_stats_snapshot(s)) stats_own_tasks(s);
+    audio_mem_stats_t m = audio_mem_stats();
+    s->internal = (audio_stats_heap_t) { m.internal_free, m.internal_min_free, m.internal_largest };
+    s->psram = (audio_stats_heap_t) { m.psram_free, m.psram_min_free, m.psram_largest };
+    s->dma = (audio_stats_heap_t) { m.dma_free, m.dma_min_free, m.dma_largest };
+    s->ring_kb = RINGBUF_SIZE_KB;
+    s->ring_fill = audio_fill_hist_take(&ring_fill);
+    audio_queue_stats_t qs = audio_queue_stats(&playback_queue);
+    s->queue_depth = qs.depth;
+    s->queue_max_depth = qs.max_depth;
+    s->queue_dropped = qs.dropped;
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) s->rssi = ap.rssi;
+    s->mqtt_connects = mqtt_connects;
+    s->mqtt_disconnects = mqtt_disconnects;
+    s->messages = messages_played;
+    s->underruns = underruns_total;
 }
 
-static void play_audio(const char *url) {
-    char *url_copy = strdup(url);
-    if (url_copy) {
-        xTaskCreate(audio_playback_task, "audio_task", 8192, url_copy, 10, NULL);
+// Low priority, next to the downloads: a snapshot waits for anything real
+// to run, and is queued to the stats topic rather than published
+static void stats_task(void *pvParameters) {
+    static audio_stats_t stats;
+    static char json[AUDIO_STATS_JSON_MAX];
+    const TickType_t interval = CONFIG_AUDIO_STATS_INTERVAL_S > 0
+        ? pdMS_TO_TICKS(CONFIG_AUDIO_STATS_INTERVAL_S * 1000) : portMAX_DELAY;
+    // Where the first interval's CPU is measured from
+    task_stats_snapshot(&stats);
+    int64_t last_us = esp_timer_get_time();
+    uint32_t seq = 0;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, interval);
+        int64_t now_us = esp_timer_get_time();
+        memset(&stats, 0, sizeof(stats));
+        stats.seq = ++seq;
+        stats.uptime_s = (uint32_t)(now_us / 1000000);
+        stats.interval_ms = (uint32_t)((now_us - last_us) / 1000);
+        last_us = now_us;
+        stats_collect(&stats);
+        int len = audio_stats_format(&stats, json, sizeof(json));
+        if (len > 0 && mqtt_client) esp_mqtt_client_enqueue(mqtt_client, STATS_TOPIC, json, len, 0, 0, true);
+        ESP_LOGD(TAG, "Stats: %s", len > 0 ? json : "(truncated)");
+    }
+}
+
+// With a secret set, whether a signed message may be acted on: its signature
+// checks out and it was neither sent long ago nor seen before. Until SNTP has
+// set the clock only repeats are caught.
+static bool message_trusted(const notify_msg_t *note, const char *data) {
+    if (HMAC_SECRET[0] == '\0') return true;
+    if (!notify_msg_verify(note, data, (const uint8_t *)HMAC_SECRET, strlen(HMAC_SECRET))) {
+        ESP_LOGW(TAG, "Ignoring message with %s signature", note->signature.p ? "an invalid" : "no");
+        return false;
+    }
+    int64_t now_us;
+    int64_t now_ms = shared_clock.now(shared_clock.ctx, &now_us) ? now_us / 1000 : -1;
+    switch (notify_replay_check(&replay_guard, note, now_ms, NOTIFY_MAX_AGE_MS)) {
+    case NOTIFY_FRESH:
+        return true;
+    case NOTIFY_UNSTAMPED:
+        ESP_LOGW(TAG, "Ignoring signed message without sent_at and nonce");
+        return false;
+    case NOTIFY_STALE:
+        ESP_LOGW(TAG, "Ignoring message sent %lld ms from now", (long long)(note->sent_at - now_ms));
+        return false;
+    default:
+        ESP_LOGW(TAG, "Ignoring replayed message (nonce %lld)", (long long)note->nonce);
+        return false;
+    }
+}
+
+// Decoded in place: no allocation, and the payload is only trusted once its
+// signature checks out
+static void handle_message(const char *data, int len, int64_t t_received_us) {
+    static notify_msg_t note;
+    uint32_t t0 = audio_cycles();
+    notify_result_t rc = notify_msg_parse(data, len, &note);
+    if (rc != NOTIFY_OK) {
+        ESP_LOGW(TAG, "Ignoring malformed message (%d)", rc);
+        return;
+    }
+    bool trusted = message_trusted(&note, data);
+    ESP_LOGI(TAG, "Decoded in %lu cycles%s", (unsigned long)(audio_cycles() - t0),
+             HMAC_SECRET[0] && trusted ? ", signature ok" : "");
+    if (!trusted) return;
+    if (note.file_url.p || note.inline_id > 0) {
+        play_audio(&note, t_received_us);
+    } else if (notify_str_eq(note.cmd, "latency")) {
+        publish_latency_summary();
+    } else if (notify_str_eq(note.cmd, "stats")) {
+        if (stats_task_handle) xTaskNotifyGive(stats_task_handle);
     }
 }
 
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
     esp_mqtt_event_handle_t event = event_data;
+    // Origin of the message's latency spans
+    int64_t t_received_us = esp_timer_get_time();
     
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT Connected");
+            mqtt_connects++;
             esp_mqtt_client_subscribe(event->client, MQTT_TOPIC, 0);
             ESP_LOGI(TAG, "Subscribed to: %s", MQTT_TOPIC);
+            if (GROUP_TOPIC[0]) {
+                esp_mqtt_client_subscribe(event->client, GROUP_TOPIC, 0);
+                ESP_LOGI(TAG, "Subscribed to: %s", GROUP_TOPIC);
+            }
+            if (!boot_times.mqtt_ready_us) {
+                boot_times.mqtt_ready_us = esp_timer_get_time();
+                log_boot_times();
+            }
             break;
             
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "MQTT Disconnected");
+            mqtt_disconnects++;
             break;
             
         case MQTT_EVENT_DATA:
-            ESP_LOGI(TAG, "MQTT Data received");
-            cJSON *root = cJSON_ParseWithLength(event->data, event->data_len);
-            if (root) {
-                cJSON *url_item = cJSON_GetObjectItem(root, "file_url");
-                if (cJSON_IsString(url_item) && url_item->valuestring) {
-                    play_audio(url_item->valuestring);
+            // A message larger than the buffer comes as several events;
+            // only inline chunks are that large
+            if (event->current_data_offset == 0) {
+                mqtt_in_chunk = audio_inline_is_chunk((const uint8_t *)event->data, event->data_len);
+            }
+            if (mqtt_in_chunk) {
+                if (audio_mem.inline_buffer) {
+                    audio_inline_feed(&inline_clip, (const uint8_t *)event->data, event->data_len,
+                                      event->current_data_offset, event->total_data_len);
                 }
-                cJSON_Delete(root);
+            } else if (event->data_len == event->total_data_len) {
+                ESP_LOGI(TAG, "MQTT Data received");
+                handle_message(event->data, event->data_len, t_received_us);
+            } else if (event->current_data_offset == 0) {
+                ESP_LOGW(TAG, "Ignoring %d byte message, larger than the MQTT buffer", event->total_data_len);
             }
             break;
             
@@ -395,22 +1126,89 @@ static void mqtt_init(void) {
         .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
         .credentials.username = MQTT_USER,
         .credentials.authentication.password = MQTT_PASS,
+        .buffer.size = MQTT_BUFFER_SIZE,
     };
     
-    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
-    esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    esp_mqtt_client_start(client);
+    mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+}
+
+// Once there is an IP: started earlier, the client's first connect fails
+// and it waits out its reconnect timeout
+static void mqtt_start(void) {
+    esp_mqtt_client_start(mqtt_client);
     ESP_LOGI(TAG, "MQTT client started on port 8883");
 }
 
+// Association runs from the start; everything that does not need the
+// network is brought up meanwhile, and MQTT connects as soon as there is
+// an IP
 void app_main(void) {
+    boot_times.app_main_us = esp_timer_get_time();
     ESP_ERROR_CHECK(nvs_flash_init());
     
     ESP_LOGI(TAG, "Starting RemoteAlarm...");
-    
     wifi_init();
+    shared_clock_init();
+    notify_replay_init(&replay_guard);
+    
+    bool flash_tier = audio_cache_flash_init(&audio_cache_store) == ESP_OK;
+    audio_cache_init(&audio_cache, CONFIG_AUDIO_CACHE_RAM_KB * 1024, cache_alloc,
+                     flash_tier ? &audio_cache_store : NULL);
+
+    chime_done = xSemaphoreCreateBinaryStatic(&chime_done_buf);
+    playback_done = xSemaphoreCreateBinaryStatic(&playback_done_buf);
+    chime_flash_init();
+
+    // Before the audio memory, which it would compete with for PSRAM
+    ring_bench_run(DOWNLOAD_CORE, AUDIO_CORE);
+
+    // One ring and one worker for the device's lifetime; messages reuse them
+    if (audio_mem_init(&audio_mem, RING_BUFFER_SIZE, CONFIG_AUDIO_INLINE_MAX_KB * 1024,
+                       CONFIG_AUDIO_PREFETCH_KB * 1024) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate audio memory!");
+        return;
+    }
+    if (audio_mem.inline_buffer) {
+        audio_signal_t signal;
+        esp_signal_bind(&inline_signal, &signal);
+        audio_inline_init(&inline_clip, audio_mem.inline_buffer, audio_mem.inline_size, &signal);
+    }
+    audio_prefetch_init(&prefetch, audio_mem.prefetch_buffer, audio_mem.prefetch_size);
+    audio_queue_init(&playback_queue, playback_slots, CONFIG_AUDIO_QUEUE_DEPTH, AUDIO_QUEUE_POLICY);
+    audio_lock_init(&playback_lock);
+    audio_trace_window_init(&trace_window);
+    audio_fill_hist_init(&ring_fill);
+
+#ifdef CONFIG_AUDIO_DSP
+    dsp_init();
+#endif
+
     i2s_init();
+    i2s_task_handle = xTaskCreateStaticPinnedToCore(i2s_write_task, "i2s_task", I2S_STACK_SIZE, NULL,
+                                                    CONFIG_AUDIO_WRITER_PRIORITY, i2s_stack, &i2s_tcb, AUDIO_CORE);
+    chime_task_handle = xTaskCreateStaticPinnedToCore(chime_task, "chime_task", CHIME_STACK_SIZE, NULL,
+                                                      CONFIG_AUDIO_WRITER_PRIORITY, chime_stack, &chime_tcb,
+                                                      AUDIO_CORE);
+    // Started after the tasks it reports on
+    playback_task_handle = xTaskCreateStaticPinnedToCore(playback_worker_task, "playback", PLAYBACK_STACK_SIZE, NULL,
+                                                         CONFIG_AUDIO_DOWNLOAD_PRIORITY, playback_stack, &playback_tcb,
+                                                         DOWNLOAD_CORE);
+    stats_task_handle = xTaskCreateStaticPinnedToCore(stats_task, "stats", STATS_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                                                      stats_stack, &stats_tcb, DOWNLOAD_CORE);
+    const esp_timer_create_args_t fill_timer_args = { .callback = ring_fill_sample, .name = "ring_fill" };
+    esp_timer_handle_t fill_timer;
+    if (esp_timer_create(&fill_timer_args, &fill_timer) == ESP_OK) {
+        esp_timer_start_periodic(fill_timer, RING_FILL_SAMPLE_MS * 1000);
+    }
     mqtt_init();
-    
+    boot_times.audio_ready_us = esp_timer_get_time();
+
+    xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
+    ESP_LOGI(TAG, "WiFi connected");
+    mqtt_start();
+
+    const TaskHandle_t tasks[] = { playback_task_handle, i2s_task_handle, chime_task_handle };
+    audio_mem_report("Boot", tasks, sizeof(tasks) / sizeof(tasks[0]));
     ESP_LOGI(TAG, "RemoteAlarm ready!");
 }
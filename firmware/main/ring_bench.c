@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "audio_pipeline.h"
+#include "audio_port.h"
+#include "audio_spsc.h"
+#include "esp_audio_io.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "ring_bench.h"
+
+#ifdef CONFIG_AUDIO_RING_BENCH
+
+static const char *TAG = "RING_BENCH";
+
+#define BENCH_RING_SIZE (64 * 1024)
+#define BENCH_SOLO_BLOCKS 4096
+#define BENCH_STREAM_BYTES (8 * 1024 * 1024)
+#define BENCH_STACK_SIZE 3072
+
+static RingbufHandle_t rb;
+static audio_spsc_t spsc;
+
+// A stream ends with finish(): bound again before each
+typedef void (*bench_bind_t)(audio_ring_t *out);
+
+static void bind_freertos(audio_ring_t *out) {
+    esp_ringbuf_bind(rb, BENCH_RING_SIZE, out);
+}
+
+static void bind_spsc(audio_ring_t *out) {
+    audio_spsc_bind(&spsc, out);
+}
+
+typedef struct {
+    const audio_ring_t *ring;
+    size_t block;
+    SemaphoreHandle_t done;
+} bench_stream_t;
+
+// Both ends on one task, the ring never full: what a block costs in locking
+static uint32_t solo_cycles(const audio_ring_t *ring, size_t block) {
+    uint32_t c0 = audio_cycles();
+    for (int i = 0; i < BENCH_SOLO_BLOCKS; i++) {
+        void *slot;
+        size_t len;
+        ring->acquire(ring->ctx, &slot, block, AUDIO_WAIT_FOREVER);
+        ring->complete(ring->ctx, slot, block);
+        void *item = ring->receive(ring->ctx, &len, AUDIO_WAIT_FOREVER);
+        ring->return_item(ring->ctx, item);
+    }
+    return (audio_cycles() - c0) / BENCH_SOLO_BLOCKS;
+}
+
+static void producer_task(void *arg) {
+    bench_stream_t *b = arg;
+    for (size_t off = 0; off < BENCH_STREAM_BYTES; off += b->block) {
+        void *slot;
+        b->ring->acquire(b->ring->ctx, &slot, b->block, AUDIO_WAIT_FOREVER);
+        b->ring->complete(b->ring->ctx, slot, b->block);
+    }
+    b->ring->finish(b->ring->ctx);
+    xSemaphoreGive(b->done);
+    vTaskDelete(NULL);
+}
+
+static void consumer_task(void *arg) {
+    bench_stream_t *b = arg;
+    size_t len;
+    void *item;
+    while ((item = b->ring->receive(b->ring->ctx, &len, AUDIO_WAIT_FOREVER)) != NULL) {
+        b->ring->return_item(b->ring->ctx, item);
+    }
+    xSemaphoreGive(b->done);
+    vTaskDelete(NULL);
+}
+
+// Producer and consumer on their own cores at the writer's priority; KB/s
+static uint32_t stream_rate(const audio_ring_t *ring, size_t block, BaseType_t producer_core,
+                            BaseType_t consumer_core) {
+    bench_stream_t b = { .ring = ring, .block = block, .done = xSemaphoreCreateCounting(2, 0) };
+    if (!b.done) return 0;
+    int64_t t0 = audio_time_us();
+    xTaskCreatePinnedToCore(consumer_task, "bench_rx", BENCH_STACK_SIZE, &b, CONFIG_AUDIO_WRITER_PRIORITY, NULL,
+                            consumer_core);
+    xTaskCreatePinnedToCore(producer_task, "bench_tx", BENCH_STACK_SIZE, &b, CONFIG_AUDIO_WRITER_PRIORITY, NULL,
+                            producer_core);
+    xSemaphoreTake(b.done, portMAX_DELAY);
+    xSemaphoreTake(b.done, portMAX_DELAY);
+    int64_t us = audio_time_us() - t0;
+    vSemaphoreDelete(b.done);
+    return us > 0 ? (uint32_t)((int64_t)BENCH_STREAM_BYTES * 1000000 / 1024 / us) : 0;
+}
+
+static void report(const char *name, bench_bind_t bind, BaseType_t producer_core, BaseType_t consumer_core) {
+    static const size_t blocks[] = { AUDIO_CHUNK_BUFFER_SIZE, 256 };
+    audio_ring_t ring;
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        bind(&ring);
+        uint32_t cycles = solo_cycles(&ring, blocks[i]);
+        uint32_t kbps = stream_rate(&ring, blocks[i], producer_core, consumer_core);
+        ESP_LOGI(TAG, "%-8s block %4u: %5lu cycles/block alone, %6lu KB/s across cores", name, (unsigned)blocks[i],
+                 (unsigned long)cycles, (unsigned long)kbps);
+    }
+}
+
+static uint8_t *alloc_storage(void) {
+    uint8_t *storage = heap_caps_malloc(BENCH_RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return storage ? storage : heap_caps_malloc(BENCH_RING_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void ring_bench_run(BaseType_t producer_core, BaseType_t consumer_core) {
+    static StaticRingbuffer_t rb_struct;
+    static esp_signal_t readable_sig, writable_sig;
+    uint8_t *storage = alloc_storage();
+    if (!storage) {
+        ESP_LOGW(TAG, "No memory for the benchmark rings");
+        return;
+    }
+    rb = xRingbufferCreateStatic(BENCH_RING_SIZE, RINGBUF_TYPE_NOSPLIT, storage, &rb_struct);
+    report("freertos", bind_freertos, producer_core, consumer_core);
+    vRingbufferDelete(rb);
+
+    audio_signal_t readable, writable;
+    esp_signal_bind(&readable_sig, &readable);
+    esp_signal_bind(&writable_sig, &writable);
+    audio_spsc_init(&spsc, storage, BENCH_RING_SIZE, &readable, &writable);
+    report("spsc", bind_spsc, producer_core, consumer_core);
+    free(storage);
+}
+
+#else
+
+void ring_bench_run(BaseType_t producer_core, BaseType_t consumer_core) {
+    (void)producer_core;
+    (void)consumer_core;
+}
+
+#endif
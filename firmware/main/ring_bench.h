@@ -0,0 +1,15 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Boot-time comparison of the audio ring (audio_spsc.h) with the FreeRTOS
+// no-split ring buffer it replaced (esp_ringbuf_bind), each on 64 KB of
+// storage placed as audio_mem.c places the playback ring. Does nothing
+// unless CONFIG_AUDIO_RING_BENCH is set.
+//
+// Logs, for each ring and block size: the CPU cycles one block costs
+// through acquire, complete, receive and return on a single task (the
+// locking overhead alone), and the throughput with a producer on
+// `producer_core` and a consumer on `consumer_core`, as the playback worker
+// and the I2S writer run.
+void ring_bench_run(BaseType_t producer_core, BaseType_t consumer_core);
@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "task_stats.h"
+
+#ifdef CONFIG_AUDIO_TASK_STATS
+
+static const char *TAG = "TASK_STATS";
+
+// More tasks than the app and IDF create between them; a snapshot holds them all
+#define TASK_STATS_MAX AUDIO_STATS_MAX_TASKS
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} task_sample_t;
+
+// One measurement interval: the per-message log and the periodic snapshot
+// keep their own, and may sample at the same time from different tasks
+typedef struct {
+    TaskStatus_t status[TASK_STATS_MAX];
+    task_sample_t last[TASK_STATS_MAX];
+    size_t last_count;
+    uint32_t last_total;
+    bool marked;
+} task_window_t;
+
+// Static: the report runs on the playback worker's stack
+static task_window_t report_window;
+static task_window_t snapshot_window;
+
+// Run time since the mark; counters wrap, a task created since counts in full
+static uint32_t runtime_since(const task_window_t *w, const TaskStatus_t *t) {
+    for (size_t i = 0; i < w->last_count; i++) {
+        if (w->last[i].handle == t->xHandle) return t->ulRunTimeCounter - w->last[i].runtime;
+    }
+    return t->ulRunTimeCounter;
+}
+
+// Tenths of a percent of one core
+static uint32_t permille(uint32_t part, uint32_t whole) {
+    return whole ? (uint32_t)((uint64_t)part * 1000 / whole) : 0;
+}
+
+static UBaseType_t sample(task_window_t *w, uint32_t *total) {
+    UBaseType_t n = uxTaskGetSystemState(w->status, TASK_STATS_MAX, total);
+    if (n == 0) ESP_LOGW(TAG, "More than %d tasks, no CPU report", TASK_STATS_MAX);
+    return n;
+}
+
+static void save(task_window_t *w, UBaseType_t n, uint32_t total) {
+    for (UBaseType_t i = 0; i < n; i++) {
+        w->last[i] = (task_sample_t) { w->status[i].xHandle, w->status[i].ulRunTimeCounter };
+    }
+    w->last_count = n;
+    w->last_total = total;
+    w->marked = n > 0;
+}
+
+static bool is_idle(const TaskStatus_t *t) {
+    return t->xCoreID >= 0 && t->xCoreID < portNUM_PROCESSORS && strncmp(t->pcTaskName, "IDLE", 4) == 0;
+}
+
+void task_stats_mark(void) {
+    uint32_t total;
+    save(&report_window, sample(&report_window, &total), total);
+}
+
+void task_stats_report(const char *when) {
+    task_window_t *w = &report_window;
+    uint32_t total;
+    UBaseType_t n = sample(w, &total);
+    if (n == 0 || !w->marked) {
+        save(w, n, total);
+        return;
+    }
+    uint32_t elapsed = total - w->last_total;
+    uint32_t idle[portNUM_PROCESSORS] = { 0 };
+    ESP_LOGI(TAG, "%s: CPU per task over %lu ms", when, (unsigned long)(elapsed / 1000));
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *t = &w->status[i];
+        uint32_t pm = permille(runtime_since(w, t), elapsed);
+        bool pinned = t->xCoreID >= 0 && t->xCoreID < portNUM_PROCESSORS;
+        if (is_idle(t)) {
+            idle[t->xCoreID] = pm;
+        } else if (pm > 0) {
+            char core = pinned ? (char)('0' + t->xCoreID) : '-';
+            ESP_LOGI(TAG, "  %-16s core %c prio %2u %3lu.%lu%%", t->pcTaskName, core,
+                     (unsigned)t->uxCurrentPriority, (unsigned long)(pm / 10), (unsigned long)(pm % 10));
+        }
+    }
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint32_t busy = idle[c] < 1000 ? 1000 - idle[c] : 0;
+        ESP_LOGI(TAG, "  core %d busy %lu.%lu%%", c, (unsigned long)(busy / 10), (unsigned long)(busy % 10));
+    }
+    save(w, n, total);
+}
+
+bool task_stats_snapshot(audio_stats_t *s) {
+    task_window_t *w = &snapshot_window;
+    uint32_t total;
+    UBaseType_t n = sample(w, &total);
+    if (n == 0) return false;
+    // CPU is left unmeasured by the first snapshot, with nothing to measure
+    // from, and for a task whose count the wrap has made nonsense
+    uint32_t elapsed = total - w->last_total;
+    for (int c = 0; c < AUDIO_STATS_MAX_CORES; c++) s->core_busy_permille[c] = -1;
+    s->task_count = 0;
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *t = &w->status[i];
+        uint32_t part = runtime_since(w, t);
+        int16_t pm = w->marked && part <= elapsed ? (int16_t)permille(part, elapsed) : -1;
+        if (pm >= 0 && is_idle(t) && t->xCoreID < AUDIO_STATS_MAX_CORES) {
+            s->core_busy_permille[t->xCoreID] = pm < 1000 ? 1000 - pm : 0;
+        }
+        audio_stats_task_t *out = &s->tasks[s->task_count++];
+        snprintf(out->name, sizeof(out->name), "%s", t->pcTaskName);
+        out->core = t->xCoreID >= 0 && t->xCoreID < portNUM_PROCESSORS ? (int8_t)t->xCoreID : -1;
+        out->cpu_permille = pm;
+        out->stack_free = t->usStackHighWaterMark;
+    }
+    save(w, n, total);
+    return true;
+}
+
+#else
+
+void task_stats_mark(void) {
+}
+
+void task_stats_report(const char *when) {
+    (void)when;
+}
+
+bool task_stats_snapshot(audio_stats_t *s) {
+    (void)s;
+    return false;
+}
+
+#endif
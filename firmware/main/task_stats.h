@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdbool.h>
+#include "audio_stats.h"
+
+// Per-task CPU usage from FreeRTOS run-time stats, to check where the
+// task topology (CONFIG_AUDIO_CORE and friends) puts the load. All do
+// nothing unless CONFIG_AUDIO_TASK_STATS is set.
+//
+// The counters are 32-bit microseconds and wrap every ~71 minutes, so
+// mark the start of the interval of interest (a message) rather than
+// reporting across idle hours.
+void task_stats_mark(void);
+// Logs every task that ran since the mark with its share of a core, and
+// the load on each core; then marks again
+void task_stats_report(const char *when);
+// Fills the tasks and per-core load of a health snapshot over the interval
+// since the previous one, which it keeps apart from the mark above. False
+// when run-time stats are off: the caller lists its own tasks instead.
+bool task_stats_snapshot(audio_stats_t *s);
@@ -0,0 +1,39 @@
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "wifi_cache.h"
+
+static const char *TAG = "WIFI_CACHE";
+
+#define NVS_NAMESPACE "wifi_cache"
+#define NVS_KEY       "ap"
+
+bool wifi_cache_load(wifi_cache_t *out) {
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return false;
+    size_t len = sizeof(*out);
+    bool ok = nvs_get_blob(nvs, NVS_KEY, out, &len) == ESP_OK && len == sizeof(*out) &&
+              out->channel >= 1 && out->channel <= 14 && memchr(out->ssid, '\0', sizeof(out->ssid));
+    nvs_close(nvs);
+    return ok;
+}
+
+void wifi_cache_save(const wifi_cache_t *ap) {
+    wifi_cache_t stored;
+    if (wifi_cache_load(&stored) && memcmp(&stored, ap, sizeof(stored)) == 0) return;
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_set_blob(nvs, NVS_KEY, ap, sizeof(*ap)) != ESP_OK || nvs_commit(nvs) != ESP_OK) {
+        ESP_LOGW(TAG, "Could not store the AP");
+    } else {
+        ESP_LOGI(TAG, "Stored AP on channel %u", ap->channel);
+    }
+    nvs_close(nvs);
+}
+
+void wifi_cache_clear(void) {
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_erase_key(nvs, NVS_KEY) == ESP_OK) nvs_commit(nvs);
+    nvs_close(nvs);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The access point the device last got an IP through, kept in NVS so a
+// reboot connects straight to its channel and BSSID instead of scanning
+// every channel first. The DHCP lease is kept by lwIP itself
+// (CONFIG_LWIP_DHCP_RESTORE_LAST_IP).
+typedef struct {
+    char ssid[33];              // the network it belongs to; a new SSID ignores it
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_cache_t;
+
+// False when nothing valid is stored; nvs_flash_init() must have run
+bool wifi_cache_load(wifi_cache_t *out);
+// Writes only when it differs from what is stored, to spare the flash
+void wifi_cache_save(const wifi_cache_t *ap);
+// After the cached AP could not be joined
+void wifi_cache_clear(void);
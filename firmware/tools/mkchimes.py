@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Build the chime image for the "chimes" partition (see audio_chime.h).
+
+    mkchimes.py -o chimes.bin alarm1.wav alarm2.wav ...
+
+Chime ids follow the argument order, starting at 1. Inputs must be PCM WAV
+(16 or 32-bit); stereo is downmixed to mono, which is what the device's
+I2S channel plays.
+"""
+import argparse
+import struct
+import sys
+
+MAGIC = b"CHM1"
+HEADER = 8
+ENTRY = 16
+MAX_CHIMES = 32
+
+
+def read_wav(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        sys.exit("%s: not a WAV file" % path)
+    fmt = pcm = None
+    pos = 12
+    while pos + 8 <= len(data):
+        cid, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if cid == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body)
+        elif cid == b"data":
+            pcm = body
+        pos += 8 + size + (size & 1)
+    if fmt is None or pcm is None:
+        sys.exit("%s: missing fmt or data chunk" % path)
+    tag, channels, rate, _, _, bits = fmt
+    if tag != 1 or bits not in (16, 32) or channels not in (1, 2):
+        sys.exit("%s: need 16/32-bit PCM, mono or stereo" % path)
+    if channels == 2:
+        code = "h" if bits == 16 else "i"
+        n = len(pcm) // (bits // 4)
+        s = struct.unpack("<%d%s" % (2 * n, code), pcm[:n * bits // 4])
+        pcm = struct.pack("<%d%s" % (n, code), *((s[2 * i] + s[2 * i + 1]) // 2 for i in range(n)))
+    return rate, bits, pcm
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-o", "--output", required=True)
+    ap.add_argument("wavs", nargs="+")
+    args = ap.parse_args()
+    if len(args.wavs) > MAX_CHIMES:
+        sys.exit("at most %d chimes" % MAX_CHIMES)
+
+    chimes = [read_wav(p) for p in args.wavs]
+    table = bytearray(MAGIC + struct.pack("<I", len(chimes)))
+    body = bytearray()
+    offset = HEADER + ENTRY * len(chimes)
+    for rate, bits, pcm in chimes:
+        table += struct.pack("<IIIHH", offset + len(body), len(pcm), rate, bits, 0)
+        body += pcm
+        body += bytes(-len(body) % 4)
+    with open(args.output, "wb") as f:
+        f.write(table + body)
+
+
+if __name__ == "__main__":
+    main()
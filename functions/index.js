@@ -1,10 +1,12 @@
 const {onObjectFinalized} = require("firebase-functions/v2/storage");
 const {onCall, HttpsError} = require("firebase-functions/v2/https");
 const {setGlobalOptions} = require("firebase-functions/v2");
-const {defineString} = require("firebase-functions/params");
+const {defineString, defineInt} = require("firebase-functions/params");
 const admin = require("firebase-admin");
 const logger = require("firebase-functions/logger");
 const mqtt = require("mqtt");
+const crypto = require("crypto");
+const {signMessage} = require("./sign");
 
 // Define environment parameters with defaults
 const mqttBrokerUrl = defineString("MQTT_BROKER_URL", {
@@ -27,6 +29,33 @@ const mqttDeviceTopic = defineString("MQTT_DEVICE_TOPIC", {
   default: "home/audio/device1",
 });
 
+const mqttGroupTopic = defineString("MQTT_GROUP_TOPIC", {
+  description: "Topic of a device group that plays in step; when set, " +
+    "notifications go here with a play_at time instead of the device topic",
+  default: "",
+});
+
+const groupPlayDelayMs = defineInt("GROUP_PLAY_DELAY_MS", {
+  description: "How far ahead of publishing a group's play_at is set; long " +
+    "enough for every device to receive the message and start the download",
+  default: 3000,
+});
+
+const hmacSecret = defineString("HMAC_SECRET", {
+  description: "Shared secret for signing device notifications (optional)",
+  default: "",
+});
+
+const inlineMaxBytes = defineInt("INLINE_MAX_BYTES", {
+  description: "Largest clip sent inline over MQTT (0 = always by URL); " +
+    "keep at or below the devices' CONFIG_AUDIO_INLINE_MAX_KB",
+  default: 160 * 1024,
+});
+
+// Inline clip chunks (firmware audio_inline.h)
+const INLINE_CHUNK_BYTES = 8192;
+const INLINE_HEADER_BYTES = 16;
+
 // Initialize Firebase Admin
 admin.initializeApp();
 
@@ -65,10 +94,13 @@ exports.onAudioUpload = onObjectFinalized({
       file_url: url,
       timestamp: new Date().toISOString(),
       filename: filePath.split("/").pop(),
+      ...chimeFields(event.data.metadata),
+      ...priorityFields(event.data.metadata),
     };
+    const clip = await inlineClip(file, event.data.size, payload);
 
     // Publish to MQTT broker
-    await publishToMQTT(payload);
+    await publishToMQTT(payload, clip);
 
     logger.info("MQTT message published successfully", {payload});
     return null;
@@ -162,28 +194,124 @@ async function processAudioNotification(bucket, filePath) {
   logger.info("Generated signed URL for replay", {filePath, url});
 
   // Prepare MQTT payload
+  const [metadata] = await file.getMetadata();
   const payload = {
     file_url: url,
     timestamp: new Date().toISOString(),
     filename: filePath.split("/").pop(),
+    ...chimeFields(metadata.metadata),
+    ...priorityFields(metadata.metadata),
   };
+  const clip = await inlineClip(file, metadata.size, payload);
 
   // Publish to MQTT broker
-  await publishToMQTT(payload);
+  await publishToMQTT(payload, clip);
+}
+
+/**
+ * Chime fields of the device notification, from the custom metadata the app
+ * sets on upload. The device plays the chime from flash before the message.
+ * @param {Object} custom - Custom object metadata (may be undefined)
+ * @return {Object} - {chime, gap_ms} when a chime was chosen, else {}
+ */
+function chimeFields(custom) {
+  const chime = parseInt((custom && custom.chime) || "0", 10);
+  if (!(chime > 0)) {
+    return {};
+  }
+  const gapMs = parseInt(custom.gapMs, 10);
+  return Number.isNaN(gapMs) ? {chime} : {chime, gap_ms: gapMs};
+}
+
+/**
+ * Priority of the device notification, from the custom metadata the app sets
+ * on upload. The device plays higher priorities first and preempts a lower
+ * one that is playing.
+ * @param {Object} custom - Custom object metadata (may be undefined)
+ * @return {Object} - {priority} when above normal (0), else {}
+ */
+function priorityFields(custom) {
+  const priority = parseInt((custom && custom.priority) || "0", 10);
+  return priority > 0 ? {priority: Math.min(priority, 255)} : {};
 }
 
 /**
- * Publish message to MQTT broker
+ * Download a clip small enough to send inline over MQTT, which saves the
+ * device a TLS connection and GET. Names it in the payload (inline_id,
+ * inline_bytes, inline_sha256) so the signature covers the clip itself,
+ * whose chunks are unsigned; file_url stays as the fallback for a device
+ * whose clip buffer is busy or too small.
+ * @param {File} file - Storage file
+ * @param {number|string} size - Object size in bytes
+ * @param {Object} payload - Notification payload, extended in place
+ * @return {Promise<Buffer|null>} - The clip, or null to send by URL only
+ */
+async function inlineClip(file, size, payload) {
+  const bytes = parseInt(size, 10);
+  if (!(bytes > 0) || bytes > inlineMaxBytes.value()) {
+    return null;
+  }
+  const [data] = await file.download();
+  payload.inline_id = crypto.randomInt(1, 2 ** 31);
+  payload.inline_bytes = data.length;
+  payload.inline_sha256 =
+    crypto.createHash("sha256").update(data).digest("hex");
+  return data;
+}
+
+/**
+ * Split an inline clip into MQTT messages, each led by a 16-byte header:
+ * "RA", version 1, flags (1 = last), clip id, byte offset, sequence number
+ * (little endian).
+ * @param {number} id - inline_id of the notification
+ * @param {Buffer} clip - The WAV file
+ * @return {Buffer[]} - Chunks in order
+ */
+function encodeChunks(id, clip) {
+  const chunks = [];
+  for (let offset = 0, seq = 0; offset < clip.length;
+    offset += INLINE_CHUNK_BYTES, seq++) {
+    const data = clip.subarray(offset, offset + INLINE_CHUNK_BYTES);
+    const header = Buffer.alloc(INLINE_HEADER_BYTES);
+    header.write("RA", 0, "latin1");
+    header.writeUInt8(1, 2);
+    header.writeUInt8(offset + data.length === clip.length ? 1 : 0, 3);
+    header.writeUInt32LE(id, 4);
+    header.writeUInt32LE(offset, 8);
+    header.writeUInt16LE(seq, 12);
+    chunks.push(Buffer.concat([header, data]));
+  }
+  return chunks;
+}
+
+/**
+ * Serialize a device notification, signed when HMAC_SECRET is set (see
+ * sign.js, which also signs commands by hand).
+ * @param {Object} payload - Message payload
+ * @return {string} - The MQTT message
+ */
+function encodePayload(payload) {
+  const secret = hmacSecret.value();
+  return secret ? signMessage(payload, secret) : JSON.stringify(payload);
+}
+
+/**
+ * Publish message to MQTT broker, followed by the inline clip's chunks on
+ * the same topic and connection so they arrive after it and in order. With
+ * a group topic the message is scheduled: play_at (Unix ms) is set when the
+ * broker connection is up, ahead of signing
  * @param {Object} payload - Message payload to publish
+ * @param {Buffer|null} clip - Inline clip named in the payload, if any
  * @return {Promise} - Resolves when message is published
  */
-async function publishToMQTT(payload) {
+async function publishToMQTT(payload, clip = null) {
   return new Promise((resolve, reject) => {
     // Get MQTT configuration from params
     const brokerUrl = mqttBrokerUrl.value();
     const username = mqttUsername.value();
     const password = mqttPassword.value();
-    const topic = mqttDeviceTopic.value();
+    const groupTopic = mqttGroupTopic.value();
+    const topic = groupTopic || mqttDeviceTopic.value();
 
     if (!brokerUrl || !username || !password) {
       const error =
@@ -221,19 +349,35 @@ async function publishToMQTT(payload) {
     client.on("connect", () => {
       logger.info("Connected to MQTT broker");
 
-      // Publish message with QoS 0 for faster delivery
-      client.publish(topic, JSON.stringify(payload), {qos: 0}, (error) => {
-        clearTimeout(timeoutId);
-        client.end();
-
-        if (error) {
-          logger.error("Failed to publish MQTT message", {error});
-          reject(error);
-        } else {
-          logger.info("MQTT message published", {topic, payload});
-          resolve();
-        }
-      });
+      if (groupTopic) {
+        payload.play_at = Date.now() + groupPlayDelayMs.value();
+      }
+      const messages = [encodePayload(payload)];
+      if (clip) {
+        messages.push(...encodeChunks(payload.inline_id, clip));
+      }
+
+      // Publish messages with QoS 0 for faster delivery
+      const publishNext = (i) => {
+        client.publish(topic, messages[i], {qos: 0}, (error) => {
+          if (!error && i + 1 < messages.length) {
+            publishNext(i + 1);
+            return;
+          }
+          clearTimeout(timeoutId);
+          client.end();
+
+          if (error) {
+            logger.error("Failed to publish MQTT message", {error});
+            reject(error);
+          } else {
+            logger.info("MQTT message published",
+                {topic, payload, chunks: messages.length - 1});
+            resolve();
+          }
+        });
+      };
+      publishNext(0);
     });
 
     client.on("error", (error) => {
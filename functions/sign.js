@@ -0,0 +1,43 @@
+const crypto = require("crypto");
+
+/**
+ * Serialize a device notification signed with `secret`: the JSON gains its
+ * send time (sent_at, Unix ms) and a random nonce, so the device can refuse
+ * a captured copy published again later, and the hex HMAC-SHA256 of it is
+ * appended as a last "signature" member, which the device strips again to
+ * check it (firmware notify_msg.h).
+ * @param {Object} payload - Message payload
+ * @param {string} secret - The devices' CONFIG_HMAC_SECRET
+ * @return {string} - The MQTT message
+ */
+function signMessage(payload, secret) {
+  const body = JSON.stringify({
+    ...payload,
+    sent_at: Date.now(),
+    nonce: crypto.randomInt(1, 2 ** 47),
+  });
+  const signature =
+    crypto.createHmac("sha256", secret).update(body).digest("hex");
+  return `${body.slice(0, -1)},"signature":"${signature}"}`;
+}
+
+module.exports = {signMessage};
+
+// Signs a command for a device that has a secret, to publish by hand:
+//   HMAC_SECRET=... node sign.js '{"cmd":"stats"}' |
+//     mosquitto_pub -h <broker> -t home/audio/<device-id> -s
+// The device takes it for CONFIG_NOTIFY_MAX_AGE_S, and only once.
+if (require.main === module) {
+  const secret = process.env.HMAC_SECRET;
+  let payload;
+  try {
+    payload = JSON.parse(process.argv[2] || "");
+  } catch (error) {
+    payload = null;
+  }
+  if (!secret || !payload || typeof payload !== "object") {
+    console.error("usage: HMAC_SECRET=<secret> node sign.js '<json object>'");
+    process.exit(2);
+  }
+  process.stdout.write(signMessage(payload, secret));
+}
@@ -25,14 +25,16 @@ class _HomeScreenState extends State<HomeScreen> {
   String? _recordedFilePath;
   String _status = 'Ready to record';
   
-  // Alarm selection
+  // Alarm selection: chime ids stored on the device (firmware/chimes,
+  // 1 = alarm1.wav), played before the message instead of being uploaded
   String _selectedAlarm = 'None';
-  final Map<String, String?> _alarmOptions = {
-    'None': null,
-    'Ding (Soft)': 'assets/sounds/alarm1.wav',
-    'Chime (Major Chord)': 'assets/sounds/alarm2.wav',
-    'Alert (Two-Tone)': 'assets/sounds/alarm3.wav',
+  final Map<String, int> _alarmOptions = {
+    'None': 0,
+    'Ding (Soft)': 1,
+    'Chime (Major Chord)': 2,
+    'Alert (Two-Tone)': 3,
   };
+  static const int _alarmGapMs = 2000;
 
   @override
   void initState() {
@@ -180,28 +182,24 @@ class _HomeScreenState extends State<HomeScreen> {
       });
       
       String fileToUpload = _recordedFilePath!;
-      final alarmAsset = _alarmOptions[_selectedAlarm];
-      
-      if (alarmAsset != null) {
-        try {
-          setState(() => _status = 'Merging alarm sound...');
-          final alarmFile = await AudioUtils.extractAssetToTemp(alarmAsset);
-          fileToUpload = await AudioUtils.mergeWavFiles(alarmFile.path, _recordedFilePath!);
-        } catch (e) {
-          debugPrint('Error merging audio: $e');
-          if (mounted) {
-            ScaffoldMessenger.of(context).showSnackBar(
-              SnackBar(content: Text('Failed to add alarm: $e. Uploading recording only.')),
-            );
-          }
-        }
+
+      try {
+        setState(() => _status = 'Compressing...');
+        fileToUpload = await AudioUtils.compressForUpload(fileToUpload);
+      } catch (e) {
+        // The device still plays plain PCM WAV, so upload uncompressed
+        debugPrint('Error compressing audio: $e');
       }
 
       setState(() {
         _status = 'Uploading...';
       });
 
-      await _storageService.uploadAudio(fileToUpload);
+      await _storageService.uploadAudio(
+        fileToUpload,
+        chime: _alarmOptions[_selectedAlarm] ?? 0,
+        gapMs: _alarmGapMs,
+      );
       
       setState(() {
         _status = 'Upload successful!';
@@ -1,6 +1,7 @@
 import 'package:record/record.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:permission_handler/permission_handler.dart';
+import '../utils/audio_utils.dart';
 
 class AudioService {
   final AudioRecorder _recorder = AudioRecorder();
@@ -21,12 +22,14 @@ class AudioService {
       final timestamp = DateTime.now().millisecondsSinceEpoch;
       _recordingPath = '${directory.path}/audio_$timestamp.wav';
 
-      // Start recording with WAV format
+      // Mono WAV at the rate the device plays uploads at, so the upload
+      // needs no resampling
       await _recorder.start(
         const RecordConfig(
           encoder: AudioEncoder.wav,
-          bitRate: 128000,
-          sampleRate: 44100,
+          bitRate: AudioUtils.uploadSampleRate * 16,
+          sampleRate: AudioUtils.uploadSampleRate,
+          numChannels: 1,
         ),
         path: _recordingPath!,
       );
@@ -15,7 +15,10 @@ class StorageService {
     }
   }
 
-  Future<String> uploadAudio(String filePath) async {
+  /// Uploads a recording. [chime] is the id of the alarm chime the device
+  /// plays before it (0 = none), [gapMs] the silence in between; both travel
+  /// as object metadata into the device notification.
+  Future<String> uploadAudio(String filePath, {int chime = 0, int gapMs = 2000}) async {
     // Ensure user is authenticated
     if (_auth.currentUser == null) {
       throw Exception('User not authenticated');
@@ -39,6 +42,8 @@ class StorageService {
           contentType: 'audio/wav',
           customMetadata: {
             'uploadedAt': DateTime.now().toIso8601String(),
+            'chime': chime.toString(),
+            'gapMs': gapMs.toString(),
           },
         ),
       );
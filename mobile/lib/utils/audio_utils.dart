@@ -1,94 +1,116 @@
 import 'dart:io';
+import 'dart:math' as math;
 import 'dart:typed_data';
-import 'package:flutter/services.dart' show rootBundle;
 import 'package:path_provider/path_provider.dart';
 
 class AudioUtils {
-  /// Extracts an asset file to a temporary file.
-  static Future<File> extractAssetToTemp(String assetPath) async {
-    final byteData = await rootBundle.load(assetPath);
-    final tempDir = await getTemporaryDirectory();
-    final tempFile = File('${tempDir.path}/${assetPath.split('/').last}');
-    await tempFile.writeAsBytes(byteData.buffer.asUint8List(), flush: true);
-    return tempFile;
-  }
+  /// Sample rate the device plays uploaded messages at.
+  static const int uploadSampleRate = 16000;
 
-  /// Merges two WAV files into a new file correctly handling headers.
-  static Future<String> mergeWavFiles(String firstPath, String secondPath) async {
-    final firstFile = File(firstPath);
-    final secondFile = File(secondPath);
+  /// IMA ADPCM block size; 256 bytes holds 505 mono samples.
+  static const int _adpcmBlockAlign = 256;
+  static const int _adpcmSamplesPerBlock = (_adpcmBlockAlign - 4) * 2 + 1;
 
-    if (!await firstFile.exists() || !await secondFile.exists()) {
-      throw Exception('Input files do not exist.');
-    }
+  /// Resampler low-pass: passband edge as a fraction of the lower rate
+  /// (6.4 kHz at 16 kHz, so everything that would fold back is in the
+  /// stopband), kernel length in zero crossings per side, and the kernel
+  /// table's steps per input sample.
+  static const double _resampleCutoff = 0.4;
+  static const int _resampleZeroCrossings = 16;
+  static const int _kernelOversample = 256;
 
-    final firstBytes = await firstFile.readAsBytes();
-    final secondBytes = await secondFile.readAsBytes();
+  static const List<int> _imaIndexTable = [-1, -1, -1, -1, 2, 4, 6, 8];
+  static const List<int> _imaStepTable = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+  ];
 
-    // 1. Robust Parse
-    final firstWav = _parseWav(firstBytes);
-    final secondWav = _parseWav(secondBytes);
+  /// Re-encodes a PCM WAV as 16 kHz mono IMA ADPCM (WAVE_FORMAT_IMA_ADPCM)
+  /// for upload. 4 bits per sample is 4x smaller than the 16-bit recording,
+  /// so the device can start playing much sooner. AudioService records at
+  /// 16 kHz already; a recording at another rate is low-pass filtered and
+  /// resampled first.
+  static Future<String> compressForUpload(String inputPath) async {
+    final wav = _parseWav(await File(inputPath).readAsBytes());
+    final pcmBytes = _processAudioData(wav, uploadSampleRate, 1);
+    final pcm = Int16List.fromList(
+        Int16List.view(pcmBytes.buffer, pcmBytes.offsetInBytes, pcmBytes.lengthInBytes ~/ 2));
 
-    print('MERGE DEBUG:');
-    print('Alarm: ${firstWav.sampleRate}Hz, Channels: ${firstWav.channels}');
-    print('Voice: ${secondWav.sampleRate}Hz, Channels: ${secondWav.channels}');
+    final blocks = (pcm.length + _adpcmSamplesPerBlock - 1) ~/ _adpcmSamplesPerBlock;
+    final dataSize = blocks * _adpcmBlockAlign;
+    const headerSize = 60; // RIFF + fmt (20) + fact + data headers
+    final out = Uint8List(headerSize + dataSize);
+    final view = ByteData.view(out.buffer);
 
-    // 2. Determine Target Format
-    // Use the voice recording's attributes as target to preserve its pitch/speed
-    // But default to Mono output unless we really want Stereo
-    final targetSampleRate = secondWav.sampleRate;
-    final targetChannels = 1; // Output Mono for simplicity and consistency with current code requirements
+    view.setUint32(0, 0x52494646, Endian.big); // "RIFF"
+    view.setUint32(4, headerSize - 8 + dataSize, Endian.little);
+    view.setUint32(8, 0x57415645, Endian.big); // "WAVE"
+    view.setUint32(12, 0x666d7420, Endian.big); // "fmt "
+    view.setUint32(16, 20, Endian.little);
+    view.setUint16(20, 0x0011, Endian.little); // IMA ADPCM
+    view.setUint16(22, 1, Endian.little);
+    view.setUint32(24, uploadSampleRate, Endian.little);
+    view.setUint32(28, uploadSampleRate * _adpcmBlockAlign ~/ _adpcmSamplesPerBlock, Endian.little);
+    view.setUint16(32, _adpcmBlockAlign, Endian.little);
+    view.setUint16(34, 4, Endian.little); // BitsPerSample
+    view.setUint16(36, 2, Endian.little); // cbSize
+    view.setUint16(38, _adpcmSamplesPerBlock, Endian.little);
+    view.setUint32(40, 0x66616374, Endian.big); // "fact"
+    view.setUint32(44, 4, Endian.little);
+    view.setUint32(48, pcm.length, Endian.little); // Sample count
+    view.setUint32(52, 0x64617461, Endian.big); // "data"
+    view.setUint32(56, dataSize, Endian.little);
 
-    // 3. Process Audio Data (Resample & Downmix if needed)
-    final firstData = _processAudioData(firstWav, targetSampleRate, targetChannels);
-    // Double volume for voice message
-    final secondData = _processAudioData(secondWav, targetSampleRate, targetChannels, gain: 2.0);
+    int index = 0;
+    for (int b = 0; b < blocks; b++) {
+      final base = b * _adpcmSamplesPerBlock;
+      int sampleAt(int i) => base + i < pcm.length ? pcm[base + i] : 0;
 
-    // Create 2 second silence
-    // 2 seconds * Sample Rate * 2 bytes/sample (16-bit) * Channels
-    final silenceBytes = 2 * targetSampleRate * 2 * targetChannels;
-    final silenceData = Uint8List(silenceBytes); // Zero-initialized by default
+      // Block header: first sample verbatim, then the step index
+      int predictor = sampleAt(0);
+      final blockOffset = headerSize + b * _adpcmBlockAlign;
+      view.setInt16(blockOffset, predictor, Endian.little);
+      out[blockOffset + 2] = index;
 
-    // 4. Create new WAV file
-    final totalDataSize = firstData.length + silenceData.length + secondData.length;
-    final totalFileSize = 36 + totalDataSize;
+      int pos = blockOffset + 4;
+      for (int i = 1; i < _adpcmSamplesPerBlock; i += 2) {
+        int packed = 0;
+        for (int half = 0; half < 2; half++) {
+          final step = _imaStepTable[index];
+          int diff = sampleAt(i + half) - predictor;
+          int nibble = 0;
+          if (diff < 0) {
+            nibble = 8;
+            diff = -diff;
+          }
+          if (diff >= step) { nibble |= 4; diff -= step; }
+          if (diff >= step >> 1) { nibble |= 2; diff -= step >> 1; }
+          if (diff >= step >> 2) { nibble |= 1; }
 
-    final outputHeader = Uint8List(44);
-    final view = ByteData.view(outputHeader.buffer);
+          // Track the decoder's reconstruction so errors don't accumulate
+          int delta = step >> 3;
+          if (nibble & 4 != 0) delta += step;
+          if (nibble & 2 != 0) delta += step >> 1;
+          if (nibble & 1 != 0) delta += step >> 2;
+          predictor += (nibble & 8 != 0) ? -delta : delta;
+          predictor = predictor.clamp(-32768, 32767);
+          index = (index + _imaIndexTable[nibble & 7]).clamp(0, 88);
 
-    // RIFF Chunk
-    view.setUint32(0, 0x52494646, Endian.big); // "RIFF"
-    view.setUint32(4, totalFileSize, Endian.little); // File Size - 8
-    view.setUint32(8, 0x57415645, Endian.big); // "WAVE"
+          packed |= nibble << (half * 4);
+        }
+        out[pos++] = packed;
+      }
+    }
 
-    // fmt Chunk
-    view.setUint32(12, 0x666d7420, Endian.big); // "fmt "
-    view.setUint32(16, 16, Endian.little); // Chunk size (16 for PCM)
-    view.setUint16(20, 1, Endian.little); // AudioFormat (1 = PCM)
-    view.setUint16(22, targetChannels, Endian.little); // NumChannels
-    view.setUint32(24, targetSampleRate, Endian.little); // SampleRate
-    view.setUint32(28, targetSampleRate * targetChannels * 2, Endian.little); // ByteRate
-    view.setUint16(32, targetChannels * 2, Endian.little); // BlockAlign
-    view.setUint16(34, 16, Endian.little); // BitsPerSample (16)
-
-    // data Chunk
-    view.setUint32(36, 0x64617461, Endian.big); // "data"
-    view.setUint32(40, totalDataSize, Endian.little); // Data Size
-
-    // Write file
     final tempDir = await getTemporaryDirectory();
     final timestamp = DateTime.now().millisecondsSinceEpoch;
-    final outputPath = '${tempDir.path}/merged_$timestamp.wav';
-    final outputFile = File(outputPath);
-    final outputSink = outputFile.openWrite();
-    
-    outputSink.add(outputHeader);
-    outputSink.add(firstData);
-    outputSink.add(silenceData);
-    outputSink.add(secondData);
-    
-    await outputSink.close();
-    
+    final outputPath = '${tempDir.path}/upload_$timestamp.wav';
+    await File(outputPath).writeAsBytes(out, flush: true);
     return outputPath;
   }
 
@@ -159,7 +181,7 @@ class AudioUtils {
     return _WavInfo(infoSampleRate ?? 44100, infoChannels ?? 1, infoData);
   }
 
-  static Uint8List _processAudioData(_WavInfo wav, int targetRate, int targetChannels, {double gain = 1.0}) {
+  static Uint8List _processAudioData(_WavInfo wav, int targetRate, int targetChannels) {
     Int16List samples;
     
     // 1. Convert bytes to Int16 samples
@@ -187,43 +209,50 @@ class AudioUtils {
         monoSamples = samples;
     }
 
-    Int16List processedSamples;
+    // 3. Resample through a low-pass filter, so nothing above the new
+    // Nyquist frequency folds back into the voice band
+    final processedSamples = wav.sampleRate == targetRate
+        ? monoSamples
+        : _resample(monoSamples, wav.sampleRate, targetRate);
 
-    // 3. Resample using Linear Interpolation
-    if (wav.sampleRate == targetRate) {
-        processedSamples = monoSamples;
-    } else {
-        final ratio = wav.sampleRate / targetRate;
-        final targetLength = (monoSamples.length / ratio).floor();
-        processedSamples = Int16List(targetLength);
-
-        for (int i = 0; i < targetLength; i++) {
-            final position = i * ratio;
-            final index = position.floor();
-            final fraction = position - index;
-
-            if (index + 1 < monoSamples.length) {
-                final a = monoSamples[index];
-                final b = monoSamples[index + 1];
-                processedSamples[i] = (a + (b - a) * fraction).round();
-            } else if (index < monoSamples.length) {
-                processedSamples[i] = monoSamples[index];
-            }
-        }
-    }
+    return processedSamples.buffer.asUint8List(processedSamples.offsetInBytes, processedSamples.lengthInBytes);
+  }
 
-    // 4. Apply Gain (Volume Boost)
-    if (gain != 1.0) {
-       for (int i = 0; i < processedSamples.length; i++) {
-          int val = (processedSamples[i] * gain).round();
-          // Clamp to 16-bit range to avoid overflow/distortion
-          if (val > 32767) val = 32767;
-          else if (val < -32768) val = -32768;
-          processedSamples[i] = val;
-       }
+  /// Windowed-sinc (Blackman) resampler. The kernel is tabulated once and
+  /// interpolated at each output sample's position between input samples;
+  /// each output is normalized by its weights, so DC passes exactly.
+  static Int16List _resample(Int16List input, int inRate, int outRate) {
+    final step = inRate / outRate;
+    // Cutoff in cycles per input sample, below both Nyquist frequencies
+    final cutoff = _resampleCutoff * math.min(inRate, outRate) / inRate;
+    final halfWidth = _resampleZeroCrossings / (2 * cutoff);
+    final table = Float64List((halfWidth * _kernelOversample).ceil() + 2);
+    for (int i = 0; i < table.length; i++) {
+      final x = i / _kernelOversample;
+      if (x >= halfWidth) break;
+      final arg = math.pi * 2 * cutoff * x;
+      final sinc = x == 0 ? 1.0 : math.sin(arg) / arg;
+      final t = x / halfWidth;
+      table[i] = sinc * (0.42 + 0.5 * math.cos(math.pi * t) + 0.08 * math.cos(2 * math.pi * t));
     }
 
-    return processedSamples.buffer.asUint8List(processedSamples.offsetInBytes, processedSamples.lengthInBytes);
+    final out = Int16List((input.length / step).floor());
+    for (int i = 0; i < out.length; i++) {
+      final center = i * step;
+      final first = math.max(0, (center - halfWidth).ceil());
+      final last = math.min(input.length - 1, (center + halfWidth).floor());
+      double acc = 0;
+      double norm = 0;
+      for (int k = first; k <= last; k++) {
+        final pos = (k - center).abs() * _kernelOversample;
+        final j = pos.floor();
+        final h = table[j] + (table[j + 1] - table[j]) * (pos - j);
+        acc += input[k] * h;
+        norm += h;
+      }
+      out[i] = norm > 0 ? (acc / norm).round().clamp(-32768, 32767) : 0;
+    }
+    return out;
   }
 }
 